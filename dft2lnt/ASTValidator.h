@@ -11,6 +11,7 @@
 #define ASTVALIDATOR_H
 
 #include <vector>
+#include <unordered_set>
 #include <iostream>
 
 #include "dft_ast.h"
@@ -27,7 +28,7 @@ namespace DFT {
  */
 class ASTValidator: public DFT::ASTVisitor<int,true> {
 private:
-	std::vector<std::string> definedNodes;
+	std::unordered_set<std::string> definedNodes;
 	static void f_aggregate(int& result, int value) {
 		result = result && value;
 	}
@@ -50,7 +51,7 @@ public:
 	 }
 
 	/**
-	 * Builds a list of defined DFT nodes in the AST specified in the
+	 * Builds the set of defined DFT nodes in the AST specified in the
 	 * constructor. The definedNodes member will be overridden.
 	 */
 	void buildDefinedNodesList() {
@@ -80,7 +81,7 @@ public:
 				//std::cout << "Defined: " << basicEvent->getName() << std::endl;
 				assert(be);
 				assert(be->getName());
-				definedNodes.push_back(be->getName()->getString());
+				definedNodes.insert(be->getName()->getString());
 				break;
 			}
 
@@ -88,7 +89,7 @@ public:
 			// Any Gate can reference multiple nodes
 			case DFT::AST::GateType: {
 				DFT::AST::ASTGate* g = static_cast<DFT::AST::ASTGate*>(node);
-				definedNodes.push_back(g->getName()->getString());
+				definedNodes.insert(g->getName()->getString());
 				std::vector<DFT::AST::ASTIdentifier*>* children = g->getChildren();
 				//for(int i=children->size();i--;) {
 				//	referencedNodes.push_back(children->at(i));
@@ -162,8 +163,7 @@ public:
 		
 		valid = ASTVisitor<int,true>::visitTopLevel(topLevel) ? valid : false ;
 		
-		std::vector<std::string>::iterator it = std::find(definedNodes.begin(),definedNodes.end(),topLevel->getTopNode()->getString());
-		if(it == definedNodes.end()) {
+		if(!definedNodes.count(topLevel->getTopNode()->getString())) {
 			valid = false;
 			cc->reportErrorAt(topLevel->getTopNode()->getLocation(),"undefined node referenced: " + topLevel->getTopNode()->getString());
 		}
@@ -186,8 +186,7 @@ public:
 
 		std::vector<DFT::AST::ASTIdentifier*>* children = gate->getChildren();
 		for(int i=children->size();i--;) {
-			std::vector<std::string>::iterator it = std::find(definedNodes.begin(),definedNodes.end(),children->at(i)->getString());
-			if(it == definedNodes.end()) {
+			if(!definedNodes.count(children->at(i)->getString())) {
 				valid = false;
 				cc->reportErrorAt(children->at(i)->getLocation(),"undefined node referenced: " + children->at(i)->getString());
 			}
@@ -199,8 +198,7 @@ public:
 
 		valid = ASTVisitor<int,true>::visitPage(page) ? valid : false ;
 
-		std::vector<std::string>::iterator it = std::find(definedNodes.begin(),definedNodes.end(),page->getNodeName()->getString());
-		if(it == definedNodes.end()) {
+		if(!definedNodes.count(page->getNodeName()->getString())) {
 			valid = false;
 			cc->reportErrorAt(page->getNodeName()->getLocation(),"undefined node referenced: " + page->getNodeName()->getString());
 		}
@@ -1,3 +1,5 @@
+#include <cmath>
+#include <cstdio>
 #include "DFTCalculationResult.h"
 
 static std::string round(std::string value, size_t digits, bool roundUp)
@@ -135,6 +137,19 @@ std::string DFT::DFTCalculationResultItem::valStr(size_t deltaDigits) const {
 	return ret;
 }
 
+decnumber<> DFT::probabilityBound(double v, bool roundUp)
+{
+	if (v <= 0)
+		return decnumber<>(0);
+	if (v >= 1)
+		return decnumber<>(1);
+	/* Printing with 17 digits is within half an ulp */
+	v = std::nextafter(v, roundUp ? 2.0 : -1.0);
+	char buf[32];
+	snprintf(buf, sizeof(buf), "%.17g", v);
+	return decnumber<>(std::string(buf));
+}
+
 const YAML::Node& operator>>(const YAML::Node& node, DFT::DFTCalculationResult& result) {
 	if(const YAML::Node itemNode = node["failProbs"]) {
 		std::vector<DFT::DFTCalculationResultItem> failProbs;
@@ -146,6 +161,9 @@ const YAML::Node& operator>>(const YAML::Node& node, DFT::DFTCalculationResult&
 		itemNode >> stats;
 		result.stats = stats;
 	}
+	if(const YAML::Node itemNode = node["cutSets"]) {
+		result.cutSets = itemNode.as<std::vector<std::vector<std::string>>>();
+	}
 	return node;
 }
 
@@ -159,6 +177,13 @@ YAML::Emitter& operator<<(YAML::Emitter& out, const DFT::DFTCalculationResult& r
 		break;
 	}
 	out << YAML::Key << "stats"  << YAML::Value << result.stats;
+	if(!result.cutSets.empty()) {
+		out << YAML::Key << "cutSets" << YAML::Value << YAML::BeginSeq;
+		for(auto& cs: result.cutSets) {
+			out << YAML::Flow << cs;
+		}
+		out << YAML::EndSeq;
+	}
 	out << YAML::EndMap;
 	return out;
 }
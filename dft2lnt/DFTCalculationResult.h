@@ -37,7 +37,15 @@ class DFTCalculationResult {
 	public:
 		Shell::RunStatistics stats;
 		std::vector<DFTCalculationResultItem> failProbs;
+		/// The minimal cut sets, as lists of basic event names
+		std::vector<std::vector<std::string>> cutSets;
 };
+
+/**
+ * Returns a short decimal lower (or upper, if roundUp) bound on the
+ * specified probability, clamped to [0, 1].
+ */
+decnumber<> probabilityBound(double v, bool roundUp);
 } // Namespace: DFT
 
 const YAML::Node& operator>>(const YAML::Node& node, DFT::DFTCalculationResult& result);
@@ -9,17 +9,111 @@
 
 #include "DFTree.h"
 #include "dftnodes/nodes.h"
+#include <cstdint>
+#include <unordered_map>
 #include <unordered_set>
 
 namespace DFT {
-	/* This should be replaced by a proper check to allow replacing of
-	 * entire subtrees rather than just basic events, but at least we
-	 * know for certain that basic events are independent.
+	/* This should be extended to allow replacing of entire subtrees
+	 * rather than just basic events.
 	 */
 	static bool isIndependentSubtree(Nodes::Node *node) {
-		if (node->getParents().size() > 1)
-			return false;
-		return node->isBasicEvent();
+		return node->isBasicEvent() && node->isIndependentSubtree();
+	}
+
+	/* A node with a single parent is an independent subtree iff the
+	 * edge to its parent is a bridge of the (undirected) graph of all
+	 * parent/child and FDEP/depender edges, i.e., it lies on no cycle.
+	 * The bridges are found by a single depth-first search, as a tree
+	 * edge to a node whose subtree has no edge back to an earlier
+	 * discovered node (Tarjan).
+	 */
+	void DFTree::detectModules(void) {
+		std::unordered_map<const Nodes::Node *, size_t> index;
+		index.reserve(nodes.size());
+		for (size_t i = 0; i < nodes.size(); i++)
+			index.emplace(nodes[i], i);
+
+		/* Edges as (from, to) pairs, and the edge from the parent of
+		 * each node with a single parent.
+		 */
+		std::vector<std::pair<size_t, size_t>> edges;
+		std::vector<size_t> parentEdge(nodes.size(), SIZE_MAX);
+		for (size_t i = 0; i < nodes.size(); i++) {
+			if (!nodes[i]->isGate())
+				continue;
+			Nodes::Gate *g = static_cast<Nodes::Gate *>(nodes[i]);
+			for (Nodes::Node *c : g->getChildren()) {
+				size_t child = index.at(c);
+				if (c->getParents().size() == 1)
+					parentEdge[child] = edges.size();
+				edges.push_back(std::make_pair(i, child));
+			}
+			if (g->matchesType(Nodes::GateFDEPType)) {
+				Nodes::GateFDEP *f = static_cast<Nodes::GateFDEP *>(g);
+				for (Nodes::Node *d : f->getDependers())
+					edges.push_back(std::make_pair(i, index.at(d)));
+			}
+		}
+
+		/* Adjacency lists of edge numbers, in compressed form */
+		std::vector<size_t> start(nodes.size() + 1, 0), adjacent(edges.size() * 2);
+		for (auto &e : edges) {
+			start[e.first + 1]++;
+			start[e.second + 1]++;
+		}
+		for (size_t i = 0; i < nodes.size(); i++)
+			start[i + 1] += start[i];
+		std::vector<size_t> fill(start.begin(), start.end() - 1);
+		for (size_t e = 0; e < edges.size(); e++) {
+			adjacent[fill[edges[e].first]++] = e;
+			adjacent[fill[edges[e].second]++] = e;
+		}
+
+		std::vector<size_t> discovered(nodes.size(), SIZE_MAX), low(nodes.size());
+		std::vector<bool> bridge(edges.size(), false);
+		/* Stack of (node, edge by which it was reached, next adjacency) */
+		struct Frame { size_t node, via, next; };
+		std::vector<Frame> stack;
+		size_t time = 0;
+		for (size_t r = 0; r < nodes.size(); r++) {
+			if (discovered[r] != SIZE_MAX)
+				continue;
+			discovered[r] = low[r] = time++;
+			stack.push_back({r, SIZE_MAX, start[r]});
+			while (!stack.empty()) {
+				Frame &f = stack.back();
+				if (f.next < start[f.node + 1]) {
+					size_t e = adjacent[f.next++];
+					if (e == f.via)
+						continue;
+					size_t other = edges[e].first == f.node ? edges[e].second : edges[e].first;
+					if (discovered[other] == SIZE_MAX) {
+						discovered[other] = low[other] = time++;
+						stack.push_back({other, e, start[other]});
+					} else {
+						low[f.node] = std::min(low[f.node], discovered[other]);
+					}
+					continue;
+				}
+				size_t node = f.node, via = f.via;
+				stack.pop_back();
+				if (stack.empty())
+					break;
+				size_t parent = stack.back().node;
+				low[parent] = std::min(low[parent], low[node]);
+				if (low[node] > discovered[parent])
+					bridge[via] = true;
+			}
+		}
+
+		for (size_t i = 0; i < nodes.size(); i++) {
+			size_t nParents = nodes[i]->getParents().size();
+			bool independent = nParents == 0
+			                   || (nParents == 1 && parentEdge[i] != SIZE_MAX
+			                       && bridge[parentEdge[i]]);
+			nodes[i]->setIndependentSubtree(independent);
+		}
 	}
 
 	static void setAllDormsToZero(Nodes::Node *node) {
@@ -34,9 +128,14 @@ namespace DFT {
 	}
 
 	void DFTree::replaceSEQs() {
+		detectModules();
+		/* Nodes are added and removed below, so iterate over a copy */
+		std::vector<Nodes::Node *> seqs;
 		for (Nodes::Node *node : nodes) {
-			if (!node->matchesType(Nodes::GateSeqType))
-				continue;
+			if (node->matchesType(Nodes::GateSeqType))
+				seqs.push_back(node);
+		}
+		for (Nodes::Node *node : seqs) {
 			Nodes::GateSeq *seq = static_cast<DFT::Nodes::GateSeq *>(node);
 			bool canReplace = true;
 			for (Nodes::Node *child : seq->getChildren()) {
@@ -64,8 +163,8 @@ namespace DFT {
 				
 				// Point all the SEQ's parents to the SAND
 				for(Nodes::Gate* parent: seq->getParents()) {
-					// Add the parent to the OR-node's parents
-					seq->getParents().push_back(parent);
+					// Add the parent to the SAND-node's parents
+					sand->getParents().push_back(parent);
 					vector<Nodes::Node *> &pcs = parent->getChildren();
 					for (int i = 0; i < pcs.size(); i++) {
 						if (pcs[i] == seq)
@@ -18,6 +18,7 @@ class DFTree;
 #include <vector>
 #include <map>
 #include <set>
+#include <unordered_map>
 #include <iostream>
 #include <assert.h>
 #include "dftnodes/nodes.h"
@@ -37,8 +38,8 @@ private:
 	/// The nodes of the DFT
 	std::vector<Nodes::Node*> nodes;
 	
-	/// The mapping from name (e.g. "A") to a Node
-	std::map<std::string,DFT::Nodes::Node*> nodeTable;
+	/// The mapping from name (e.g. "A") to the first Node of that name
+	std::unordered_map<std::string,DFT::Nodes::Node*> nodeTable;
 	
 	/// The Top (root) Node of the DFT
 	Nodes::Node* topNode;
@@ -76,6 +77,7 @@ public:
 	 */
 	void addNode(Nodes::Node* node) {
 		nodes.push_back(node);
+		nodeTable.emplace(node->getName(), node);
 	}
 	
 	/**
@@ -107,6 +109,18 @@ public:
 		vector<DFT::Nodes::Node*>::iterator it = std::remove(nodes.begin(),nodes.end(),node);
 		nodes.resize(it-nodes.begin());
 		
+		// Remove its name, falling back to another Node of that name
+		auto named = nodeTable.find(node->getName());
+		if(named != nodeTable.end() && named->second == node) {
+			nodeTable.erase(named);
+			for(DFT::Nodes::Node* n: nodes) {
+				if(n->getName() == node->getName()) {
+					nodeTable.emplace(n->getName(), n);
+					break;
+				}
+			}
+		}
+		
 		// Delete the node
 		delete node;
 		
@@ -120,12 +134,8 @@ public:
 	 * @return The Node associated with the specified name.
 	 */
 	Nodes::Node* getNode(const std::string& name) {
-		for(size_t i=0; i<nodes.size(); ++i) {
-			if(nodes.at(i)->getName()==name) {
-				return nodes.at(i);
-			}
-		}
-		return NULL;
+		auto it = nodeTable.find(name);
+		return it == nodeTable.end() ? NULL : it->second;
 	}
 
 	/**
@@ -171,6 +181,13 @@ public:
 
 	void removeUnreachable(void);
 
+	/**
+	 * Determines for every node whether it is an independent subtree
+	 * (see Node::isIndependentSubtree()), in time linear in the size
+	 * of the DFT. Must be called again after the DFT is modified.
+	 */
+	void detectModules(void);
+
 	/**
 	 * Translates this DFTree so that all FDEP nodes are removed and Or nodes
 	 * are inserted, such that the meaning of the DFTree is unaltered.
@@ -262,9 +279,9 @@ public:
 	 * @param evidence List of names of basic events that will fail at t=0
 	 * @throw std::vector<std::string> List of error messages
 	 */
-	void applyEvidence(std::vector<std::string>& evidence) {
+	void applyEvidence(const std::vector<std::string>& evidence) {
 		std::vector<std::string> errors;
-		for(std::string& nodeName: evidence) {
+		for(const std::string& nodeName: evidence) {
 			DFT::Nodes::Node* node = getNode(nodeName);
 			if(node) {
 				if(node->isBasicEvent()) {
@@ -10,6 +10,9 @@
 #include "DFTreeValidator.h"
 #include "dft2lnt.h"
 
+#include <algorithm>
+#include <unordered_set>
+
 DFT::DFTreeValidator::DFTreeValidator(DFT::DFTree* dft, CompilerContext* cc):
 	dft(dft),
 	cc(cc) {
@@ -25,14 +28,11 @@ int DFT::DFTreeValidator::validateReferences() {
 		assert(nodes.at(i));
 		nodes.at(i)->addReferencesTo(notDefinedButReferencedNodes);
 	}
-	for(size_t i=0; i<nodes.size();++i) {
-		//std::remove(notDefinedButReferencedNodes.begin(),notDefinedButReferencedNodes.end(),nodes.at(i));
-		for(;;) {
-			std::vector<Nodes::Node*>::iterator it = std::find(notDefinedButReferencedNodes.begin(),notDefinedButReferencedNodes.end(),nodes.at(i));
-			if(it == notDefinedButReferencedNodes.end()) break;
-			notDefinedButReferencedNodes.erase(it);
-		}
-	}
+	std::unordered_set<Nodes::Node*> definedNodes(nodes.begin(), nodes.end());
+	std::vector<Nodes::Node*>::iterator defined = std::remove_if(
+		notDefinedButReferencedNodes.begin(), notDefinedButReferencedNodes.end(),
+		[&definedNodes](Nodes::Node* node) { return definedNodes.count(node) > 0; });
+	notDefinedButReferencedNodes.erase(defined, notDefinedButReferencedNodes.end());
 	
 	for(std::vector<Nodes::Node*>::iterator i = notDefinedButReferencedNodes.begin(); i != notDefinedButReferencedNodes.end(); i++) {
 		cc->reportErrorAt((*i)->getLocation(),"node " + ((*i)->getName()) + " references inexistent node");
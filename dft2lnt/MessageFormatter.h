@@ -11,6 +11,7 @@
 
 #include "dft_parser_location.h"
 #include "ConsoleWriter.h"
+#include <mutex>
 #include <set>
 
 class MessageFormatter {
@@ -116,6 +117,8 @@ private:
 	unsigned int warnings;
 	bool m_autoFlush;
 	int verbosity;
+	/// Serialises messages from concurrent analyses
+	std::recursive_mutex lock;
 	void print(const Location& l, const std::string& str, const MessageType& mType);
 public:
 
@@ -143,9 +143,12 @@ int Shell::system(const SystemOptions& options, RunStatistics* stats) {
 		}
 	}
 	
-	// Obtain the real path of the specified cwd and enter it
+	// Obtain the real path of the specified cwd and enter it. This is
+	// done by the shell rather than by changing the working directory
+	// of this process, so commands can be run from multiple threads.
 	string realCWD = FileSystem::getRealPath(options.cwd);
-	PushD dir(realCWD);
+	if(!realCWD.empty())
+		command = "cd \"" + realCWD + "\" && " + command;
 	if(messageFormatter) messageFormatter->reportAction("Entering directory: `" + realCWD + "'", options.verbosity);
 
 	// Execute the command
@@ -179,8 +182,6 @@ int Shell::system(const SystemOptions& options, RunStatistics* stats) {
 		}
 	}
 	
-	// Leave the cwd
-	dir.popd();
 	if(messageFormatter) messageFormatter->reportAction("Exiting directory: `" + realCWD + "'", options.verbosity);
 	
 	if(removeTmpFile && FileSystem::exists(statFile))
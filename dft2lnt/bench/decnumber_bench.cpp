@@ -0,0 +1,98 @@
+/*
+ * decnumber_bench.cpp
+ *
+ * Part of dft2lnt library - a library containing read/write operations for DFT
+ * files in Galileo format and translating DFT specifications into Lotos NT.
+ *
+ * Compares decnumber with its previous implementation on the operations
+ * dftcalc performs when combining module results: parsing the results of
+ * the modules, combining them by AND, OR and voting gates, computing the
+ * error margins and formatting the results, for every time point.
+ *
+ * Usage: decnumber_bench [modules [time points]]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "decnumber.h"
+#include "old_decnumber.h"
+
+/* Module results as printed by the analysis tools: 17 significant
+ * digits, a tenth of them in exponent notation.
+ */
+static std::vector<std::string> makeInputs(size_t modules, size_t points)
+{
+	std::mt19937_64 rng(1);
+	std::uniform_real_distribution<double> dist(0.0, 0.5);
+	std::vector<std::string> ret;
+	for (size_t i = 0; i < modules * points * 2; i++) {
+		char buf[32];
+		double p = dist(rng);
+		if (i % 10 == 0)
+			p *= 1e-9;
+		snprintf(buf, sizeof(buf), "%.17g", p);
+		ret.push_back(buf);
+	}
+	return ret;
+}
+
+/* Returns the formatted results, and the time taken in seconds. */
+template<class N>
+static double run(const std::vector<std::string> &inputs, size_t modules,
+                  size_t points, std::vector<std::string> &out)
+{
+	const N ONE(1), ZERO(0), BOUND(std::string("1e-6"));
+	auto start = std::chrono::steady_clock::now();
+	size_t next = 0;
+	for (size_t t = 0; t < points; t++) {
+		std::vector<N> lower, upper;
+		for (size_t m = 0; m < modules; m++) {
+			lower.push_back(N(inputs[next++]));
+			upper.push_back(lower.back() + N(inputs[next++]) * BOUND);
+		}
+		for (const std::vector<N> *ps : {&lower, &upper}) {
+			const std::vector<N> &p = *ps;
+			N andRes(ONE), notOr(ONE);
+			/* 2-out-of-n: at[c] is P(at least c have failed) */
+			std::vector<N> at(3, ZERO);
+			at[0] = ONE;
+			for (const N &v : p) {
+				andRes *= v;
+				notOr *= ONE - v;
+				for (size_t c = 2; c > 0; c--)
+					at[c] = at[c] + (at[c - 1] - at[c]) * v;
+			}
+			out.push_back(andRes.str());
+			out.push_back((ONE - notOr).str());
+			out.push_back(at[2].str());
+		}
+		N margin = upper.back() - lower.back();
+		out.push_back(margin < BOUND ? "exact" : "inexact");
+		out.push_back(std::to_string((double)((lower.back() + upper.back()) * N(0.5))));
+	}
+	std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+	return d.count();
+}
+
+int main(int argc, char **argv)
+{
+	size_t modules = argc > 1 ? strtoul(argv[1], nullptr, 10) : 20;
+	size_t points = argc > 2 ? strtoul(argv[2], nullptr, 10) : 100;
+	std::vector<std::string> inputs = makeInputs(modules, points);
+	std::vector<std::string> oldOut, newOut;
+	double oldTime = run<old_decnumber<>>(inputs, modules, points, oldOut);
+	double newTime = run<decnumber<>>(inputs, modules, points, newOut);
+	printf("%zu modules, %zu time points\n", modules, points);
+	printf("old_decnumber: %10.6f s\n", oldTime);
+	printf("decnumber:     %10.6f s (%.1fx)\n", newTime, oldTime / newTime);
+	if (oldOut != newOut) {
+		fprintf(stderr, "Results differ\n");
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
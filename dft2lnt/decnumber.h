@@ -1,10 +1,14 @@
+#include <algorithm>
 #include <string>
 #include <cstring>
+#include <cstdint>
 #include <limits>
 #include <cctype>
 #include <cmath>
 #include <exception>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 
 #ifndef DECNUMBER_H
 #define DECNUMBER_H
@@ -22,189 +26,481 @@ class decnumber
 	 * integers.
 	 * e is stored as a standard integer (I doubt we'll need numbers
 	 * bigger than 10^2^32 any time soon).
-	 * i is stored as a base-N sequence of digits, where N is the
-	 * largest multiple of 10 we can fit in a block (the sequence is
-	 * stored big-endian).
+	 * i is stored as a base-N sequence of limbs, where N is the
+	 * largest power of 10 we can fit in a limb (the sequence is
+	 * stored little-endian). Short sequences are stored in the object
+	 * itself, so most numbers never allocate.
+	 * Numbers are kept normalized: i has no trailing decimal zeros
+	 * and no leading zero limbs, and zero has no limbs, exponent 0
+	 * and sign 1. Equal numbers thus have equal representations.
 	 */
 private:
-	static constexpr BT base = (std::numeric_limits<BT>::max() / 10) * 10;
+	/* Holds the product of two limbs, or a sum of several */
+	typedef uint64_t DT;
+	static_assert(std::numeric_limits<BT>::is_integer
+	              && !std::numeric_limits<BT>::is_signed
+	              && sizeof(BT) <= 4,
+	              "Limbs must be unsigned integers of at most 32 bits");
+
+	static constexpr unsigned int limb_digits() {
+		unsigned int ret = 0;
+		for (BT v = std::numeric_limits<BT>::max(); v >= 10; v /= 10)
+			ret++;
+		return ret;
+	}
+
+	static constexpr BT pow10(unsigned int n) {
+		BT ret = 1;
+		while (n--)
+			ret *= 10;
+		return ret;
+	}
+
+	static constexpr unsigned int DIGITS = limb_digits();
+	static constexpr BT base = pow10(DIGITS);
+
+	/* The largest powers of 2 and 5 below the base, by which
+	 * mul_small() can multiply.
+	 */
+	static constexpr unsigned int bits_per_step() {
+		unsigned int ret = 0;
+		while (((DT)1 << (ret + 1)) < base)
+			ret++;
+		return ret;
+	}
+	static constexpr unsigned int fives_per_step() {
+		unsigned int ret = 0;
+		DT p = 5;
+		while (p * 5 < base) {
+			p *= 5;
+			ret++;
+		}
+		return ret + 1;
+	}
+	static constexpr BT pow5(unsigned int n) {
+		BT ret = 1;
+		while (n--)
+			ret *= 5;
+		return ret;
+	}
+
+	/* A column sum below this can take another product of two limbs */
+	static constexpr DT FOLD = std::numeric_limits<DT>::max() - (DT)(base - 1) * (base - 1);
 
-	std::size_t num_blocks;
-	BT *blocks;
+	static constexpr std::size_t INLINE_LIMBS = 4;
+	/* Operands with fewer limbs are multiplied in quadratic time */
+	static constexpr std::size_t KARATSUBA_THRESHOLD = 32;
+
+	BT *limbs;
+	std::size_t num_limbs;
+	std::size_t capacity;
 	ET exponent;
 	int sign;
+	BT local[INLINE_LIMBS];
 
-	void mul_unnorm(BT val) {
-		if (val == 0) {
-			free(blocks);
-			blocks = nullptr;
-			num_blocks = 0;
-			sign = 1;
-			exponent = 0;
-			return;
+	/* Arithmetic on little-endian limb sequences. Sequences may have
+	 * leading zero limbs.
+	 */
+
+	static int mag_cmp(const BT *a, std::size_t na, const BT *b, std::size_t nb) {
+		while (na && !a[na - 1])
+			na--;
+		while (nb && !b[nb - 1])
+			nb--;
+		if (na != nb)
+			return na < nb ? -1 : 1;
+		while (na--) {
+			if (a[na] != b[na])
+				return a[na] < b[na] ? -1 : 1;
+		}
+		return 0;
+	}
+
+	/* r += b, for nb <= nr. Returns the carry out of r. */
+	static BT mag_add_to(BT *r, std::size_t nr, const BT *b, std::size_t nb) {
+		BT carry = 0;
+		std::size_t i;
+		for (i = 0; i < nb; i++) {
+			DT s = (DT)r[i] + b[i] + carry;
+			carry = s >= base;
+			r[i] = (BT)(carry ? s - base : s);
+		}
+		for (; carry && i < nr; i++) {
+			if (r[i] == base - 1) {
+				r[i] = 0;
+			} else {
+				r[i]++;
+				carry = 0;
+			}
 		}
-		if (val < 0)
-			throw std::invalid_argument("Unnormalized multiplication by negative numbers currently not supported.");
-		if (val == 1)
+		return carry;
+	}
+
+	/* r -= b, for nb <= nr. Returns the borrow out of r. */
+	static BT mag_sub_from(BT *r, std::size_t nr, const BT *b, std::size_t nb) {
+		BT borrow = 0;
+		std::size_t i;
+		for (i = 0; i < nb; i++) {
+			DT sub = (DT)b[i] + borrow;
+			borrow = r[i] < sub;
+			r[i] = (BT)(borrow ? r[i] + base - sub : r[i] - sub);
+		}
+		for (; borrow && i < nr; i++) {
+			if (r[i] == 0) {
+				r[i] = base - 1;
+			} else {
+				r[i]--;
+				borrow = 0;
+			}
+		}
+		return borrow;
+	}
+
+	/* a = b - a for a <= b, where a has room for nb limbs. */
+	static void mag_rsub(BT *a, std::size_t na, const BT *b, std::size_t nb) {
+		BT borrow = 0;
+		for (std::size_t i = 0; i < nb; i++) {
+			DT sub = (DT)(i < na ? a[i] : 0) + borrow;
+			borrow = b[i] < sub;
+			a[i] = (BT)(borrow ? b[i] + base - sub : b[i] - sub);
+		}
+	}
+
+	/* r = a * b by columns (Comba), where r has na + nb limbs and
+	 * does not overlap a or b. Each column is summed in a double
+	 * limb, folding into hi before it could overflow.
+	 */
+	static void mul_comba(BT *r, const BT *a, std::size_t na,
+	                      const BT *b, std::size_t nb)
+	{
+		DT carry = 0;
+		for (std::size_t k = 0; k + 1 < na + nb; k++) {
+			DT acc = carry, hi = 0;
+			std::size_t i = k < nb ? 0 : k - nb + 1;
+			std::size_t end = k < na ? k + 1 : na;
+			for (; i < end; i++) {
+				acc += (DT)a[i] * b[k - i];
+				if (acc >= FOLD) {
+					hi += acc / base;
+					acc %= base;
+				}
+			}
+			r[k] = (BT)(acc % base);
+			carry = hi + acc / base;
+		}
+		r[na + nb - 1] = (BT)carry;
+	}
+
+	/* r = a * b, where r has na + nb limbs and does not overlap a or
+	 * b. Long operands are split in halves (Karatsuba):
+	 * (a1 B + a0)(b1 B + b0) = a1 b1 B^2 + ((a0+a1)(b0+b1) - a0 b0 - a1 b1) B + a0 b0
+	 */
+	static void mag_mul(BT *r, const BT *a, std::size_t na,
+	                    const BT *b, std::size_t nb)
+	{
+		if (na < nb) {
+			std::swap(a, b);
+			std::swap(na, nb);
+		}
+		if (nb < KARATSUBA_THRESHOLD) {
+			mul_comba(r, a, na, b, nb);
 			return;
-		if (val == base) {
-			if (num_blocks == SIZE_MAX)
-				throw std::overflow_error("Number way too big.");
-			BT *tmp = new BT[num_blocks + 1];
-			memcpy(tmp, blocks, num_blocks * sizeof(BT));
-			delete[] blocks;
-			blocks = tmp;
-			blocks[num_blocks] = 0;
-			num_blocks++;
+		}
+		std::size_t m = (na + 1) / 2;
+		if (nb <= m) {
+			/* Too unbalanced to split b: multiply b with both
+			 * halves of a.
+			 */
+			std::vector<BT> hi(na - m + nb);
+			mag_mul(r, a, m, b, nb);
+			memset(r + m + nb, 0, (na - m) * sizeof(BT));
+			mag_mul(hi.data(), a + m, na - m, b, nb);
+			mag_add_to(r + m, na + nb - m, hi.data(), hi.size());
 			return;
 		}
-		decnumber<BT, ET> old(*this);
-		if (val > 2) {
-			mul_unnorm(val / 2);
+		std::vector<BT> sa(m + 1), sb(m + 1), mid(2 * m + 2);
+		memcpy(sa.data(), a, m * sizeof(BT));
+		sa[m] = mag_add_to(sa.data(), m, a + m, na - m);
+		memcpy(sb.data(), b, m * sizeof(BT));
+		sb[m] = mag_add_to(sb.data(), m, b + m, nb - m);
+		mag_mul(r, a, m, b, m);
+		mag_mul(r + 2 * m, a + m, na - m, b + m, nb - m);
+		mag_mul(mid.data(), sa.data(), m + 1, sb.data(), m + 1);
+		mag_sub_from(mid.data(), mid.size(), r, 2 * m);
+		mag_sub_from(mid.data(), mid.size(), r + 2 * m, na + nb - 2 * m);
+		std::size_t nmid = mid.size();
+		while (nmid && !mid[nmid - 1])
+			nmid--;
+		mag_add_to(r + m, na + nb - m, mid.data(), nmid);
+	}
+
+	bool on_heap() const {
+		return limbs != local;
+	}
+
+	/* Makes room for n limbs, keeping the current ones. */
+	void reserve(std::size_t n) {
+		if (n <= capacity)
+			return;
+		if (n > SIZE_MAX / sizeof(BT))
+			throw std::overflow_error("Number way too big.");
+		std::size_t cap = std::max(n, capacity + capacity / 2);
+		BT *tmp = new BT[cap];
+		memcpy(tmp, limbs, num_limbs * sizeof(BT));
+		if (on_heap())
+			delete[] limbs;
+		limbs = tmp;
+		capacity = cap;
+	}
+
+	void set_zero() {
+		num_limbs = 0;
+		exponent = 0;
+		sign = 1;
+	}
+
+	void assign(const decnumber<BT, ET> &other) {
+		reserve(other.num_limbs);
+		memcpy(limbs, other.limbs, other.num_limbs * sizeof(BT));
+		num_limbs = other.num_limbs;
+		exponent = other.exponent;
+		sign = other.sign;
+	}
+
+	/* Takes over other's limbs, leaving it zero. */
+	void take(decnumber<BT, ET> &other) {
+		if (other.on_heap()) {
+			if (on_heap())
+				delete[] limbs;
+			limbs = other.limbs;
+			capacity = other.capacity;
+			num_limbs = other.num_limbs;
+			other.limbs = other.local;
+			other.capacity = INLINE_LIMBS;
+		} else {
+			assign(other);
 		}
-		/* val == 2 */
-		BT carry = 0;
-		for (std::size_t i = num_blocks - 1; i != SIZE_MAX; i--) {
-			BT new_carry = 0;
-			/* This entirely depends on base being divisible by 2, which it
-			 * is since we've chosen it to be a multiple of 10.
-			 */
-			if (blocks[i] >= base / 2) {
-				blocks[i] -= base / 2;
-				new_carry = 1;
-			}
-			blocks[i] *= 2;
-			blocks[i] += carry;
-			if (blocks[i] >= base) {
-				new_carry++;
-				blocks[i] -= base;
-			}
-			carry = new_carry;
+		exponent = other.exponent;
+		sign = other.sign;
+		other.set_zero();
+	}
+
+	/* i *= val, for val < base. */
+	void mul_small(BT val) {
+		DT carry = 0;
+		for (std::size_t i = 0; i < num_limbs; i++) {
+			DT p = (DT)limbs[i] * val + carry;
+			limbs[i] = (BT)(p % base);
+			carry = p / base;
 		}
 		if (carry) {
-			if (num_blocks == SIZE_MAX)
-				throw std::overflow_error("Number way too big.");
-			BT *tmp = new BT[num_blocks + 1];
-			memcpy(tmp+1, blocks, num_blocks * sizeof(BT));
-			delete[] blocks;
-			num_blocks++;
-			blocks = tmp;
-			blocks[0] = carry;
-		}
-		if (val & 1) {
-			BT carry = 0;
-			size_t i;
-			for (i = 0; i < old.num_blocks; i++) {
-				size_t pn = num_blocks - i - 1;
-				size_t po = old.num_blocks - i - 1;
-				if (blocks[pn] == base - carry) {
-					blocks[pn] = 0;
-				} else {
-					blocks[pn] += carry;
-					carry = 0;
-				}
-				if (blocks[pn] >= base - old.blocks[po]) {
-					carry++;
-					blocks[pn] -= base - old.blocks[po];
-				} else {
-					blocks[pn] += old.blocks[po];
-				}
-			}
-			i = num_blocks - old.num_blocks;
-			while (carry) {
-				if (i) {
-					i--;
-					blocks[i]++;
-					if (blocks[i] == base)
-						blocks[i] = 0;
-					else
-						carry = 0;
-				} else {
-					if (num_blocks == SIZE_MAX)
-						throw std::overflow_error("Number way too big.");
-					BT *tmp = new BT[num_blocks + 1];
-					memcpy(tmp+1, blocks, num_blocks * sizeof(BT));
-					delete[] blocks;
-					num_blocks++;
-					blocks = tmp;
-					blocks[0] = carry;
-					carry = 0;
-				}
-			}
+			reserve(num_limbs + 1);
+			limbs[num_limbs++] = (BT)carry;
 		}
 	}
 
+	/* i += val, for val < base. */
+	void add_small(BT val) {
+		if (!val)
+			return;
+		reserve(num_limbs + 1);
+		limbs[num_limbs] = 0;
+		mag_add_to(limbs, num_limbs + 1, &val, 1);
+		if (limbs[num_limbs])
+			num_limbs++;
+	}
+
+	/* i /= val, for 0 < val <= base, returning the remainder. */
+	BT div_small(BT val) {
+		DT rem = 0;
+		for (std::size_t i = num_limbs; i-- > 0;) {
+			DT cur = rem * base + limbs[i];
+			limbs[i] = (BT)(cur / val);
+			rem = cur % val;
+		}
+		while (num_limbs && !limbs[num_limbs - 1])
+			num_limbs--;
+		return (BT)rem;
+	}
+
+	/* i *= 10^n, keeping the value by lowering the exponent. */
+	void shift_up(uintmax_t n) {
+		ET emin = std::numeric_limits<ET>::min();
+		if (exponent < emin + (ET)std::min<uintmax_t>(n, std::numeric_limits<ET>::max()))
+			throw std::overflow_error("Exponent out of range");
+		exponent -= (ET)n;
+		if (n % DIGITS)
+			mul_small(pow10(n % DIGITS));
+		std::size_t whole = n / DIGITS;
+		if (!whole)
+			return;
+		reserve(num_limbs + whole);
+		memmove(limbs + whole, limbs, num_limbs * sizeof(BT));
+		memset(limbs, 0, whole * sizeof(BT));
+		num_limbs += whole;
+	}
+
 	void normalize() {
-		while (blocks && !(blocks[num_blocks - 1] % 10)) {
-			divint(10);
-			exponent++;
-		}
-		while (num_blocks && blocks[0] == 0) {
-			if (num_blocks == 0) {
-				delete[] blocks;
-				blocks = nullptr;
+		while (num_limbs && !limbs[num_limbs - 1])
+			num_limbs--;
+		if (!num_limbs) {
+			set_zero();
+			return;
+		}
+		std::size_t whole = 0;
+		while (!limbs[whole])
+			whole++;
+		unsigned int digits = 0;
+		for (BT low = limbs[whole]; !(low % 10); low /= 10)
+			digits++;
+		uintmax_t shift = (uintmax_t)whole * DIGITS + digits;
+		if (!shift)
+			return;
+		if (exponent > 0 && (uintmax_t)(std::numeric_limits<ET>::max() - exponent) < shift)
+			throw std::overflow_error("Exponent out of range");
+		exponent += (ET)shift;
+		if (whole) {
+			num_limbs -= whole;
+			memmove(limbs, limbs + whole, num_limbs * sizeof(BT));
+		}
+		if (digits)
+			div_small(pow10(digits));
+	}
+
+	/* The number of decimal digits of i */
+	uintmax_t num_digits() const {
+		if (!num_limbs)
+			return 0;
+		unsigned int top = 0;
+		for (BT v = limbs[num_limbs - 1]; v; v /= 10)
+			top++;
+		return (uintmax_t)(num_limbs - 1) * DIGITS + top;
+	}
+
+	/* Compares the absolute values of nonzero numbers. */
+	static int cmp_abs(const decnumber<BT, ET> &a, const decnumber<BT, ET> &b) {
+		if (a.exponent == b.exponent)
+			return mag_cmp(a.limbs, a.num_limbs, b.limbs, b.num_limbs);
+		/* Compare the positions of the leading digits first */
+		long double lead_a = (long double)a.num_digits() + a.exponent;
+		long double lead_b = (long double)b.num_digits() + b.exponent;
+		if (lead_a != lead_b)
+			return lead_a < lead_b ? -1 : 1;
+		if (a.exponent > b.exponent) {
+			decnumber<BT, ET> tmp(a);
+			tmp.shift_up(a.exponent - b.exponent);
+			return mag_cmp(tmp.limbs, tmp.num_limbs, b.limbs, b.num_limbs);
+		}
+		decnumber<BT, ET> tmp(b);
+		tmp.shift_up(b.exponent - a.exponent);
+		return mag_cmp(a.limbs, a.num_limbs, tmp.limbs, tmp.num_limbs);
+	}
+
+	/* *this += other_sign * |other| */
+	void add(const decnumber<BT, ET> &other, int other_sign) {
+		if (!other.num_limbs)
+			return;
+		if (&other == this) {
+			if (other_sign == sign)
+				mul_small(2);
+			else
+				set_zero();
+			normalize();
+			return;
+		}
+		if (!num_limbs) {
+			assign(other);
+			sign = other_sign;
+			return;
+		}
+		decnumber<BT, ET> tmp(0);
+		const decnumber<BT, ET> *add = &other;
+		if (other.exponent < exponent) {
+			shift_up(exponent - other.exponent);
+		} else if (other.exponent > exponent) {
+			tmp.assign(other);
+			tmp.shift_up(other.exponent - exponent);
+			add = &tmp;
+		}
+		if (sign == other_sign) {
+			std::size_t n = std::max(num_limbs, add->num_limbs);
+			reserve(n + 1);
+			memset(limbs + num_limbs, 0, (n + 1 - num_limbs) * sizeof(BT));
+			mag_add_to(limbs, n + 1, add->limbs, add->num_limbs);
+			num_limbs = n + 1;
+		} else {
+			int c = mag_cmp(limbs, num_limbs, add->limbs, add->num_limbs);
+			if (c == 0) {
+				set_zero();
+				return;
+			} else if (c > 0) {
+				mag_sub_from(limbs, num_limbs, add->limbs, add->num_limbs);
 			} else {
-				BT *tmp = new BT[num_blocks - 1];
-				num_blocks--;
-				memcpy(tmp, blocks + 1, num_blocks*sizeof(BT));
-				delete[] blocks;
-				blocks = tmp;
+				reserve(add->num_limbs);
+				mag_rsub(limbs, num_limbs, add->limbs, add->num_limbs);
+				num_limbs = add->num_limbs;
+				sign = other_sign;
 			}
 		}
-		if (!blocks)
-			exponent = 0;
+		normalize();
 	}
 
-	void parse_string(std::string num) {
+	void parse_string(const std::string &num) {
 		std::size_t pos = 0;
 		bool past_point = false;
+		set_zero();
 		while (isspace(num[pos]))
 			pos++;
 		if (num[pos] == '-') {
 			sign = -1;
 			pos++;
 		} else {
-			sign = 1;
 			if (num[pos] == '+')
 				pos++;
 		}
 		while (num[pos] == '0')
 			pos++;
-		num_blocks = 0;
-		exponent = 0;
-		blocks = nullptr;
 
+		/* Validate and count the digits first, then fill the limbs
+		 * from the least significant digit up.
+		 */
+		std::size_t start = pos;
+		std::size_t digits = 0;
 		while (num[pos] != 0 && num[pos] != 'e' && num[pos] != 'E') {
 			if (num[pos] == '.') {
-				if (past_point) {
-					delete[] blocks;
+				if (past_point)
 					throw std::runtime_error("Multiple decimal points");
-				}
 				past_point = true;
 				pos++;
 				continue;
 			}
-			if (!isdigit(num[pos])) {
-				delete[] blocks;
+			if (!isdigit(num[pos]))
 				throw std::runtime_error("Unexpected character in number: '" + num + "'");
-			}
-			mul_unnorm(10);
-			if (num_blocks == 0) {
-				blocks = new BT[1];
-				blocks[0] = 0;
-				num_blocks = 1;
-			}
-			blocks[num_blocks - 1] += num[pos] - '0';
 			if (past_point) {
 				if (exponent == std::numeric_limits<ET>::min())
-				{
-					delete[] blocks;
 					throw std::overflow_error("Exponent out of range: " + num);
-				}
 				exponent--;
 			}
+			digits++;
 			pos++;
 		}
+		reserve(digits / DIGITS + 1);
+		num_limbs = 0;
+		BT limb = 0, mul = 1;
+		for (std::size_t i = pos; i-- > start;) {
+			if (num[i] == '.')
+				continue;
+			limb += (BT)(num[i] - '0') * mul;
+			mul *= 10;
+			if (mul == base) {
+				limbs[num_limbs++] = limb;
+				limb = 0;
+				mul = 1;
+			}
+		}
+		if (mul != 1)
+			limbs[num_limbs++] = limb;
+
 		if (!num[pos]) {
 			normalize();
 			return;
@@ -221,153 +517,107 @@ private:
 			pos++;
 		}
 		while (num[pos]) {
-			if (!isdigit(num[pos])) {
-				delete[] blocks;
+			if (!isdigit(num[pos]))
 				throw std::runtime_error("Unexpected character in number: " + num);
-			}
 			if (additional_exponent < ((emax - 9) / 10) - 9) {
 				additional_exponent *= 10;
 				additional_exponent += num[pos] - '0';
 			} else {
-				delete[] blocks;
 				throw std::overflow_error("Exponent out of range: " + num);
 			}
 			pos++;
 		}
-		additional_exponent *= exp_sign;
-		if (exponent <= 0 && sign == 1) {
-			exponent += additional_exponent;
-		} else if (exponent >= 0 && sign == -1) {
-			exponent -= additional_exponent;
-		} else if (sign == 1) {
-			if (exponent > emax - additional_exponent) {
-				delete[] blocks;
-				throw std::overflow_error("Exponent out of range: " + num);
-			}
-			exponent += additional_exponent;
-		} else { /* sign == -1 */
+		/* exponent <= 0, so only a negative exponent can overflow */
+		if (exp_sign < 0) {
 			ET emin = std::numeric_limits<ET>::min();
-			if (exponent < emin + additional_exponent) {
-				delete[] blocks;
+			if (exponent < emin + additional_exponent)
 				throw std::overflow_error("Exponent out of range: " + num);
-			}
 			exponent -= additional_exponent;
+		} else {
+			exponent += additional_exponent;
 		}
 		normalize();
 	}
+
+	void init() {
+		limbs = local;
+		capacity = INLINE_LIMBS;
+		set_zero();
+	}
 public:
 	//decnumber() :num_blocks(0), blocks(nullptr), sign(1), exponent(0)
 	//{}
 	decnumber() = delete;
 
 	decnumber(const decnumber<BT, ET> &other) {
-		num_blocks = other.num_blocks;
-		if (num_blocks) {
-			blocks = new BT[num_blocks];
-			memcpy(blocks, other.blocks, num_blocks * sizeof(*blocks));
-		} else {
-			blocks = nullptr;
-		}
-		exponent = other.exponent;
-		sign = other.sign;
+		init();
+		assign(other);
 	}
 
-	decnumber(decnumber<BT, ET> &&other)
-		: num_blocks(other.num_blocks),
-		  blocks(other.blocks),
-		  exponent(other.exponent),
-		  sign(other.sign)
-	{
-		other.blocks = nullptr;
+	decnumber(decnumber<BT, ET> &&other) {
+		init();
+		take(other);
 	}
 
-	decnumber(std::string num) {
-		parse_string(num);
+	decnumber(const std::string &num) {
+		init();
+		try {
+			parse_string(num);
+		} catch (...) {
+			if (on_heap())
+				delete[] limbs;
+			throw;
+		}
 	}
 
 	decnumber(uintmax_t i) {
-		blocks = nullptr;
+		init();
 		*this = i;
 	}
 
 	decnumber(intmax_t i) {
-		blocks = nullptr;
+		init();
 		*this = i;
 	}
 
 	decnumber(int i) {
-		blocks = nullptr;
+		init();
 		*this = (intmax_t)i;
 	}
 
 	decnumber(long double v) {
-		blocks = nullptr;
+		init();
 		*this = v;
 	}
 
 	decnumber(double v) {
-		blocks = nullptr;
+		init();
 		*this = (long double)v;
 	}
 
 	~decnumber() {
-		delete[] blocks;
+		if (on_heap())
+			delete[] limbs;
 	}
 
 	decnumber<BT, ET>& operator=(const decnumber<BT, ET> &other) {
-		if (this != &other) {
-			delete[] blocks;
-			num_blocks = other.num_blocks;
-			if (num_blocks) {
-				blocks = new BT[num_blocks];
-				memcpy(blocks, other.blocks, num_blocks * sizeof(BT));
-			} else {
-				blocks = nullptr;
-			}
-			exponent = other.exponent;
-			sign = other.sign;
-		}
+		if (this != &other)
+			assign(other);
 		return *this;
 	}
 
 	decnumber<BT, ET>& operator=(decnumber<BT, ET> &&other) {
-		if (this != &other) {
-			delete[] blocks;
-			blocks = other.blocks;
-			other.blocks = nullptr;
-			num_blocks = other.num_blocks;
-			exponent = other.exponent;
-			sign = other.sign;
-		}
+		if (this != &other)
+			take(other);
 		return *this;
 	}
 
 	decnumber<BT, ET>& operator=(uintmax_t i) {
-		delete[] blocks;
-		blocks = nullptr;
-		num_blocks = 0;
-		sign = 1;
-		exponent = 0;
-		uintmax_t rev = 0, bits = 0;
-		if (i == 0)
-			return *this;
+		set_zero();
 		while (i) {
-			rev <<= 1;
-			if (i % 2)
-				rev++;
-			i /= 2;
-			bits++;
-		}
-		while (bits--) {
-			mul_unnorm(2);
-			if (num_blocks == 0) {
-				blocks = new BT[1];
-				blocks[0] = 0;
-				num_blocks = 1;
-			}
-			if (rev % 2)
-				blocks[num_blocks - 1]++;
-			rev /= 2;
+			reserve(num_limbs + 1);
+			limbs[num_limbs++] = (BT)(i % base);
+			i /= base;
 		}
 		normalize();
 		return *this;
@@ -384,223 +634,68 @@ public:
 	}
 
 	decnumber<BT, ET>& operator=(long double v) {
-		long double frac, ipart;
-		delete[] blocks;
-		blocks = nullptr;
-		frac = modfl(v, &ipart);
-		blocks = nullptr;
-		num_blocks = 0;
-		sign = 1;
-		exponent = 0;
-		if (v < 0) {
-			sign = -1;
-			v = -v;
-		}
-		while (ipart) {
-			mul_unnorm(2);
-			if (num_blocks == 0) {
-				blocks = new BT[1];
-				blocks[0] = 0;
-				num_blocks = 1;
-			}
-			frac = modfl(ipart / 2, &ipart);
-			if (frac)
-				blocks[num_blocks - 1]++;
+		/* Note: this is only exact for base-2 floats (i.e.,
+		 * IEEE-754): v = m*2^e with an integer m, and for negative
+		 * e that is m*5^-e*10^e.
+		 */
+		if (!std::isfinite(v))
+			throw std::invalid_argument("Cannot represent non-finite number");
+		set_zero();
+		if (v == 0)
+			return *this;
+		bool negative = v < 0;
+		int e;
+		long double frac = frexpl(negative ? -v : v, &e);
+		const unsigned int bits = bits_per_step();
+		while (frac != 0) {
+			long double ipart;
+			frac = modfl(ldexpl(frac, bits), &ipart);
+			mul_small((BT)1 << bits);
+			add_small((BT)ipart);
+			e -= bits;
+		}
+		if (e >= 0) {
+			for (; e >= (int)bits; e -= bits)
+				mul_small((BT)1 << bits);
+			mul_small((BT)1 << e);
+		} else {
+			const unsigned int fives = fives_per_step();
+			exponent = e;
+			for (e = -e; e >= (int)fives; e -= fives)
+				mul_small(pow5(fives));
+			mul_small(pow5(e));
 		}
 		normalize();
-		if (frac) {
-			/* Note: this is only guaranteed to terminate
-			 * (and be exact) in base-2 floats (i.e.,
-			 * IEEE-754)
-			 */
-			decnumber<BT, ET> f(5), h(5);
-			f.exponent = -1;
-			h.exponent = -1;
-			while (frac) {
-				if (frac >= 0.5) {
-					*this += f;
-					frac -= 0.5;
-				}
-				frac *= 2;
-				f *= h;
-			}
-		}
+		if (negative)
+			sign = -1;
 		return *this;
 	}
 
 	decnumber<BT, ET> operator+(const decnumber<BT, ET> &other) const {
-		if (other.num_blocks == 0)
-			return *this;
-		if (num_blocks == 0)
-			return other;
 		decnumber<BT, ET> ret(*this);
-		ret += other;
+		ret.add(other, other.sign);
 		return ret;
 	}
 
-	decnumber<BT, ET> operator+=(const decnumber<BT, ET> &other) {
-		if (other.num_blocks == 0)
-			return *this;
-		if (num_blocks == 0) {
-			*this = other;
-			return *this;
-		}
-		if (other.sign == -1) {
-			decnumber<BT, ET> ret(other);
-			ret.sign *= -1;
-			*this = *this - ret;
-			return *this;
-		}
-
-		if (sign == -1) {
-			sign = 1;
-			*this = other - *this;
-			sign *= -1;
-			return *this;
-		}
-		decnumber<BT, ET> tmp(0);
-		const decnumber<BT, ET> *add;
-		if (other.exponent <= exponent) {
-			add = &other;
-			while (add->exponent < exponent) {
-				mul_unnorm(10);
-				exponent--;
-			}
-		} else {
-			tmp = other;
-			while (exponent < tmp.exponent) {
-				tmp.mul_unnorm(10);
-				tmp.exponent--;
-			}
-			add = &tmp;
-		}
-		BT carry = 0;
-		if (num_blocks < add->num_blocks) {
-			size_t d = add->num_blocks - num_blocks;
-			BT *tmp = new BT[add->num_blocks];
-			memcpy(tmp + d, blocks, num_blocks * sizeof(*tmp));
-			delete[] blocks;
-			blocks = tmp;
-			while (d--)
-				blocks[d] = 0;
-			num_blocks = add->num_blocks;
-		}
-		size_t d = num_blocks - add->num_blocks;
-		for (std::size_t i = num_blocks - 1; i != SIZE_MAX; i--) {
-			if (blocks[i] == (base - 1) && carry) {
-				blocks[i] = 0;
-				carry = 1;
-			} else {
-				blocks[i] += carry;
-				carry = 0;
-			}
-			if (i >= d) {
-				if (blocks[i] > base - add->blocks[i - d]) {
-					carry = 1;
-					blocks[i] -= base - add->blocks[i - d];
-				} else {
-					carry = 0;
-					blocks[i] += add->blocks[i - d];
-				}
-			}
-		}
-		if (carry) {
-			if (num_blocks == SIZE_MAX)
-				throw std::overflow_error("Addition result too large");
-			BT *bl;
-			bl = new BT[num_blocks + 1];
-			bl[0] = carry;
-			memcpy(bl+1, blocks, num_blocks * sizeof(*bl));
-			num_blocks++;
-			delete[] blocks;
-			blocks = bl;
-		}
-		normalize();
+	decnumber<BT, ET>& operator+=(const decnumber<BT, ET> &other) {
+		add(other, other.sign);
 		return *this;
 	}
 
 	decnumber<BT, ET> operator-(const decnumber<BT, ET> &other) const {
-		if (other.num_blocks == 0)
-			return *this;
-		if (num_blocks == 0) {
-			decnumber<BT, ET> ret(other);
-			ret.sign *= -1;
-			return ret;
-		}
-		if (other.sign == -1) {
-			decnumber<BT, ET> ret(other);
-			ret.sign *= -1;
-			return *this + ret;
-		}
-
 		decnumber<BT, ET> ret(*this);
-		if (sign == -1) {
-			ret.sign = 1;
-			ret = ret + other;
-			ret.sign *= -1;
-			return ret;
-		}
-		decnumber<BT, ET> tmp(0);
-		const decnumber<BT, ET> *sub;
-		if (other.exponent <= ret.exponent) {
-			sub = &other;
-			while (sub->exponent < ret.exponent) {
-				ret.mul_unnorm(10);
-				ret.exponent--;
-			}
-		} else {
-			tmp = other;
-			while (exponent < tmp.exponent) {
-				tmp.mul_unnorm(10);
-				tmp.exponent--;
-			}
-			sub = &tmp;
-		}
-		if (ret.num_blocks < sub->num_blocks) {
-			size_t d = sub->num_blocks - ret.num_blocks;
-			BT *tmp = new BT[sub->num_blocks];
-			memcpy(tmp + d, ret.blocks, ret.num_blocks * sizeof(*tmp));
-			delete[] ret.blocks;
-			ret.blocks = tmp;
-			while (d--)
-				ret.blocks[d] = 0;
-			ret.num_blocks = sub->num_blocks;
-		}
-		size_t d = ret.num_blocks - sub->num_blocks;
-		BT carry = 0;
-		for (std::size_t i = ret.num_blocks - 1; i != SIZE_MAX; i--) {
-			if (ret.blocks[i] < carry) {
-				ret.blocks[i] += base - carry;
-				carry = 1;
-			} else {
-				ret.blocks[i] -= carry;
-				carry = 0;
-			}
-			if (i >= d) {
-				if (ret.blocks[i] < sub->blocks[i - d]) {
-					carry += 1;
-					ret.blocks[i] += base - sub->blocks[i - d];
-				} else {
-					ret.blocks[i] -= sub->blocks[i - d];
-				}
-			}
-		}
-		if (carry) {
-			ret = other - *this;
-			ret.sign = -1;
-		} else {
-			ret.normalize();
-		}
+		ret.add(other, -other.sign);
 		return ret;
 	}
 
+	decnumber<BT, ET>& operator-=(const decnumber<BT, ET> &other) {
+		add(other, -other.sign);
+		return *this;
+	}
+
 	decnumber<BT, ET>& operator*=(const decnumber<BT, ET> &other) {
-		if (other.num_blocks == 0 || num_blocks == 0) {
-			num_blocks = 0;
-			exponent = 0;
-			sign = 1;
-			delete[] blocks;
-			blocks = nullptr;
+		if (other.num_limbs == 0 || num_limbs == 0) {
+			set_zero();
 			return *this;
 		}
 		int target_sign = 1;
@@ -617,35 +712,32 @@ public:
 		}
 		target_exponent += exponent;
 
-		decnumber<BT, ET> multiplier(0);
-		multiplier.blocks = blocks;
-		multiplier.exponent = 0;
-		multiplier.num_blocks = num_blocks;
-		num_blocks = 0;
-		blocks = nullptr;
-		exponent = 0;
-		sign = 1;
-
-		decnumber<BT, ET> multiplicand(other);
-		multiplicand.exponent = 0;
-		std::size_t i;
-		for (i = multiplicand.num_blocks - 1; i != SIZE_MAX; i--) {
-			decnumber<BT, ET> tmp(multiplier);
-			tmp.mul_unnorm(multiplicand.blocks[i]);
-			tmp.normalize();
-			*this += tmp;
-			multiplier.mul_unnorm(base);
-			multiplier.normalize();
+		if (other.num_limbs == 1) {
+			mul_small(other.limbs[0]);
+		} else {
+			std::size_t n = num_limbs + other.num_limbs;
+			if (n <= 2 * INLINE_LIMBS) {
+				BT tmp[2 * INLINE_LIMBS];
+				mag_mul(tmp, limbs, num_limbs, other.limbs, other.num_limbs);
+				reserve(n);
+				memcpy(limbs, tmp, n * sizeof(BT));
+			} else {
+				BT *tmp = new BT[n];
+				mag_mul(tmp, limbs, num_limbs, other.limbs, other.num_limbs);
+				if (on_heap())
+					delete[] limbs;
+				limbs = tmp;
+				capacity = n;
+			}
+			num_limbs = n;
 		}
 		sign = target_sign;
-		exponent += target_exponent;
+		exponent = target_exponent;
 		normalize();
 		return *this;
 	}
 
 	decnumber<BT, ET> operator*(const decnumber<BT, ET> &other) const {
-		if (other.num_blocks == 0 || num_blocks == 0)
-			return decnumber<BT, ET>(0);
 		decnumber<BT, ET> ret(*this);
 		ret *= other;
 		return ret;
@@ -654,15 +746,13 @@ public:
 	bool operator==(const decnumber<BT, ET> &other) const {
 		if (&other == this)
 			return true;
-		if (other.num_blocks == 0 && num_blocks == 0)
-			return true;
-		if (other.num_blocks != num_blocks)
+		if (other.num_limbs != num_limbs)
 			return false;
 		if (other.sign != sign)
 			return false;
 		if (other.exponent != exponent)
 			return false;
-		return !memcmp(other.blocks, blocks, num_blocks * sizeof(BT));
+		return !memcmp(other.limbs, limbs, num_limbs * sizeof(BT));
 	}
 
 	bool operator!=(const decnumber<BT, ET> &other) const {
@@ -672,44 +762,38 @@ public:
 	bool operator<(const decnumber<BT, ET> &other) const {
 		if (&other == this)
 			return false;
-		if (other.num_blocks == 0 && num_blocks == 0)
+		if (other.num_limbs == 0 && num_limbs == 0)
 			return false;
-		if (num_blocks == 0)
+		if (num_limbs == 0)
 			return other.sign > 0;
-		if (other.num_blocks == 0)
+		if (other.num_limbs == 0)
 			return sign < 0;
 		if (other.sign != sign)
 			return sign < other.sign;
-		if (other.exponent == exponent) {
-			if (other.num_blocks != num_blocks)
-				return num_blocks < other.num_blocks;
-			for (size_t i = 0; i < num_blocks; i++)
-				if (blocks[i] != other.blocks[i])
-					return blocks[i] < other.blocks[i];
-		}
-		decnumber<BT, ET> delta = (*this) - other;
-		if (delta.sign < 0)
-			return true;
-		return false;
+		return cmp_abs(*this, other) * sign < 0;
 	}
 
 	bool operator<=(const decnumber<BT, ET> &other) const {
-		return (*this == other) || (*this < other);
+		return !(other < *this);
 	}
 
 	bool operator>(const decnumber<BT, ET> &other) const {
-		return !(*this <= other);
+		return other < *this;
 	}
 
 	std::string str() const {
-		if (!num_blocks)
+		if (!num_limbs)
 			return "0";
-		std::string ret;
-		decnumber<BT, ET> num(*this);
-		while (num.num_blocks) {
-			BT digit = num.blocks[num.num_blocks - 1] % 10;
-			ret = (char)('0' + digit) + ret;
-			num.divint(10);
+		std::string ret = std::to_string(limbs[num_limbs - 1]);
+		ret.reserve(num_limbs * DIGITS + 32);
+		for (std::size_t i = num_limbs - 1; i-- > 0;) {
+			BT limb = limbs[i];
+			std::size_t end = ret.size() + DIGITS;
+			ret.resize(end);
+			for (unsigned int d = 0; d < DIGITS; d++) {
+				ret[--end] = (char)('0' + limb % 10);
+				limb /= 10;
+			}
 		}
 		if (exponent == 1)
 			ret += std::string("0");
@@ -743,14 +827,8 @@ public:
 				dot_pos = 1;
 				neg_exponent -= digits - 1;
 			}
-			if (digits > 1) {
-				ret += ".";
-				while (digits > dot_pos) {
-					ret[digits] = ret[digits - 1];
-					ret[digits - 1] = '.';
-					digits--;
-				}
-			}
+			if (digits > 1)
+				ret.insert(dot_pos, 1, '.');
 			if (neg_exponent)
 				ret += std::string("e-") + std::to_string(neg_exponent);
 		}
@@ -765,39 +843,20 @@ public:
 	}
 
 	bool is_zero() const {
-		return num_blocks == 0;
+		return num_limbs == 0;
 	}
 
+	/* Divides i by num, truncating, for num dividing the internal
+	 * base. The exponent is unchanged.
+	 */
 	void divint(BT num) {
-		if ((num < 0 && num < -base) || num > base)
+		if (num > base)
 			throw std::invalid_argument("Division by numbers larger than the internal base is currently not supported.");
-		if (base % num)
+		if (num == 0 || base % num)
 			throw std::invalid_argument("Divisor currently must be multiple of internal base.");
-		BT carry = 0;
-		if (num < 0) {
-			sign = -sign;
-			num = -num;
-		}
-		BT carry_mul = base / num;
-		for (std::size_t i = 0; i < num_blocks; i++) {
-			BT new_carry;
-			new_carry = blocks[i] % num;
-			blocks[i] /= num;
-			blocks[i] += carry * carry_mul;
-			carry = new_carry;
-		}
-		if (!num_blocks || blocks[0])
-			return;
-		num_blocks--;
-		if (!num_blocks) {
-			delete[] blocks;
-			blocks = nullptr;
-		} else {
-			BT *new_blocks = new BT[num_blocks];
-			memcpy(new_blocks, blocks + 1, num_blocks * sizeof(BT));
-			delete[] blocks;
-			blocks = new_blocks;
-		}
+		div_small(num);
+		if (!num_limbs)
+			set_zero();
 	}
 };
 
@@ -16,3 +16,4 @@ const std::string DFT2LNT::BCGSUBROOT ("/share/dft2lnt/bcgnodes");
 const std::string DFT2LNT::TESTSUBROOT("/share/dft2lnt/tests");
 
 const std::string DFT2LNT::AUT_CACHE_DIR ("/autnodes");
+const std::string DFT2LNT::RESULT_CACHE_DIR ("/results");
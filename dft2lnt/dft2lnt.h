@@ -20,6 +20,7 @@ public:
 	static const std::string BCGSUBROOT;
 	static const std::string TESTSUBROOT;
 	static const std::string AUT_CACHE_DIR;
+	static const std::string RESULT_CACHE_DIR;
 };
 
 #endif // DFT2LNT_H
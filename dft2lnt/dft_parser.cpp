@@ -71,6 +71,9 @@ DFT::AST::ASTNodes* Parser::parse() {
 	// Free the lexer
 	yylex_destroy(scanner);
 	
+	// Allow a new parser to become active in this process
+	pp = NULL;
+	
 	return result_nodes;//new Program(ASTroot);
 }
 
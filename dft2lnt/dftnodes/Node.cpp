@@ -12,7 +12,6 @@
 #include "Gate.h"
 #include "GateFDEP.h"
 #include <string>
-#include <unordered_set>
 
 namespace DFT {
 namespace Nodes {
@@ -52,44 +51,5 @@ namespace Nodes {
 		return false;
 	}
 
-	bool Node::isIndependentSubtree(void) const {
-		if (parents.size() > 1)
-			return false;
-		if (parents.size() == 0)
-			return true;
-		std::unordered_set<const Node *> to_explore, subtree;
-		to_explore.insert(this);
-		while (to_explore.size() != 0) {
-			const Node *current = *to_explore.begin();
-			to_explore.erase(current);
-			subtree.insert(current);
-			if (current->isGate()) {
-				const Gate *g = static_cast<const Gate *>(current);
-				for (Node *c : g->getChildren()) {
-					if (subtree.find(c) == subtree.end())
-						to_explore.insert(c);
-				}
-				if (g->matchesType(DFT::Nodes::NodeType::GateFDEPType)) {
-					const GateFDEP *f = static_cast<const GateFDEP *>(g);
-					for (Node *c : f->getDependers()) {
-						if (subtree.find(c) == subtree.end())
-							to_explore.insert(c);
-					}
-				}
-			}
-			if (current == this)
-				continue;
-			for (Node *par : current->parents) {
-				if (subtree.find(par) == subtree.end())
-					to_explore.insert(par);
-			}
-			for (Node *par : current->triggers) {
-				if (subtree.find(par) == subtree.end())
-					to_explore.insert(par);
-			}
-		}
-		Node *parent = static_cast<Node *>(parents[0]);
-		return subtree.find(parent) == subtree.end();
-	}
 }
 }
@@ -157,6 +157,7 @@ private:
 	NodeType type;
 	bool repairable;
 	bool alwaysActive;
+	bool independent;
 	
 	/// List of parents, instances are freed by DFTree instance.
 	std::vector<Nodes::Gate*> parents;
@@ -166,22 +167,25 @@ public:
 	Node(Location location, NodeType type):
 		location(location),
 		type(type),
+		repairable(false),
 		alwaysActive(false),
-		repairable(false){
+		independent(false){
 	}
 	Node(Location location, std::string name, NodeType type):
 		location(location),
 		name(name),
 		type(type),
+		repairable(false),
 		alwaysActive(false),
-		repairable(false){
+		independent(false){
 	}
 	Node(Location location, std::string name, NodeType type, bool repairable):
 		location(location),
 		name(name),
 		type(type),
+		repairable(repairable),
 		alwaysActive(false),
-		repairable(repairable){
+		independent(false){
 	}
 	Node() {
 	}
@@ -309,13 +313,17 @@ public:
 	bool hasRepairModule(void) const;
 
 	/* A node is an independent subtree if:
-	 * - It has exactly one parent.
-	 * - The set of nodes that is reachable (via parent/child
-	 *   relationships) from the node without visiting its parent is
-	 *   disjoint from the set of nodes that is reachable from the
-	 *   parent without visiting this node.
+	 * - It has at most one parent.
+	 * - The set of nodes that is reachable (via parent/child and
+	 *   FDEP/depender relationships) from the node without visiting
+	 *   its parent is disjoint from the set of nodes that is
+	 *   reachable from the parent without visiting this node.
+	 * Only valid after DFTree::detectModules().
 	 */
-	bool isIndependentSubtree(void) const;
+	bool isIndependentSubtree(void) const { return independent; }
+	void setIndependentSubtree(bool independent) {
+		this->independent = independent;
+	}
 };
 
 } // Namespace: Nodes
@@ -0,0 +1,213 @@
+/*
+ * interval.h
+ *
+ * Part of dft2lnt library - a library containing read/write operations for DFT
+ * files in Galileo format and translating DFT specifications into Lotos NT.
+ */
+
+#ifndef INTERVAL_H
+#define INTERVAL_H
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "decnumber.h"
+
+namespace DFT {
+
+/**
+ * A closed interval [lower, upper] of numbers of type N, bounding an
+ * unknown real number. The operations round outwards, so the result
+ * contains the exact result of the operation for all operands in the
+ * operand intervals.
+ *
+ * With N = decnumber<>, the operations are exact. With N = double,
+ * each bound is rounded in its own direction: the error of the
+ * hardware's round-to-nearest result is computed exactly (by TwoSum,
+ * or by a fused multiply-add for products), and the bound is moved one
+ * ulp outwards if the error points that way. This needs no change of
+ * the rounding mode, and no allocation.
+ */
+template<class N>
+class Interval {
+private:
+	N lo, hi;
+
+	static N addDown(const N &a, const N &b) { return a + b; }
+	static N addUp(const N &a, const N &b) { return a + b; }
+	static N mulDown(const N &a, const N &b) { return a * b; }
+	static N mulUp(const N &a, const N &b) { return a * b; }
+
+public:
+	Interval(const N &v): lo(v), hi(v) {}
+	Interval(const N &lower, const N &upper): lo(lower), hi(upper) {}
+
+	const N &lower() const { return lo; }
+	const N &upper() const { return hi; }
+
+	Interval<N> operator+(const Interval<N> &other) const {
+		return Interval<N>(addDown(lo, other.lo), addUp(hi, other.hi));
+	}
+
+	Interval<N> operator-(const Interval<N> &other) const {
+		return Interval<N>(addDown(lo, N(0) - other.hi),
+		                   addUp(hi, N(0) - other.lo));
+	}
+
+	Interval<N> operator*(const Interval<N> &other) const {
+		const N zero(0);
+		if (!(lo < zero) && !(other.lo < zero)) {
+			return Interval<N>(mulDown(lo, other.lo),
+			                   mulUp(hi, other.hi));
+		}
+		N retLo = mulDown(lo, other.lo), retHi = mulUp(lo, other.lo);
+		for (int i = 1; i < 4; i++) {
+			const N &a = (i & 2) ? hi : lo;
+			const N &b = (i & 1) ? other.hi : other.lo;
+			N down = mulDown(a, b), up = mulUp(a, b);
+			if (down < retLo)
+				retLo = down;
+			if (retHi < up)
+				retHi = up;
+		}
+		return Interval<N>(retLo, retHi);
+	}
+
+	Interval<N> &operator+=(const Interval<N> &other) {
+		return *this = *this + other;
+	}
+
+	Interval<N> &operator*=(const Interval<N> &other) {
+		return *this = *this * other;
+	}
+
+	/**
+	 * Returns 1 - this, e.g. the probability of the complement of an
+	 * event with this probability.
+	 */
+	Interval<N> complement() const {
+		const N one(1);
+		return Interval<N>(addDown(one, N(0) - hi), addUp(one, N(0) - lo));
+	}
+};
+
+/* Error-free transformations: r + err is exactly a + b (TwoSum), or
+ * exactly a * b. The product's error is only exact above the range of
+ * subnormal numbers, so it is treated as nonzero below that.
+ */
+inline double roundedSum(double a, double b, double &err)
+{
+	double s = a + b;
+	double bv = s - a;
+	err = (a - (s - bv)) + (b - bv);
+	return s;
+}
+
+inline double roundedProduct(double a, double b, double &err)
+{
+	double p = a * b;
+	const double tiny = std::numeric_limits<double>::min()
+	                    / std::numeric_limits<double>::epsilon();
+	if (std::fabs(p) < tiny && a != 0 && b != 0)
+		err = std::numeric_limits<double>::quiet_NaN();
+	else
+		err = std::fma(a, b, -p);
+	return p;
+}
+
+/* NaN errors are unknown, and move the result either way. */
+inline double roundedDown(double r, double err)
+{
+	if (std::isinf(r))
+		return r;
+	if (err < 0 || err != err)
+		return std::nextafter(r, -std::numeric_limits<double>::infinity());
+	return r;
+}
+
+inline double roundedUp(double r, double err)
+{
+	if (std::isinf(r))
+		return r;
+	if (err > 0 || err != err)
+		return std::nextafter(r, std::numeric_limits<double>::infinity());
+	return r;
+}
+
+template<>
+inline double Interval<double>::addDown(const double &a, const double &b)
+{
+	double err, s = roundedSum(a, b, err);
+	return roundedDown(s, err);
+}
+
+template<>
+inline double Interval<double>::addUp(const double &a, const double &b)
+{
+	double err, s = roundedSum(a, b, err);
+	return roundedUp(s, err);
+}
+
+template<>
+inline double Interval<double>::mulDown(const double &a, const double &b)
+{
+	double err, p = roundedProduct(a, b, err);
+	return roundedDown(p, err);
+}
+
+template<>
+inline double Interval<double>::mulUp(const double &a, const double &b)
+{
+	double err, p = roundedProduct(a, b, err);
+	return roundedUp(p, err);
+}
+
+/**
+ * Returns the largest double not above v (or above it, if roundUp).
+ */
+inline double roundToDouble(const decnumber<> &v, bool roundUp)
+{
+	double ret;
+	try {
+		ret = (double)v;
+	} catch (std::out_of_range &) {
+		/* Beyond the range of doubles, or below the normal ones */
+		bool negative = v < decnumber<>(0);
+		if (decnumber<>(-1) < v && v < decnumber<>(1)) {
+			double min = std::numeric_limits<double>::min();
+			if (negative)
+				return roundUp ? 0.0 : -min;
+			return roundUp ? min : 0.0;
+		}
+		double max = std::numeric_limits<double>::max();
+		double inf = std::numeric_limits<double>::infinity();
+		if (negative)
+			return roundUp ? -max : -inf;
+		return roundUp ? inf : max;
+	}
+	/* The conversion is to the nearest double, so at most one step
+	 * away from the bound.
+	 */
+	decnumber<> exact(ret);
+	if (roundUp && exact < v)
+		return std::nextafter(ret, std::numeric_limits<double>::infinity());
+	if (!roundUp && v < exact)
+		return std::nextafter(ret, -std::numeric_limits<double>::infinity());
+	return ret;
+}
+
+/**
+ * Returns the smallest interval of doubles containing [lower, upper].
+ */
+inline Interval<double> toDoubleInterval(const decnumber<> &lower,
+                                       const decnumber<> &upper)
+{
+	return Interval<double>(roundToDouble(lower, false),
+	                        roundToDouble(upper, true));
+}
+
+} // Namespace: DFT
+
+#endif
@@ -0,0 +1,49 @@
+/*
+ * sha256.h
+ *
+ * Part of dft2lnt library - a library containing read/write operations for DFT
+ * files in Galileo format and translating DFT specifications into Lotos NT.
+ */
+
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+/**
+ * Incremental SHA-256 (FIPS 180-4), used to derive content-addressed
+ * names for cached files.
+ */
+class SHA256 {
+private:
+	uint32_t state[8];
+	unsigned char buffer[64];
+	size_t buffered;
+	uint64_t length;
+
+	void compress(const unsigned char *block);
+
+public:
+	SHA256();
+
+	/**
+	 * Appends the specified bytes to the hashed message.
+	 */
+	void update(const void *data, size_t len);
+	void update(const std::string& data) { update(data.data(), data.size()); }
+
+	/**
+	 * Finishes the hash and returns it as 64 lowercase hexadecimal
+	 * digits. The object must not be updated afterwards.
+	 */
+	std::string hexDigest();
+
+	/**
+	 * Returns the hexadecimal SHA-256 hash of the specified string.
+	 */
+	static std::string hash(const std::string& data);
+};
+
+#endif
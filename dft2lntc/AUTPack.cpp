@@ -0,0 +1,330 @@
+#include "AUTPack.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#ifndef WIN32
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static uint64_t pageSize() {
+	return sysconf(_SC_PAGESIZE);
+}
+
+static int64_t fileSize(int fd) {
+	struct stat st;
+	if (fstat(fd, &st))
+		return -1;
+	return st.st_size;
+}
+
+static void *mapFile(int fd, uint64_t offset, size_t length) {
+	void *ret = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, offset);
+	return ret == MAP_FAILED ? NULL : ret;
+}
+
+static void unmapFile(void *map, size_t length) {
+	munmap(map, length);
+}
+
+static int writeAt(int fd, uint64_t offset, const char *data, size_t length) {
+	while (length) {
+		ssize_t written = pwrite(fd, data, length, offset);
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		data += written;
+		offset += written;
+		length -= written;
+	}
+	return 0;
+}
+
+static int truncateFile(int fd, uint64_t length) {
+	return ftruncate(fd, length);
+}
+
+static int lockFile(int fd, bool exclusive) {
+	int ret;
+	do {
+		ret = flock(fd, exclusive ? LOCK_EX : LOCK_SH);
+	} while (ret && errno == EINTR);
+	return ret;
+}
+
+static void unlockFile(int fd) {
+	flock(fd, LOCK_UN);
+}
+#else /* WIN32: the pack is read into memory, and not locked. */
+#include <io.h>
+
+static uint64_t pageSize() {
+	return 1;
+}
+
+static int64_t fileSize(int fd) {
+	return _filelengthi64(fd);
+}
+
+static void *mapFile(int fd, uint64_t offset, size_t length) {
+	char *ret = (char *)malloc(length);
+	if (!ret || _lseeki64(fd, offset, SEEK_SET) < 0) {
+		free(ret);
+		return NULL;
+	}
+	for (size_t done = 0; done < length; ) {
+		int n = _read(fd, ret + done, (unsigned int)(length - done));
+		if (n <= 0) {
+			free(ret);
+			return NULL;
+		}
+		done += n;
+	}
+	return ret;
+}
+
+static void unmapFile(void *map, size_t length) {
+	free(map);
+}
+
+static int writeAt(int fd, uint64_t offset, const char *data, size_t length) {
+	if (_lseeki64(fd, offset, SEEK_SET) < 0)
+		return -1;
+	while (length) {
+		int n = _write(fd, data, (unsigned int)length);
+		if (n <= 0)
+			return -1;
+		data += n;
+		length -= n;
+	}
+	return 0;
+}
+
+static int truncateFile(int fd, uint64_t length) {
+	return _chsize_s(fd, length);
+}
+
+static int lockFile(int fd, bool exclusive) {
+	return 0;
+}
+
+static void unlockFile(int fd) {
+}
+#endif
+
+namespace DFT {
+
+static const char FILE_MAGIC[8] = {'A', 'U', 'T', 'P', 'A', 'C', 'K', '1'};
+static const uint32_t RECORD_MAGIC = 0x52545541;
+
+/* Followed by the name, the contents, and padding to 8 bytes. */
+struct RecordHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t nameSize;
+	uint32_t reserved;
+	uint64_t dataSize;
+	uint64_t checksum;
+};
+
+/* FNV-1a, a word at a time. */
+static uint64_t checksum(unsigned int version, const char *name,
+                         size_t nameSize, const char *data, size_t size)
+{
+	const uint64_t PRIME = UINT64_C(1099511628211);
+	uint64_t h = UINT64_C(14695981039346656037) ^ version;
+	for (const char *p : {name, data}) {
+		size_t n = p == name ? nameSize : size;
+		for (; n >= 8; n -= 8, p += 8) {
+			uint64_t w;
+			memcpy(&w, p, 8);
+			h = (h ^ w) * PRIME;
+		}
+		for (; n; n--, p++)
+			h = (h ^ (unsigned char)*p) * PRIME;
+		h = (h ^ 0xff) * PRIME;
+	}
+	return h;
+}
+
+AUTPack::AUTPack(const std::string &filename, unsigned int version,
+                 CompilerContext *cc)
+	:filename(filename), version(version), cc(cc), fd(-1), end(0)
+{ }
+
+AUTPack::~AUTPack() {
+	for (auto &map : maps)
+		unmapFile(map.first, map.second);
+	if (fd >= 0)
+		close(fd);
+}
+
+int AUTPack::open() {
+#ifndef WIN32
+	fd = ::open(filename.c_str(), O_RDWR | O_CREAT, 0666);
+#else
+	fd = _open(filename.c_str(), _O_RDWR | _O_CREAT | _O_BINARY,
+	           _S_IREAD | _S_IWRITE);
+#endif
+	if (fd < 0) {
+		cc->reportError("Error opening " + filename + ": " + strerror(errno));
+		return -1;
+	}
+	if (lock(false))
+		return -1;
+	int ret = refresh();
+	unlock();
+	return ret;
+}
+
+int AUTPack::lock(bool exclusive) {
+	if (lockFile(fd, exclusive)) {
+		cc->reportError("Error locking " + filename + ": " + strerror(errno));
+		return -1;
+	}
+	return 0;
+}
+
+void AUTPack::unlock() {
+	unlockFile(fd);
+}
+
+/* Maps and indexes the records appended since the last call. Must be
+ * called with the pack locked.
+ */
+int AUTPack::refresh() {
+	int64_t fsize = fileSize(fd);
+	if (fsize < 0) {
+		cc->reportError("Error reading " + filename + ": " + strerror(errno));
+		return -1;
+	}
+	uint64_t size = fsize;
+	if (size <= end)
+		return 0;
+	uint64_t start = end - end % pageSize();
+	size_t length = size - start;
+	const char *map = (const char *)mapFile(fd, start, length);
+	if (!map) {
+		cc->reportError("Error mapping " + filename + ": " + strerror(errno));
+		return -1;
+	}
+	maps.emplace_back((void *)map, length);
+
+	if (end == 0) {
+		if (length < sizeof(FILE_MAGIC)
+		    || memcmp(map, FILE_MAGIC, sizeof(FILE_MAGIC)))
+		{
+			return 0;
+		}
+		end = sizeof(FILE_MAGIC);
+	}
+	RecordHeader header;
+	while (size - end >= sizeof(header)) {
+		const char *record = map + (end - start);
+		memcpy(&header, record, sizeof(header));
+		if (header.magic != RECORD_MAGIC
+		    || header.dataSize > size)
+		{
+			break;
+		}
+		uint64_t total = sizeof(header) + header.nameSize + header.dataSize;
+		total = (total + 7) & ~UINT64_C(7);
+		if (total > size - end)
+			break;
+		if (header.version == version) {
+			const char *name = record + sizeof(header);
+			Entry &entry = index[std::string(name, header.nameSize)];
+			entry.data = name + header.nameSize;
+			entry.size = header.dataSize;
+			entry.checksum = header.checksum;
+			entry.verified = false;
+		}
+		end += total;
+	}
+	return 0;
+}
+
+bool AUTPack::verify(const std::string &name, Entry &entry) {
+	uint64_t sum = checksum(version, name.data(), name.size(),
+	                        entry.data, entry.size);
+	entry.verified = sum == entry.checksum;
+	return entry.verified;
+}
+
+bool AUTPack::find(const std::string &name, const char *&data, size_t &size) {
+	auto it = index.find(name);
+	if (it == index.end()) {
+		if (lock(false))
+			return false;
+		refresh();
+		unlock();
+		it = index.find(name);
+		if (it == index.end())
+			return false;
+	}
+	if (!it->second.verified && !verify(it->first, it->second)) {
+		index.erase(it);
+		return false;
+	}
+	data = it->second.data;
+	size = it->second.size;
+	return true;
+}
+
+int AUTPack::add(const std::string &name, const std::string &contents) {
+	if (lock(true))
+		return -1;
+	if (refresh()) {
+		unlock();
+		return -1;
+	}
+	auto it = index.find(name);
+	if (it != index.end()) {
+		if (it->second.verified || verify(it->first, it->second)) {
+			unlock();
+			return 0;
+		}
+		index.erase(it);
+	}
+
+	/* Anything after the last complete record is a torn append. */
+	uint64_t offset = end;
+	std::string head;
+	if (offset == 0)
+		head.append(FILE_MAGIC, sizeof(FILE_MAGIC));
+	RecordHeader header;
+	header.magic = RECORD_MAGIC;
+	header.version = version;
+	header.nameSize = name.size();
+	header.reserved = 0;
+	header.dataSize = contents.size();
+	header.checksum = checksum(version, name.data(), name.size(),
+	                           contents.data(), contents.size());
+	head.append((const char *)&header, sizeof(header));
+	head += name;
+	static const char padding[8] = {0};
+	size_t padSize = -(sizeof(header) + name.size() + contents.size()) % 8;
+	if (truncateFile(fd, offset)
+	    || writeAt(fd, offset, head.data(), head.size())
+	    || writeAt(fd, offset + head.size(), contents.data(), contents.size())
+	    || writeAt(fd, offset + head.size() + contents.size(), padding, padSize))
+	{
+		cc->reportError("Error writing " + filename + ": " + strerror(errno));
+		unlock();
+		return -1;
+	}
+	int ret = refresh();
+	unlock();
+	it = index.find(name);
+	if (it != index.end())
+		it->second.verified = true;
+	return ret;
+}
+
+} /* Namespace DFT */
@@ -0,0 +1,77 @@
+#ifndef AUTPACK_H
+#define AUTPACK_H
+
+#include "compiler.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace DFT {
+
+/**
+ * An append-only file of automata, shared by concurrent processes.
+ * Every record holds the name of an automaton, the version of the
+ * builder that made it (see DFTreeAUTNodeBuilder::VERSION) and its
+ * contents; records of other versions are ignored, and a later record
+ * of a name supersedes earlier ones.
+ * Records are appended under an exclusive lock on the file and read
+ * under a shared one. As a record never changes once written, find()
+ * returns it from the memory-mapped file without copying.
+ * A record torn by a crash fails its checksum when it is first looked
+ * up, and is then treated as missing.
+ */
+class AUTPack {
+public:
+	AUTPack(const std::string &filename, unsigned int version,
+	        CompilerContext *cc);
+	~AUTPack();
+
+	/**
+	 * Opens the pack, creating it if it does not exist.
+	 * @return 0 if successful, non-zero otherwise
+	 */
+	int open();
+
+	/**
+	 * Looks up the automaton with the specified name. The returned
+	 * contents remain valid until the pack is destroyed.
+	 * @return true if found, with data and size set to its contents
+	 */
+	bool find(const std::string &name, const char *&data, size_t &size);
+
+	/**
+	 * Appends the automaton with the specified name, unless another
+	 * process has done so since the last lookup.
+	 * @return 0 if successful, non-zero otherwise
+	 */
+	int add(const std::string &name, const std::string &contents);
+
+private:
+	struct Entry {
+		const char *data;
+		size_t size;
+		uint64_t checksum;
+		bool verified;
+	};
+
+	std::string filename;
+	unsigned int version;
+	CompilerContext *cc;
+	int fd;
+	/* The offset after the last complete record that was read */
+	uint64_t end;
+	std::vector<std::pair<void *, size_t>> maps;
+	std::unordered_map<std::string, Entry> index;
+
+	int lock(bool exclusive);
+	void unlock();
+	int refresh();
+	bool verify(const std::string &name, Entry &entry);
+};
+
+} /* Namespace DFT */
+
+#endif
@@ -1,120 +1,120 @@
 #include "DFTreeAUTNodeBuilder.h"
+#include <cstdio>
+#include <cstring>
 #include <fstream>
+#include <sstream>
 #include <stdexcept>
 #include <memory>
 #include <iostream>
 
 #ifndef WIN32
 #include <unistd.h>
-#include <fcntl.h>
-#include <cerrno>
-static int try_sync(const std::string filename, CompilerContext *cc) {
-	int fd = open(filename.c_str(), O_WRONLY);
-	if (fd == -1) {
-		char *errstr = strerror(errno);
-		cc->reportError("Error opening " + filename + " to sync: " + errstr);
-		return -1;
-	}
-	int ret = fsync(fd);
-	if (ret) {
-		char *errstr = strerror(errno);
-		cc->reportError("Error syncing " + filename + ": " + errstr);
-		close(fd);
-		return ret;
-	}
-	ret = close(fd);
-	if (ret) {
-		char *errstr = strerror(errno);
-		cc->reportError("Error closing " + filename + " to sync: " + errstr);
-		return ret;
-	}
-	std::string dir;
-	size_t dir_end = filename.rfind('/');
-	if (dir_end == std::string::npos)
-		dir = ".";
-	else
-		dir = filename.substr(0, dir_end);
-#ifdef O_DIRECTORY
-	fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY);
 #else
-	fd = open(dir.c_str(), O_RDONLY);
+#include <process.h>
+#define getpid _getpid
 #endif
-	if (!fd) {
-		char *errstr = strerror(errno);
-		cc->reportError("Error opening dir " + dir + " to sync: " + errstr);
+
+static bool same_contents(const std::string &filename, const char *data,
+                          size_t size)
+{
+	std::ifstream in(filename, std::ios::binary);
+	char buf[65536];
+	while (in && size) {
+		size_t n = size < sizeof(buf) ? size : sizeof(buf);
+		if (!in.read(buf, n) || memcmp(buf, data, n))
+			return false;
+		data += n;
+		size -= n;
+	}
+	return in && in.peek() == std::ifstream::traits_type::eof();
+}
+
+/* Makes the file hold the specified contents, unless it already does.
+ * It is written under a temporary name and then renamed, so other
+ * processes see either the old or the new file, never a partial one.
+ */
+static int publish(const std::string &filename, const char *data,
+                   size_t size, CompilerContext *cc)
+{
+	if (same_contents(filename, data, size))
+		return 0;
+	std::string tmp = filename + ".tmp" + std::to_string(getpid());
+	std::ofstream out(tmp, std::ios::binary);
+	out.write(data, size);
+	out.close();
+	if (out.fail()) {
+		cc->reportError("Error writing " + tmp);
+		std::remove(tmp.c_str());
 		return -1;
 	}
-	ret = fsync(fd);
-	if (ret) {
-		char *errstr = strerror(errno);
-		cc->reportError("Error syncing dir " + dir + ": " + errstr);
-		close(fd);
-		return ret;
+#ifdef WIN32
+	std::remove(filename.c_str());
+#endif
+	if (std::rename(tmp.c_str(), filename.c_str())) {
+		cc->reportError("Error renaming " + tmp + " to " + filename);
+		std::remove(tmp.c_str());
+		return -1;
 	}
-	return close(fd);
-}
-#else /* unistd.h */
-static int try_sync(const std::string &filename, CompilerContext *cc) {
 	return 0;
 }
-#endif
 
 namespace DFT {
-const unsigned int DFTreeAUTNodeBuilder::VERSION = 2;
+const unsigned int DFTreeAUTNodeBuilder::VERSION = 3;
+
+std::string DFTreeAUTNodeBuilder::getAutomatonName(const DFT::Nodes::Node& node) {
+	/* Voting gates without repairs count their failed children, which
+	 * is only valid if no child reports its failure twice.
+	 */
+	if (!node.isRepairable() && hasRepeatedFailures(node))
+		return getNodeName(node) + "_rf";
+	return getNodeName(node);
+}
 
 std::string DFTreeAUTNodeBuilder::getFileForNode(const DFT::Nodes::Node& node) {
-	return getNodeName(node) + ".aut";
+	return getAutomatonName(node) + ".aut";
 }
 
-std::string DFT::DFTreeAUTNodeBuilder::getFileForTopLevel() {
-	return "toplevel.aut";
+std::string DFTreeAUTNodeBuilder::getBinaryFileForNode(const DFT::Nodes::Node& node) {
+	return getAutomatonName(node) + ".baut";
 }
 
-static bool already_valid(std::string filename)
-{
-	std::string fullFileName = filename + ".version";
-	try {
-		std::ifstream in(fullFileName);
-		unsigned int currentVersion = -1;
-		in >> currentVersion;
-		if (!in.good())
-			return 0;
-		return currentVersion >= DFTreeAUTNodeBuilder::VERSION;
-	} catch (std::exception e) {
-		return 0;
+bool DFTreeAUTNodeBuilder::hasRepeatedFailures(const Nodes::Node &node) {
+	if (!node.matchesType(Nodes::GateOrType)
+	    && !node.matchesType(Nodes::GateAndType)
+	    && !node.matchesType(Nodes::GateVotingType))
+	{
+		return false;
 	}
+	const Nodes::Gate &gate = static_cast<const Nodes::Gate &>(node);
+	for (const Nodes::Node *child : gate.getChildren()) {
+		if (dependers.count(child))
+			return true;
+	}
+	return false;
 }
 
-static void make_valid(std::string filename)
-{
-	std::string fullFileName = filename + ".version";
-	std::ofstream out(fullFileName);
-	out << DFTreeAUTNodeBuilder::VERSION;
+std::string DFT::DFTreeAUTNodeBuilder::getFileForTopLevel() {
+	return "toplevel.aut";
 }
 
 static int generateTopLevel(std::string root, CompilerContext *cc) {
-	std::string filename(root + "toplevel.aut");
-	if (already_valid(filename))
-		return 0;
-	std::ofstream out(filename);
+	std::ostringstream out;
 	out << "des (0, 1, 2)\n";
 	out << "(0, \"" << automata::signals::ACTIVATE(0, true) << "\", 1)\n";
-	out.close();
-	if (out.fail()) {
-		cc->reportError("Error writing " + filename);
-		return -1;
-	}
-	if (try_sync(filename, cc))
-		return -1;
-	make_valid(filename);
-	return 0;
+	std::string contents = out.str();
+	return publish(root + "toplevel.aut", contents.data(), contents.size(), cc);
 }
 
 int DFTreeAUTNodeBuilder::generate(const Nodes::Node &node) {
-	std::string nodename = getNodeName(node);
-	std::string filename = autRoot + getFileForNode(node);
-	if (already_valid(filename))
-		return 0;
+	std::string file = getFileForNode(node);
+	std::string binary = getBinaryFileForNode(node);
+	const char *data, *binaryData;
+	size_t size, binarySize;
+	if (pack.find(file, data, size) && pack.find(binary, binaryData, binarySize)) {
+		if (publish(autRoot + file, data, size, cc))
+			return -1;
+		return publish(autRoot + binary, binaryData, binarySize, cc);
+	}
 	std::unique_ptr<automaton> to_output;
 	switch (node.getType()) {
 	case Nodes::BasicEventType: {
@@ -124,17 +124,17 @@ int DFTreeAUTNodeBuilder::generate(const Nodes::Node &node) {
 		break;
 	case DFT::Nodes::GateOrType: {
 		const Nodes::GateOr& gate = static_cast<const Nodes::GateOr&>(node);
-		to_output = std::unique_ptr<automaton>(new automata::voting(gate));
+		to_output = std::unique_ptr<automaton>(new automata::voting(gate, hasRepeatedFailures(node)));
 		}
 		break;
 	case DFT::Nodes::GateAndType: {
 		const Nodes::GateAnd& gate = static_cast<const Nodes::GateAnd&>(node);
-		to_output = std::unique_ptr<automaton>(new automata::voting(gate));
+		to_output = std::unique_ptr<automaton>(new automata::voting(gate, hasRepeatedFailures(node)));
 		}
 		break;
 	case DFT::Nodes::GateVotingType: {
 		const Nodes::GateVoting& gate = static_cast<const Nodes::GateVoting&>(node);
-		to_output = std::unique_ptr<automaton>(new automata::voting(gate));
+		to_output = std::unique_ptr<automaton>(new automata::voting(gate, hasRepeatedFailures(node)));
 		}
 		break;
 	case DFT::Nodes::GatePAndType: {
@@ -160,27 +160,36 @@ int DFTreeAUTNodeBuilder::generate(const Nodes::Node &node) {
 	default:
 		return 1;
 	}
-	if (to_output) {
-		std::ofstream out(filename);
-		to_output->write(out);
-		out.close();
-		if (out.fail()) {
-			cc->reportError("Error writing " + filename);
-			return -1;
-		}
-		if (try_sync(filename, cc))
-			return -1;
-		make_valid(filename);
+	std::ostringstream out, binaryOut;
+	to_output->write(out);
+	to_output->write_binary(binaryOut);
+	if (pack.add(file, out.str()) || pack.add(binary, binaryOut.str())
+	    || !pack.find(file, data, size)
+	    || !pack.find(binary, binaryData, binarySize))
+	{
+		return -1;
 	}
-	return 0;
+	if (publish(autRoot + file, data, size, cc))
+		return -1;
+	return publish(autRoot + binary, binaryData, binarySize, cc);
 }
 
 int DFTreeAUTNodeBuilder::generate() {
+	if (pack.open())
+		return 1;
 	if (generateTopLevel(autRoot, cc)) {
 		cc->reportError("Error generating Top Level AUT file");
 		return 1;
 	}
 	std::vector<const Nodes::Node *> nodes = dft->getNodes();
+	dependers.clear();
+	for (const Nodes::Node *node : nodes) {
+		if (!node->matchesType(Nodes::GateFDEPType))
+			continue;
+		const Nodes::GateFDEP &fdep = static_cast<const Nodes::GateFDEP &>(*node);
+		dependers.insert(fdep.getDependers().begin(),
+		                 fdep.getDependers().end());
+	}
 	for (const Nodes::Node *node : nodes) {
 		int bad = generate(*node);
 		if(bad < 0) {
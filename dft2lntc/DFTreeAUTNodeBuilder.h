@@ -1,5 +1,6 @@
 #include "automata/automata.h"
 #include "dft2lnt.h"
+#include "AUTPack.h"
 #include "DFTreeNodeBuilder.h"
 #include <set>
 
@@ -10,10 +11,12 @@ public:
 
 	DFTreeAUTNodeBuilder(std::string cacheDir, DFT::DFTree* dft, CompilerContext* cc)
 		:DFTreeNodeBuilder(dft, cc),
-		 autRoot(cacheDir + DFT2LNT::AUT_CACHE_DIR + "/")
+		 autRoot(cacheDir + DFT2LNT::AUT_CACHE_DIR + "/"),
+		 pack(autRoot + "automata.pack", VERSION, cc)
 	{ }
 
 	virtual std::string getFileForNode(const Nodes::Node& node);
+	virtual std::string getBinaryFileForNode(const Nodes::Node& node);
 	virtual std::string getFileForTopLevel();
 	virtual std::string getRoot() {
 		return autRoot;
@@ -23,7 +26,15 @@ public:
 private:
 	set<std::string> alreadyGenerated;
 	std::string autRoot;
+	/* The automata of all gates, from which their files are written */
+	AUTPack pack;
+	/* The dependers of the FDEPs in the DFT, which may report their
+	 * failure twice: once when they fail, once when the FDEP fails.
+	 */
+	set<const Nodes::Node *> dependers;
 
 	int generate(const Nodes::Node &node);
+	std::string getAutomatonName(const Nodes::Node &node);
+	bool hasRepeatedFailures(const Nodes::Node &node);
 };
 } /* Namespace DFT */
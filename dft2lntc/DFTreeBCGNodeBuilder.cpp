@@ -47,6 +47,18 @@ std::string DFT::DFTreeBCGNodeBuilder::getFileForNode(const DFT::Nodes::Node& no
 	return getNodeName(node) + ".bcg";
 }
 
+/* Runs the command in the specified directory, without changing the
+ * working directory of this process (which other threads may rely on).
+ */
+static int systemIn(const std::string& dir, const std::string& command) {
+#ifdef WIN32
+	std::string full = "cd /d \"" + dir + "\" && " + command;
+#else
+	std::string full = "cd \"" + dir + "\" && " + command;
+#endif
+	return system(full.c_str());
+}
+
 int DFT::DFTreeBCGNodeBuilder::bcgIsValid(std::string bcgFilePath) {
 	std::string command("bcg_info \"" + bcgFilePath +"\"");
 	if(cc->getVerbosity()<VERBOSE_BCGISVALID) {
@@ -56,9 +68,7 @@ int DFT::DFTreeBCGNodeBuilder::bcgIsValid(std::string bcgFilePath) {
 		command += " > /dev/null 2> /dev/null";
 #endif
 	}
-	PushD dir(bcgRoot);
-	int res = system( command.c_str() );
-	dir.popd();
+	int res = systemIn(bcgRoot, command);
 	return res==0;
 }
 
@@ -71,9 +81,7 @@ int DFT::DFTreeBCGNodeBuilder::lntIsValid(std::string lntFilePath) {
 		command += " > /dev/null 2> /dev/null";
 #endif
 	}
-	PushD dir(lntRoot);
-	int res = system( command.c_str() );
-	dir.popd();
+	int res = systemIn(lntRoot, command);
 	return res==0;
 }
 
@@ -1352,8 +1360,6 @@ int DFT::DFTreeBCGNodeBuilder::executeSVL(std::string root, std::string fileName
 		command += " > /dev/null 2> /dev/null";
 #endif
 	}
-	PushD dir(root);
-	int res = system( command.c_str() );
-	dir.popd();
+	int res = systemIn(root, command);
 	return res==0;
 }
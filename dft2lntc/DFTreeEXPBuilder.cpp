@@ -13,27 +13,50 @@
 #include "dft2lnt.h"
 #include "automata/signals.h"
 
+#include <algorithm>
 #include <map>
 #include <fstream>
+#include <iomanip>
+#include <unordered_map>
+#include <unordered_set>
 
 static const int VERBOSITY_FLOW = 1;
 static const int VERBOSITY_RULES = 2;
 static const int VERBOSITY_RULEORIGINS = 3;
 
+/* Above this many entries in the rule table (rules times processes),
+ * printEXP() composes the processes hierarchically.
+ */
+static const size_t MAX_DENSE_ENTRIES = 1 << 20;
+
 std::ostream& operator<<(std::ostream& stream, const DFT::EXPSyncItem& item) {
-	bool first = true;
-	for(int a: item.args) {
-		if(first) first = false;
-		else stream << ",";
-		stream << a;
+	for(unsigned int n=0; n<item.getArgCount(); ++n) {
+		if(n>0) stream << ",";
+		stream << item.getArg(n);
 	}
 	return stream;
 }
 
+const std::string* DFT::EXPSyncItem::intern(const std::string& s) {
+	static std::unordered_set<std::string> names;
+	return &*names.insert(s).first;
+}
+
+void DFT::EXPSyncItem::appendTo(std::string& out) const {
+	out += *name;
+	for(unsigned int n=0; n<nargs; ++n) {
+		out += " !";
+		if(format == BOOL || (format == INT_BOOL && n == 1))
+			out += args[n] ? "TRUE" : "FALSE";
+		else
+			out += std::to_string(args[n]);
+	}
+}
+
 void DFT::DFTreeEXPBuilder::printSyncLineShort(std::ostream& stream, const EXPSyncRule& rule) {
 	stream << "< ";
 	bool first = true;
-	for(auto syncIdx: rule.label) {
+	for(const auto& syncIdx: rule.label) {
 		if(first) first = false;
 		else stream << " | ";
 		if (syncIdx.first > 0) {
@@ -46,34 +69,44 @@ void DFT::DFTreeEXPBuilder::printSyncLineShort(std::ostream& stream, const EXPSy
 			stream << "TopLevel";
 		}
 		stream << ":";
-		stream << *syncIdx.second;
+		stream << syncIdx.second;
 	}
 	stream << " > @ " << (rule.syncOnNode?rule.syncOnNode->getName():"NOSYNC") << " -> " << rule.toLabel;
 }
 
-static std::string rename(bool comma, std::string gate, const decnumber<> &rate)
+std::string DFT::EXPProcess::toString() const {
+	if(renames.empty())
+		return "\"" + file + "\"";
+	std::stringstream ss;
+	ss << "total rename ";
+	bool first = true;
+	for(const std::pair<std::string, std::string>& r: renames) {
+		if(first) first = false;
+		else ss << ", ";
+		ss << "\"" << r.first << "\" -> \"" << r.second << "\"";
+	}
+	ss << " in \"" << file << "\" end rename";
+	return ss.str();
+}
+
+static void renameRate(DFT::EXPProcess& proc, std::string gate, const decnumber<> &rate)
 {
-	std::string start(comma ? ", \"" : "\"");
 	if (!rate.is_zero())
-		return start + gate + "\" -> \"rate " + rate.str() + '"';
-	else if (!comma) /* Return something to avoid a spurious comma */
-		return start + gate + "\" -> \"" + gate + '"';
-	else
-		return "";
+		proc.rename(gate, "rate " + rate.str());
+	else if (proc.renames.empty()) /* Rename something to keep the rename a rename */
+		proc.rename(gate, gate);
 }
 
-std::string DFT::DFTreeEXPBuilder::getBEProc(const DFT::Nodes::BasicEvent& be) const {
-	std::stringstream ss;
-
+DFT::EXPProcess DFT::DFTreeEXPBuilder::getBEProcess(const DFT::Nodes::BasicEvent& be) const {
 	if(be.getMode() == DFT::Nodes::BE::CalculationMode::APH) {
-		ss << "total rename ";
-		ss << "\"ACTIVATE\" -> \"" << automata::signals::GATE_ACTIVATE << " !0 !FALSE\"";
-		ss << ", ";
-		ss << "\"FAIL\" -> \"" << automata::signals::GATE_FAIL << " !0\"";
-		ss << " in \"";
-		ss << be.getFileToEmbed();
-		ss << "\" end rename";
-	} else if (!be.getLambda().is_zero() || !be.getProb().is_zero()) {
+		DFT::EXPProcess proc(be.getFileToEmbed());
+		proc.rename("ACTIVATE", std::string(automata::signals::GATE_ACTIVATE) + " !0 !FALSE");
+		proc.rename("FAIL", std::string(automata::signals::GATE_FAIL) + " !0");
+		return proc;
+	}
+
+	DFT::EXPProcess proc = getNodeFileProcess(be);
+	if (!be.getLambda().is_zero() || !be.getProb().is_zero()) {
 		using namespace automata::signals;
 		const decnumber<> ONE(1);
 		decnumber<> l = be.getLambda(), mu = be.getMu();
@@ -91,49 +124,39 @@ std::string DFT::DFTreeEXPBuilder::getBEProc(const DFT::Nodes::BasicEvent& be) c
 			failSafe = l * (ONE - p);
 		}
 
-		const std::string GATE = automata::signals::GATE_RATE_FAIL;
-		ss << "total rename ";
 		// Insert lambda value
-		ss << rename(0, RATE_FAIL(1, 2), l * p * cov);
-		ss << rename(1, RATE_FAIL(1, 4), l * p * res);
-		ss << rename(1, RATE_FAIL(0, 2), failSafe * cov);
-		ss << rename(1, RATE_FAIL(0, 4), failSafe * res);
+		renameRate(proc, RATE_FAIL(1, 2), l * p * cov);
+		renameRate(proc, RATE_FAIL(1, 4), l * p * res);
+		renameRate(proc, RATE_FAIL(0, 2), failSafe * cov);
+		renameRate(proc, RATE_FAIL(0, 4), failSafe * res);
 		l = be.getLambda() * cov;
 		res = be.getLambda() * res;
 		for (int i = be.getPhases(); i > 1; i--) {
-			ss << rename(1, RATE_FAIL(i, 2), l * cov);
-			ss << rename(1, RATE_FAIL(i, 4), l * res);
+			renameRate(proc, RATE_FAIL(i, 2), l * cov);
+			renameRate(proc, RATE_FAIL(i, 4), l * res);
 		}
 	
 		// Insert mu value (only for non-cold BE's)
 		failSafe = mu * (ONE - p);
-		ss << rename(1, RATE_FAIL(1, 1), mu * p * cov);
-		ss << rename(1, RATE_FAIL(1, 3), mu * p * res);
-		ss << rename(1, RATE_FAIL(1, 1), failSafe * cov);
-		ss << rename(1, RATE_FAIL(1, 3), failSafe * res);
+		renameRate(proc, RATE_FAIL(1, 1), mu * p * cov);
+		renameRate(proc, RATE_FAIL(1, 3), mu * p * res);
+		renameRate(proc, RATE_FAIL(1, 1), failSafe * cov);
+		renameRate(proc, RATE_FAIL(1, 3), failSafe * res);
 		for (int i = be.getPhases(); i > 1; i--) {
-			ss << rename(1, RATE_FAIL(i, 1), mu * cov);
-			ss << rename(1, RATE_FAIL(i, 3), mu * res);
+			renameRate(proc, RATE_FAIL(i, 1), mu * cov);
+			renameRate(proc, RATE_FAIL(i, 3), mu * res);
 		}
 		if (be.getRepair()>0) {
-			ss << ", ";
-			ss << "\"" << automata::signals::GATE_RATE_REPAIR << "\" -> \"rate " << be.getRepair() << "\"";
+			std::stringstream rate;
+			rate << "rate " << be.getRepair();
+			proc.rename(automata::signals::GATE_RATE_REPAIR, rate.str());
 		}
-		ss << " in \"";
-		ss << nodeBuilder->getRoot() << nodeBuilder->getFileForNode(be);
-		ss << "\" end rename";
-	} else {
-		ss << "\"";
-		ss << nodeBuilder->getRoot() << nodeBuilder->getFileForNode(be);
-		ss << "\"";
 	}
-	return ss.str();
+	return proc;
 }
 
-std::string DFT::DFTreeEXPBuilder::getRUProc(const DFT::Nodes::Gate& ru) const {
-	std::stringstream ss;
-
-	ss << "total rename ";
+DFT::EXPProcess DFT::DFTreeEXPBuilder::getRUProcess(const DFT::Nodes::Gate& ru) const {
+	DFT::EXPProcess proc = getNodeFileProcess(ru);
 
 	for(size_t n = 0; n<ru.getChildren().size(); ++n) {
 
@@ -144,77 +167,99 @@ std::string DFT::DFTreeEXPBuilder::getRUProc(const DFT::Nodes::Gate& ru) const {
 			const DFT::Nodes::BasicEvent& be = *static_cast<const DFT::Nodes::BasicEvent*>(&child);
 
 			// Insert repair values
-			ss << "\"" << automata::signals::GATE_RATE_REPAIR << " !1 !" << n+1 << "\" -> \"rate " << be.getRepair() << "\"";
-			if(n < ru.getChildren().size()-1){
-				ss << ", ";
-			}
+			std::stringstream gate, rate;
+			gate << automata::signals::GATE_RATE_REPAIR << " !1 !" << n+1;
+			rate << "rate " << be.getRepair();
+			proc.rename(gate.str(), rate.str());
 		}
 
 	}
 
-	ss << " in \"";
-	ss << nodeBuilder->getRoot() << nodeBuilder->getFileForNode(ru);
-	ss << "\" end rename";
-
-	return ss.str();
+	return proc;
 }
 
-std::string DFT::DFTreeEXPBuilder::getINSPProc(const DFT::Nodes::Inspection& insp) const {
-    std::stringstream ss;
-    
-    ss << "total rename ";
-    // Insert lambda value
+DFT::EXPProcess DFT::DFTreeEXPBuilder::getINSPProcess(const DFT::Nodes::Inspection& insp) const {
+	DFT::EXPProcess proc = getNodeFileProcess(insp);
+
+	// Insert lambda value
 	std::string rate = "rate " + insp.getLambda().str();
 	if (insp.getPhases() == 0)
 		rate = "time " + insp.getLambda().str();
-    ss << "\"" << automata::signals::GATE_RATE_INSPECTION << " !1" << "\" -> \"" << rate << "\"";
-    
-    ss << " in \"";
-    ss << nodeBuilder->getRoot() << nodeBuilder->getFileForNode(insp);
-    ss << "\" end rename";
-    
-    return ss.str();
+	proc.rename(std::string(automata::signals::GATE_RATE_INSPECTION) + " !1", rate);
+
+	return proc;
 }
 
-std::string DFT::DFTreeEXPBuilder::getREPProc(const DFT::Nodes::Replacement& rep) const {
-    std::stringstream ss;
-    
-    ss << "total rename ";
-    // Insert lambda value
-    ss << "\"" << automata::signals::GATE_RATE_PERIOD << " !1 !" << "\" -> \"rate " << rep.getLambda() << "\"";
-    
-    ss << " in \"";
-    ss << nodeBuilder->getRoot() << nodeBuilder->getFileForNode(rep);
-    ss << "\" end rename";
-    
-    return ss.str();
+DFT::EXPProcess DFT::DFTreeEXPBuilder::getREPProcess(const DFT::Nodes::Replacement& rep) const {
+	DFT::EXPProcess proc = getNodeFileProcess(rep);
+
+	// Insert lambda value
+	std::stringstream rate;
+	rate << "rate " << rep.getLambda();
+	proc.rename(std::string(automata::signals::GATE_RATE_PERIOD) + " !1 !", rate.str());
+
+	return proc;
+}
+
+DFT::EXPProcess DFT::DFTreeEXPBuilder::getNodeFileProcess(const DFT::Nodes::Node& node) const {
+	DFT::EXPProcess proc(nodeBuilder->getRoot() + nodeBuilder->getFileForNode(node));
+	std::string binary = nodeBuilder->getBinaryFileForNode(node);
+	if (!binary.empty())
+		proc.binaryFile = nodeBuilder->getRoot() + binary;
+	return proc;
+}
+
+DFT::EXPProcess DFT::DFTreeEXPBuilder::getProcess(const DFT::Nodes::Node& node) const {
+	if(node.isBasicEvent()) {
+		return getBEProcess(*static_cast<const DFT::Nodes::BasicEvent*>(&node));
+	} else if (DFT::Nodes::Node::typeMatch(node.getType(), DFT::Nodes::InspectionType)) {
+		return getINSPProcess(*static_cast<const DFT::Nodes::Inspection*>(&node));
+	} else if (DFT::Nodes::Node::typeMatch(node.getType(), DFT::Nodes::ReplacementType)) {
+		return getREPProcess(*static_cast<const DFT::Nodes::Replacement*>(&node));
+	}
+	assert(node.isGate() && "getProcess(): Unknown node type");
+	return getNodeFileProcess(node);
 }
 
-void DFT::DFTreeEXPBuilder::printSyncLine(const EXPSyncRule& rule, const vector<unsigned int>& columnWidths) {
-	std::map<unsigned int,std::shared_ptr<EXPSyncItem>>::const_iterator it = rule.label.begin();
+/* The label a rule results in, quoted if needed */
+static std::string resultLabel(const DFT::EXPSyncRule& rule) {
+	if (rule.toLabel.find(' ') == std::string::npos)
+		return rule.toLabel;
+	return "\"" + rule.toLabel + "\"";
+}
+
+/* Appends text to line, padded with spaces to width */
+static void appendPadded(std::string& line, const std::string& text, size_t width) {
+	line += text;
+	if (text.size() < width)
+		line.append(width - text.size(), ' ');
+}
+
+void DFT::DFTreeEXPBuilder::printSyncLine(std::string& line, const EXPSyncRule& rule, const vector<unsigned int>& columnWidths) const {
+	static const std::string ANY("_");
 	size_t c=0;
-	for(; it!=rule.label.end();++it) {
-		while(c<it->first) {
-			if(c>0) exp_body << " * ";
-			exp_body.outlineLeftNext(columnWidths[c],' ');
-			exp_body << "_";
+	for(const auto& item: rule.label) {
+		while(c<item.first) {
+			if(c>0) line += " * ";
+			appendPadded(line, ANY, columnWidths[c]);
 			++c;
 		}
-		if(c>0) exp_body << " * ";
-		exp_body.outlineLeftNext(columnWidths[c],' ');
-		exp_body << it->second->toStringQuoted();
+		if(c>0) line += " * ";
+		size_t start = line.size();
+		line += '"';
+		item.second.appendTo(line);
+		line += '"';
+		if (line.size() - start < columnWidths[c])
+			line.append(columnWidths[c] - (line.size() - start), ' ');
 		++c;
 	}
 	while(c<dft->getNodes().size() + 1) {
-		if(c>0) exp_body << " * ";
-		exp_body.outlineLeftNext(columnWidths[c],' ');
-		exp_body << "_";
+		if(c>0) line += " * ";
+		appendPadded(line, ANY, columnWidths[c]);
 		++c;
 	}
-	if (rule.toLabel.find(' ') == std::string::npos)
-		exp_body << " -> " << rule.toLabel;
-	else
-		exp_body << " -> \"" << rule.toLabel << "\"";
+	line += " -> ";
+	line += resultLabel(rule);
 }
 
 DFT::DFTreeEXPBuilder::DFTreeEXPBuilder(std::string root, std::string tmp, std::string nameBCG, std::string nameEXP, DFT::DFTree* dft, DFTreeNodeBuilder *nb, CompilerContext* cc):
@@ -257,8 +302,6 @@ int DFT::DFTreeEXPBuilder::build() {
 		// Build the EXP file
 		svl_header.clearAll();
 		svl_body.clearAll();
-		exp_header.clearAll();
-		exp_body.clearAll();
 		
 		vector<DFT::EXPSyncRule> activationRules;
 		vector<DFT::EXPSyncRule> failRules;
@@ -272,7 +315,9 @@ int DFT::DFTreeEXPBuilder::build() {
 		// Rules for detection of modelling errors.
         vector<DFT::EXPSyncRule> impossibleRules;
 
+        rulesByNode.clear();
         parseDFT(impossibleRules, activationRules,failRules,repairRules,repairedRules,repairingRules,onlineRules,inspectionRules);
+        rulesByNode.clear();
         buildEXPBody(impossibleRules, activationRules,failRules,repairRules,repairedRules,repairingRules,onlineRules,inspectionRules);
 
 		// Build SVL file
@@ -283,9 +328,321 @@ int DFT::DFTreeEXPBuilder::build() {
 	return !ok;
 }
 
-void DFT::DFTreeEXPBuilder::printEXP(std::ostream& out) {
-	out << exp_header.toString();
-	out << exp_body.toString();
+void DFT::DFTreeEXPBuilder::printEXP(std::ostream& out) const {
+	if (processes.size() * allRules.size() > MAX_DENSE_ENTRIES)
+		printSparseEXP(out);
+	else
+		printDenseEXP(out);
+}
+
+void DFT::DFTreeEXPBuilder::printDenseEXP(std::ostream& out) const {
+	out << "(* Number of rules: " << allRules.size() << "*)\n";
+	out << "hide\n";
+	writeHideLines(out, allRules);
+	out << "in\n";
+
+	// Synchronization rules
+	vector<unsigned int> columnWidths(dft->getNodes().size() + 1, 0);
+	calculateColumnWidths(columnWidths,allRules);
+
+	out << "\tlabel par using\n";
+	out << "\t(*\t" << std::left << std::setw(columnWidths[0]) << "tle";
+	for(size_t c = 0; c < dft->getNodes().size(); ++c) {
+		const DFT::Nodes::Node* node = dft->getNodes()[c];
+		out << "   " << std::setw(columnWidths[c + 1])
+		    << node->getTypeStr() + std::to_string(getIDOfNode(*node));
+	}
+	out << " *)\n";
+	writeRules(out, allRules, columnWidths);
+
+	// Generate the parallel composition of all the nodes
+	out << "\tin\n";
+	out << "\t\t" << processes[0].toString() << "\n";
+	for(size_t c = 1; c < processes.size(); ++c) {
+		out << "\t\t||\n";
+		out << "\t\t" << processes[c].toString() << "\n";
+	}
+	out << "\tend par\n";
+	out << "end hide\n";
+}
+
+namespace {
+
+const size_t NONE = (size_t)-1;
+
+/* Deeper pars are not indented further, so lines stay short */
+const size_t MAX_INDENT = 16;
+
+/* A par of printSparseEXP(): a leaf is a single process, any other part
+ * composes two smaller ones.
+ */
+struct EXPPart {
+	size_t parent;
+	size_t operands[2];
+};
+
+/* A vector of a part, of the specified rule, with the operands in mask
+ * taking part. If pass, the rule is complete already, and its label is
+ * passed on from an operand.
+ */
+struct EXPVector {
+	uint32_t rule;
+	uint8_t mask;
+	bool pass;
+};
+
+} // Anonymous namespace
+
+void DFT::DFTreeEXPBuilder::printSparseEXP(std::ostream& out) const {
+	/* Build the parts as the native composer merges components: in
+	 * post-order from the toplevel, every process with the parts of its
+	 * children, and finally all that is left. Operands are paired off
+	 * level by level, so the nesting of a wide gate is logarithmic.
+	 */
+	size_t n = processes.size();
+	std::vector<EXPPart> parts(n, EXPPart{NONE, {NONE, NONE}});
+	std::vector<size_t> up(n); /* Some ancestor, or the part itself */
+	for (size_t c = 0; c < n; c++)
+		up[c] = c;
+	auto top = [&](size_t x) {
+		while (up[x] != x) {
+			up[x] = up[up[x]];
+			x = up[x];
+		}
+		return x;
+	};
+	auto combine = [&](std::vector<size_t>& operands) {
+		while (operands.size() > 1) {
+			size_t m = 0;
+			for (size_t i = 0; i + 1 < operands.size(); i += 2) {
+				size_t p = parts.size();
+				parts.push_back(EXPPart{NONE, {operands[i], operands[i + 1]}});
+				up.push_back(p);
+				parts[operands[i]].parent = parts[operands[i + 1]].parent = p;
+				up[operands[i]] = up[operands[i + 1]] = p;
+				operands[m++] = p;
+			}
+			if (operands.size() % 2)
+				operands[m++] = operands.back();
+			operands.resize(m);
+		}
+	};
+
+	std::vector<size_t> order;
+	std::vector<bool> visited(n);
+	std::vector<std::pair<size_t, size_t>> stack;
+	for (size_t root = 0; root < n; root++) {
+		if (visited[root])
+			continue;
+		visited[root] = true;
+		stack.push_back(std::make_pair(root, 0));
+		while (!stack.empty()) {
+			size_t p = stack.back().first;
+			const std::vector<unsigned int>& children = processes[p].children;
+			if (stack.back().second < children.size()) {
+				size_t child = children[stack.back().second++];
+				if (child < n && !visited[child]) {
+					visited[child] = true;
+					stack.push_back(std::make_pair(child, 0));
+				}
+				continue;
+			}
+			order.push_back(p);
+			stack.pop_back();
+		}
+	}
+	std::vector<size_t> operands;
+	for (size_t p : order) {
+		operands.assign(1, top(p));
+		for (unsigned int child : processes[p].children) {
+			size_t t = top(child);
+			if (std::find(operands.begin(), operands.end(), t) == operands.end())
+				operands.push_back(t);
+		}
+		combine(operands);
+	}
+	operands.clear();
+	std::vector<bool> seen(parts.size());
+	for (size_t c = 0; c < n; c++) {
+		size_t t = top(c);
+		if (!seen[t]) {
+			seen[t] = true;
+			operands.push_back(t);
+		}
+	}
+	combine(operands);
+	size_t root = operands[0];
+
+	/* Parts are made after their operands */
+	std::vector<size_t> depth(parts.size(), 0);
+	for (size_t p = parts.size(); p-- > n; ) {
+		depth[parts[p].operands[0]] = depth[p] + 1;
+		depth[parts[p].operands[1]] = depth[p] + 1;
+	}
+	auto side = [&](size_t p, size_t x) {
+		return (uint8_t)(parts[p].operands[1] == x ? 2 : 1);
+	};
+
+	/* Place the vectors of every rule. It is complete in the smallest
+	 * part containing its processes, and in the parent of that if it is
+	 * a leaf.
+	 */
+	std::vector<std::vector<EXPVector>> vectors(parts.size());
+	std::vector<std::vector<uint32_t>> hidden(parts.size());
+	std::vector<size_t> complete(allRules.size());
+	std::vector<uint32_t> stamp(parts.size(), 0);
+	std::vector<size_t> slot(parts.size());
+	/* Visible labels by number, with the number of rules resulting in
+	 * them, and the (label, operand) pairs shared labels are passed on
+	 * through
+	 */
+	std::unordered_map<std::string, uint32_t> labelIds;
+	std::vector<uint32_t> labelRules;
+	std::vector<uint32_t> ruleLabel(allRules.size());
+	for (uint32_t r = 0; r < allRules.size(); r++) {
+		if (allRules[r].hideToLabel)
+			continue;
+		auto id = labelIds.emplace(allRules[r].toLabel, labelRules.size());
+		if (id.second)
+			labelRules.push_back(0);
+		ruleLabel[r] = id.first->second;
+		labelRules[ruleLabel[r]]++;
+	}
+	labelIds.clear();
+	std::unordered_set<uint64_t> passed;
+	for (uint32_t r = 0; r < allRules.size(); r++) {
+		const EXPSyncRule& rule = allRules[r];
+		size_t lca = NONE;
+		for (const auto& item : rule.label) {
+			size_t x = item.first;
+			if (lca == NONE) {
+				lca = x;
+				continue;
+			}
+			while (depth[x] > depth[lca])
+				x = parts[x].parent;
+			while (depth[lca] > depth[x])
+				lca = parts[lca].parent;
+			while (x != lca) {
+				x = parts[x].parent;
+				lca = parts[lca].parent;
+			}
+		}
+		size_t done = lca < n ? parts[lca].parent : lca;
+		complete[r] = done;
+		for (const auto& item : rule.label) {
+			for (size_t x = item.first; x != done; x = parts[x].parent) {
+				size_t p = parts[x].parent;
+				if (stamp[p] == r + 1) {
+					vectors[p][slot[p]].mask |= side(p, x);
+					break;
+				}
+				stamp[p] = r + 1;
+				slot[p] = vectors[p].size();
+				vectors[p].push_back(EXPVector{r, side(p, x), false});
+			}
+		}
+		if (rule.hideToLabel) {
+			hidden[done].push_back(r);
+			continue;
+		}
+		/* Passing on a label once per operand is enough */
+		uint64_t label = ruleLabel[r];
+		bool shared = labelRules[label] > 1;
+		for (size_t x = done; x != root; x = parts[x].parent) {
+			size_t p = parts[x].parent;
+			if (shared && !passed.insert(label << 32 | (2 * p + side(p, x))).second)
+				break;
+			vectors[p].push_back(EXPVector{r, side(p, x), true});
+		}
+	}
+	passed.clear();
+
+	auto pending = [](std::string& line, uint32_t r) {
+		line += "\"#";
+		line += std::to_string(r);
+		line += '"';
+	};
+	auto indent = [&](size_t level) -> std::ostream& {
+		for (size_t i = std::min(level, MAX_INDENT); i--; )
+			out << '\t';
+		return out;
+	};
+
+	out << "(* Number of rules: " << allRules.size() << "*)\n";
+	/* The parts still to print, with their indentation; a part is on the
+	 * stack once before each of its operands and once after them.
+	 */
+	std::vector<std::pair<size_t, size_t>> todo;
+	std::vector<unsigned char> printed(parts.size(), 0);
+	std::string line;
+	todo.push_back(std::make_pair(root, 0));
+	while (!todo.empty()) {
+		size_t p = todo.back().first;
+		size_t level = todo.back().second;
+		todo.pop_back();
+		if (p < n) {
+			indent(level) << processes[p].toString() << "\n";
+			continue;
+		}
+		size_t inner = level + !hidden[p].empty();
+		switch (printed[p]++) {
+		case 0:
+			if (!hidden[p].empty()) {
+				indent(level) << "hide\n";
+				for (size_t i = 0; i < hidden[p].size(); i++) {
+					indent(level + 1) << resultLabel(allRules[hidden[p][i]])
+					                  << (i + 1 < hidden[p].size() ? ",\n" : "\n");
+				}
+				indent(level) << "in\n";
+			}
+			indent(inner) << "label par using\n";
+			for (size_t i = 0; i < vectors[p].size(); i++) {
+				const EXPVector& v = vectors[p][i];
+				const EXPSyncRule& rule = allRules[v.rule];
+				line.assign(std::min(inner + 1, MAX_INDENT), '\t');
+				for (int o = 0; o < 2; o++) {
+					size_t x = parts[p].operands[o];
+					if (o)
+						line += " * ";
+					if (!(v.mask & (1 << o))) {
+						line += '_';
+					} else if (v.pass) {
+						line += '"';
+						line += rule.toLabel;
+						line += '"';
+					} else if (x < n) {
+						line += '"';
+						rule.findLabel(x)->appendTo(line);
+						line += '"';
+					} else {
+						pending(line, v.rule);
+					}
+				}
+				line += " -> ";
+				if (v.pass || complete[v.rule] == p)
+					line += resultLabel(rule);
+				else
+					pending(line, v.rule);
+				line += i + 1 < vectors[p].size() ? ",\n" : "\n";
+				out.write(line.data(), line.size());
+			}
+			indent(inner) << "in\n";
+			todo.push_back(std::make_pair(p, level));
+			todo.push_back(std::make_pair(parts[p].operands[0], inner + 1));
+			break;
+		case 1:
+			indent(inner) << "||\n";
+			todo.push_back(std::make_pair(p, level));
+			todo.push_back(std::make_pair(parts[p].operands[1], inner + 1));
+			break;
+		default:
+			indent(inner) << "end par\n";
+			if (!hidden[p].empty())
+				indent(level) << "end hide\n";
+			break;
+		}
+	}
 }
 
 void DFT::DFTreeEXPBuilder::printSVL(std::ostream& out) {
@@ -293,6 +650,13 @@ void DFT::DFTreeEXPBuilder::printSVL(std::ostream& out) {
 	out << svl_body.toString();
 }
 
+void DFT::DFTreeEXPBuilder::getComposition(EXPComposition& out) const {
+	out.processes = processes;
+	out.rules = allRules;
+	for(DFT::EXPSyncRule& rule: out.rules)
+		rule.syncOnNode = NULL;
+}
+
 unsigned int DFT::DFTreeEXPBuilder::getIDOfNode(const DFT::Nodes::Node& node) const {
 	std::map<const DFT::Nodes::Node*, unsigned int>::const_iterator it = nodeIDs.find(&node);
 	assert( (it != nodeIDs.end()) && "getIDOfNode() did not know the ID of the node");
@@ -347,9 +711,9 @@ int DFT::DFTreeEXPBuilder::parseDFT(
 				if (!be.hasInspectionModule()) {
 					addIndepRule(inspectionRules, be, syncInspection(0), "i_");
 				} else if (be.getRepair() <= 0) {
-					EXPSyncItem *RR = new EXPSyncItem(
-								automata::signals::GATE_RATE_REPAIR);
-					addIndepRule(repairRules, be, RR, "rr_");
+					addIndepRule(repairRules, be,
+					             EXPSyncItem(automata::signals::GATE_RATE_REPAIR),
+					             "rr_");
 				}
 			}
 			unsigned int nodeID = getIDOfNode(**it);
@@ -359,39 +723,42 @@ int DFT::DFTreeEXPBuilder::parseDFT(
 			iName += std::to_string(nodeID);
 			DFT::EXPSyncRule ruleI(iName, false);
 			ruleI.insertLabel(nodeID, syncImpossible());
-			impossibleRules.push_back(ruleI);
+			impossibleRules.push_back(std::move(ruleI));
         }
     }
     return 0;
 }
 
-void DFT::DFTreeEXPBuilder::writeHideLines(vector<DFT::EXPSyncRule>& rules)
+void DFT::DFTreeEXPBuilder::writeHideLines(std::ostream& out,
+                                           const vector<DFT::EXPSyncRule>& rules) const
 {
 	bool first = true;
 	for(size_t s = 0; s < rules.size(); ++s) {
-		EXPSyncRule& rule = rules[s];
+		const EXPSyncRule& rule = rules[s];
 		if(rule.hideToLabel) {
 			if (!first)
-				exp_body << "," << exp_body.applypostfix;
+				out << ",\n";
 			first = false;
-			exp_body << exp_body.applyprefix << rule.toLabel;
+			out << "\t" << rule.toLabel;
 		}
 	}
-	exp_body << exp_body.applypostfix;
+	out << "\n";
 }
 
-void DFT::DFTreeEXPBuilder::writeRules(vector<DFT::EXPSyncRule>& rules,
-									   vector<unsigned int> columnWidths)
+void DFT::DFTreeEXPBuilder::writeRules(std::ostream& out,
+                                       const vector<DFT::EXPSyncRule>& rules,
+                                       const vector<unsigned int>& columnWidths) const
 {
-	bool first = true;
+	std::string line;
 	for(size_t s = 0; s < rules.size(); ++s) {
-		if (!first)
-			exp_body << "," << exp_body.applypostfix;
-		first = false;
-		exp_body << exp_body.applyprefix;
-		printSyncLine(rules[s],columnWidths);
+		line.clear();
+		if (s > 0)
+			line += ",\n";
+		line += "\t\t";
+		printSyncLine(line, rules[s], columnWidths);
+		out.write(line.data(), line.size());
 	}
-	exp_body << exp_body.applypostfix;
+	out << "\n";
 }
 
 int DFT::DFTreeEXPBuilder::buildEXPBody(
@@ -405,95 +772,30 @@ int DFT::DFTreeEXPBuilder::buildEXPBody(
 			vector<DFT::EXPSyncRule>& inspectionRules)
 {
 
-	vector<DFT::EXPSyncRule> allRules(activationRules);
-	allRules.insert(allRules.end(), repairRules.begin(), repairRules.end());
-	allRules.insert(allRules.end(), repairedRules.begin(), repairedRules.end());
-	allRules.insert(allRules.end(), repairingRules.begin(), repairingRules.end());
-	allRules.insert(allRules.end(), onlineRules.begin(), onlineRules.end());
-	allRules.insert(allRules.end(), inspectionRules.begin(), inspectionRules.end());
-	allRules.insert(allRules.end(), failRules.begin(), failRules.end());
-	allRules.insert(allRules.end(), impossibleRules.begin(), impossibleRules.end());
-
-    /* Generate the EXP based on the generated synchronization rules */
-    exp_body.clearAll();
-    exp_body << exp_body.applyprefix << "(* Number of rules: " << allRules.size();
-   	exp_body << "*)" << exp_body.applypostfix;
-    exp_body << exp_body.applyprefix << "hide" << exp_body.applypostfix;
-    exp_body.indent();
-    
-	writeHideLines(allRules);
-    
-    exp_body.outdent();
-    exp_body.appendLine("in");
-    exp_body.indent();
+	allRules = std::move(activationRules);
+	for(vector<DFT::EXPSyncRule>* rules: {&repairRules, &repairedRules,
+	                                      &repairingRules, &onlineRules,
+	                                      &inspectionRules, &failRules,
+	                                      &impossibleRules})
+	{
+		allRules.insert(allRules.end(), std::make_move_iterator(rules->begin()),
+		                std::make_move_iterator(rules->end()));
+		rules->clear();
+	}
 
-	// Synchronization rules
-	vector<unsigned int> columnWidths(dft->getNodes().size() + 1, 0);
-	calculateColumnWidths(columnWidths,allRules);
-	
-	exp_body << exp_body.applyprefix << "label par using" << exp_body.applypostfix;
-	exp_body << exp_body.applyprefix << "(*\t";
-	exp_body.outlineLeftNext(columnWidths[0],' ');
-	exp_body << exp_body._push << "tle" << exp_body._pop;
-
-	std::vector<DFT::Nodes::Node*>::const_iterator it = dft->getNodes().begin();
-	for(int c = 0; it!=dft->getNodes().end(); ++it,++c) {
-		exp_body << "   ";
-		exp_body.outlineLeftNext(columnWidths[c + 1],' ');
-		exp_body << exp_body._push << (*it)->getTypeStr() << getIDOfNode(**it)
-			<< exp_body._pop;
-	}
-	exp_body << " *)" << exp_body.applypostfix;
-	
-	exp_body.indent();
-	writeRules(allRules, columnWidths);
-	exp_body.outdent();
-	
-	// Generate the parallel composition of all the nodes
-	exp_body << exp_body.applyprefix << "in" << exp_body.applypostfix;
-	exp_body.indent();
-	exp_body << exp_body.applyprefix;
-	exp_body << "\"" << nodeBuilder->getRoot() << nodeBuilder->getFileForTopLevel() << "\"";
-	exp_body << exp_body.applypostfix;
-	int c=0;
-	it = dft->getNodes().begin();
-	for(it = dft->getNodes().begin(); it!=dft->getNodes().end(); ++it, ++c) {
-		const DFT::Nodes::Node& node = **it;
-		exp_body << exp_body.applyprefix << "||" << exp_body.applypostfix;
-		if(node.isBasicEvent()) {
-			const DFT::Nodes::BasicEvent *be;
-		   	be = static_cast<const DFT::Nodes::BasicEvent*>(&node);
-			exp_body << exp_body.applyprefix << getBEProc(*be)
-			         << exp_body.applypostfix;
-		} else if (node.isGate()) {
-			if (DFT::Nodes::Node::typeMatch(node.getType(),
-			                                DFT::Nodes::InspectionType))
-			{
-				const DFT::Nodes::Inspection *insp;
-			   	insp = static_cast<const DFT::Nodes::Inspection*>(&node);
-				exp_body << exp_body.applyprefix << getINSPProc(*insp)
-				         << exp_body.applypostfix;
-			} else if (DFT::Nodes::Node::typeMatch(node.getType(),
-												   DFT::Nodes::ReplacementType))
-			{
-				const DFT::Nodes::Replacement *rep;
-			   	rep = static_cast<const DFT::Nodes::Replacement*>(&node);
-				exp_body << exp_body.applyprefix << getREPProc(*rep)
-				         << exp_body.applypostfix;
-			} else {
-				exp_body << exp_body.applyprefix << "\""
-				         << nodeBuilder->getRoot()
-				         << nodeBuilder->getFileForNode(node)
-				         << "\"" << exp_body.applypostfix;
-			}
-		} else {
-			assert(0 && "buildEXPBody(): Unknown node type");
+	processes.clear();
+	processes.push_back(DFT::EXPProcess(nodeBuilder->getRoot() + nodeBuilder->getFileForTopLevel()));
+	processes[0].children.push_back(getIDOfNode(*dft->getTopNode()));
+	for(const DFT::Nodes::Node* node: dft->getNodes()) {
+		DFT::EXPProcess proc = getProcess(*node);
+		if(node->isGate()) {
+			const DFT::Nodes::Gate* gate = static_cast<const DFT::Nodes::Gate*>(node);
+			for(const DFT::Nodes::Node* child: gate->getChildren())
+				proc.children.push_back(getIDOfNode(*child));
 		}
+		processes.push_back(proc);
 	}
-	exp_body.outdent();
-	exp_body << exp_body.applyprefix << "end par" << exp_body.applypostfix;
-    exp_body.outdent();
-    exp_body.appendLine("end hide");
+
     return 0;
 }
 	
@@ -538,13 +840,13 @@ int DFT::DFTreeEXPBuilder::createSyncRuleGateFDEP(vector<DFT::EXPSyncRule>& acti
 		}
 
 		// Add it to the list of rules
-		failRules.push_back(ruleF);
-		{
+		if(cc->getVerbosity() >= VERBOSITY_RULES) {
 			std::stringstream report;
 			report << "Added new fail       sync rule: ";
 			printSyncLineShort(report,ruleF);
 			cc->reportAction2(report.str(),VERBOSITY_RULES);
 		}
+		failRules.push_back(std::move(ruleF));
 	}
 
 	return 0;
@@ -602,33 +904,46 @@ int DFT::DFTreeEXPBuilder::createSyncRuleTop(
 		if(!nameTop.empty())
 			ss << "_" << nameTop;
 		ruleO.insertLabel(topNode, syncOnline(0));
-		onlineRules.push_back(ruleO);
-		ss.str("Added new online     sync rule: ");
-		printSyncLineShort(ss, ruleO);
-		cc->reportAction2(ss.str(), VERBOSITY_RULES);
+		if(cc->getVerbosity() >= VERBOSITY_RULES) {
+			ss.str("Added new online     sync rule: ");
+			printSyncLineShort(ss, ruleO);
+			cc->reportAction2(ss.str(), VERBOSITY_RULES);
+		}
+		addRule(onlineRules, std::move(ruleO));
 	}
 
-	// Add the generated rules to the lists
-	activationRules.push_back(ruleA);
-	failRules.push_back(ruleF);
+	if(cc->getVerbosity() >= VERBOSITY_RULES) {
+		ss.str("Added new activation sync rule: ");
+		printSyncLineShort(ss, ruleA);
+		cc->reportAction2(ss.str(), VERBOSITY_RULES);
 
-	ss.str("Added new activation sync rule: ");
-	printSyncLineShort(ss, ruleA);
-	cc->reportAction2(ss.str(), VERBOSITY_RULES);
+		ss.str("Added new fail       sync rule: ");
+		printSyncLineShort(ss, ruleF);
+		cc->reportAction2(ss.str(), VERBOSITY_RULES);
+	}
 
-	ss.str("Added new fail       sync rule: ");
-	printSyncLineShort(ss, ruleF);
-	cc->reportAction2(ss.str(), VERBOSITY_RULES);
+	// Add the generated rules to the lists
+	addRule(activationRules, std::move(ruleA));
+	addRule(failRules, std::move(ruleF));
 
 	return 0;
 }
 
+DFT::EXPSyncRule& DFT::DFTreeEXPBuilder::addRule(vector<DFT::EXPSyncRule>& rules,
+                                                 DFT::EXPSyncRule&& rule)
+{
+	if(rule.syncOnNode)
+		rulesByNode[std::make_pair(&rules, rule.syncOnNode)].push_back(rules.size());
+	rules.push_back(std::move(rule));
+	return rules.back();
+}
+
 /** Add a rule between a child and any of its parents. */
 DFT::EXPSyncRule &DFT::DFTreeEXPBuilder::addAnycastRule(
 		vector<DFT::EXPSyncRule> &rules,
 		const DFT::Nodes::Gate &node,
-		EXPSyncItem *nodeSignal,
-		EXPSyncItem *childSignal,
+		const EXPSyncItem& nodeSignal,
+		const EXPSyncItem& childSignal,
 		std::string name_prefix,
 		unsigned int childNum)
 {
@@ -642,29 +957,32 @@ DFT::EXPSyncRule &DFT::DFTreeEXPBuilder::addAnycastRule(
 	rule.syncOnNode = &child;
 	rule.insertLabel(nodeID, nodeSignal);
 	rule.insertLabel(childID, childSignal);
-	std::stringstream report("Added new anycast sync rule: ");
-	printSyncLineShort(report, rule);
-	cc->reportAction3(report.str(), VERBOSITY_RULES);
-	rules.push_back(rule);
-	return rules[rules.size() - 1];
+	if(cc->getVerbosity() >= VERBOSITY_RULES) {
+		std::stringstream report("Added new anycast sync rule: ");
+		printSyncLineShort(report, rule);
+		cc->reportAction3(report.str(), VERBOSITY_RULES);
+	}
+	return addRule(rules, std::move(rule));
 }
 
 /** Add broadcast from a parent to all of its children */
 void DFT::DFTreeEXPBuilder::addInvBroadcastRule(vector<DFT::EXPSyncRule> &rules,
 											 const DFT::Nodes::Gate &node,
-											 EXPSyncItem *nodeSignal,
-											 EXPSyncItem *childSignal,
+											 const EXPSyncItem& nodeSignal,
+											 const EXPSyncItem& childSignal,
 											 std::string name_prefix,
 											 unsigned int childNum)
 {
 	const DFT::Nodes::Node *child = node.getChildren().at(childNum);
 	unsigned int nodeID = nodeIDs[&node];
-	for (auto &rule : rules) {
-		// If there is a rule that also synchronizes on the same node,
-		// we have come across a different child of this node.
-		if(rule.syncOnNode == &node) {
-			shared_ptr<EXPSyncItem> prevSignal = rule.label[nodeID];
-			if (prevSignal->toString() != nodeSignal->toString())
+	// If there is a rule that also synchronizes on the same node,
+	// we have come across a different child of this node.
+	auto synced = rulesByNode.find(std::make_pair(&rules, (const DFT::Nodes::Node*)&node));
+	if(synced != rulesByNode.end()) {
+		for(size_t r: synced->second) {
+			EXPSyncRule &rule = rules[r];
+			const EXPSyncItem* prevSignal = rule.findLabel(nodeID);
+			if (!prevSignal || *prevSignal != nodeSignal)
 				continue;
 			cc->reportAction3("Found earlier fail rule",VERBOSITY_RULEORIGINS);
 			rule.insertLabel(nodeIDs[child], childSignal);
@@ -673,25 +991,30 @@ void DFT::DFTreeEXPBuilder::addInvBroadcastRule(vector<DFT::EXPSyncRule> &rules,
 	}
 
 	EXPSyncRule &rule = addAnycastRule(rules, node, nodeSignal, childSignal, name_prefix, childNum);
+	// Index the rule by this node instead of the child
+	rulesByNode[std::make_pair(&rules, child)].pop_back();
 	rule.syncOnNode = &node;
+	rulesByNode[std::make_pair(&rules, rule.syncOnNode)].push_back(rules.size() - 1);
 }
 
 /** Add a rule broadcast from a child to all its parents. */
 void DFT::DFTreeEXPBuilder::addBroadcastRule(vector<DFT::EXPSyncRule> &rules,
 					     const DFT::Nodes::Gate &node,
-					     EXPSyncItem *nodeSignal,
-					     EXPSyncItem *childSignal,
+					     const EXPSyncItem& nodeSignal,
+					     const EXPSyncItem& childSignal,
 					     std::string name_prefix,
 					     unsigned int childNum)
 {
 	const DFT::Nodes::Node *child = node.getChildren().at(childNum);
 	unsigned int nodeID = nodeIDs[&node];
-	for (auto &rule : rules) {
-		// If there is a rule that also synchronizes on the same node,
-		// we have come across a child with another parent.
-		if(rule.syncOnNode == child) {
-			shared_ptr<EXPSyncItem> prevSignal = rule.label[nodeIDs[child]];
-			if (prevSignal->toString() != childSignal->toString())
+	// If there is a rule that also synchronizes on the same node,
+	// we have come across a child with another parent.
+	auto synced = rulesByNode.find(std::make_pair(&rules, child));
+	if(synced != rulesByNode.end()) {
+		for(size_t r: synced->second) {
+			EXPSyncRule &rule = rules[r];
+			const EXPSyncItem* prevSignal = rule.findLabel(nodeIDs[child]);
+			if (!prevSignal || *prevSignal != childSignal)
 				continue;
 			cc->reportAction3("Found earlier fail rule",VERBOSITY_RULEORIGINS);
 			rule.insertLabel(nodeID, nodeSignal);
@@ -705,7 +1028,7 @@ void DFT::DFTreeEXPBuilder::addBroadcastRule(vector<DFT::EXPSyncRule> &rules,
 /** Add a rule to make a given signal independent */
 void DFT::DFTreeEXPBuilder::addIndepRule(vector<DFT::EXPSyncRule> &rules,
 					     const DFT::Nodes::Node &node,
-					     EXPSyncItem *nodeSignal,
+					     const EXPSyncItem& nodeSignal,
 					     std::string name_prefix)
 {
 	unsigned int nodeID = nodeIDs[&node];
@@ -715,10 +1038,12 @@ void DFT::DFTreeEXPBuilder::addIndepRule(vector<DFT::EXPSyncRule> &rules,
 	EXPSyncRule rule(ss.str());
 	rule.syncOnNode = &node;
 	rule.insertLabel(nodeID, nodeSignal);
-	std::stringstream report("Added new independent sync rule: ");
-	printSyncLineShort(report, rule);
-	cc->reportAction2(report.str(),VERBOSITY_RULES);
-	rules.push_back(rule);
+	if(cc->getVerbosity() >= VERBOSITY_RULES) {
+		std::stringstream report("Added new independent sync rule: ");
+		printSyncLineShort(report, rule);
+		cc->reportAction2(report.str(),VERBOSITY_RULES);
+	}
+	addRule(rules, std::move(rule));
 }
 
 int DFT::DFTreeEXPBuilder::createSyncRule(
@@ -770,25 +1095,28 @@ int DFT::DFTreeEXPBuilder::createSyncRule(
 			cc->reportAction3("THIS node added to sync rule",
 							  VERBOSITY_RULEORIGINS);
 
-			// Go through all the existing activation rules
-			for (auto &otherRule : activationRules) {
-				// If there is a rule that also synchronizes on the same node,
-				// we have come across a child with another parent.
-				if(otherRule.syncOnNode != child)
-					continue;
-				std::stringstream report;
-				report << "Detected earlier activation rule: ";
-				printSyncLineShort(report, otherRule);
-				cc->reportAction3(report.str(), VERBOSITY_RULEORIGINS);
+			// Go through the existing activation rules that also
+			// synchronize on the same node: we have come across a
+			// child with another parent.
+			static const std::vector<size_t> none;
+			auto synced = rulesByNode.find(std::make_pair(&activationRules, child));
+			for (size_t r : synced == rulesByNode.end() ? none : synced->second) {
+				EXPSyncRule &otherRule = activationRules[r];
+				if(cc->getVerbosity() >= VERBOSITY_RULEORIGINS) {
+					std::stringstream report;
+					report << "Detected earlier activation rule: ";
+					printSyncLineShort(report, otherRule);
+					cc->reportAction3(report.str(), VERBOSITY_RULEORIGINS);
+				}
 
 				// First, we look up the sending Node of the
 				// current activation rule...
 				int otherNodeID = -1;
 				int otherLocalNodeID = -1;
-				for(auto& syncItem: otherRule.label) {
-					if(syncItem.second->getArg(1)) {
+				for(const auto& syncItem: otherRule.label) {
+					if(syncItem.second.getArg(1)) {
 						otherNodeID = syncItem.first;
-						otherLocalNodeID = syncItem.second->getArg(0);
+						otherLocalNodeID = syncItem.second.getArg(0);
 						break;
 					}
 				}
@@ -847,11 +1175,13 @@ int DFT::DFTreeEXPBuilder::createSyncRule(
 			ruleA.insertLabel(childID, syncActivate(0, false));
 			ruleD.insertLabel(childID, syncDeactivate(0, false));
 			cc->reportAction3("Child added to sync rule",VERBOSITY_RULEORIGINS);
-			report.str("Added new activation sync rule: ");
-			printSyncLineShort(report,ruleA);
-			cc->reportAction2(report.str(),VERBOSITY_RULES);
-			activationRules.push_back(ruleA);
-			activationRules.push_back(ruleD);
+			if(cc->getVerbosity() >= VERBOSITY_RULES) {
+				report.str("Added new activation sync rule: ");
+				printSyncLineShort(report,ruleA);
+				cc->reportAction2(report.str(),VERBOSITY_RULES);
+			}
+			addRule(activationRules, std::move(ruleA));
+			addRule(activationRules, std::move(ruleD));
 
 			addBroadcastRule(failRules, node, syncFail(n + 1), syncFail(0),
 							 "f_", n);
@@ -889,27 +1219,31 @@ int DFT::DFTreeEXPBuilder::createSyncRule(
 			rule.insertLabel(childID, syncRepairing(0));
 			cc->reportAction3("THIS node added to sync rule",
 							  VERBOSITY_RULEORIGINS);
-			for (auto &otherRule : repairingRules) {
-				// If there is a rule that also synchronizes on the same node,
-				// we have come across a child with another parent.
-				if(otherRule.syncOnNode != child)
-					continue;
-				std::stringstream report;
-				report << "Detected earlier repairing rule: ";
-				printSyncLineShort(report, otherRule);
-				cc->reportAction3(report.str(), VERBOSITY_RULEORIGINS);
+			// Go through the existing repairing rules that also
+			// synchronize on the same node: we have come across a
+			// child with another parent.
+			static const std::vector<size_t> none;
+			auto synced = rulesByNode.find(std::make_pair(&repairingRules, child));
+			for (size_t r : synced == rulesByNode.end() ? none : synced->second) {
+				EXPSyncRule &otherRule = repairingRules[r];
+				if(cc->getVerbosity() >= VERBOSITY_RULEORIGINS) {
+					std::stringstream report;
+					report << "Detected earlier repairing rule: ";
+					printSyncLineShort(report, otherRule);
+					cc->reportAction3(report.str(), VERBOSITY_RULEORIGINS);
+				}
 
 				// First, we look up the sending Node of the
 				// current repairing rule...
 				int otherNodeID = -1;
 				int otherLocalNodeID = -1;
-				for(auto& syncItem: otherRule.label) {
-					if (syncItem.second->args.size() == 1)
+				for(const auto& syncItem: otherRule.label) {
+					if (syncItem.second.getArgCount() == 1)
 						continue;
-					std::cerr << "Looking up " << syncItem.second->toString() << "\n";
-					if(syncItem.second->getArg(1)) {
+					std::cerr << "Looking up " << syncItem.second.toString() << "\n";
+					if(syncItem.second.getArg(1)) {
 						otherNodeID = syncItem.first;
-						otherLocalNodeID = syncItem.second->getArg(0);
+						otherLocalNodeID = syncItem.second.getArg(0);
 						break;
 					}
 				}
@@ -933,7 +1267,7 @@ int DFT::DFTreeEXPBuilder::createSyncRule(
 				cc->reportAction3("Detected (other) repair unit `" + otherNode->getName() + "', added to sync rule",VERBOSITY_RULEORIGINS);
 
 			}
-			repairingRules.push_back(rule);
+			addRule(repairingRules, std::move(rule));
 		} else if(node.matchesType(DFT::Nodes::InspectionType)) {
 			addBroadcastRule(inspectionRules, node, syncInspection(n+1),
 							 syncInspection(0), "insp_", n);
@@ -947,16 +1281,17 @@ int DFT::DFTreeEXPBuilder::createSyncRule(
 			const DFT::Nodes::Inspection *insp = static_cast<const DFT::Nodes::Inspection *>(&node);
 			if (insp->getPhases() == 0) {
 				std::string l = "time " + insp->getLambda().str();
-				EXPSyncItem *RR = new EXPSyncItem(l);
 				unsigned int nodeID = nodeIDs[&node];
 
 				EXPSyncRule rule(l, false);
 				rule.syncOnNode = &node;
-				rule.insertLabel(nodeID, RR);
-				std::stringstream report("Added new timed sync rule: ");
-				printSyncLineShort(report, rule);
-				cc->reportAction2(report.str(),VERBOSITY_RULES);
-				inspectionRules.push_back(rule);
+				rule.insertLabel(nodeID, EXPSyncItem(l));
+				if(cc->getVerbosity() >= VERBOSITY_RULES) {
+					std::stringstream report("Added new timed sync rule: ");
+					printSyncLineShort(report, rule);
+					cc->reportAction2(report.str(),VERBOSITY_RULES);
+				}
+				addRule(inspectionRules, std::move(rule));
 			}
 		} else if(DFT::Nodes::Node::typeMatch(node.getType(),
 											  DFT::Nodes::ReplacementType))
@@ -1000,16 +1335,17 @@ int DFT::DFTreeEXPBuilder::createSyncRule(
 
 void DFT::DFTreeEXPBuilder::calculateColumnWidths(
 		vector<unsigned int>& columnWidths,
-		const vector<DFT::EXPSyncRule>& syncRules)
+		const vector<DFT::EXPSyncRule>& syncRules) const
 {
+	std::string s;
 	for (const DFT::EXPSyncRule &rule : syncRules) {
-		std::map<unsigned int, std::shared_ptr<EXPSyncItem>>::const_iterator it = rule.label.begin();
-		for(;it!=rule.label.end();++it) {
-			assert( (0<=it->first) );
-			assert( (it->first<columnWidths.size()) );
-			std::string s = it->second->toStringQuoted();
-			if(s.length() > columnWidths[it->first]) {
-				columnWidths[it->first] = s.length();
+		for(const auto& item: rule.label) {
+			assert( (item.first<columnWidths.size()) );
+			s.clear();
+			item.second.appendTo(s);
+			// Two doublequotes are added when printing
+			if(s.length() + 2 > columnWidths[item.first]) {
+				columnWidths[item.first] = s.length() + 2;
 			}
 		}
 	}
@@ -14,7 +14,10 @@ class DFTreeEXPBuilder;
 #ifndef DFTREEEXPBUILDER_H
 #define DFTREEEXPBUILDER_H
 
+#include <algorithm>
+#include <cstdint>
 #include <set>
+#include <stdexcept>
 #include <map>
 #include <vector>
 #include <iostream>
@@ -31,66 +34,86 @@ namespace DFT {
 
 /**
  * This class reflects how one Node is synchronized in a synchronization rule.
- * It consists of a gate name and a list of arguments.
+ * It consists of a gate name and up to two arguments. Items are plain
+ * values: the gate name is interned, so copying and comparing an item
+ * does not touch the heap.
  */
-
 class EXPSyncItem {
 public:
-	std::string name;
-	vector<int> args;
+	/// How the arguments are rendered
+	enum Format: uint8_t {
+		INTS,     ///< ' !' <arg> for every argument
+		INT_BOOL, ///< ' !' <arg0> ' !' (TRUE|FALSE)
+		BOOL      ///< ' !' (TRUE|FALSE)
+	};
+
+protected:
+	const std::string* name;
+	uint8_t format;
+	uint8_t nargs;
+	int args[2];
+
+	EXPSyncItem(const std::string& name, Format format, int nargs, int arg1, int arg2):
+		name(intern(name)),
+		format(format),
+		nargs(nargs),
+		args{arg1, arg2} {
+	}
+
 public:
-	EXPSyncItem(std::string name):
-		name(name) {
+	EXPSyncItem(const std::string& name):
+		EXPSyncItem(name, INTS, 0, 0, 0) {
 	}
-	EXPSyncItem(std::string name, int arg1):
-		name(name) {
-		args.push_back(arg1);
+	EXPSyncItem(const std::string& name, int arg1):
+		EXPSyncItem(name, INTS, 1, arg1, 0) {
 	}
-	EXPSyncItem(std::string name, int arg1, int arg2):
-		name(name) {
-		args.push_back(arg1);
-		args.push_back(arg2);
+	EXPSyncItem(const std::string& name, int arg1, int arg2):
+		EXPSyncItem(name, INTS, 2, arg1, arg2) {
 	}
 
+	/**
+	 * Returns the single copy of the specified string, which lives as
+	 * long as the program.
+	 */
+	static const std::string* intern(const std::string& s);
+
 	/**
 	 * Returns the arguments used to synchronize on.
 	 * @return The arguments used to synchronize on.
 	 */
-	int getArg(unsigned int n) const { return args.at(n); }
-	
-	/**
-	 * Sets the argument used to synchronize on at the specified index.
-	 * If there are unspecified arguments before the specified index, they
-	 * will be initialized to 0.
-	 * @param n The index of the new argument used to syncrhonize on.
-	 * @param v The new argument used to syncrhonize on.
-	 */
-	void setArg(unsigned int n, int v) {
-		while(args.size()<n) {
-			args.push_back(0);
-		}
-		args.at(n) = v;
+	int getArg(unsigned int n) const {
+		if(n >= nargs)
+			throw std::out_of_range("EXPSyncItem has no such argument");
+		return args[n];
 	}
-	
+
+	/**
+	 * Returns the number of arguments used to synchronize on.
+	 */
+	unsigned int getArgCount() const { return nargs; }
+
 	/**
 	 * Returns the name of the gate used to synchronize on.
 	 * @return The name of the gate used to synchronize on.
 	 */
-	const std::string& getName() const { return name; }
-	
+	const std::string& getName() const { return *name; }
+
 	/**
-	 * Returns the label to be synchronized on. This is a textual
-	 * representation of this class. The format is:
-	 *  <gate name> ( ' !' <arg> )+
+	 * Appends the label to be synchronized on to the specified string.
+	 * The format is:
+	 *  <gate name> ( ' !' <arg> )*
+	 * with boolean arguments represented as TRUE/FALSE.
+	 */
+	void appendTo(std::string& out) const;
+
+	/**
+	 * Returns the label to be synchronized on, as appended by appendTo().
 	 * @return The label to synchronize on.
 	 */
-	virtual std::string toString() const {
-		std::stringstream ss;
-		ss << name;
-		for(size_t n=0; n<args.size(); ++n) {
-			ss << " !" << args.at(n);
-		}
-		return ss.str();
+	std::string toString() const {
+		std::string ret;
+		appendTo(ret);
+		return ret;
 	}
 	/**
 	 * Returns the label to be synchronized on. This is a textual
@@ -98,58 +121,44 @@ public:
 	 * with doublequotes added.
 	 * @return The label to synchronize on.
 	 */
-	virtual std::string toStringQuoted() const {
-		return "\"" + toString() + "\"";
+	std::string toStringQuoted() const {
+		std::string ret(1, '"');
+		appendTo(ret);
+		ret += '"';
+		return ret;
+	}
+
+	/**
+	 * Two items are equal if they render the same label.
+	 */
+	bool operator==(const EXPSyncItem& other) const {
+		return name == other.name && format == other.format
+		    && nargs == other.nargs
+		    && (nargs < 1 || args[0] == other.args[0])
+		    && (nargs < 2 || args[1] == other.args[1]);
+	}
+	bool operator!=(const EXPSyncItem& other) const {
+		return !(*this == other);
 	}
 };
 
+/**
+ * An EXPSyncItem with an integer and a boolean argument.
+ */
 class EXPSyncItemIB: public EXPSyncItem {
 public:
-	EXPSyncItemIB(std::string name, int arg1):
-		EXPSyncItem(name,arg1) {
-	}
-	EXPSyncItemIB(std::string name, int arg1, bool arg2):
-		EXPSyncItem(name,arg1,arg2?1:0) {
-	}
-	
-	/**
-	 * Returns the label to be synchronized on. This is a textual
-	 * representation of this class. The format is:
-	 *  <gate name> ' !' arg0 ' !' arg1
-	 * Node that arg0 is represented as Integer
-	 * and that arg1 is represented as boolean (TRUE/FALSE)
-	 * @return The label to synchronize on.
-	 */
-	virtual std::string toString() const {
-		assert( (args.size()==2) && "EXPSyncItemIB should have two arguments");
-		std::stringstream ss;
-		ss << name;
-		ss << " !" << args.at(0);
-		ss << " !" << (args.at(1)?"TRUE":"FALSE");
-		return ss.str();
+	EXPSyncItemIB(const std::string& name, int arg1, bool arg2):
+		EXPSyncItem(name, INT_BOOL, 2, arg1, arg2?1:0) {
 	}
 };
 
+/**
+ * An EXPSyncItem with a single boolean argument.
+ */
 class EXPSyncItemB: public EXPSyncItem {
 public:
-	EXPSyncItemB(std::string name, bool arg1):
-		EXPSyncItem(name,arg1) {
-	}
-	
-	/**
-	 * Returns the label to be synchronized on. This is a textual
-	 * representation of this class. The format is:
-	 *  <gate name> ' !' arg0 ' !' arg1
-	 * Node that arg0 is represented as Integer
-	 * and that arg1 is represented as boolean (TRUE/FALSE)
-	 * @return The label to synchronize on.
-	 */
-	virtual std::string toString() const {
-		assert( (args.size()==1) && "EXPSyncItemB should have one argument");
-		std::stringstream ss;
-		ss << name;
-		ss << " !" << (args.at(0)?"TRUE":"FALSE");
-		return ss.str();
+	EXPSyncItemB(const std::string& name, bool arg1):
+		EXPSyncItem(name, BOOL, 1, arg1?1:0, 0) {
 	}
 };
 
@@ -164,8 +173,8 @@ public:
  */
 class EXPSyncRule {
 public:
-	/// A mapping from NodeID to EXPSyncItem
-	std::map<unsigned int,std::shared_ptr<EXPSyncItem>> label;
+	/// The EXPSyncItem of every NodeID taking part, sorted by NodeID
+	std::vector<std::pair<unsigned int,EXPSyncItem>> label;
 	
 	/// The renamed label name
 	std::string toLabel;
@@ -192,9 +201,79 @@ public:
 		syncOnNode(NULL) {
 	}
 
-	void insertLabel(unsigned int pos, EXPSyncItem *item) {
-		label.insert(std::pair<unsigned int, std::shared_ptr<EXPSyncItem>>(pos, std::shared_ptr<EXPSyncItem>(item)));
+	/**
+	 * Adds the specified item for the specified NodeID, unless the
+	 * NodeID takes part already.
+	 */
+	void insertLabel(unsigned int pos, const EXPSyncItem& item) {
+		auto it = std::lower_bound(label.begin(), label.end(), pos,
+			[](const std::pair<unsigned int,EXPSyncItem>& l, unsigned int p) {
+				return l.first < p;
+			});
+		if(it == label.end() || it->first != pos)
+			label.insert(it, std::make_pair(pos, item));
+	}
+
+	/**
+	 * Returns the item of the specified NodeID, or NULL if it does not
+	 * take part.
+	 */
+	const EXPSyncItem* findLabel(unsigned int pos) const {
+		auto it = std::lower_bound(label.begin(), label.end(), pos,
+			[](const std::pair<unsigned int,EXPSyncItem>& l, unsigned int p) {
+				return l.first < p;
+			});
+		return it != label.end() && it->first == pos ? &it->second : NULL;
+	}
+};
+
+/**
+ * This class reflects one process of the parallel composition in a
+ * generated EXP file: the automaton file of a Node, and the total renaming
+ * applied to its labels (e.g., of failure gates to rates).
+ */
+class EXPProcess {
+public:
+	/// The automaton file of the process
+	std::string file;
+
+	/// The same automaton in binary format, or empty if there is none
+	std::string binaryFile;
+
+	/// Pairs of (label, new label). A label may be renamed more than once.
+	std::vector<std::pair<std::string, std::string>> renames;
+
+	/// The processes of the children of the Node, to guide composition
+	std::vector<unsigned int> children;
+
+public:
+	EXPProcess(const std::string& file):
+		file(file) {
+	}
+
+	void rename(const std::string& from, const std::string& to) {
+		renames.push_back(std::make_pair(from, to));
 	}
+
+	/**
+	 * Returns the EXP behaviour of this process, i.e., the quoted file
+	 * name, wrapped in a total rename if there are renames.
+	 * @return The EXP behaviour of this process.
+	 */
+	std::string toString() const;
+};
+
+/**
+ * The parallel composition described by a generated EXP file, in a form
+ * that can be composed without EXP.OPEN.
+ * Process 0 is the toplevel process, process i the Node with ID i. The
+ * synchronization rules refer to processes by the same index. The
+ * syncOnNode of the rules is not set, since the DFT may be gone.
+ */
+class EXPComposition {
+public:
+	std::vector<EXPProcess> processes;
+	std::vector<EXPSyncRule> rules;
 };
 
 /**
@@ -213,43 +292,56 @@ private:
 	
 	FileWriter svl_header;
 	FileWriter svl_body;
-	FileWriter exp_header;
-	FileWriter exp_body;
 
 	std::vector<DFT::Nodes::BasicEvent*> basicEvents;
 	std::vector<DFT::Nodes::Gate*> gates;
 	std::map<const DFT::Nodes::Node*, unsigned int> nodeIDs;
+
+	std::vector<DFT::EXPSyncRule> allRules;
+	std::vector<DFT::EXPProcess> processes;
+
+	/// The index in its vector of every rule synchronizing on a Node,
+	/// by vector and Node
+	std::map<std::pair<const vector<DFT::EXPSyncRule>*, const DFT::Nodes::Node*>,
+	         std::vector<size_t>> rulesByNode;
+
+	/**
+	 * Appends the specified rule to the specified vector, indexing it
+	 * by its syncOnNode.
+	 * @return The rule in the vector.
+	 */
+	DFT::EXPSyncRule& addRule(vector<DFT::EXPSyncRule>& rules, DFT::EXPSyncRule&& rule);
 	
-	void writeRules(vector<DFT::EXPSyncRule>& rules,
-					vector<unsigned int> columnWidths);
-	void writeHideLines(vector<DFT::EXPSyncRule>& rules);
+	void writeRules(std::ostream& out, const vector<DFT::EXPSyncRule>& rules,
+	                const vector<unsigned int>& columnWidths) const;
+	void writeHideLines(std::ostream& out, const vector<DFT::EXPSyncRule>& rules) const;
 	int validateReferences();
-	void printSyncLine(const EXPSyncRule& rule, const vector<unsigned int>& columnWidths);
+	void printSyncLine(std::string& line, const EXPSyncRule& rule, const vector<unsigned int>& columnWidths) const;
 	void printSyncLineShort(std::ostream& stream, const EXPSyncRule& rule);
 
 	void addBroadcastRule(vector<DFT::EXPSyncRule> &rules,
 						  const DFT::Nodes::Gate &node,
-						  EXPSyncItem *nodeSignal,
-						  EXPSyncItem *childSignal,
+						  const EXPSyncItem& nodeSignal,
+						  const EXPSyncItem& childSignal,
 						  std::string name_prefix,
 						  unsigned int childNum);
 
 	void addInvBroadcastRule(vector<DFT::EXPSyncRule> &rules,
 	                         const DFT::Nodes::Gate &node,
-	                         EXPSyncItem *nodeSignal,
-	                         EXPSyncItem *childSignal,
+	                         const EXPSyncItem& nodeSignal,
+	                         const EXPSyncItem& childSignal,
 	                         std::string name_prefix,
 	                         unsigned int childNum);
 
 	void addIndepRule(vector<DFT::EXPSyncRule> &rules,
 					     const DFT::Nodes::Node &node,
-					     EXPSyncItem *nodeSignal,
+					     const EXPSyncItem& nodeSignal,
 					     std::string name_prefix);
 
 	DFT::EXPSyncRule& addAnycastRule(vector<DFT::EXPSyncRule> &rules,
 	                                 const DFT::Nodes::Gate &node,
-	                                 EXPSyncItem *nodeSignal,
-	                                 EXPSyncItem *childSignal,
+	                                 const EXPSyncItem& nodeSignal,
+	                                 const EXPSyncItem& childSignal,
 	                                 std::string name_prefix,
 	                                 unsigned int childNum);
 
@@ -269,63 +361,63 @@ public:
 	}
 
 	/**
-	 * Returns an EXP formatted string reflecting the specified Basic Event.
+	 * Returns the EXP process reflecting the specified Basic Event.
 	 * Takes into account the renaming of failure rates.
-	 * @param be The Basic Event of which an EXP formatted strign is wanted.
-	 */	 
-	std::string getBEProc(const DFT::Nodes::BasicEvent& be) const;
+	 * @param be The Basic Event of which the EXP process is wanted.
+	 */
+	DFT::EXPProcess getBEProcess(const DFT::Nodes::BasicEvent& be) const;
 	
 	/**
-	 * Returns an EXP formatted string reflecting the specified Repair Unit.
-	 * Takes into account the renaming of failure rates.
-	 * @param ru The Repair Unit of which an EXP formatted strign is wanted.
+	 * Returns the EXP process reflecting the specified Repair Unit.
+	 * Takes into account the renaming of repair rates.
+	 * @param ru The Repair Unit of which the EXP process is wanted.
 	 */
-	std::string getRUProc(const DFT::Nodes::Gate& ru) const;
-    
-    /**
-     * Returns an EXP formatted string reflecting the specified inspection.
-     * Takes into account the renaming of inspection rates.
-     * @param insp The inspection Unit of which an EXP formatted strign is wanted.
-     */
-    std::string getINSPProc(const DFT::Nodes::Inspection& insp) const;
-    
-    /**
-     * Returns an EXP formatted string reflecting the specified replacement.
-     * Takes into account the renaming of inspection rates.
-     * @param rep The replacement Unit of which an EXP formatted strign is wanted.
-     */
-    std::string getREPProc(const DFT::Nodes::Replacement& rep) const;
+	DFT::EXPProcess getRUProcess(const DFT::Nodes::Gate& ru) const;
+	
+	/**
+	 * Returns the EXP process reflecting the specified inspection.
+	 * Takes into account the renaming of inspection rates.
+	 * @param insp The inspection Unit of which the EXP process is wanted.
+	 */
+	DFT::EXPProcess getINSPProcess(const DFT::Nodes::Inspection& insp) const;
+	
+	/**
+	 * Returns the EXP process reflecting the specified replacement.
+	 * Takes into account the renaming of replacement rates.
+	 * @param rep The replacement Unit of which the EXP process is wanted.
+	 */
+	DFT::EXPProcess getREPProcess(const DFT::Nodes::Replacement& rep) const;
 
 	/**
-	 * Start building EXP specification from the DFT specified
-	 * in the constructor.
-	 * @return UNDECIDED
+	 * Returns the EXP process of the automaton generated for the
+	 * specified Node, without renaming.
+	 * @param node The Node of which the EXP process is wanted.
 	 */
-	int build();
+	DFT::EXPProcess getNodeFileProcess(const DFT::Nodes::Node& node) const;
 
 	/**
-	 * Affects FileWriters: exp_header
-	 * @return UNDECIDED
+	 * Returns the EXP process reflecting the specified Node.
+	 * @param node The Node of which the EXP process is wanted.
 	 */
-	int buildEXPHeader(vector<DFT::EXPSyncRule>& activationRules, vector<DFT::EXPSyncRule>& failRules);
+	DFT::EXPProcess getProcess(const DFT::Nodes::Node& node) const;
 
 	/**
-	 * Builds the actual composition script from the DFT specification
-	 * Affects FileWriters: exp_body
+	 * Start building EXP specification from the DFT specified
+	 * in the constructor.
 	 * @return UNDECIDED
 	 */
-	int buildEXPBody(vector<DFT::EXPSyncRule>& activationRules, vector<DFT::EXPSyncRule>& failRules);
+	int build();
 
     /**
      * Builds the rule system for the to be generated EXP file.
-     * Calls to buildEXPBody() and buildEXPHeader() should be valid after this.
+     * Calls to buildEXPBody() should be valid after this.
      * @return UNDECIDED
      */
     int parseDFT(vector<DFT::EXPSyncRule> &impossibleRules, vector<DFT::EXPSyncRule>& activationRules, vector<DFT::EXPSyncRule>& failRules, vector<DFT::EXPSyncRule>& repairRules, vector<DFT::EXPSyncRule>& repairedRules, vector<DFT::EXPSyncRule>& repairingRules, vector<DFT::EXPSyncRule>& onlineRules, vector<DFT::EXPSyncRule>& inspectionRules);
 
     /**
-     * Builds the actual composition script from the DFT specification
-     * Affects FileWriters: exp_body
+     * Collects the synchronization rules and the processes of the
+     * composition, for printEXP() and getComposition().
      * @return UNDECIDED
      */
     int buildEXPBody(vector<DFT::EXPSyncRule> &impossibleRules, vector<DFT::EXPSyncRule>& activationRules, vector<DFT::EXPSyncRule>& failRules, vector<DFT::EXPSyncRule>& repairRules, vector<DFT::EXPSyncRule>& repairedRules, vector<DFT::EXPSyncRule>& repairingRules, vector<DFT::EXPSyncRule>& onlineRules, vector<DFT::EXPSyncRule>& inspectionRules);
@@ -343,104 +435,104 @@ public:
 	const DFT::Nodes::Node* getNodeWithID(unsigned int id);
 
 	/**
-	 * Create a new EXPSyncItem instance reflecting an Activate action
+	 * Create an EXPSyncItem reflecting an Activate action
 	 * based on the specified localNodeID and if this is the sendign action
 	 * or not.
 	 * @param localNodeID This is the ID of the Node seen from the actor.
 	 * @param sending Whether this is a sending action or not.
-	 * @return A new EXPSyncItem instance.
+	 * @return The EXPSyncItem.
 	 */
-	EXPSyncItem *syncActivate(unsigned int localNodeID, bool sending) {
-		return new EXPSyncItemIB(automata::signals::GATE_ACTIVATE,localNodeID,sending);
+	EXPSyncItem syncActivate(unsigned int localNodeID, bool sending) {
+		return EXPSyncItemIB(automata::signals::GATE_ACTIVATE,localNodeID,sending);
 	}
 
-	EXPSyncItem *syncDeactivate(unsigned int localNodeID, bool sending) {
-		return new EXPSyncItemIB(automata::signals::GATE_DEACTIVATE,localNodeID,sending);
+	EXPSyncItem syncDeactivate(unsigned int localNodeID, bool sending) {
+		return EXPSyncItemIB(automata::signals::GATE_DEACTIVATE,localNodeID,sending);
 	}
 
 	/**
-	 * Create a new EXPSyncItem instance reflecting a Fail action
+	 * Create an EXPSyncItem reflecting a Fail action
 	 * based on the specified localNodeID.
 	 * @param localNodeID This is the ID of the Node seen from the actor.
-	 * @return A new EXPSyncItem instance.
+	 * @return The EXPSyncItem.
 	 */
-	EXPSyncItem *syncFail(unsigned int localNodeID) {
-		return new EXPSyncItem(automata::signals::GATE_FAIL,localNodeID);
+	EXPSyncItem syncFail(unsigned int localNodeID) {
+		return EXPSyncItem(automata::signals::GATE_FAIL,localNodeID);
 	}
 
-	EXPSyncItem *syncImpossible() {
-		return new EXPSyncItem(automata::signals::GATE_IMPOSSIBLE);
+	EXPSyncItem syncImpossible() {
+		return EXPSyncItem(automata::signals::GATE_IMPOSSIBLE);
 	}
 
 	/**
-	 * Create a new EXPSyncItem instance reflecting a Repair action.
+	 * Create an EXPSyncItem reflecting a Repair action.
 	 * @param direction: input (false) or output (true)
-	 * @return A new EXPSyncItem instance.
+	 * @return The EXPSyncItem.
 	 */
-	EXPSyncItem *syncRepair(bool direction) {
-		return new EXPSyncItemB(automata::signals::GATE_REPAIR,direction);
+	EXPSyncItem syncRepair(bool direction) {
+		return EXPSyncItemB(automata::signals::GATE_REPAIR,direction);
 	}
 
 	/**
-	 * Create a new EXPSyncItem instance reflecting a Repair action
+	 * Create an EXPSyncItem reflecting a Repair action
 	 * based on the specified localNodeID.
 	 * @param localNodeID This is the ID of the Node seen from the actor.
-	 * @return A new EXPSyncItem instance.
+	 * @return The EXPSyncItem.
 	 */
-	EXPSyncItem *syncRepair(size_t localNodeID) {
-		return new EXPSyncItem(automata::signals::GATE_REPAIR,localNodeID);
+	EXPSyncItem syncRepair(size_t localNodeID) {
+		return EXPSyncItem(automata::signals::GATE_REPAIR,localNodeID);
 	}
 
 	/**
-	 * Create a new EXPSyncItem instance reflecting a Repairing action
+	 * Create an EXPSyncItem reflecting a Repairing action
 	 * based on the specified localNodeID.
 	 * @param localNodeID This is the ID of the Node seen from the actor.
-	 * @return A new EXPSyncItem instance.
+	 * @return The EXPSyncItem.
 	 */
-	EXPSyncItem *syncRepairing(unsigned int localNodeID) {
-		return new EXPSyncItem(automata::signals::GATE_REPAIRING,localNodeID);
+	EXPSyncItem syncRepairing(unsigned int localNodeID) {
+		return EXPSyncItem(automata::signals::GATE_REPAIRING,localNodeID);
 	}
 
 	/**
-	 * Create a new EXPSyncItem instance reflecting a Repairing action
+	 * Create an EXPSyncItem reflecting a Repairing action
 	 * based on the specified localNodeID.
 	 * @param localNodeID This is the ID of the Node seen from the actor.
 	 * @param direction: input (false) or output (true)
-	 * @return A new EXPSyncItem instance.
+	 * @return The EXPSyncItem.
 	 */
-	EXPSyncItem *syncRepairing(unsigned int localNodeID, bool direction) {
-		return new EXPSyncItemIB(automata::signals::GATE_REPAIRING,localNodeID, direction);
+	EXPSyncItem syncRepairing(unsigned int localNodeID, bool direction) {
+		return EXPSyncItemIB(automata::signals::GATE_REPAIRING,localNodeID, direction);
 	}
 
 	/**
-	 * Create a new EXPSyncItem instance reflecting a Online action
+	 * Create an EXPSyncItem reflecting a Online action
 	 * based on the specified localNodeID.
 	 * @param localNodeID This is the ID of the Node seen from the actor.
-	 * @return A new EXPSyncItem instance.
+	 * @return The EXPSyncItem.
 	 */
-	EXPSyncItem *syncOnline(unsigned int localNodeID) {
-		return new EXPSyncItem(automata::signals::GATE_ONLINE,localNodeID);
+	EXPSyncItem syncOnline(unsigned int localNodeID) {
+		return EXPSyncItem(automata::signals::GATE_ONLINE,localNodeID);
 	}
 
 	/**
-	 * Create a new EXPSyncItem instance reflecting an Repaired action
+	 * Create an EXPSyncItem reflecting an Repaired action
 	 * based on the specified localNodeID and if this is the sendign action
 	 * or not.
 	 * @param localNodeID This is the ID of the Node seen from the actor.
-	 * @return A new EXPSyncItem instance.
+	 * @return The EXPSyncItem.
 	 */
-	EXPSyncItem *syncRepaired(unsigned int localNodeID) {
-		return new EXPSyncItem(automata::signals::GATE_REPAIRED,localNodeID);
+	EXPSyncItem syncRepaired(unsigned int localNodeID) {
+		return EXPSyncItem(automata::signals::GATE_REPAIRED,localNodeID);
 	}
     
     /**
-     * Create a new EXPSyncItem instance reflecting a Inspection action
+     * Create an EXPSyncItem reflecting a Inspection action
      * based on the specified localNodeID.
      * @param localNodeID This is the ID of the Node seen from the actor.
-     * @return A new EXPSyncItem instance.
+     * @return The EXPSyncItem.
      */
-    EXPSyncItem *syncInspection(unsigned int localNodeID) {
-        return new EXPSyncItem(automata::signals::GATE_INSPECT,localNodeID);
+    EXPSyncItem syncInspection(unsigned int localNodeID) {
+        return EXPSyncItem(automata::signals::GATE_INSPECT,localNodeID);
     }
 
 	int createSyncRuleGateFDEP(vector<DFT::EXPSyncRule>& activationRules, vector<DFT::EXPSyncRule>& failRules, const DFT::Nodes::GateFDEP& node, unsigned int nodeID);
@@ -463,19 +555,48 @@ public:
 	 * Elements of columnWidths are only updated if the
 	 * existing value is smaller than the calculated value.
 	 */
-	void calculateColumnWidths(vector<unsigned int>& columnWidths, const vector<DFT::EXPSyncRule>& syncRules);
+	void calculateColumnWidths(vector<unsigned int>& columnWidths, const vector<DFT::EXPSyncRule>& syncRules) const;
 
 	/**
-	 * Print the generated EXP output to the specified stream.
+	 * Print the generated EXP output to the specified stream, as the
+	 * dense composition of printDenseEXP() unless its rule table would
+	 * be too large, and as the sparse one of printSparseEXP() otherwise.
 	 * @param out The generated EXP output will be streamed to this stream.
 	 */
-	void printEXP(std::ostream& out);
+	void printEXP(std::ostream& out) const;
+
+	/**
+	 * Print the generated EXP output to the specified stream as a single
+	 * label par of all processes, with a column in every synchronization
+	 * vector for every process. The size of the output is the number of
+	 * rules times the number of processes.
+	 * @param out The generated EXP output will be streamed to this stream.
+	 */
+	void printDenseEXP(std::ostream& out) const;
+
+	/**
+	 * Print the generated EXP output to the specified stream as nested
+	 * label pars of two operands each, following the DFT bottom-up as
+	 * the native composer does. A rule only has vectors in the pars on
+	 * the way from its processes to the smallest par containing them
+	 * all, where it gets its label (or is hidden), and a visible label
+	 * has a vector passing it on in every par above that one.
+	 * @param out The generated EXP output will be streamed to this stream.
+	 */
+	void printSparseEXP(std::ostream& out) const;
 
 	/**
 	 * Print the generated SVL output to the specified stream.
 	 * @param out The generated SVL output will be streamed to this stream.
 	 */
 	void printSVL(std::ostream& out);
+
+	/**
+	 * Stores the composition generated by build() in the specified
+	 * EXPComposition.
+	 * @param out The generated composition will be stored here.
+	 */
+	void getComposition(EXPComposition& out) const;
 	
 	void setTopName(std::string name) {
 		nameTop = name;
@@ -10,8 +10,13 @@ protected:
 	const DFT::DFTree* dft;
 	CompilerContext* cc;
 
-	static std::string getNodeName(const DFT::Nodes::Node& node);
 public:
+	/**
+	 * Returns the name of the node automaton for the specified node,
+	 * which identifies its behaviour up to the rates of basic events.
+	 */
+	static std::string getNodeName(const DFT::Nodes::Node& node);
+
 	DFTreeNodeBuilder(DFT::DFTree* dft, CompilerContext* cc)
 		:dft(dft), cc(cc)
 	{ }
@@ -21,6 +26,15 @@ public:
 	 * @return he Lotos NT File needed for the specified node.
 	 */
 	virtual std::string getFileForNode(const Nodes::Node& node) = 0;
+
+	/**
+	 * Returns the file holding the same automaton as
+	 * getFileForNode() in binary format (see automata/binary.h), or
+	 * the empty string if the builder makes none.
+	 */
+	virtual std::string getBinaryFileForNode(const Nodes::Node&) {
+		return "";
+	}
 	virtual std::string getFileForTopLevel() = 0;
 	virtual std::string getRoot() = 0;
 	virtual int generate() = 0;
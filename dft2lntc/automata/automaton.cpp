@@ -1,71 +1,300 @@
 #include "automata/automaton.h"
-#include <set>
+#include "automata/binary.h"
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <numeric>
 
-void automaton::write(std::ostream &out)
+/* Explores the automaton, and collapses and sorts its transitions.
+ * Does nothing if it has been built already.
+ */
+void automaton::build()
 {
-	const state *init = initial_state();
-	add_state(init->copy());
+	if (!first.empty())
+		return;
+	std::unique_ptr<state> cursor(initial_state()->copy());
+	cursor->normalize();
+	add_state(cursor->words);
 	size_t pos = 0;
-	size_t n_transitions = 0;
-	while (pos < states.size()) {
-		state *s = states[pos];
-		s->initialize_outgoing();
+	while (pos < n_states) {
+		cursor->load(&state_words[pos * n_words]);
+		first.push_back(transitions.size());
+		cursor->initialize_outgoing();
 		pos++;
 	}
+	first.push_back(transitions.size());
+	std::vector<uint32_t>().swap(table);
 	tau_collapse();
-	for (const state *s : states)
-		n_transitions += s->outgoing.size();
-	out << "des (0, " << n_transitions << ", " << states.size()
+
+	text.reserve(labels.size());
+	for (const automata::label &label : labels)
+		text.push_back(label.str());
+	sort_transitions(text);
+}
+
+void automaton::write(std::ostream &out)
+{
+	build();
+	out << "des (0, " << transitions.size() << ", " << n_states
 	<< ")\n";
-	for (pos = 0; pos < states.size(); pos++) {
-		for (auto transition : states[pos]->outgoing) {
+	for (size_t pos = 0; pos < n_states; pos++) {
+		for (size_t i = first[pos]; i < first[pos + 1]; i++) {
 			out << "(" << pos << ", \""
-			<< transition.first << "\", "
-			<< transition.second << ") "
-			//<< (std::string) *states[pos]
+			<< text[transitions[i].label] << "\", "
+			<< transitions[i].target << ") "
 			<< "\n";
 		}
 	}
 }
 
-static void merge(std::set<std::pair<std::string, size_t>> &target,
-                  const std::set<std::pair<std::string, size_t>> &source)
+void automaton::write_binary(std::ostream &out)
 {
-	for (auto &entry : source)
-		target.emplace(entry.first, entry.second);
+	using namespace automata::binary;
+	build();
+	std::string buf(MAGIC, sizeof(MAGIC));
+	put(buf, VERSION);
+	put(buf, 0);
+	put(buf, n_states);
+	put(buf, transitions.size());
+	put(buf, text.size());
+	for (const std::string &label : text) {
+		put(buf, label.size());
+		buf += label;
+	}
+	for (size_t pos = 0; pos < n_states; pos++) {
+		put(buf, first[pos + 1] - first[pos]);
+		for (size_t i = first[pos]; i < first[pos + 1]; i++) {
+			put(buf, transitions[i].label);
+			put(buf, zigzag((int64_t)transitions[i].target - (int64_t)pos));
+		}
+	}
+	out.write(buf.data(), buf.size());
 }
 
-void automaton::tau_collapse()
+/* Mixes every word through the finaliser of MurmurHash3, so that states
+ * differing in a single field still spread over the table.
+ */
+uint64_t automaton::hash(const uint64_t *words) const
 {
-	for (state *s : states) {
-		auto it = s->outgoing.begin();
-		for (; it != s->outgoing.end(); ++it) {
-			if (it->first == "") {
-				size_t t = it->second;
-				s->outgoing.erase(it);
-				merge(s->outgoing, states[t]->outgoing);
-				it = s->outgoing.begin();
+	uint64_t h = n_words;
+	for (size_t i = 0; i < n_words; i++) {
+		h ^= words[i];
+		h ^= h >> 33;
+		h *= UINT64_C(0xff51afd7ed558ccd);
+		h ^= h >> 33;
+		h *= UINT64_C(0xc4ceb9fe1a85ec53);
+		h ^= h >> 33;
+	}
+	return h;
+}
+
+void automaton::grow_table()
+{
+	const uint32_t NONE = UINT32_MAX;
+	size_t size = table.empty() ? 1024 : table.size() * 2;
+	table.assign(size, NONE);
+	for (size_t s = 0; s < n_states; s++) {
+		size_t i = hash(&state_words[s * n_words]) & (size - 1);
+		while (table[i] != NONE)
+			i = (i + 1) & (size - 1);
+		table[i] = s;
+	}
+}
+
+/* Returns the number of the state with the given words, adding it if it
+ * is new.
+ */
+size_t automaton::add_state(const uint64_t *words)
+{
+	const uint32_t NONE = UINT32_MAX;
+	if (2 * (n_states + 1) > table.size())
+		grow_table();
+	size_t mask = table.size() - 1;
+	size_t i = hash(words) & mask;
+	while (table[i] != NONE) {
+		const uint64_t *existing = &state_words[table[i] * n_words];
+		if (!memcmp(existing, words, n_words * sizeof(uint64_t)))
+			return table[i];
+		i = (i + 1) & mask;
+	}
+	if (n_states == UINT32_MAX)
+		throw std::length_error("automaton has too many states");
+	table[i] = n_states;
+	state_words.insert(state_words.end(), words, words + n_words);
+	return n_states++;
+}
+
+/* Orders the transitions of every state by label text and target, and
+ * removes duplicates.
+ */
+void automaton::sort_transitions(const std::vector<std::string> &text)
+{
+	std::vector<uint32_t> order(labels.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(),
+	          [&text](uint32_t a, uint32_t b) { return text[a] < text[b]; });
+	std::vector<uint32_t> rank(labels.size());
+	for (uint32_t i = 0; i < order.size(); i++)
+		rank[order[i]] = i;
+
+	auto less = [&rank](const transition &a, const transition &b) {
+		if (a.label != b.label)
+			return rank[a.label] < rank[b.label];
+		return a.target < b.target;
+	};
+	size_t n = 0;
+	for (size_t s = 0; s < n_states; s++) {
+		size_t begin = first[s], end = first[s + 1];
+		std::sort(transitions.begin() + begin,
+		          transitions.begin() + end, less);
+		first[s] = n;
+		for (size_t i = begin; i < end; i++) {
+			const transition &t = transitions[i];
+			if (n > first[s] && transitions[n - 1].label == t.label
+			    && transitions[n - 1].target == t.target)
+			{
+				continue;
 			}
+			transitions[n++] = t;
 		}
 	}
-	std::vector<bool> reachable(states.size());
-	reachable[0] = true;
-	bool change = true;
-	while (change) {
-		change = false;
-		for (size_t i = 0; i < states.size(); i++) {
-			if (!reachable[i])
+	first[n_states] = n;
+	transitions.resize(n);
+}
+
+/* Replaces the internal transitions of every state by the visible
+ * transitions of the states reachable by internal ones, then removes
+ * the states that are no longer reachable.
+ *
+ * States on a cycle of internal transitions share their closure, so the
+ * closures are computed per strongly connected component of the
+ * internal transitions (Tarjan's algorithm), each from those of the
+ * components it reaches, which are completed first.
+ */
+void automaton::tau_collapse()
+{
+	auto tau = labelIds.find(automata::label());
+	if (tau == labelIds.end())
+		return;
+	uint32_t tau_id = tau->second;
+	const size_t NONE = SIZE_MAX;
+	size_t n = n_states;
+
+	std::vector<size_t> index(n, NONE), low(n), component(n, NONE);
+	std::vector<size_t> members;
+	/* (state, next transition to consider) */
+	std::vector<std::pair<size_t, size_t>> dfs;
+	std::vector<transition> closure;
+	std::vector<size_t> closure_first(1, 0);
+	size_t counter = 0, n_components = 0;
+	auto less = [](const transition &a, const transition &b) {
+		if (a.label != b.label)
+			return a.label < b.label;
+		return a.target < b.target;
+	};
+	auto equal = [](const transition &a, const transition &b) {
+		return a.label == b.label && a.target == b.target;
+	};
+
+	for (size_t root = 0; root < n; root++) {
+		if (index[root] != NONE)
+			continue;
+		index[root] = low[root] = counter++;
+		members.push_back(root);
+		dfs.emplace_back(root, first[root]);
+		while (!dfs.empty()) {
+			size_t v = dfs.back().first;
+			size_t i = dfs.back().second;
+			while (i < first[v + 1] && transitions[i].label != tau_id)
+				i++;
+			if (i < first[v + 1]) {
+				size_t w = transitions[i].target;
+				dfs.back().second = i + 1;
+				if (index[w] == NONE) {
+					index[w] = low[w] = counter++;
+					members.push_back(w);
+					dfs.emplace_back(w, first[w]);
+				} else if (component[w] == NONE) {
+					low[v] = std::min(low[v], index[w]);
+				}
 				continue;
-			for (auto &trans : states[i]->outgoing) {
-				if (!reachable[trans.second]) {
-					change = true;
-					reachable[trans.second] = true;
+			}
+			dfs.pop_back();
+			if (!dfs.empty()) {
+				size_t u = dfs.back().first;
+				low[u] = std::min(low[u], low[v]);
+			}
+			if (low[v] != index[v])
+				continue;
+
+			size_t begin = members.size();
+			do {
+				begin--;
+				component[members[begin]] = n_components;
+			} while (members[begin] != v);
+			size_t start = closure.size();
+			for (size_t m = begin; m < members.size(); m++) {
+				size_t s = members[m];
+				for (size_t t = first[s]; t < first[s + 1]; t++) {
+					const transition &trans = transitions[t];
+					if (trans.label != tau_id) {
+						closure.push_back(trans);
+						continue;
+					}
+					size_t c = component[trans.target];
+					if (c == n_components)
+						continue;
+					for (size_t k = closure_first[c]; k < closure_first[c + 1]; k++) {
+						transition copy = closure[k];
+						closure.push_back(copy);
+					}
 				}
 			}
+			std::sort(closure.begin() + start, closure.end(), less);
+			closure.erase(std::unique(closure.begin() + start,
+			                          closure.end(), equal),
+			              closure.end());
+			closure_first.push_back(closure.size());
+			members.resize(begin);
+			n_components++;
+		}
+	}
+
+	/* Number the reachable states in their current order */
+	std::vector<size_t> number(n, NONE);
+	std::vector<size_t> queue(1, 0);
+	number[0] = 0;
+	for (size_t q = 0; q < queue.size(); q++) {
+		size_t c = component[queue[q]];
+		for (size_t k = closure_first[c]; k < closure_first[c + 1]; k++) {
+			size_t t = closure[k].target;
+			if (number[t] == NONE) {
+				number[t] = 0;
+				queue.push_back(t);
+			}
 		}
 	}
-	for (size_t i = 0; i < states.size(); i++) {
-		if (!reachable[i])
-			states[i]->outgoing.clear();
+	size_t n_reachable = 0;
+	for (size_t s = 0; s < n; s++) {
+		if (number[s] != NONE)
+			number[s] = n_reachable++;
+	}
+
+	transitions.clear();
+	first.clear();
+	for (size_t s = 0; s < n; s++) {
+		if (number[s] == NONE)
+			continue;
+		first.push_back(transitions.size());
+		size_t c = component[s];
+		for (size_t k = closure_first[c]; k < closure_first[c + 1]; k++)
+			transitions.push_back({closure[k].label,
+			                       (uint32_t)number[closure[k].target]});
+		std::copy(state_words.begin() + s * n_words,
+		          state_words.begin() + (s + 1) * n_words,
+		          state_words.begin() + number[s] * n_words);
 	}
+	first.push_back(transitions.size());
+	n_states = n_reachable;
+	state_words.resize(n_states * n_words);
 }
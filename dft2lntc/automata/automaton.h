@@ -1,45 +1,135 @@
 #ifndef AUTOMATA_H
 #define AUTOMATA_H
 
-#include <set>
+#include <cstdint>
+#include <cstring>
 #include <ostream>
+#include <stdexcept>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
 #include <iostream>
 
+#include "automata/signals.h"
+
 /* Warning to new automata:
- * Internal actions can be indicated by leaving the action empty.
+ * Internal actions are indicated by the empty label (labels::TAU).
  * However, these will be collapsed before the automaton is output.
  * The tau-reduction does not consider probabilistic behaviour (as
  * stochastic behaviour may not be known before the later renaming
  * step), and will produce incorrect results if a tau-action decides
  * what stochastic transitions will be enabled.
+ *
+ * Labels are interned per automaton, and the transitions of all states
+ * are kept in one array in the order of exploration.
+ *
+ * States are packed into a few 64-bit words, whose size the automaton
+ * passes to the constructor. Two states are the same if their words
+ * are, so fields that do not matter in a state should be cleared by
+ * normalize(). The automaton keeps the words of all states in one
+ * array; state objects only exist while a state is being explored.
  */
 class automaton {
 public:
+	/* A field of width bits at bit offset of a packed state. Fields
+	 * may not cross a word boundary.
+	 */
+	struct field {
+		uint16_t offset;
+		uint8_t width;
+	};
+
 	class state {
 	private:
-		std::set<std::pair<std::string, size_t>> outgoing;
+		static const size_t INLINE_WORDS = 4;
+
 		automaton * parent;
+		uint64_t *words;
+		uint64_t local[INLINE_WORDS];
+
+		void load(const uint64_t *source) {
+			memcpy(words, source, parent->n_words * sizeof(uint64_t));
+		}
 
 	protected:
 		state(automaton *parent)
-			:parent(parent)
-		{ }
+			:parent(parent),
+			 words(parent->n_words > INLINE_WORDS
+			       ? new uint64_t[parent->n_words] : local)
+		{
+			clear();
+		}
+
+		state(const state &other)
+			:parent(other.parent),
+			 words(parent->n_words > INLINE_WORDS
+			       ? new uint64_t[parent->n_words] : local)
+		{
+			load(other.words);
+		}
+
+		state &operator=(const state &other) {
+			if (parent != other.parent) {
+				if (words != local)
+					delete[] words;
+				parent = other.parent;
+				words = parent->n_words > INLINE_WORDS
+				        ? new uint64_t[parent->n_words] : local;
+			}
+			load(other.words);
+			return *this;
+		}
+
+		size_t get(field f) const {
+			uint64_t w = words[f.offset / 64] >> (f.offset % 64);
+			if (f.width < 64)
+				w &= (UINT64_C(1) << f.width) - 1;
+			return w;
+		}
+
+		void set(field f, size_t value) {
+			uint64_t mask = f.width < 64
+			                ? (UINT64_C(1) << f.width) - 1 : ~UINT64_C(0);
+			uint64_t &w = words[f.offset / 64];
+			w &= ~(mask << (f.offset % 64));
+			w |= ((uint64_t)value & mask) << (f.offset % 64);
+		}
+
+		bool bit(size_t n) const {
+			return (words[n / 64] >> (n % 64)) & 1;
+		}
+
+		void set_bit(size_t n, bool value) {
+			if (value)
+				words[n / 64] |= UINT64_C(1) << (n % 64);
+			else
+				words[n / 64] &= ~(UINT64_C(1) << (n % 64));
+		}
+
+		void clear() {
+			memset(words, 0, parent->n_words * sizeof(uint64_t));
+		}
 
 		virtual void initialize_outgoing() = 0;
-		void add_transition(std::string label, const state &target) {
-			size_t target_num = parent->add_state(&target);
-			outgoing.emplace(std::make_pair(label, target_num));
+
+		/* Clears the fields that do not distinguish this state from
+		 * others, e.g. everything but the flag of a terminated state.
+		 */
+		virtual void normalize() { }
+
+		void add_transition(const automata::label &label, state &target) {
+			target.normalize();
+			size_t target_num = parent->add_state(target.words);
+			parent->transitions.push_back({parent->intern(label),
+			                               (uint32_t)target_num});
 		}
 
 	public:
-		virtual size_t hashcode() const noexcept = 0;
-		virtual bool operator==(const state &other) const noexcept = 0;
 		virtual state *copy() const = 0;
 
-		virtual ~state() { }
+		virtual ~state() {
+			if (words != local)
+				delete[] words;
+		}
 
 		virtual operator std::string() const {
 			return "";
@@ -52,53 +142,69 @@ public:
 		const automaton *get_parent() const {
 			return parent;
 		}
-		
-		friend class automaton;
-	};
-
-	class stateHash {
-	public:
-		size_t operator()(const state * const &s) const {
-			return s->hashcode();
-		}
-	};
 
-	class ptr_equal {
-	public:
-		size_t operator()(const state * const &s1,
-		                  const state * const &s2) const
-		{
-			return *s1 == *s2;
-		}
+		friend class automaton;
 	};
 
 	virtual const state *initial_state() const = 0;
 
+	/* Writes the automaton in Aldebaran format. */
 	void write(std::ostream &out);
+	/* Writes the automaton in binary format (see automata/binary.h). */
+	void write_binary(std::ostream &out);
 
-	virtual ~automaton() {
-		for (state *entry : states) {
-			delete entry;
-		}
-	}
+	virtual ~automaton() { }
+
+protected:
+	automaton(size_t bits)
+		:n_words(bits > 64 ? (bits + 63) / 64 : 1),
+		 n_states(0)
+	{ }
 
 private:
-	std::unordered_map<const state *, size_t, stateHash, ptr_equal> stateNums;
-	std::vector<state *> states;
+	struct transition {
+		uint32_t label;
+		uint32_t target;
+	};
 
-	size_t add_state(const state *newState) {
-		auto existing = stateNums.find(newState);
-		if (existing != stateNums.end())
+	const size_t n_words;
+
+	/* The words of state i are state_words[i * n_words] onwards.
+	 * table is an open-addressing hash table of state numbers, with
+	 * linear probing.
+	 */
+	std::vector<uint64_t> state_words;
+	size_t n_states;
+	std::vector<uint32_t> table;
+
+	std::unordered_map<automata::label, uint32_t, automata::label::hash> labelIds;
+	std::vector<automata::label> labels;
+
+	/* The outgoing transitions of state i are
+	 * transitions[first[i]] to transitions[first[i + 1]].
+	 */
+	std::vector<transition> transitions;
+	std::vector<size_t> first;
+	/* The text of every label, once built */
+	std::vector<std::string> text;
+
+	uint32_t intern(const automata::label &label) {
+		auto existing = labelIds.find(label);
+		if (existing != labelIds.end())
 			return existing->second;
-		state *copy = newState->copy();
-		copy->outgoing.clear();
-		size_t ret = stateNums.size();
-		stateNums.emplace(copy, ret);
-		states.emplace_back(copy);
+		uint32_t ret = labels.size();
+		labelIds.emplace(label, ret);
+		labels.push_back(label);
 		return ret;
 	}
 
+	uint64_t hash(const uint64_t *words) const;
+	void grow_table();
+	size_t add_state(const uint64_t *words);
+
+	void build();
 	void tau_collapse();
+	void sort_transitions(const std::vector<std::string> &text);
 };
 
 #endif
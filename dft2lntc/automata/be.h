@@ -26,97 +26,86 @@ namespace automata {
 		const bool always_active : 1;
 		const bool has_res : 1;
 
+		/* Packed into a single word */
 		class be_state : public automaton::state {
 			private:
-			enum BE_STATE status;
-			enum REPAIR_STATE repair_status;
-			size_t phase;
-			bool isactive : 1;
-			bool emit_fail : 1;
-			bool emit_online : 1;
-			bool emit_inspect : 1;
-			bool can_definitely_fail : 1;
-			bool terminated : 1;
+			static constexpr field STATUS{0, 3};
+			static constexpr field REPAIR_STATUS{3, 3};
+			static constexpr field ISACTIVE{6, 1};
+			static constexpr field EMIT_FAIL{7, 1};
+			static constexpr field EMIT_ONLINE{8, 1};
+			static constexpr field EMIT_INSPECT{9, 1};
+			static constexpr field CAN_DEFINITELY_FAIL{10, 1};
+			static constexpr field TERMINATED{11, 1};
+			static constexpr field PHASE{32, 32};
+			static const size_t BITS = 64;
+
+			BE_STATE status() const {
+				return (BE_STATE)get(STATUS);
+			}
+			void status(BE_STATE v) { set(STATUS, v); }
+			REPAIR_STATE repair_status() const {
+				return (REPAIR_STATE)get(REPAIR_STATUS);
+			}
+			void repair_status(REPAIR_STATE v) {
+				set(REPAIR_STATUS, v);
+			}
+			size_t phase() const { return get(PHASE); }
+			void phase(size_t v) { set(PHASE, v); }
+			bool isactive() const { return get(ISACTIVE); }
+			void isactive(bool v) { set(ISACTIVE, v); }
+			bool emit_fail() const { return get(EMIT_FAIL); }
+			void emit_fail(bool v) { set(EMIT_FAIL, v); }
+			bool emit_online() const { return get(EMIT_ONLINE); }
+			void emit_online(bool v) { set(EMIT_ONLINE, v); }
+			bool emit_inspect() const { return get(EMIT_INSPECT); }
+			void emit_inspect(bool v) { set(EMIT_INSPECT, v); }
+			bool can_definitely_fail() const {
+				return get(CAN_DEFINITELY_FAIL);
+			}
+			void can_definitely_fail(bool v) {
+				set(CAN_DEFINITELY_FAIL, v);
+			}
+			bool terminated() const { return get(TERMINATED); }
+			void terminated(bool v) { set(TERMINATED, v); }
 
 			be_state(be *parent, BE_STATE status)
-				:automaton::state(parent),
-				 status(status),
-				 repair_status(NONE),
-				 isactive(parent->always_active),
-				 phase(1),
-				 emit_fail(false), emit_online(false),
-				 emit_inspect(false),
-				 can_definitely_fail(false),
-				 terminated(false)
+				:automaton::state(parent)
 			{
+				this->status(status);
+				repair_status(NONE);
+				isactive(parent->always_active);
+				phase(1);
 				if (status == FAILING) {
-					emit_fail = 1;
+					emit_fail(1);
 					if (parent->threshold >= 0)
-						emit_inspect = 1;
-					status = UP;
+						emit_inspect(1);
 				}
 			}
 
 			void fail_sig(bool active, size_t phase, bool canfail, be_state &target);
 			void fail_res(bool active, size_t phase, bool canfail, be_state &target);
-			void add_transition(std::string label, be_state &target);
+			void add_transition(const label &label, be_state &target);
 			friend class be;
 
 			public:
-			size_t hashcode() const noexcept {
-				if (terminated)
-					return 0;
-				if (status == IMPOSSIBLE)
-					return 1;
-				size_t ret = status;
-				ret = (ret * 33) + repair_status;
-				ret = (ret * 33) + phase;
-				ret = (ret * 33) + isactive;
-				ret = (ret * 33) + emit_fail;
-				ret = (ret * 33) + emit_online;
-				ret = (ret * 33) + emit_inspect;
-				ret = (ret * 33) + can_definitely_fail;
-				return ret;
-			}
-
 			virtual state *copy() const {
 				return new be_state(*this);
 			}
 
-			bool operator==(const state &other) const noexcept {
-				if (get_parent() != other.get_parent())
-					return 0;
-				const be_state &o = static_cast<const be_state &>(other);
-				if (terminated)
-					return o.terminated;
-				if (o.terminated)
-					return 0;
-				if (status == IMPOSSIBLE)
-					return o.status == IMPOSSIBLE;
-				if (o.status == IMPOSSIBLE)
-					return 0;
-				return status == o.status
-				       && repair_status == o.repair_status
-				       && phase == o.phase
-				       && isactive == o.isactive
-				       && emit_fail == o.emit_fail
-				       && emit_online == o.emit_online
-				       && emit_inspect == o.emit_inspect
-				       && can_definitely_fail == o.can_definitely_fail
-				       && terminated == o.terminated;
-			}
-
 			virtual operator std::string() const;
 
 			protected:
 			virtual void initialize_outgoing();
+			virtual void normalize();
 		};
 
 		be_state initial_be_state;
 
 	public:
 		be(const DFT::Nodes::BasicEvent &be)
-			: cold(be.getMu().is_zero()),
+			: automaton(be_state::BITS),
+			  cold(be.getMu().is_zero()),
 			  phases(be.getPhases()),
 			  threshold(be.getInterval()),
 			  repairable(be.isRepairable()),
@@ -0,0 +1,56 @@
+#ifndef AUTOMATA_BINARY_H
+#define AUTOMATA_BINARY_H
+
+#include <cstdint>
+#include <string>
+
+/* The binary automaton format (.baut). A file holds the same automaton
+ * as an Aldebaran (.aut) file, but can be read without parsing text.
+ * All numbers are unsigned LEB128 varints:
+ *
+ *   "BAUT", the format version
+ *   the initial state, the number of states and of transitions
+ *   the number of labels, then the length and text of every label
+ *   for every state in order, its number of outgoing transitions,
+ *     then the label of every transition and its target minus the
+ *     state, zigzag-encoded
+ *
+ * Labels are written as in the Aldebaran format without the quotes, so
+ * the internal action is "i".
+ */
+namespace automata {
+namespace binary {
+	static const char MAGIC[4] = {'B', 'A', 'U', 'T'};
+	static const unsigned int VERSION = 1;
+
+	inline void put(std::string &out, uint64_t v) {
+		while (v >= 0x80) {
+			out += (char)(v | 0x80);
+			v >>= 7;
+		}
+		out += (char)v;
+	}
+
+	/* Returns false if the varint at pos runs past end. */
+	inline bool get(const char *&pos, const char *end, uint64_t &v) {
+		v = 0;
+		for (unsigned int shift = 0; pos < end && shift < 64; shift += 7) {
+			unsigned char c = *pos++;
+			v |= (uint64_t)(c & 0x7f) << shift;
+			if (!(c & 0x80))
+				return true;
+		}
+		return false;
+	}
+
+	inline uint64_t zigzag(int64_t v) {
+		return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+	}
+
+	inline int64_t unzigzag(uint64_t v) {
+		return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+	}
+} /* Namespace binary */
+} /* Namespace automata */
+
+#endif
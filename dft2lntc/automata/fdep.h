@@ -5,50 +5,39 @@
 #ifndef AUTOMATA_FDEP_H
 #define AUTOMATA_FDEP_H
 #include "dftnodes/GateFDEP.h"
-#include <vector>
 
 namespace automata {
 	class fdep : public automaton {
 		const size_t total;
 		const bool trigger_always_active : 1;
 
+		/* Packed: the scalars in the first word, then which of the
+		 * dependers have been notified.
+		 */
 		class fdep_state : public automaton::state {
 			private:
-			size_t act;
-			std::vector<bool> notified;
-			bool failed : 1;
+			static constexpr field ACT{0, 1};
+			static constexpr field FAILED{1, 1};
+			static const size_t NOTIFIED = 64;
+
+			size_t act() const { return get(ACT); }
+			void act(size_t v) { set(ACT, v); }
+			bool failed() const { return get(FAILED); }
+			void failed(bool v) { set(FAILED, v); }
+			bool notified(size_t i) const { return bit(NOTIFIED + i); }
+			void notified(size_t i, bool v) { set_bit(NOTIFIED + i, v); }
 
 			fdep_state(fdep *parent)
-				:automaton::state(parent),
-				 act(0),
-				 notified(parent->total),
-				 failed(0)
+				:automaton::state(parent)
 			{ }
 
 			friend class fdep;
 
 			public:
-			size_t hashcode() const noexcept {
-				size_t ret = act << 1;
-				ret += failed;
-				ret *= 33;
-				ret += std::hash<std::vector<bool>>()(notified);
-				return ret;
-			}
-
 			virtual state *copy() const {
 				return new fdep_state(*this);
 			}
 
-			bool operator==(const state &other) const noexcept {
-				if (get_parent() != other.get_parent())
-					return 0;
-				const fdep_state &o = static_cast<const fdep_state &>(other);
-				return act == o.act
-				       && notified == o.notified
-				       && failed == o.failed;
-			}
-
 			virtual operator std::string() const;
 
 			protected:
@@ -59,7 +48,9 @@ namespace automata {
 
 	public:
 		fdep(const DFT::Nodes::GateFDEP &gate)
-			: total(gate.getDependers().size()),
+			: automaton(fdep_state::NOTIFIED
+			            + gate.getDependers().size()),
+			  total(gate.getDependers().size()),
 			  trigger_always_active(gate.getChildren()[0]->isAlwaysActive()),
 			  initial_fdep_state(this)
 		{ }
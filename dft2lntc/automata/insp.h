@@ -11,35 +11,29 @@ namespace automata {
 		const size_t total;
 		const size_t phases;
 
+		/* Packed into a single word */
 		class insp_state : public automaton::state {
 			private:
-			size_t counter;
-			bool signal : 1;
+			static constexpr field COUNTER{0, 32};
+			static constexpr field SIGNAL{32, 1};
+			static const size_t BITS = 64;
+
+			size_t counter() const { return get(COUNTER); }
+			void counter(size_t v) { set(COUNTER, v); }
+			bool signal() const { return get(SIGNAL); }
+			void signal(bool v) { set(SIGNAL, v); }
 
 			insp_state(insp *parent)
-				:automaton::state(parent),
-				 counter(0), signal(0)
+				:automaton::state(parent)
 			{ }
 
 			friend class insp;
 
 			public:
-			size_t hashcode() const noexcept {
-				return (counter << 1) + signal;
-			}
-
 			virtual state *copy() const {
 				return new insp_state(*this);
 			}
 
-			bool operator==(const state &other) const noexcept {
-				if (get_parent() != other.get_parent())
-					return 0;
-				const insp_state &o = static_cast<const insp_state &>(other);
-				return counter == o.counter
-				       && signal == o.signal;
-			}
-
 			virtual operator std::string() const;
 
 			protected:
@@ -50,7 +44,8 @@ namespace automata {
 
 	public:
 		insp(const DFT::Nodes::Inspection &gate)
-			: total(gate.getChildren().size()),
+			: automaton(insp_state::BITS),
+			  total(gate.getChildren().size()),
 			  phases(gate.getPhases() ? gate.getPhases() : 1),
 			  initial_insp_state(this)
 		{ }
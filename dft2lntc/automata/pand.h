@@ -13,74 +13,60 @@ namespace automata {
 		const bool repairable : 1;
 		const bool always_active : 1;
 
+		/* Packed: the scalars in the first word, then which of
+		 * children 0..total have failed.
+		 */
 		class pand_state : public automaton::state {
 			private:
-			std::vector<bool> failed;
-			size_t nr_failed = 0;
-			size_t nr_active = 0;
-			size_t in_order_mark = 0;
-			bool done : 1;
-			bool impossible : 1;
-			bool terminated : 1;
+			static constexpr field NR_FAILED{0, 16};
+			static constexpr field NR_ACTIVE{16, 16};
+			static constexpr field IN_ORDER_MARK{32, 16};
+			static constexpr field DONE{48, 1};
+			static constexpr field IMPOSSIBLE{49, 1};
+			static constexpr field TERMINATED{50, 1};
+			static const size_t FAILED = 64;
+
+			size_t nr_failed() const { return get(NR_FAILED); }
+			void nr_failed(size_t v) { set(NR_FAILED, v); }
+			size_t nr_active() const { return get(NR_ACTIVE); }
+			void nr_active(size_t v) { set(NR_ACTIVE, v); }
+			size_t in_order_mark() const { return get(IN_ORDER_MARK); }
+			void in_order_mark(size_t v) { set(IN_ORDER_MARK, v); }
+			bool done() const { return get(DONE); }
+			void done(bool v) { set(DONE, v); }
+			bool impossible() const { return get(IMPOSSIBLE); }
+			void impossible(bool v) { set(IMPOSSIBLE, v); }
+			bool terminated() const { return get(TERMINATED); }
+			void terminated(bool v) { set(TERMINATED, v); }
+
+			bool failed(size_t i) const { return bit(FAILED + i); }
+			void failed(size_t i, bool v) { set_bit(FAILED + i, v); }
 
 			pand_state(pand *parent)
-				:automaton::state(parent),
-				 failed(parent->total + 1),
-				 nr_failed(0), nr_active(0), in_order_mark(0),
-				 done(0), impossible(0), terminated(0)
+				:automaton::state(parent)
 			{ }
 
 			friend class pand;
 
 			public:
-			size_t hashcode() const noexcept {
-				if (terminated)
-					return 0;
-				if (impossible)
-					return 1;
-				size_t ret = 2;
-				ret = (ret * 33) + nr_failed;
-				ret = (ret * 33) + nr_active;
-				ret = (ret * 33) + in_order_mark;
-				ret = (ret * 33) + done;
-				ret = (ret * 33) + std::hash<std::vector<bool>>()(failed);
-				return ret;
-			}
-
 			virtual state *copy() const {
 				return new pand_state(*this);
 			}
 
-			bool operator==(const state &other) const noexcept {
-				if (get_parent() != other.get_parent())
-					return 0;
-				const pand_state &o = static_cast<const pand_state &>(other);
-				if (terminated)
-					return o.terminated;
-				if (o.terminated)
-					return 0;
-				if (impossible)
-					return o.impossible;
-				if (o.impossible)
-					return 0;
-				return nr_failed == o.nr_failed
-				       && nr_active == o.nr_active
-				       && in_order_mark == o.in_order_mark
-				       && done == o.done
-				       && failed == o.failed;
-			}
-
 			virtual operator std::string() const;
 
 			protected:
 			virtual void initialize_outgoing();
+			virtual void normalize();
 		};
 
 		pand_state initial_pand_state;
 
 	public:
 		pand(const DFT::Nodes::GatePAnd &gate)
-			: total(gate.getChildren().size()),
+			: automaton(pand_state::FAILED
+			            + gate.getChildren().size() + 1),
+			  total(gate.getChildren().size()),
 			  repairable(total),
 			  always_active(gate.isAlwaysActive()),
 			  initial_pand_state(this)
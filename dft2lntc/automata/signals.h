@@ -95,6 +95,150 @@ namespace automata {
 			return ret;
 		}
 	};
+
+	/* The actions above as the automata produce them: cheap to build,
+	 * compare and hash, and only spelled out when the automaton is
+	 * written. Arguments are printed in order, followed by the
+	 * direction (if any).
+	 */
+	class label {
+	public:
+		enum class gate : unsigned char {
+			TAU, FAIL, ACTIVATE, DEACTIVATE, ONLINE, RATE_FAIL,
+			RATE_INSPECTION, INSPECT, REPAIR, REPAIRING, REPAIRED,
+			RATE_REPAIR, IMPOSSIBLE
+		};
+
+		label(gate g = gate::TAU)
+			:g(g), direction(-1), n_args(0), args{0, 0}
+		{ }
+
+		label(gate g, size_t arg)
+			:g(g), direction(-1), n_args(1), args{arg, 0}
+		{ }
+
+		label(gate g, size_t arg1, size_t arg2)
+			:g(g), direction(-1), n_args(2), args{arg1, arg2}
+		{ }
+
+		label(gate g, size_t arg, bool dir)
+			:g(g), direction(dir), n_args(1), args{arg, 0}
+		{ }
+
+		label(gate g, bool dir)
+			:g(g), direction(dir), n_args(0), args{0, 0}
+		{ }
+
+		bool operator==(const label &other) const noexcept {
+			return g == other.g && direction == other.direction
+			       && n_args == other.n_args
+			       && args[0] == other.args[0]
+			       && args[1] == other.args[1];
+		}
+
+		size_t hashcode() const noexcept {
+			size_t ret = (size_t)g;
+			ret = (ret * 33) + direction;
+			ret = (ret * 33) + args[0];
+			ret = (ret * 33) + args[1];
+			return ret;
+		}
+
+		std::string str() const {
+			std::string ret = name();
+			for (unsigned char i = 0; i < n_args; i++) {
+				ret += " !";
+				ret += std::to_string(args[i]);
+			}
+			if (direction >= 0)
+				ret += direction ? " !TRUE" : " !FALSE";
+			return ret;
+		}
+
+		class hash {
+		public:
+			size_t operator()(const label &l) const noexcept {
+				return l.hashcode();
+			}
+		};
+
+	private:
+		gate g;
+		signed char direction;
+		unsigned char n_args;
+		size_t args[2];
+
+		const std::string &name() const {
+			static const std::string tau;
+			switch (g) {
+			case gate::FAIL: return signals::GATE_FAIL;
+			case gate::ACTIVATE: return signals::GATE_ACTIVATE;
+			case gate::DEACTIVATE: return signals::GATE_DEACTIVATE;
+			case gate::ONLINE: return signals::GATE_ONLINE;
+			case gate::RATE_FAIL: return signals::GATE_RATE_FAIL;
+			case gate::RATE_INSPECTION:
+				return signals::GATE_RATE_INSPECTION;
+			case gate::INSPECT: return signals::GATE_INSPECT;
+			case gate::REPAIR: return signals::GATE_REPAIR;
+			case gate::REPAIRING: return signals::GATE_REPAIRING;
+			case gate::REPAIRED: return signals::GATE_REPAIRED;
+			case gate::RATE_REPAIR: return signals::GATE_RATE_REPAIR;
+			case gate::IMPOSSIBLE: return signals::GATE_IMPOSSIBLE;
+			default: return tau;
+			}
+		}
+	};
+
+	/* Counterparts of the functions in signals, for the automata. */
+	namespace labels {
+		static const label TAU;
+		static const label GATE_IMPOSSIBLE(label::gate::IMPOSSIBLE);
+		static const label GATE_RATE_REPAIR(label::gate::RATE_REPAIR);
+
+		static label ACTIVATE(size_t num, bool direction) {
+			return label(label::gate::ACTIVATE, num, direction);
+		}
+
+		static label DEACTIVATE(size_t num, bool direction) {
+			return label(label::gate::DEACTIVATE, num, direction);
+		}
+
+		static label FAIL(size_t num) {
+			return label(label::gate::FAIL, num);
+		}
+
+		static label ONLINE(size_t num) {
+			return label(label::gate::ONLINE, num);
+		}
+
+		static label RATE_FAIL(size_t num1, size_t num2) {
+			return label(label::gate::RATE_FAIL, num1, num2);
+		}
+
+		static label RATE_INSPECTION(size_t num) {
+			return label(label::gate::RATE_INSPECTION, num);
+		}
+
+		static label INSPECT(size_t num) {
+			return label(label::gate::INSPECT, num);
+		}
+
+		static label REPAIR(bool direction) {
+			return label(label::gate::REPAIR, direction);
+		}
+
+		static label REPAIR(int num) {
+			return label(label::gate::REPAIR, (size_t)num);
+		}
+
+		static label REPAIRING(size_t num) {
+			return label(label::gate::REPAIRING, num);
+		}
+
+		static label REPAIRED(size_t num) {
+			return label(label::gate::REPAIRED, num);
+		}
+	};
 };
 
 #endif
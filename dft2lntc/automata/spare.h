@@ -5,7 +5,6 @@
 #ifndef AUTOMATA_SPARE_H
 #define AUTOMATA_SPARE_H
 #include "dftnodes/GateWSP.h"
-#include <set>
 
 namespace automata {
 	class spare : public automaton {
@@ -13,89 +12,105 @@ namespace automata {
 		bool repairable : 1;
 		const bool always_active : 1;
 
+		/* Packed: the scalars in the first word, then which of
+		 * children 0..total have not failed, and which are not
+		 * claimed by other spare gates. Child 0 is in neither.
+		 */
 		class spare_state : public automaton::state {
 			private:
-			set<size_t> unfailed;
-			set<size_t> unclaimed;
-			size_t repairing_deactivate;
-			size_t cur_using;
-			size_t prev_using;
-			bool done : 1;
-			bool activated : 1;
-			bool impossible : 1;
-			bool terminated : 1;
+			static constexpr field REPAIRING_DEACTIVATE{0, 16};
+			static constexpr field CUR_USING{16, 16};
+			static constexpr field PREV_USING{32, 16};
+			static constexpr field DONE{48, 1};
+			static constexpr field ACTIVATED{49, 1};
+			static constexpr field IMPOSSIBLE{50, 1};
+			static constexpr field TERMINATED{51, 1};
+			static const size_t UNFAILED = 64;
+
+			size_t repairing_deactivate() const {
+				return get(REPAIRING_DEACTIVATE);
+			}
+			void repairing_deactivate(size_t v) {
+				set(REPAIRING_DEACTIVATE, v);
+			}
+			size_t cur_using() const { return get(CUR_USING); }
+			void cur_using(size_t v) { set(CUR_USING, v); }
+			size_t prev_using() const { return get(PREV_USING); }
+			void prev_using(size_t v) { set(PREV_USING, v); }
+			bool done() const { return get(DONE); }
+			void done(bool v) { set(DONE, v); }
+			bool activated() const { return get(ACTIVATED); }
+			void activated(bool v) { set(ACTIVATED, v); }
+			bool impossible() const { return get(IMPOSSIBLE); }
+			void impossible(bool v) { set(IMPOSSIBLE, v); }
+			bool terminated() const { return get(TERMINATED); }
+			void terminated(bool v) { set(TERMINATED, v); }
+
+			bool unfailed(size_t i) const {
+				return bit(UNFAILED + i);
+			}
+			void unfailed(size_t i, bool v) {
+				set_bit(UNFAILED + i, v);
+			}
+			bool unclaimed(size_t i) const {
+				return bit(UNFAILED + par()->total + 1 + i);
+			}
+			void unclaimed(size_t i, bool v) {
+				set_bit(UNFAILED + par()->total + 1 + i, v);
+			}
+
+			/* Whether child i can be used, and the first such child
+			 * (or 0).
+			 */
+			bool available(size_t i) const {
+				return unfailed(i) && unclaimed(i);
+			}
+			size_t first_available() const {
+				for (size_t i = 1; i <= par()->total; i++) {
+					if (available(i))
+						return i;
+				}
+				return 0;
+			}
+
+			const spare *par() const {
+				return (const spare *)get_parent();
+			}
 
 			spare_state(spare *parent)
-				:automaton::state(parent),
-				 repairing_deactivate(0),
-				 cur_using(parent->always_active ? 1 : 0),
-				 prev_using(0), done(0),
-				 activated(parent->always_active),
-				 impossible(0), terminated(0)
+				:automaton::state(parent)
 			{
+				cur_using(parent->always_active ? 1 : 0);
+				activated(parent->always_active);
 				for (size_t i = 1; i <= parent->total; i++) {
-					unfailed.insert(i);
-					unclaimed.insert(i);
+					unfailed(i, 1);
+					unclaimed(i, 1);
 				}
 			}
 
-			void add_transition(std::string label, spare_state &target);
+			void add_transition(const label &label, spare_state &target);
 			friend class spare;
 
 			public:
-			size_t hashcode() const noexcept {
-				if (terminated)
-					return 0;
-				if (impossible)
-					return 1;
-				size_t ret = cur_using;
-				ret = (ret * 33) + repairing_deactivate;
-				ret = (ret * 33) + prev_using;
-				ret = (ret * 33) + done;
-				ret = (ret * 33) + activated;
-				for (size_t i : unfailed)
-					ret = (ret * 33) + i;
-				for (size_t i : unclaimed)
-					ret = (ret * 31) + i;
-				return ret;
-			}
-
 			virtual state *copy() const {
 				return new spare_state(*this);
 			}
 
-			bool operator==(const state &other) const noexcept {
-				if (get_parent() != other.get_parent())
-					return 0;
-				const spare_state &o = static_cast<const spare_state &>(other);
-				if (terminated)
-					return o.terminated;
-				if (o.terminated)
-					return 0;
-				if (impossible)
-					return o.impossible;
-				if (o.impossible)
-					return 0;
-				return done == o.done
-				       && repairing_deactivate == o.repairing_deactivate
-				       && cur_using == o.cur_using
-				       && prev_using == o.prev_using
-				       && activated == o.activated
-				       && unfailed == o.unfailed
-				       && unclaimed == o.unclaimed;
-			}
-
 			virtual operator std::string() const;
 
 			protected:
 			virtual void initialize_outgoing();
+			virtual void normalize();
 		};
 
 		spare_state initial_spare_state;
 
 	public:
 		spare(const DFT::Nodes::GateWSP &gate)
-			: total(gate.getChildren().size()),
+			: automaton(spare_state::UNFAILED
+			            + 2 * (gate.getChildren().size() + 1)),
+			  total(gate.getChildren().size()),
+			  repairable(false),
 			  always_active(gate.isAlwaysActive()),
 			  initial_spare_state(this)
 		{
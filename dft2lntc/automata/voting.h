@@ -15,101 +15,118 @@ namespace automata {
 		const size_t threshold;
 		const size_t repairable;
 		const bool always_active : 1;
-
+		/* If no child can be repaired or report its failure twice, a
+		 * repeated FAIL(i) cannot occur, and only the number of failed
+		 * children is tracked.
+		 */
+		const bool counting : 1;
+
+		/* Packed: the scalars in the first word, then (unless counting)
+		 * the failures received from children 0..total. The activated
+		 * children are always 1..nr_active.
+		 */
 		class voting_state : public automaton::state {
 			private:
-			size_t nr_failed = 0;
-			bool emit_fail : 1;
-			bool done : 1;
-			bool running : 1;
-			bool impossible : 1;
-			bool terminated : 1;
-			std::vector<bool> received;
-			std::vector<bool> activated;
+			static constexpr field NR_FAILED{0, 16};
+			static constexpr field EMIT_FAIL{16, 1};
+			static constexpr field DONE{17, 1};
+			static constexpr field RUNNING{18, 1};
+			static constexpr field IMPOSSIBLE{19, 1};
+			static constexpr field TERMINATED{20, 1};
+			static constexpr field NR_ACTIVE{32, 16};
+			static const size_t RECEIVED = 64;
+
+			size_t nr_failed() const { return get(NR_FAILED); }
+			void nr_failed(size_t v) { set(NR_FAILED, v); }
+			bool emit_fail() const { return get(EMIT_FAIL); }
+			void emit_fail(bool v) { set(EMIT_FAIL, v); }
+			bool done() const { return get(DONE); }
+			void done(bool v) { set(DONE, v); }
+			bool running() const { return get(RUNNING); }
+			void running(bool v) { set(RUNNING, v); }
+			bool impossible() const { return get(IMPOSSIBLE); }
+			void impossible(bool v) { set(IMPOSSIBLE, v); }
+			bool terminated() const { return get(TERMINATED); }
+			void terminated(bool v) { set(TERMINATED, v); }
+			size_t nr_active() const { return get(NR_ACTIVE); }
+			void nr_active(size_t v) { set(NR_ACTIVE, v); }
+
+			bool received(size_t i) const {
+				return bit(RECEIVED + i);
+			}
+			void received(size_t i, bool v) {
+				set_bit(RECEIVED + i, v);
+			}
+			bool activated(size_t i) const {
+				return i > 0 && i <= nr_active();
+			}
+
+			const voting *par() const {
+				return (const voting *)get_parent();
+			}
 
 			voting_state(voting *parent)
-				:automaton::state(parent),
-				 emit_fail(0),
-				 done(0), running(0),
-				 impossible(0), terminated(0),
-				 received(parent->total + 1),
-				 activated(parent->total + 1)
+				:automaton::state(parent)
 			{ }
 
 			friend class voting;
 
 			public:
-			size_t hashcode() const noexcept {
-				if (terminated)
-					return 0;
-				if (impossible)
-					return 1;
-				size_t ret = 2;
-				ret = (ret * 33) + emit_fail;
-				ret = (ret * 33) + nr_failed;
-				ret = (ret * 33) + done;
-				ret = (ret * 33) + running;
-				ret = (ret * 33) + std::hash<std::vector<bool>>()(received);
-				ret = (ret * 33) + std::hash<std::vector<bool>>()(activated);
-				return ret;
-			}
-
 			virtual state *copy() const {
 				return new voting_state(*this);
 			}
 
-			bool operator==(const state &other) const noexcept {
-				if (get_parent() != other.get_parent())
-					return 0;
-				const voting_state &o = static_cast<const voting_state &>(other);
-				if (terminated)
-					return o.terminated;
-				if (o.terminated)
-					return 0;
-				if (impossible)
-					return o.impossible;
-				if (o.impossible)
-					return 0;
-				return nr_failed == o.nr_failed
-				       && emit_fail == o.emit_fail
-				       && done == o.done
-				       && running == o.running
-				       && received == o.received
-				       && activated == o.activated;
-			}
-
 			virtual operator std::string() const;
 
 			protected:
 			virtual void initialize_outgoing();
+			virtual void normalize();
 		};
 
 		voting_state initial_voting_state;
 
+		static size_t state_bits(const DFT::Nodes::Gate &gate,
+		                         bool repeated_failures)
+		{
+			if (!gate.isRepairable() && !repeated_failures)
+				return voting_state::RECEIVED;
+			return voting_state::RECEIVED + gate.getChildren().size() + 1;
+		}
+
 	public:
-		voting(const DFT::Nodes::GateOr &gate)
-			: total(gate.getChildren().size()),
+		/* repeated_failures: whether a child may report its failure
+		 * more than once without being repaired in between, as the
+		 * dependers of an FDEP do.
+		 */
+		voting(const DFT::Nodes::GateOr &gate, bool repeated_failures)
+			: automaton(state_bits(gate, repeated_failures)),
+			  total(gate.getChildren().size()),
 			  threshold(1),
 			  repairable(total),
 			  always_active(gate.isAlwaysActive()),
+			  counting(!gate.isRepairable() && !repeated_failures),
 			  initial_voting_state(this)
 		{
 		}
 
-		voting(const DFT::Nodes::GateAnd &gate)
-			: total(gate.getChildren().size()),
+		voting(const DFT::Nodes::GateAnd &gate, bool repeated_failures)
+			: automaton(state_bits(gate, repeated_failures)),
+			  total(gate.getChildren().size()),
 			  threshold(gate.getChildren().size()),
 			  repairable(total),
 			  always_active(gate.isAlwaysActive()),
+			  counting(!gate.isRepairable() && !repeated_failures),
 			  initial_voting_state(this)
 		{
 		}
 
-		voting(const DFT::Nodes::GateVoting &gate)
-			: total(gate.getChildren().size()),
+		voting(const DFT::Nodes::GateVoting &gate, bool repeated_failures)
+			: automaton(state_bits(gate, repeated_failures)),
+			  total(gate.getChildren().size()),
 			  threshold(gate.getThreshold()),
 			  repairable(total),
 			  always_active(gate.isAlwaysActive()),
+			  counting(!gate.isRepairable() && !repeated_failures),
 			  initial_voting_state(this)
 		{
 		}
@@ -0,0 +1,130 @@
+/*
+ * bdd.cpp
+ *
+ * Part of dft2lnt library - a library containing read/write operations for DFT
+ * files in Galileo format and translating DFT specifications into Lotos NT.
+ */
+
+#include <algorithm>
+#include <stdexcept>
+#include "bdd.h"
+
+const uint32_t DFT::BDD::ZERO;
+const uint32_t DFT::BDD::ONE;
+
+DFT::BDD::BDD(size_t maxNodes)
+	:maxNodes(maxNodes)
+{
+	/* The terminals come after every variable */
+	nodes.push_back({UINT32_MAX, ZERO, ZERO});
+	nodes.push_back({UINT32_MAX, ONE, ONE});
+}
+
+uint32_t DFT::BDD::make(uint32_t var, uint32_t low, uint32_t high)
+{
+	if (low == high)
+		return low;
+	Key k = {var, low, high};
+	auto it = unique.find(k);
+	if (it != unique.end())
+		return it->second;
+	if (nodes.size() >= maxNodes)
+		throw std::length_error("BDD too large");
+	uint32_t ret = nodes.size();
+	nodes.push_back({var, low, high});
+	unique.emplace(k, ret);
+	return ret;
+}
+
+uint32_t DFT::BDD::ite(uint32_t f, uint32_t g, uint32_t h)
+{
+	if (f == ONE)
+		return g;
+	if (f == ZERO)
+		return h;
+	if (g == h)
+		return g;
+	if (g == ONE && h == ZERO)
+		return f;
+	Key k = {f, g, h};
+	auto it = computed.find(k);
+	if (it != computed.end())
+		return it->second;
+
+	uint32_t v = std::min(level(f), std::min(level(g), level(h)));
+	auto cofactor = [&](uint32_t x, bool high) {
+		if (level(x) != v)
+			return x;
+		return high ? nodes[x].high : nodes[x].low;
+	};
+	uint32_t fl = cofactor(f, false), fh = cofactor(f, true);
+	uint32_t gl = cofactor(g, false), gh = cofactor(g, true);
+	uint32_t hl = cofactor(h, false), hh = cofactor(h, true);
+	uint32_t low = ite(fl, gl, hl);
+	uint32_t high = ite(fh, gh, hh);
+	uint32_t ret = make(v, low, high);
+	computed.emplace(k, ret);
+	return ret;
+}
+
+uint32_t DFT::BDD::atLeast(size_t k, const std::vector<uint32_t>& ops)
+{
+	if (k == 0)
+		return ONE;
+	if (k > ops.size())
+		return ZERO;
+	/* atLeast[c]: at least c of the ops from i onwards */
+	std::vector<uint32_t> atLeast(k + 1, ZERO);
+	atLeast[0] = ONE;
+	for (size_t i = ops.size(); i-- > 0;) {
+		size_t maxC = std::min(k, ops.size() - i);
+		for (size_t c = maxC; c > 0; c--)
+			atLeast[c] = ite(ops[i], atLeast[c - 1], atLeast[c]);
+	}
+	return atLeast[k];
+}
+
+std::vector<DFT::BDD::Node> DFT::BDD::extract(uint32_t root, uint32_t& newRoot) const
+{
+	std::vector<uint32_t> renumber(nodes.size(), UINT32_MAX);
+	renumber[ZERO] = ZERO;
+	renumber[ONE] = ONE;
+	std::vector<uint32_t> stack(1, root);
+	std::vector<uint32_t> reachable;
+	while (!stack.empty()) {
+		uint32_t n = stack.back();
+		stack.pop_back();
+		if (renumber[n] != UINT32_MAX)
+			continue;
+		renumber[n] = 0;
+		reachable.push_back(n);
+		stack.push_back(nodes[n].low);
+		stack.push_back(nodes[n].high);
+	}
+	/* Children have smaller indices, so keeping the original order
+	 * keeps them before their parents.
+	 */
+	std::sort(reachable.begin(), reachable.end());
+	std::vector<Node> ret(nodes.begin(), nodes.begin() + 2);
+	for (uint32_t n : reachable) {
+		renumber[n] = ret.size();
+		ret.push_back({nodes[n].var, renumber[nodes[n].low],
+		               renumber[nodes[n].high]});
+	}
+	newRoot = renumber[root];
+	return ret;
+}
+
+double DFT::BDD::probability(const std::vector<Node>& nodes, uint32_t root,
+                             const std::vector<double>& pTrue,
+                             const std::vector<double>& pFalse)
+{
+	std::vector<double> p(std::max<size_t>(root + 1, 2));
+	p[ZERO] = 0;
+	p[ONE] = 1;
+	for (size_t i = 2; i <= root; i++) {
+		const Node& n = nodes[i];
+		p[i] = pFalse[n.var] * p[n.low] + pTrue[n.var] * p[n.high];
+	}
+	return p[root];
+}
@@ -0,0 +1,101 @@
+/*
+ * bdd.h
+ *
+ * Part of dft2lnt library - a library containing read/write operations for DFT
+ * files in Galileo format and translating DFT specifications into Lotos NT.
+ */
+
+#ifndef BDD_H
+#define BDD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace DFT {
+
+/**
+ * Reduced ordered binary decision diagrams, used to analyse the static
+ * parts of a DFT. Nodes are identified by their index; 0 and 1 are the
+ * terminals, and every other node has a larger index than its children.
+ * Variables are ordered by their number.
+ */
+class BDD {
+public:
+	static const uint32_t ZERO = 0, ONE = 1;
+
+	struct Node {
+		uint32_t var, low, high;
+	};
+
+	/**
+	 * @param maxNodes The number of nodes after which operations throw
+	 *        std::length_error.
+	 */
+	BDD(size_t maxNodes = 1 << 22);
+
+	/**
+	 * Returns the BDD of the specified variable.
+	 */
+	uint32_t variable(uint32_t var) { return make(var, ZERO, ONE); }
+
+	/**
+	 * Returns the BDD of: if f then g else h.
+	 */
+	uint32_t ite(uint32_t f, uint32_t g, uint32_t h);
+
+	uint32_t conj(uint32_t f, uint32_t g) { return ite(f, g, ZERO); }
+	uint32_t disj(uint32_t f, uint32_t g) { return ite(f, ONE, g); }
+
+	/**
+	 * Returns the BDD that is true iff at least k of the specified
+	 * BDDs are, using O(n*k) ite operations.
+	 */
+	uint32_t atLeast(size_t k, const std::vector<uint32_t>& ops);
+
+	/**
+	 * Returns the terminals and the nodes reachable from root,
+	 * renumbered in the same order.
+	 * @param newRoot Will contain the new index of root.
+	 */
+	std::vector<Node> extract(uint32_t root, uint32_t& newRoot) const;
+
+	/**
+	 * Computes the probability that the BDD rooted at the specified
+	 * node is true, given the probabilities that its (independent)
+	 * variables are true and false.
+	 * @param nodes The nodes of the BDD, each after its children.
+	 */
+	static double probability(const std::vector<Node>& nodes, uint32_t root,
+	                          const std::vector<double>& pTrue,
+	                          const std::vector<double>& pFalse);
+
+private:
+	struct Key {
+		uint32_t a, b, c;
+		bool operator==(const Key& o) const {
+			return a == o.a && b == o.b && c == o.c;
+		}
+	};
+	struct KeyHash {
+		size_t operator()(const Key& k) const {
+			uint64_t h = k.a * 0x9e3779b97f4a7c15ULL;
+			h ^= (h >> 29) + k.b * 0xbf58476d1ce4e5b9ULL;
+			h ^= (h >> 31) + k.c * 0x94d049bb133111ebULL;
+			return h ^ (h >> 32);
+		}
+	};
+
+	size_t maxNodes;
+	std::vector<Node> nodes;
+	std::unordered_map<Key, uint32_t, KeyHash> unique;
+	std::unordered_map<Key, uint32_t, KeyHash> computed;
+
+	uint32_t make(uint32_t var, uint32_t low, uint32_t high);
+	uint32_t level(uint32_t f) const { return nodes[f].var; }
+};
+
+} // Namespace: DFT
+
+#endif
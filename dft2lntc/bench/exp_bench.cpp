@@ -0,0 +1,147 @@
+/*
+ * exp_bench.cpp
+ *
+ * Part of dft2lnt library - a library containing read/write operations for DFT
+ * files in Galileo format and translating DFT specifications into Lotos NT.
+ *
+ * Times the EXP builder on synthetic DFTs: a tree of AND, OR, voting and
+ * PAND gates of four children each over basic events, with an FDEP for
+ * every hundred basic events. For every size, it reports the time taken
+ * to build the synchronization rules and to print the EXP file, which is
+ * counted but not stored.
+ *
+ * Usage: exp_bench [nodes...]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "DFTree.h"
+#include "dftnodes/nodes.h"
+#include "compiler.h"
+#include "DFTreeAUTNodeBuilder.h"
+#include "DFTreeEXPBuilder.h"
+
+namespace Nodes = DFT::Nodes;
+
+/* Discards its output, counting the characters. */
+class CountingBuf: public std::streambuf {
+public:
+	size_t count = 0;
+protected:
+	int_type overflow(int_type c) override {
+		if (c != traits_type::eof())
+			count++;
+		return c;
+	}
+	std::streamsize xsputn(const char *, std::streamsize n) override {
+		count += n;
+		return n;
+	}
+};
+
+template<class G>
+static G *addGate(DFT::DFTree *dft, G *gate, const std::vector<Nodes::Node*> &children)
+{
+	for (Nodes::Node *child : children) {
+		child->getParents().push_back(gate);
+		gate->getChildren().push_back(child);
+	}
+	dft->addNode(gate);
+	return gate;
+}
+
+/* A DFT of about the specified number of nodes. */
+static DFT::DFTree *makeDFT(size_t nodes)
+{
+	DFT::DFTree *dft = new DFT::DFTree();
+	std::vector<Nodes::BasicEvent*> bes;
+	std::vector<Nodes::Node*> level;
+	size_t nbe = nodes * 3 / 4;
+	for (size_t i = 0; i < nbe; i++) {
+		Nodes::BasicEvent *be = new Nodes::BasicEvent(Location(), "b" + std::to_string(i));
+		be->setLambda(decnumber<>(1));
+		be->setDorm(decnumber<>(0.5));
+		dft->addNode(be);
+		bes.push_back(be);
+		level.push_back(be);
+	}
+	size_t g = 0;
+	while (level.size() > 1) {
+		std::vector<Nodes::Node*> next;
+		for (size_t i = 0; i < level.size(); i += 4) {
+			std::vector<Nodes::Node*> children(level.begin() + i,
+				level.begin() + std::min(i + 4, level.size()));
+			std::string name = "g" + std::to_string(g++);
+			switch (g % 4) {
+			case 0:
+				next.push_back(addGate(dft, new Nodes::GateOr(Location(), name), children));
+				break;
+			case 1:
+				next.push_back(addGate(dft, new Nodes::GateAnd(Location(), name), children));
+				break;
+			case 2:
+				next.push_back(addGate(dft, new Nodes::GateVoting(Location(), name, 2, children.size()), children));
+				break;
+			default:
+				next.push_back(addGate(dft, new Nodes::GatePAnd(Location(), name), children));
+				break;
+			}
+		}
+		level = next;
+	}
+	dft->setTopNode(level[0]);
+	for (size_t i = 0; i + 50 < nbe; i += 100) {
+		Nodes::GateFDEP *fdep = new Nodes::GateFDEP(Location(), "f" + std::to_string(i));
+		fdep->getChildren().push_back(bes[i]);
+		bes[i]->getParents().push_back(fdep);
+		fdep->getDependers().push_back(bes[i + 50]);
+		bes[i + 50]->getTriggers().push_back(fdep);
+		dft->addNode(fdep);
+	}
+	dft->addRepairInfo();
+	dft->addAlwaysActiveInfo();
+	dft->checkFDEPInfo();
+	return dft;
+}
+
+int main(int argc, char **argv)
+{
+	std::vector<size_t> sizes;
+	for (int i = 1; i < argc; i++)
+		sizes.push_back(strtoul(argv[i], nullptr, 10));
+	if (sizes.empty())
+		sizes = {10000, 50000};
+
+	for (size_t nodes : sizes) {
+		DFT::DFTree *dft = makeDFT(nodes);
+		CompilerContext cc(std::cerr);
+		DFT::DFTreeAUTNodeBuilder nodeBuilder(".", dft, &cc);
+
+		auto start = std::chrono::steady_clock::now();
+		DFT::DFTreeEXPBuilder builder(".", ".", "bench.bcg", "bench.exp", dft, &nodeBuilder, &cc);
+		if (builder.build()) {
+			cc.flush();
+			return EXIT_FAILURE;
+		}
+		auto built = std::chrono::steady_clock::now();
+		CountingBuf buf;
+		std::ostream out(&buf);
+		builder.printEXP(out);
+		auto printed = std::chrono::steady_clock::now();
+
+		printf("%zu nodes: build %.3f s, print %.3f s (%zu bytes)\n",
+		       dft->getNodes().size(),
+		       std::chrono::duration<double>(built - start).count(),
+		       std::chrono::duration<double>(printed - built).count(),
+		       buf.count);
+		delete dft;
+	}
+	return EXIT_SUCCESS;
+}
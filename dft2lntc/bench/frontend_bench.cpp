@@ -0,0 +1,95 @@
+/*
+ * frontend_bench.cpp
+ *
+ * Part of dft2lnt library - a library containing read/write operations for DFT
+ * files in Galileo format and translating DFT specifications into Lotos NT.
+ *
+ * Times the front end on generated Galileo files of growing size: parsing
+ * and validating the AST, and building and validating the DFTree. The
+ * DFTs are trees of OR and AND gates of four children each over basic
+ * events. For every size, it reports the time taken per node, which
+ * should stay about the same as the DFT grows.
+ *
+ * Usage: frontend_bench [nodes...]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "compiler.h"
+#include "frontend.h"
+
+/* Writes a DFT of about the specified number of nodes to file. */
+static void writeDFT(FILE *file, size_t nodes)
+{
+	size_t nbe = nodes * 3 / 4;
+	std::vector<std::string> level;
+	for (size_t i = 0; i < nbe; i++)
+		level.push_back("B" + std::to_string(i));
+	std::vector<std::string> gates;
+	size_t g = 0;
+	while (level.size() > 1) {
+		std::vector<std::string> next;
+		for (size_t i = 0; i < level.size(); i += 4) {
+			std::string gate = "\"G" + std::to_string(g) + "\" "
+			                   + (g % 2 ? "and" : "or");
+			for (size_t c = i; c < i + 4 && c < level.size(); c++)
+				gate += " \"" + level[c] + "\"";
+			gates.push_back(gate + ";\n");
+			next.push_back("G" + std::to_string(g++));
+		}
+		level.swap(next);
+	}
+	fprintf(file, "toplevel \"%s\";\n", level[0].c_str());
+	for (const std::string &gate : gates)
+		fputs(gate.c_str(), file);
+	for (size_t i = 0; i < nbe; i++)
+		fprintf(file, "\"B%zu\" lambda=0.5 dorm=0;\n", i);
+}
+
+int main(int argc, char **argv)
+{
+	std::vector<size_t> sizes;
+	for (int i = 1; i < argc; i++)
+		sizes.push_back(strtoul(argv[i], nullptr, 10));
+	if (sizes.empty())
+		sizes = {10000, 100000, 1000000};
+
+	for (size_t nodes : sizes) {
+		FILE *file = tmpfile();
+		if (!file) {
+			perror("tmpfile");
+			return EXIT_FAILURE;
+		}
+		writeDFT(file, nodes);
+		rewind(file);
+
+		CompilerContext cc(std::cerr);
+		DFT::Frontend frontend(&cc, ".", ".");
+		auto start = std::chrono::steady_clock::now();
+		if (!frontend.parse(file, "bench.dft") || !frontend.validate()) {
+			cc.flush();
+			return EXIT_FAILURE;
+		}
+		auto parsed = std::chrono::steady_clock::now();
+		DFT::DFTree *dft = frontend.buildTree();
+		if (!dft) {
+			cc.flush();
+			return EXIT_FAILURE;
+		}
+		auto built = std::chrono::steady_clock::now();
+		fclose(file);
+
+		size_t n = dft->getNodes().size();
+		double parseTime = std::chrono::duration<double>(parsed - start).count();
+		double buildTime = std::chrono::duration<double>(built - parsed).count();
+		printf("%zu nodes: parse %.3f s (%.2f us/node), build %.3f s (%.2f us/node)\n",
+		       n, parseTime, parseTime * 1e6 / n, buildTime, buildTime * 1e6 / n);
+		delete dft;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,359 @@
+/*
+ * cutsets.cpp
+ *
+ * Part of dft2lnt library - a library containing read/write operations for DFT
+ * files in Galileo format and translating DFT specifications into Lotos NT.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include "cutsets.h"
+#include "dftnodes/nodes.h"
+
+typedef DFT::Nodes::Node DFTNode;
+
+/* The nodes the FDEP gates triggering the specified node depend on. */
+static std::vector<const DFTNode *> triggerSources(const DFTNode *node)
+{
+	std::vector<const DFTNode *> ret;
+	for (const DFT::Nodes::GateFDEP *fdep : node->getTriggers()) {
+		if (fdep->getEventSource())
+			ret.push_back(fdep->getEventSource());
+	}
+	return ret;
+}
+
+static bool hasCycle(const DFTNode *node,
+                     std::unordered_map<const DFTNode *, int> &state)
+{
+	int &s = state[node];
+	if (s)
+		return s == 1;
+	s = 1;
+	std::vector<const DFTNode *> next = triggerSources(node);
+	if (node->isGate()) {
+		const DFT::Nodes::Gate *g = static_cast<const DFT::Nodes::Gate *>(node);
+		next.insert(next.end(), g->getChildren().begin(), g->getChildren().end());
+	}
+	for (const DFTNode *n : next) {
+		if (hasCycle(n, state))
+			return true;
+	}
+	state[node] = 2;
+	return false;
+}
+
+class DFT::CutSetGenerator::Worker {
+	const CutSetGenerator &gen;
+	std::unordered_map<const DFTNode *, Family> memo;
+
+	/* Removes duplicates and supersets. */
+	static void minimise(Family &f) {
+		std::sort(f.begin(), f.end(), [](const CutSet &a, const CutSet &b) {
+				if (a.size() != b.size())
+					return a.size() < b.size();
+				return a < b;
+			});
+		f.erase(std::unique(f.begin(), f.end()), f.end());
+		if (!f.empty() && f[0].empty()) {
+			f.resize(1);
+			return;
+		}
+		/* Kept sets by their first event: a subset of c starts
+		 * with one of the events of c.
+		 */
+		std::unordered_map<uint32_t, std::vector<size_t>> byFirst;
+		Family ret;
+		for (CutSet &c : f) {
+			bool minimal = true;
+			for (size_t i = 0; minimal && i < c.size(); i++) {
+				auto it = byFirst.find(c[i]);
+				if (it == byFirst.end())
+					continue;
+				for (size_t j : it->second) {
+					const CutSet &s = ret[j];
+					if (std::includes(c.begin(), c.end(), s.begin(), s.end())) {
+						minimal = false;
+						break;
+					}
+				}
+			}
+			if (minimal) {
+				byFirst[c[0]].push_back(ret.size());
+				ret.push_back(std::move(c));
+			}
+		}
+		f.swap(ret);
+	}
+
+	void truncate(const CutSet &cs) {
+		for (size_t t = 0; t < truncated.size(); t++)
+			truncated[t] += gen.probability(cs, t);
+	}
+
+	Family disj(Family a, const Family &b) {
+		a.insert(a.end(), b.begin(), b.end());
+		minimise(a);
+		return a;
+	}
+
+	Family conj(const Family &a, const Family &b) {
+		if (a.size() == 1 && a[0].empty())
+			return b;
+		if (b.size() == 1 && b[0].empty())
+			return a;
+		Family ret;
+		for (const CutSet &f : a) {
+			for (const CutSet &g : b) {
+				CutSet u;
+				u.reserve(f.size() + g.size());
+				std::set_union(f.begin(), f.end(), g.begin(), g.end(),
+				               std::back_inserter(u));
+				if (u.size() > gen.maxOrder
+				    || gen.maxProbability(u) < gen.cutoff)
+				{
+					truncate(u);
+					continue;
+				}
+				ret.push_back(std::move(u));
+			}
+		}
+		minimise(ret);
+		return ret;
+	}
+
+	/* At least k of the ops, using O(n*k) conjunctions. */
+	Family atLeast(size_t k, const std::vector<Family> &ops) {
+		if (k > ops.size())
+			return Family();
+		std::vector<Family> at(k + 1);
+		at[0].push_back(CutSet());
+		for (size_t i = ops.size(); i-- > 0;) {
+			size_t maxC = std::min(k, ops.size() - i);
+			for (size_t c = maxC; c > 0; c--)
+				at[c] = disj(conj(ops[i], at[c - 1]), at[c]);
+		}
+		return at[k];
+	}
+
+public:
+	std::vector<double> truncated;
+
+	Worker(const CutSetGenerator &gen)
+		:gen(gen), truncated(gen.probabilities->size(), 0)
+	{ }
+
+	/* The cut sets of the gate, given those of its children. */
+	Family combine(const DFTNode *node, const std::vector<Family> &children) {
+		Family ret;
+		if (node->outputIsDumb())
+			return ret;
+		if (node->matchesType(DFT::Nodes::GateOrType)) {
+			for (const Family &c : children)
+				ret = disj(std::move(ret), c);
+		} else if (node->matchesType(DFT::Nodes::GateVotingType)) {
+			const DFT::Nodes::GateVoting *v;
+			v = static_cast<const DFT::Nodes::GateVoting *>(node);
+			ret = atLeast(v->getThreshold(), children);
+		} else if (node->matchesType(DFT::Nodes::GatePorType)) {
+			if (!children.empty())
+				ret = children[0];
+		} else {
+			/* AND, PAND, SAND and spares */
+			ret.push_back(CutSet());
+			for (const Family &c : children)
+				ret = conj(ret, c);
+		}
+		return ret;
+	}
+
+	/* Adds the cut sets of the triggers of the node. */
+	Family addTriggers(const DFTNode *node, Family ret) {
+		for (const DFTNode *src : triggerSources(node))
+			ret = disj(std::move(ret), cutSets(src));
+		return ret;
+	}
+
+	Family cutSets(const DFTNode *node) {
+		auto it = memo.find(node);
+		if (it != memo.end())
+			return it->second;
+		Family ret;
+		if (node->isBasicEvent()) {
+			auto idx = gen.indices.find(node);
+			if (idx == gen.indices.end())
+				ret.push_back(CutSet()); /* Failed by evidence */
+			else
+				ret.push_back(CutSet(1, idx->second));
+		} else {
+			const DFT::Nodes::Gate *g = static_cast<const DFT::Nodes::Gate *>(node);
+			std::vector<Family> children;
+			for (const DFTNode *c : g->getChildren())
+				children.push_back(cutSets(c));
+			ret = combine(node, children);
+		}
+		ret = addTriggers(node, std::move(ret));
+		memo[node] = ret;
+		return ret;
+	}
+};
+
+DFT::CutSetGenerator::CutSetGenerator(DFT::DFTree *dft)
+	:dft(dft), exact(true), probabilities(nullptr), maxOrder(0), cutoff(0)
+{
+	std::vector<std::string> errors;
+	for (const DFTNode *node : dft->getNodes()) {
+		if (!node->getTriggers().empty())
+			exact = false;
+		if (node->isBasicEvent()) {
+			const DFT::Nodes::BasicEvent *be;
+			be = static_cast<const DFT::Nodes::BasicEvent *>(node);
+			if (be->getMode() == DFT::Nodes::BE::CalculationMode::APH) {
+				errors.push_back("Cut sets do not support APH basic event `"
+				                 + be->getName() + "'");
+			} else if (be->getRepair() > 0 || be->isRepairable()
+			           || be->getMaintain() > 0 || be->getInterval() > 0)
+			{
+				errors.push_back("Cut sets do not support repairable basic event `"
+				                 + be->getName() + "'");
+			} else if (!be->getFailed()) {
+				indices.emplace(be, events.size());
+				events.push_back(be);
+			}
+			continue;
+		}
+		if (node->matchesType(DFT::Nodes::GateAndType)
+		    || node->matchesType(DFT::Nodes::GateOrType)
+		    || node->matchesType(DFT::Nodes::GateVotingType))
+		{
+			continue;
+		}
+		exact = false;
+		if (node->matchesType(DFT::Nodes::GatePAndType)
+		    || node->matchesType(DFT::Nodes::GateSAndType)
+		    || node->matchesType(DFT::Nodes::GatePorType)
+		    || node->matchesType(DFT::Nodes::GateSeqType)
+		    || node->matchesType(DFT::Nodes::GateFDEPType))
+		{
+			continue;
+		}
+		if (node->matchesType(DFT::Nodes::GateSpareType)) {
+			/* Without sharing, a spare gate fails only once all
+			 * of its children have failed.
+			 */
+			const DFT::Nodes::Gate *g = static_cast<const DFT::Nodes::Gate *>(node);
+			for (const DFTNode *c : g->getChildren()) {
+				if (c->getParents().size() > 1) {
+					errors.push_back("Cut sets do not support shared spare `"
+					                 + c->getName() + "'");
+				}
+			}
+			continue;
+		}
+		errors.push_back("Cut sets do not support " + node->getTypeStr()
+		                 + " `" + node->getName() + "'");
+	}
+	std::unordered_map<const DFTNode *, int> state;
+	if (errors.empty() && hasCycle(dft->getTopNode(), state))
+		errors.push_back("Cut sets do not support cyclic functional dependencies");
+	if (!errors.empty())
+		throw errors;
+}
+
+double DFT::CutSetGenerator::probability(const CutSet &cs, size_t time) const
+{
+	const std::vector<double> &p = (*probabilities)[time];
+	double ret = 1;
+	for (uint32_t e : cs)
+		ret *= p[e];
+	return ret;
+}
+
+double DFT::CutSetGenerator::maxProbability(const CutSet &cs) const
+{
+	double ret = 1;
+	for (uint32_t e : cs)
+		ret *= maxProbabilities[e];
+	return ret;
+}
+
+void DFT::CutSetGenerator::generate(const std::vector<std::vector<double>> &probabilities,
+                                    size_t maxOrder, double cutoff,
+                                    unsigned int jobs)
+{
+	this->probabilities = &probabilities;
+	this->maxOrder = maxOrder;
+	this->cutoff = cutoff;
+	cutSets.clear();
+	truncated.assign(probabilities.size(), 0);
+	if (probabilities.empty())
+		return;
+	maxProbabilities.assign(events.size(), 0);
+	for (const std::vector<double> &p : probabilities) {
+		for (size_t e = 0; e < events.size(); e++)
+			maxProbabilities[e] = std::max(maxProbabilities[e], p[e]);
+	}
+
+	const DFTNode *top = dft->getTopNode();
+	Worker main(*this);
+	Family result;
+	if (top->isGate() && !top->outputIsDumb() && jobs > 1) {
+		/* The children of the top node are independent tasks, each
+		 * worker taking the next one not yet started.
+		 */
+		const DFT::Nodes::Gate *g = static_cast<const DFT::Nodes::Gate *>(top);
+		const std::vector<DFTNode *> &children = g->getChildren();
+		std::vector<Family> families(children.size());
+		std::vector<std::unique_ptr<Worker>> workers;
+		std::atomic<size_t> next(0);
+		size_t nThreads = std::min<size_t>(jobs, children.size());
+		for (size_t i = 0; i < nThreads; i++)
+			workers.emplace_back(new Worker(*this));
+		std::vector<std::thread> threads;
+		for (size_t i = 0; i < nThreads; i++) {
+			Worker *w = workers[i].get();
+			threads.emplace_back([&, w]() {
+					size_t n;
+					while ((n = next++) < children.size())
+						families[n] = w->cutSets(children[n]);
+				});
+		}
+		for (std::thread &t : threads)
+			t.join();
+		for (const std::unique_ptr<Worker> &w : workers) {
+			for (size_t t = 0; t < truncated.size(); t++)
+				truncated[t] += w->truncated[t];
+		}
+		result = main.addTriggers(top, main.combine(top, families));
+	} else {
+		result = main.cutSets(top);
+	}
+	for (size_t t = 0; t < truncated.size(); t++)
+		truncated[t] += main.truncated[t];
+
+	/* Single events are only checked against the cutoff here */
+	for (CutSet &cs : result) {
+		if (maxProbability(cs) < cutoff) {
+			for (size_t t = 0; t < truncated.size(); t++)
+				truncated[t] += probability(cs, t);
+		} else {
+			cutSets.push_back(std::move(cs));
+		}
+	}
+	std::vector<double> p;
+	for (const CutSet &cs : cutSets)
+		p.push_back(maxProbability(cs));
+	std::vector<size_t> order(cutSets.size());
+	for (size_t i = 0; i < order.size(); i++)
+		order[i] = i;
+	std::stable_sort(order.begin(), order.end(), [&p](size_t a, size_t b) {
+			return p[a] > p[b];
+		});
+	std::vector<CutSet> sorted;
+	for (size_t i : order)
+		sorted.push_back(std::move(cutSets[i]));
+	cutSets.swap(sorted);
+}
@@ -0,0 +1,108 @@
+/*
+ * cutsets.h
+ *
+ * Part of dft2lnt library - a library containing read/write operations for DFT
+ * files in Galileo format and translating DFT specifications into Lotos NT.
+ */
+
+#ifndef CUTSETS_H
+#define CUTSETS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "DFTree.h"
+
+namespace DFT {
+
+/**
+ * Generates the minimal cut sets of a DFT, bottom-up in the manner of
+ * MOCUS. AND, OR and voting gates are handled exactly. Dynamic gates
+ * are relaxed to a necessary condition for their failure: PAND, SAND
+ * and spare gates (without shared spares) to an AND, POR to its first
+ * child, and FDEP dependers to an OR with their triggers. The cut sets
+ * are then those of the relaxed DFT, see isExact().
+ */
+class CutSetGenerator {
+public:
+	/// A cut set, as the sorted indices of its basic events
+	typedef std::vector<uint32_t> CutSet;
+
+	/**
+	 * Prepares the generation for the specified DFT.
+	 * @throws std::vector<std::string> The nodes that cannot be
+	 *         relaxed: repairs, inspections, and repairable or APH
+	 *         basic events.
+	 */
+	CutSetGenerator(DFT::DFTree *dft);
+
+	/**
+	 * Returns the basic events that are not failed by evidence, in the
+	 * order of the indices used in the cut sets.
+	 */
+	const std::vector<const Nodes::BasicEvent *> &getEvents() const {
+		return events;
+	}
+
+	/**
+	 * Returns whether the DFT is static, so that its cut sets are those
+	 * of the DFT itself rather than of a relaxation.
+	 */
+	bool isExact() const { return exact; }
+
+	/**
+	 * Generates the minimal cut sets. Cut sets with more than maxOrder
+	 * events, or with less than cutoff probability at every mission
+	 * time, are not expanded further.
+	 * @param probabilities probabilities[i][e] is the probability that
+	 *        event e has failed at the i'th mission time.
+	 * @param jobs The number of children of the top node whose cut sets
+	 *        are generated in parallel.
+	 */
+	void generate(const std::vector<std::vector<double>> &probabilities,
+	              size_t maxOrder, double cutoff, unsigned int jobs);
+
+	/**
+	 * Returns the minimal cut sets found by generate(), the most
+	 * probable first.
+	 */
+	const std::vector<CutSet> &getCutSets() const { return cutSets; }
+
+	/**
+	 * Returns, for every mission time, an upper bound on the
+	 * probability that a cut set removed by truncation has failed.
+	 */
+	const std::vector<double> &getTruncated() const { return truncated; }
+
+	/**
+	 * Returns the probability that all events of the cut set have
+	 * failed at the specified mission time.
+	 */
+	double probability(const CutSet &cs, size_t time) const;
+
+private:
+	/// The largest probability of the cut set over the mission times
+	double maxProbability(const CutSet &cs) const;
+
+	typedef std::vector<CutSet> Family;
+	class Worker;
+
+	DFT::DFTree *dft;
+	std::vector<const Nodes::BasicEvent *> events;
+	std::unordered_map<const Nodes::Node *, uint32_t> indices;
+	bool exact;
+	const std::vector<std::vector<double>> *probabilities;
+	/// The largest probability of every event over the mission times
+	std::vector<double> maxProbabilities;
+	size_t maxOrder;
+	double cutoff;
+	std::vector<CutSet> cutSets;
+	std::vector<double> truncated;
+};
+
+} // Namespace: DFT
+
+#endif
@@ -19,10 +19,7 @@
 
 #ifdef WIN32
 #define WIN32_LEAN_AND_MEAN // Omit rarely-used and architecture-specific stuff from WIN32
-#include <locale>
 #include <io.h>
-#include <shlobj.h>
-#include <codecvt>
 #include <windows.h>
 #include <memory>
 #endif
@@ -30,18 +27,12 @@
 #include "dft_parser.h"
 #include "dft_ast.h"
 #include "ASTPrinter.h"
-#include "ASTValidator.h"
-#include "ASTDFTBuilder.h"
 #include "FileSystem.h"
 #include "dft2lnt.h"
+#include "files.h"
 #include "DFTree.h"
-#include "DFTreeValidator.h"
 #include "DFTreePrinter.h"
-#ifdef HAVE_CADP
-#include "DFTreeBCGNodeBuilder.h"
-#endif
-#include "DFTreeAUTNodeBuilder.h"
-#include "DFTreeEXPBuilder.h"
+#include "frontend.h"
 #include "compiletime.h"
 #include "Settings.h"
 #include "modularize.h"
@@ -109,54 +100,6 @@ void print_version(MessageFormatter* messageFormatter) {
 	messageFormatter->flush();
 }
 
-static std::string getCache(CompilerContext* compilerContext) {
-	std::string root;
-#ifdef WIN32
-	PWSTR rootStr;
-	HRESULT hr = SHGetKnownFolderPath(FOLDERID_LocalAppData, 0, NULL, &rootStr);
-	if (!SUCCEEDED(hr)) {
-		compilerContext->reportError("Unable to lookup Application Data directory");
-		exit(EXIT_FAILURE);
-	}
-	char bytes[MAX_PATH];
-	WideCharToMultiByte(CP_ACP, 0, rootStr, -1, bytes, sizeof(bytes), NULL, NULL);
-	std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
-	CoTaskMemFree(rootStr);
-	root = std::string(bytes);
-#elif defined __APPLE__
-	root = std::getenv("HOME");
-	root += "/Library/Caches";
-#else
-	root = std::getenv("HOME");
-	root += "/.cache";
-	if (!FileSystem::isDir(File(root))) {
-		if (FileSystem::mkdir(File(root))) {
-			compilerContext->reportError("Could not create cache root directory (" + root + ")");
-			return "";
-		}
-	}
-#endif
-	/* End of OS-specific part */
-
-	std::string cache = root + "/dftcalc";
-	if (!FileSystem::isDir(File(cache))) {
-		if (FileSystem::mkdir(File(cache))) {
-			compilerContext->reportError("Could not create cache directory (" + cache + ")");
-			return "";
-		}
-	}
-
-	std::string autDir = cache + DFT2LNT::AUT_CACHE_DIR;
-	if (!FileSystem::isDir(File(autDir))) {
-		if (FileSystem::mkdir(File(autDir))) {
-			compilerContext->reportError("Could not create .aut directory (" + autDir + ")");
-			return "";
-		}
-	}
-
-	return cache;
-}
-
 std::string getRoot(CompilerContext* compilerContext) {
 	char* root = getenv((const char*)"DFT2LNTROOT");
 	std::string dft2lntRoot = root?string(root):"";
@@ -338,7 +281,8 @@ int main(int argc, char** argv) {
 					break;
 				begin = end + 1;
 			}
-		} else if (!strcmp(argv[argi], "-e")) {
+		} else if (!strcmp(argv[argi], "-r")) {
+			// -r ROOT
 			rootNode = string(argv[++argi]);
 		} else if(!strcmp("--help", argv[argi])) {
 			printHelp = true;
@@ -441,24 +385,16 @@ int main(int argc, char** argv) {
 	std::string dft2lntRoot = getRoot(&compilerContext);
 	bool rootValid = dft2lntRoot!="";
 
-	std::string cacheDir = getCache(&compilerContext);
+	std::string cacheDir = DFT::getCacheDir(&compilerContext);
 	if (cacheDir == "") {
 		compilerContext.flush();
 		return EXIT_FAILURE;
 	}
 
 	/* Parse input file */
-	compilerContext.notify("Checking syntax...",VERBOSITY_FLOW);
-	Parser* parser = new Parser(inputFile,parserInputFilePath,&compilerContext);
-	DFT::AST::ASTNodes* ast = parser->parse();
-	compilerContext.flush();
-	if(!ast || compilerContext.getErrors()>0) {
-		compilerContext.reportError("Syntax is incorrect");
-		ast = 0;
-	} else {
-		compilerContext.reportAction("Syntax is correct",VERBOSITY_FLOW);
-	}
-	compilerContext.flush();
+	DFT::Frontend frontend(&compilerContext, dft2lntRoot, cacheDir);
+	frontend.parse(inputFile, parserInputFilePath);
+	DFT::AST::ASTNodes* ast = frontend.getAST();
 
 	/* Print AST */
 	if(ast && outputASTFileSet) {
@@ -475,62 +411,13 @@ int main(int argc, char** argv) {
 		}
 	}
 	compilerContext.flush();
-	
-	/* Validate input */
-	int astValid = false;
-	if(ast) {
-		compilerContext.notify("Validating AST...",VERBOSITY_FLOW);
-		compilerContext.flush();
-		DFT::ASTValidator validator(ast, &compilerContext);
-		astValid = validator.validate();
-		if(!astValid) {
-			compilerContext.reportError("AST invalid");
-		} else {
-			compilerContext.reportAction("AST is valid",VERBOSITY_FLOW);
-		}
-	}
-	compilerContext.flush();
-	
-	/* Create DFT */
-	DFT::DFTree* dft = NULL;
-	if(astValid) {
-		compilerContext.notify("Building DFT...",VERBOSITY_FLOW);
-		compilerContext.flush();
-		DFT::ASTDFTBuilder builder(ast, &compilerContext);
-		dft = builder.build();
-		if(!dft) {
-			compilerContext.reportError("Could not build DFT");
-		} else {
-			compilerContext.reportAction("DFT built successfully",VERBOSITY_FLOW);
-		}
-	}
-	compilerContext.flush();
 
-	/* Validate DFT */
-	int dftValid = false;
-	if(dft) {
-		compilerContext.notify("Validating DFT...",VERBOSITY_FLOW);
-		compilerContext.flush();
-		DFT::DFTreeValidator validator(dft, &compilerContext);
-		dftValid = validator.validate();
-		if(!dftValid) {
-			compilerContext.reportError("DFT invalid");
-		} else {
-			compilerContext.reportAction("DFT is valid",VERBOSITY_FLOW);
-		}
-	}
-	compilerContext.flush();
-
-	if (!rootNode.empty()) {
-		DFT::Nodes::Node *newRoot = dft->getNode(rootNode);
-		if (newRoot == nullptr) {
-			compilerContext.reportError("Root node " + rootNode + " does not exist.");
-			compilerContext.flush();
-			return 1;
-		}
-		dft->setTopNode(newRoot);
-		dft->removeUnreachable();
+	/* Validate input, create and validate DFT */
+	DFT::DFTree* dft = NULL;
+	if(frontend.validate()) {
+		dft = frontend.buildTree(rootNode);
 	}
+	int dftValid = dft != NULL;
 
 	if (dftValid && outputMODFileSet) {
 		compilerContext.reportAction("Writing static modules...",VERBOSITY_FLOW);
@@ -544,50 +431,14 @@ int main(int argc, char** argv) {
 			compilerContext.flush();
 		}
 		compilerContext.reportAction("Done writing static modules.",VERBOSITY_FLOW);
+		delete dft;
 		return 0;
 	}
-	
-	/* Apply evidence to DFT */
-	if(dftValid && !failedBEs.empty()) {
-		compilerContext.reportAction("Applying evidence to DFT...",VERBOSITY_FLOW);
-		compilerContext.flush();
-		try {
-			dft->applyEvidence(failedBEs);
-		} catch(std::vector<std::string>& errors) {
-			for(std::string e: errors) {
-				compilerContext.reportError(e);
-			}
-			compilerContext.flush();
-		}
-	}
-    
-	/* Add repair knowledge to gates */
-	if(dft) {
-		compilerContext.reportAction("Applying repair knowledge to DFT gates...",VERBOSITY_FLOW);
-		compilerContext.flush();
-		dft->addRepairInfo();
-		compilerContext.reportAction("Done applying repair knowledge to DFT gates...",VERBOSITY_FLOW);
-	}
 
+	/* Apply evidence, repair, always-active, FDEP and SEQ knowledge */
 	if(dft) {
-		/* Add always-active knowledge to gates */
-		compilerContext.reportAction("Applying always-active knowledge to DFT gates...",VERBOSITY_FLOW);
-		compilerContext.flush();
-		dft->addAlwaysActiveInfo();
-		compilerContext.reportAction("Done applying always-active knowledge to DFT gates...",VERBOSITY_FLOW);
-    
-		/* Remove superflous FDEP edges */
-        compilerContext.reportAction("Applying FDEP cleanup to DFT gates...",VERBOSITY_FLOW);
-        compilerContext.flush();
-        dft->checkFDEPInfo();
-        compilerContext.reportAction("Done applying FDEP cleanup to DFT gates...",VERBOSITY_FLOW);
-
-		/* Replace sequence enforcers by SAND gates when possible. */
-        compilerContext.reportAction("Applying SEQ cleanup to DFT gates...",VERBOSITY_FLOW);
-        compilerContext.flush();
-        dft->replaceSEQs();
-        compilerContext.reportAction("Done applying SEQ cleanup to DFT gates...",VERBOSITY_FLOW);
-    }
+		frontend.prepare(dft, failedBEs);
+	}
 
 	/* Printing DFT */
 	if(dftValid && outputDFTFileSet) {
@@ -606,48 +457,38 @@ int main(int argc, char** argv) {
 	}
 	compilerContext.flush();
 
-	/* Building needed BCG files for DFT */
-	if(rootValid && dftValid) {
-		compilerContext.notify("Building needed AUT files...",VERBOSITY_FLOW);
-		compilerContext.flush();
-		DFT::DFTreeAUTNodeBuilder autBuilder(cacheDir, dft, &compilerContext);
-		DFT::DFTreeNodeBuilder *nodeBuilder = &autBuilder;
-#ifdef HAVE_CADP
-		DFT::DFTreeBCGNodeBuilder bcgBuilder(dft2lntRoot,dft, &compilerContext);
-		if (autBuilder.generate()) {
-			compilerContext.notify("Unable to make AUT files, building needed BCG files...",VERBOSITY_FLOW);
-			bcgBuilder.generate();
-			nodeBuilder = &bcgBuilder;
+	/* Building needed AUT files and EXP for DFT */
+	if(rootValid && dftValid && outputFileSet) {
+		// Stream to the output files; only buffer what goes to the report
+		std::ofstream svlFile, expFile;
+		std::stringstream svlText, expText;
+		if(outputSVLFileName!="") {
+			svlFile.open(outputSVLFileName);
+			if(!svlFile.is_open())
+				compilerContext.reportError("SVL output file is not writable: `" + outputSVLFileName + "'");
 		}
-#else
-		if (autBuilder.generate()) {
-			compilerContext.reportError("Unable to create AUT files.");
+		if(outputEXPFileName!="") {
+			expFile.open(outputEXPFileName);
+			if(!expFile.is_open())
+				compilerContext.reportError("EXP output file is not writable: `" + outputEXPFileName + "'");
 		}
-#endif
-		if (outputFileSet) {
-			/* Building EXP out of DFT */
-			compilerContext.notify("Building EXP...",VERBOSITY_FLOW);
-			compilerContext.flush();
-			DFT::DFTreeEXPBuilder builder(dft2lntRoot,".",outputBCGFileName,outputEXPFileName,dft, nodeBuilder, &compilerContext);
-			builder.build();
-
-			if(outputSVLFileName!="") {
-				std::ofstream svlFile (outputSVLFileName);
-				builder.printSVL(svlFile);
-			} else {
-				std::stringstream out;
-				builder.printSVL(out);
-				compilerContext.reportFile("SVL",out.str());
+		std::ostream& svl = svlFile.is_open() ? (std::ostream&)svlFile : svlText;
+		std::ostream& exp = expFile.is_open() ? (std::ostream&)expFile : expText;
+		if(frontend.compile(dft, outputBCGFileName, outputEXPFileName, svl, exp)) {
+			if(outputSVLFileName=="")
+				compilerContext.reportFile("SVL",svlText.str());
+			if(outputEXPFileName=="")
+				compilerContext.reportFile("EXP",expText.str());
+		} else {
+			// Do not leave partially written output behind
+			if(svlFile.is_open()) {
+				svlFile.close();
+				FileSystem::remove(File(outputSVLFileName));
 			}
-			if(outputEXPFileName!="") {
-				std::ofstream expFile (outputEXPFileName);
-				builder.printEXP(expFile);
-			} else {
-				std::stringstream out;
-				builder.printEXP(out);
-				compilerContext.reportFile("EXP",out.str());
+			if(expFile.is_open()) {
+				expFile.close();
+				FileSystem::remove(File(outputEXPFileName));
 			}
-
 		}
 	}
 	compilerContext.flush();
@@ -660,9 +501,7 @@ int main(int argc, char** argv) {
 		compilerContext.flush();
 	}
 	
-	if(ast) delete ast;
 	if(dft) delete dft;
-	delete parser;
 	
 	if(settings["warn-code"] && compilerContext.getWarnings()>0) {
 		return EXIT_FAILURE;
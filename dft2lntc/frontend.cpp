@@ -0,0 +1,280 @@
+/*
+ * frontend.cpp
+ *
+ * Part of dft2lnt library - a library containing read/write operations for DFT
+ * files in Galileo format and translating DFT specifications into Lotos NT.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string>
+
+#ifdef WIN32
+#define WIN32_LEAN_AND_MEAN // Omit rarely-used and architecture-specific stuff from WIN32
+#include <locale>
+#include <io.h>
+#include <shlobj.h>
+#include <codecvt>
+#include <windows.h>
+#endif
+
+#include "frontend.h"
+#include "ASTValidator.h"
+#include "ASTDFTBuilder.h"
+#include "FileSystem.h"
+#include "dft2lnt.h"
+#include "DFTreeValidator.h"
+#ifdef HAVE_CADP
+#include "DFTreeBCGNodeBuilder.h"
+#endif
+#include "DFTreeAUTNodeBuilder.h"
+
+static const int VERBOSITY_FLOW = 1;
+
+DFT::Frontend::Frontend(CompilerContext* cc, std::string dft2lntRoot, std::string cacheDir):
+	cc(cc),
+	dft2lntRoot(dft2lntRoot),
+	cacheDir(cacheDir),
+	parser(NULL),
+	ast(NULL),
+	valid(false) {
+}
+
+DFT::Frontend::~Frontend() {
+	if(ast) delete ast;
+	if(parser) delete parser;
+}
+
+bool DFT::Frontend::parse(FILE* file, const std::string& fileName) {
+	if(ast) delete ast;
+	if(parser) delete parser;
+	ast = NULL;
+	valid = false;
+	this->fileName = fileName;
+
+	cc->notify("Checking syntax...",VERBOSITY_FLOW);
+	parser = new Parser(file,fileName,cc);
+	ast = parser->parse();
+	cc->flush();
+	if(!ast || cc->getErrors()>0) {
+		cc->reportError("Syntax is incorrect");
+		if(ast) delete ast;
+		ast = NULL;
+	} else {
+		cc->reportAction("Syntax is correct",VERBOSITY_FLOW);
+	}
+	cc->flush();
+	return ast != NULL;
+}
+
+bool DFT::Frontend::validate() {
+	if(!ast) return false;
+	cc->notify("Validating AST...",VERBOSITY_FLOW);
+	cc->flush();
+	DFT::ASTValidator validator(ast, cc);
+	valid = validator.validate();
+	if(!valid) {
+		cc->reportError("AST invalid");
+	} else {
+		cc->reportAction("AST is valid",VERBOSITY_FLOW);
+	}
+	cc->flush();
+	return valid;
+}
+
+bool DFT::Frontend::load(const std::string& fileName) {
+	FILE* file = fopen(fileName.c_str(),"rb");
+	if(!file) {
+		cc->reportError("unable to open inputfile " + fileName);
+		cc->flush();
+		return false;
+	}
+	bool ok = parse(file,fileName);
+	fclose(file);
+	return ok && validate();
+}
+
+DFT::DFTree* DFT::Frontend::buildTree(const std::string& root) {
+	if(!valid) return NULL;
+
+	/* Create DFT */
+	cc->notify("Building DFT...",VERBOSITY_FLOW);
+	cc->flush();
+	DFT::ASTDFTBuilder builder(ast, cc);
+	DFT::DFTree* dft = builder.build();
+	if(!dft) {
+		cc->reportError("Could not build DFT");
+		cc->flush();
+		return NULL;
+	}
+	cc->reportAction("DFT built successfully",VERBOSITY_FLOW);
+
+	/* Validate DFT */
+	cc->notify("Validating DFT...",VERBOSITY_FLOW);
+	cc->flush();
+	DFT::DFTreeValidator validator(dft, cc);
+	if(!validator.validate()) {
+		cc->reportError("DFT invalid");
+		cc->flush();
+		delete dft;
+		return NULL;
+	}
+	cc->reportAction("DFT is valid",VERBOSITY_FLOW);
+
+	if(!root.empty()) {
+		DFT::Nodes::Node* newRoot = dft->getNode(root);
+		if(newRoot == nullptr) {
+			cc->reportError("Root node " + root + " does not exist.");
+			cc->flush();
+			delete dft;
+			return NULL;
+		}
+		dft->setTopNode(newRoot);
+		dft->removeUnreachable();
+	}
+	cc->flush();
+	return dft;
+}
+
+bool DFT::Frontend::prepare(DFT::DFTree* dft, const std::vector<std::string>& evidence) {
+	bool ok = true;
+
+	/* Apply evidence to DFT */
+	if(!evidence.empty()) {
+		cc->reportAction("Applying evidence to DFT...",VERBOSITY_FLOW);
+		cc->flush();
+		try {
+			dft->applyEvidence(evidence);
+		} catch(std::vector<std::string>& errors) {
+			for(std::string e: errors) {
+				cc->reportError(e);
+			}
+			cc->flush();
+			ok = false;
+		}
+	}
+
+	/* Add repair knowledge to gates */
+	cc->reportAction("Applying repair knowledge to DFT gates...",VERBOSITY_FLOW);
+	cc->flush();
+	dft->addRepairInfo();
+	cc->reportAction("Done applying repair knowledge to DFT gates...",VERBOSITY_FLOW);
+
+	/* Add always-active knowledge to gates */
+	cc->reportAction("Applying always-active knowledge to DFT gates...",VERBOSITY_FLOW);
+	cc->flush();
+	dft->addAlwaysActiveInfo();
+	cc->reportAction("Done applying always-active knowledge to DFT gates...",VERBOSITY_FLOW);
+
+	/* Remove superflous FDEP edges */
+	cc->reportAction("Applying FDEP cleanup to DFT gates...",VERBOSITY_FLOW);
+	cc->flush();
+	dft->checkFDEPInfo();
+	cc->reportAction("Done applying FDEP cleanup to DFT gates...",VERBOSITY_FLOW);
+
+	/* Replace sequence enforcers by SAND gates when possible. */
+	cc->reportAction("Applying SEQ cleanup to DFT gates...",VERBOSITY_FLOW);
+	cc->flush();
+	dft->replaceSEQs();
+	cc->reportAction("Done applying SEQ cleanup to DFT gates...",VERBOSITY_FLOW);
+	cc->flush();
+
+	return ok;
+}
+
+bool DFT::Frontend::compile(DFT::DFTree* dft, const std::string& bcgName,
+                            const std::string& expName,
+                            std::ostream& svl, std::ostream& exp,
+                            EXPComposition* composition)
+{
+	/* Building needed AUT files for DFT */
+	cc->notify("Building needed AUT files...",VERBOSITY_FLOW);
+	cc->flush();
+	DFT::DFTreeAUTNodeBuilder autBuilder(cacheDir, dft, cc);
+	DFT::DFTreeNodeBuilder *nodeBuilder = &autBuilder;
+#ifdef HAVE_CADP
+	DFT::DFTreeBCGNodeBuilder bcgBuilder(dft2lntRoot, dft, cc);
+	if (autBuilder.generate()) {
+		cc->notify("Unable to make AUT files, building needed BCG files...",VERBOSITY_FLOW);
+		bcgBuilder.generate();
+		nodeBuilder = &bcgBuilder;
+	}
+#else
+	if (autBuilder.generate()) {
+		cc->reportError("Unable to create AUT files.");
+		cc->flush();
+		return false;
+	}
+#endif
+
+	/* Building EXP out of DFT */
+	cc->notify("Building EXP...",VERBOSITY_FLOW);
+	cc->flush();
+	DFT::DFTreeEXPBuilder builder(dft2lntRoot, ".", bcgName, expName, dft, nodeBuilder, cc);
+	if(builder.build()) {
+		cc->reportError("Could not build EXP");
+		cc->flush();
+		return false;
+	}
+	builder.printSVL(svl);
+	builder.printEXP(exp);
+	if(composition)
+		builder.getComposition(*composition);
+	cc->flush();
+	return true;
+}
+
+std::string DFT::getCacheDir(CompilerContext* compilerContext) {
+	std::string root;
+#ifdef WIN32
+	PWSTR rootStr;
+	HRESULT hr = SHGetKnownFolderPath(FOLDERID_LocalAppData, 0, NULL, &rootStr);
+	if (!SUCCEEDED(hr)) {
+		compilerContext->reportError("Unable to lookup Application Data directory");
+		return "";
+	}
+	char bytes[MAX_PATH];
+	WideCharToMultiByte(CP_ACP, 0, rootStr, -1, bytes, sizeof(bytes), NULL, NULL);
+	CoTaskMemFree(rootStr);
+	root = std::string(bytes);
+#elif defined __APPLE__
+	root = std::getenv("HOME");
+	root += "/Library/Caches";
+#else
+	root = std::getenv("HOME");
+	root += "/.cache";
+	if (!FileSystem::isDir(File(root))) {
+		if (FileSystem::mkdir(File(root))) {
+			compilerContext->reportError("Could not create cache root directory (" + root + ")");
+			return "";
+		}
+	}
+#endif
+	/* End of OS-specific part */
+
+	std::string cache = root + "/dftcalc";
+	if (!FileSystem::isDir(File(cache))) {
+		if (FileSystem::mkdir(File(cache))) {
+			compilerContext->reportError("Could not create cache directory (" + cache + ")");
+			return "";
+		}
+	}
+
+	std::string autDir = cache + DFT2LNT::AUT_CACHE_DIR;
+	if (!FileSystem::isDir(File(autDir))) {
+		if (FileSystem::mkdir(File(autDir))) {
+			compilerContext->reportError("Could not create .aut directory (" + autDir + ")");
+			return "";
+		}
+	}
+
+	std::string resultDir = cache + DFT2LNT::RESULT_CACHE_DIR;
+	if (!FileSystem::isDir(File(resultDir))) {
+		if (FileSystem::mkdir(File(resultDir))) {
+			compilerContext->reportError("Could not create result directory (" + resultDir + ")");
+			return "";
+		}
+	}
+
+	return cache;
+}
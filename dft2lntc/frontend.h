@@ -0,0 +1,124 @@
+/*
+ * frontend.h
+ *
+ * Part of dft2lnt library - a library containing read/write operations for DFT
+ * files in Galileo format and translating DFT specifications into Lotos NT.
+ */
+
+#ifndef FRONTEND_H
+#define FRONTEND_H
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <stdio.h>
+
+#include "dft_parser.h"
+#include "dft_ast.h"
+#include "DFTree.h"
+#include "compiler.h"
+#include "DFTreeEXPBuilder.h"
+
+namespace DFT {
+
+/**
+ * In-process access to the stages of the dft2lntc compiler:
+ * parser -> ASTValidator -> ASTDFTBuilder -> DFTreeValidator ->
+ * DFTreeEXPBuilder.
+ * A DFT file is parsed and validated once. The AST is retained, so any
+ * number of (re-rooted) DFTrees can afterwards be built from it without
+ * touching the input file again.
+ */
+class Frontend {
+private:
+	CompilerContext* cc;
+	std::string dft2lntRoot;
+	std::string cacheDir;
+	std::string fileName;
+	Parser* parser;
+	DFT::AST::ASTNodes* ast;
+	bool valid;
+public:
+
+	/**
+	 * Creates a new front end reporting to the specified CompilerContext.
+	 * @param cc The CompilerContext used for errors and progress.
+	 * @param dft2lntRoot The dft2lnt root folder, used by the BCG node
+	 *        builder and the EXP builder.
+	 * @param cacheDir The cache directory the AUT node files are put in,
+	 *        see getCacheDir().
+	 */
+	Frontend(CompilerContext* cc, std::string dft2lntRoot, std::string cacheDir);
+	virtual ~Frontend();
+
+	/**
+	 * Parses the specified open file. The name is used in error messages
+	 * and to find files embedded by aph attributes.
+	 * @return true if the syntax is correct, false otherwise.
+	 */
+	bool parse(FILE* file, const std::string& fileName);
+
+	/**
+	 * Validates the AST obtained by parse().
+	 * @return true if the AST is valid, false otherwise.
+	 */
+	bool validate();
+
+	/**
+	 * Parses and validates the specified file.
+	 * @return true if the file is a valid DFT, false otherwise.
+	 */
+	bool load(const std::string& fileName);
+
+	/**
+	 * Returns the AST obtained by parse(), or NULL if there is none.
+	 */
+	DFT::AST::ASTNodes* getAST() { return ast; }
+
+	/**
+	 * Returns the name of the file the AST was parsed from.
+	 */
+	const std::string& getFileName() const { return fileName; }
+
+	/**
+	 * Builds and validates a new DFTree from the retained AST. If root is
+	 * not empty, the tree is re-rooted at the node with that name and all
+	 * nodes no longer reachable are removed.
+	 * The caller becomes owner of the returned DFTree.
+	 * @return The new DFTree, or NULL on error.
+	 */
+	DFT::DFTree* buildTree(const std::string& root = "");
+
+	/**
+	 * Applies the specified evidence, and the repair, always-active, FDEP
+	 * and SEQ rewrites needed before node generation.
+	 * @return true if successful, false otherwise.
+	 */
+	bool prepare(DFT::DFTree* dft, const std::vector<std::string>& evidence);
+
+	/**
+	 * Generates the node automata needed by the specified DFT and writes
+	 * its SVL script and EXP composition to the specified streams.
+	 * @param bcgName The BCG file the SVL script should produce.
+	 * @param expName The name of the EXP file as referenced by the SVL
+	 *        script.
+	 * @param composition If not NULL, the composition described by the
+	 *        EXP file is stored here as well.
+	 * @return true if successful, false otherwise.
+	 */
+	bool compile(DFT::DFTree* dft, const std::string& bcgName,
+	             const std::string& expName,
+	             std::ostream& svl, std::ostream& exp,
+	             EXPComposition* composition = NULL);
+};
+
+/**
+ * Returns the dftcalc cache directory (e.g., ~/.cache/dftcalc), creating
+ * it and its AUT node subdirectory if needed.
+ * @return The cache directory, or the empty string on error.
+ */
+std::string getCacheDir(CompilerContext* cc);
+
+} // Namespace: DFT
+
+#endif
@@ -1,14 +1,539 @@
 #include "modularize.h"
 #include "dftnodes/nodes.h"
+#include "DFTreeNodeBuilder.h"
+#include "bdd.h"
+#include "sha256.h"
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_set>
 #include <ostream>
 #include <fstream>
+#include <sstream>
+#include <unordered_map>
 #include <vector>
 
+typedef DFT::Nodes::Node DFTNode;
+
+/* Everything about a node that affects its behaviour, except for its
+ * connections to other nodes.
+ */
+static std::string nodeLabel(const DFTNode *node)
+{
+	std::ostringstream out;
+	out << DFT::DFTreeNodeBuilder::getNodeName(*node);
+	if (node->isBasicEvent()) {
+		const DFT::Nodes::BasicEvent *be;
+		be = static_cast<const DFT::Nodes::BasicEvent *>(node);
+		out << " l=" << be->getLambda().str()
+		    << " p=" << be->getProb().str()
+		    << " d=" << be->getDorm().str()
+		    << " res=" << be->getRes().str()
+		    << " m=" << be->getMaintain()
+		    << " r=" << be->getRepair()
+		    << " prio=" << be->getPriority()
+		    << " ph=" << be->getPhases()
+		    << " i=" << be->getInterval()
+		    << " f=" << be->getFailed()
+		    << " e=" << be->getFileToEmbed();
+	} else if (node->matchesType(DFT::Nodes::InspectionType)) {
+		const DFT::Nodes::Inspection *insp;
+		insp = static_cast<const DFT::Nodes::Inspection *>(node);
+		out << " l=" << insp->getLambda().str()
+		    << " ph=" << insp->getPhases();
+	} else if (node->matchesType(DFT::Nodes::ReplacementType)) {
+		const DFT::Nodes::Replacement *rep;
+		rep = static_cast<const DFT::Nodes::Replacement *>(node);
+		out << " l=" << rep->getLambda()
+		    << " ph=" << rep->getPhases();
+	}
+	return out.str();
+}
+
+/* Whether the order of the children of the node is irrelevant. */
+static bool isCommutative(const DFTNode *node)
+{
+	return node->matchesType(DFT::Nodes::GateAndType)
+	       || node->matchesType(DFT::Nodes::GateOrType)
+	       || node->matchesType(DFT::Nodes::GateVotingType);
+}
+
+namespace {
+/* Computes the canonical form of a module: a depth-first serialisation
+ * of its nodes, each given by its label and the (indices of the) nodes
+ * it depends on. Nodes with several candidate orders (the children of
+ * commutative gates, the dependers of FDEPs and the parents of a node)
+ * are ordered by a hash of the shape of their subtree, so that modules
+ * differing only in names and in the order of their declarations get the
+ * same form.
+ */
+class ModuleHasher {
+	const DFTNode *root;
+	std::unordered_map<const DFTNode *, size_t> shapes;
+	std::unordered_map<const DFTNode *, size_t> indices;
+	SHA256 hash;
+
+	size_t shape(const DFTNode *node) {
+		auto it = shapes.find(node);
+		if (it != shapes.end())
+			return it->second;
+		size_t ret = std::hash<std::string>()(nodeLabel(node));
+		/* Provisional value, in case of cycles through FDEPs */
+		shapes[node] = ret;
+		std::vector<size_t> children, dependers;
+		if (node->isGate()) {
+			const DFT::Nodes::Gate *g;
+			g = static_cast<const DFT::Nodes::Gate *>(node);
+			for (const DFTNode *c : g->getChildren())
+				children.push_back(shape(c));
+			if (isCommutative(node))
+				std::sort(children.begin(), children.end());
+			if (node->matchesType(DFT::Nodes::GateFDEPType)) {
+				const DFT::Nodes::GateFDEP *f;
+				f = static_cast<const DFT::Nodes::GateFDEP *>(node);
+				for (const DFTNode *d : f->getDependers())
+					dependers.push_back(shape(d));
+				std::sort(dependers.begin(), dependers.end());
+			}
+		}
+		for (size_t c : children)
+			ret = ret * 31 + c;
+		ret = ret * 37 + dependers.size();
+		for (size_t d : dependers)
+			ret = ret * 31 + d;
+		shapes[node] = ret;
+		return ret;
+	}
+
+	void sortByShape(std::vector<const DFTNode *> &nodes) {
+		std::stable_sort(nodes.begin(), nodes.end(),
+			[this](const DFTNode *a, const DFTNode *b) {
+				return shape(a) < shape(b);
+			});
+	}
+
+	void visit(const DFTNode *node) {
+		auto it = indices.find(node);
+		if (it != indices.end()) {
+			hash.update("@" + std::to_string(it->second) + ";");
+			return;
+		}
+		indices.emplace(node, indices.size());
+		hash.update("N" + nodeLabel(node) + "|");
+
+		std::vector<const DFTNode *> children, dependers;
+		if (node->isGate()) {
+			const DFT::Nodes::Gate *g;
+			g = static_cast<const DFT::Nodes::Gate *>(node);
+			children.assign(g->getChildren().begin(), g->getChildren().end());
+			if (isCommutative(node))
+				sortByShape(children);
+			if (node->matchesType(DFT::Nodes::GateFDEPType)) {
+				const DFT::Nodes::GateFDEP *f;
+				f = static_cast<const DFT::Nodes::GateFDEP *>(node);
+				dependers.assign(f->getDependers().begin(),
+				                 f->getDependers().end());
+				sortByShape(dependers);
+			}
+		}
+		hash.update(std::to_string(children.size()) + "{");
+		for (const DFTNode *c : children)
+			visit(c);
+		hash.update("}" + std::to_string(dependers.size()) + "{");
+		for (const DFTNode *d : dependers)
+			visit(d);
+		hash.update("}");
+
+		/* The edges from the other nodes of the module to this one
+		 * are serialised with those nodes, but they still need to be
+		 * reached. As in isIndependentSubtree(), the parents of the
+		 * root are outside the module.
+		 */
+		if (node == root)
+			return;
+		std::vector<const DFTNode *> users;
+		for (const DFTNode *p : node->getParents())
+			users.push_back(p);
+		for (const DFTNode *t : node->getTriggers())
+			users.push_back(t);
+		sortByShape(users);
+		for (const DFTNode *u : users) {
+			if (indices.find(u) == indices.end()) {
+				hash.update("^");
+				visit(u);
+			}
+		}
+	}
+
+public:
+	ModuleHasher(const DFTNode *root) :root(root) {}
+
+	std::string compute() {
+		visit(root);
+		return hash.hexDigest();
+	}
+};
+}
+
+std::string moduleHash(const DFTNode *root)
+{
+	return ModuleHasher(root).compute();
+}
+
+static bool isStaticGate(const DFTNode *node)
+{
+	return node->matchesType(DFT::Nodes::GateAndType)
+	       || node->matchesType(DFT::Nodes::GateOrType)
+	       || node->matchesType(DFT::Nodes::GateVotingType);
+}
+
+static bool isStaticBE(const DFTNode *node)
+{
+	if (!node->isBasicEvent())
+		return false;
+	const DFT::Nodes::BasicEvent *be;
+	be = static_cast<const DFT::Nodes::BasicEvent *>(node);
+	if (be->getMode() != DFT::Nodes::BE::CalculationMode::EXPONENTIAL
+	    && be->getMode() != DFT::Nodes::BE::CalculationMode::PROBABILITY)
+	{
+		return false;
+	}
+	return !be->isRepairable() && be->getMaintain() <= 0
+	       && be->getInterval() <= 0 && be->getRes().is_zero();
+}
+
+/* Collects the nodes of the module rooted at root, if it is a static
+ * fault tree: AND, OR and voting gates over non-repairable basic events
+ * with (Erlang-)exponential or constant failure distributions, without
+ * any FDEPs, and connected to the rest of the DFT only through root.
+ */
+static bool collectStatic(DFTNode *root, std::unordered_set<DFTNode *> &region)
+{
+	std::vector<DFTNode *> stack(1, root);
+	region.insert(root);
+	while (!stack.empty()) {
+		DFTNode *node = stack.back();
+		stack.pop_back();
+		if (!node->getTriggers().empty())
+			return false;
+		if (isStaticBE(node))
+			continue;
+		if (!isStaticGate(node))
+			return false;
+		DFT::Nodes::Gate *g = static_cast<DFT::Nodes::Gate *>(node);
+		for (DFTNode *c : g->getChildren()) {
+			if (region.insert(c).second)
+				stack.push_back(c);
+		}
+	}
+	for (DFTNode *node : region) {
+		if (node == root)
+			continue;
+		for (DFTNode *p : node->getParents()) {
+			if (region.find(p) == region.end())
+				return false;
+		}
+	}
+	return true;
+}
+
+namespace {
+/* How a StaticCompiler treats dynamic gates: not at all (EXACT), or
+ * relaxed to a necessary (UPPER) or sufficient (LOWER) condition for
+ * their failure.
+ */
+enum class Relaxation { EXACT, UPPER, LOWER };
+
+/* Compiles a static module into a BDD. The variables are ordered
+ * depth-first, visiting the children with the most shared basic events
+ * below them first, so that shared events get the top levels.
+ */
+class StaticCompiler {
+	Relaxation relax;
+	DFT::BDD bdd;
+	std::unordered_map<const DFTNode *, size_t> shared;
+	std::unordered_map<const DFTNode *, uint32_t> vars;
+	std::unordered_set<const DFTNode *> ordered;
+	std::unordered_map<const DFTNode *, uint32_t> built;
+	std::unordered_set<const DFTNode *> building;
+
+	size_t countShared(const DFTNode *node) {
+		auto it = shared.find(node);
+		if (it != shared.end())
+			return it->second;
+		size_t ret = 0;
+		if (node->isBasicEvent()) {
+			ret = node->getParents().size() > 1;
+		} else {
+			const DFT::Nodes::Gate *g;
+			g = static_cast<const DFT::Nodes::Gate *>(node);
+			for (const DFTNode *c : g->getChildren())
+				ret += countShared(c);
+		}
+		shared[node] = ret;
+		return ret;
+	}
+
+	/* The primaries of the other spare gates that may claim the
+	 * specified spare.
+	 */
+	std::vector<const DFTNode *> claimants(const DFTNode *gate,
+	                                       const DFTNode *spare)
+	{
+		std::vector<const DFTNode *> ret;
+		for (const DFT::Nodes::Gate *q : spare->getParents()) {
+			if (q != gate && q->matchesType(DFT::Nodes::GateSpareType)
+			    && !q->getChildren().empty())
+			{
+				ret.push_back(q->getChildren()[0]);
+			}
+		}
+		return ret;
+	}
+
+	/* The nodes the BDD of the specified node is built from. */
+	std::vector<const DFTNode *> inputs(const DFTNode *node) {
+		std::vector<const DFTNode *> ret;
+		if (node->isGate()) {
+			const DFT::Nodes::Gate *g = static_cast<const DFT::Nodes::Gate *>(node);
+			ret.assign(g->getChildren().begin(), g->getChildren().end());
+			std::stable_sort(ret.begin(), ret.end(),
+				[this](const DFTNode *a, const DFTNode *b) {
+					return countShared(a) > countShared(b);
+				});
+		}
+		if (relax != Relaxation::UPPER)
+			return ret;
+		for (const DFT::Nodes::GateFDEP *fdep : node->getTriggers()) {
+			if (fdep->getEventSource())
+				ret.push_back(fdep->getEventSource());
+		}
+		if (node->matchesType(DFT::Nodes::GateSpareType)) {
+			const DFT::Nodes::Gate *g = static_cast<const DFT::Nodes::Gate *>(node);
+			for (const DFTNode *c : g->getChildren()) {
+				for (const DFTNode *p : claimants(node, c))
+					ret.push_back(p);
+			}
+		}
+		return ret;
+	}
+
+	void order(const DFTNode *node) {
+		if (node->isBasicEvent()) {
+			const DFT::Nodes::BasicEvent *be;
+			be = static_cast<const DFT::Nodes::BasicEvent *>(node);
+			if (!be->getFailed() && vars.find(node) == vars.end()) {
+				vars.emplace(node, events.size());
+				events.push_back(be);
+			}
+		}
+		if (ordered.insert(node).second) {
+			for (const DFTNode *c : inputs(node))
+				order(c);
+		}
+	}
+
+	uint32_t buildGate(const DFTNode *node) {
+		if (node->outputIsDumb())
+			return DFT::BDD::ZERO;
+		const DFT::Nodes::Gate *g = static_cast<const DFT::Nodes::Gate *>(node);
+		const std::vector<DFTNode *> &children = g->getChildren();
+		uint32_t ret;
+		if (isStaticGate(node)) {
+			std::vector<uint32_t> ops;
+			for (const DFTNode *c : children)
+				ops.push_back(build(c));
+			if (node->matchesType(DFT::Nodes::GateAndType)) {
+				ret = DFT::BDD::ONE;
+				for (uint32_t op : ops)
+					ret = bdd.conj(ret, op);
+			} else if (node->matchesType(DFT::Nodes::GateOrType)) {
+				ret = DFT::BDD::ZERO;
+				for (uint32_t op : ops)
+					ret = bdd.disj(ret, op);
+			} else {
+				const DFT::Nodes::GateVoting *v;
+				v = static_cast<const DFT::Nodes::GateVoting *>(node);
+				ret = bdd.atLeast(v->getThreshold(), ops);
+			}
+		} else if (node->matchesType(DFT::Nodes::GateSpareType)) {
+			/* A spare gate has failed if all of its children have,
+			 * and only if all of them have failed or been claimed
+			 * by another gate after the failure of its primary.
+			 */
+			ret = DFT::BDD::ONE;
+			for (size_t i = 0; i < children.size(); i++) {
+				uint32_t gone = build(children[i]);
+				if (relax == Relaxation::UPPER && i > 0) {
+					for (const DFTNode *p : claimants(node, children[i]))
+						gone = bdd.disj(gone, build(p));
+				}
+				ret = bdd.conj(ret, gone);
+			}
+		} else if (relax == Relaxation::LOWER) {
+			ret = DFT::BDD::ZERO;
+		} else if (node->matchesType(DFT::Nodes::GatePorType)) {
+			ret = children.empty() ? DFT::BDD::ZERO : build(children[0]);
+		} else {
+			/* PAND, SAND and SEQ need all of their children */
+			ret = DFT::BDD::ONE;
+			for (const DFTNode *c : children)
+				ret = bdd.conj(ret, build(c));
+		}
+		return ret;
+	}
+
+	uint32_t build(const DFTNode *node) {
+		auto it = built.find(node);
+		if (it != built.end())
+			return it->second;
+		if (!building.insert(node).second) {
+			cyclic = true;
+			return DFT::BDD::ZERO;
+		}
+		uint32_t ret;
+		if (node->isBasicEvent()) {
+			auto var = vars.find(node);
+			if (var == vars.end())
+				ret = DFT::BDD::ONE; /* Failed by evidence */
+			else
+				ret = bdd.variable(var->second);
+		} else {
+			ret = buildGate(node);
+		}
+		if (relax == Relaxation::UPPER) {
+			for (const DFT::Nodes::GateFDEP *fdep : node->getTriggers()) {
+				if (fdep->getEventSource())
+					ret = bdd.disj(ret, build(fdep->getEventSource()));
+			}
+		}
+		building.erase(node);
+		built[node] = ret;
+		return ret;
+	}
+
+public:
+	std::vector<const DFT::Nodes::BasicEvent *> events;
+	/// Whether the relaxation has cyclic functional dependencies
+	bool cyclic;
+
+	StaticCompiler(Relaxation relax = Relaxation::EXACT,
+	               size_t maxNodes = 1 << 22)
+		:relax(relax), bdd(maxNodes), cyclic(false)
+	{ }
+
+	/* Returns the root of the BDD of the module rooted at node. */
+	uint32_t compile(const DFTNode *node) {
+		order(node);
+		return build(node);
+	}
+
+	std::vector<DFT::BDD::Node> extract(uint32_t root, uint32_t &newRoot) {
+		return bdd.extract(root, newRoot);
+	}
+};
+}
+
+/* Writes the BDD of the module rooted at root as a B module:
+ * B<events> <nodes> <BDD root> <DFT root>
+ * followed by the lambda, probability and phases of every event, and
+ * the variable, low and high child of every non-terminal node.
+ * The events in dormant are written with their dormant failure rate.
+ * @return Whether the BDD could be built within maxNodes nodes.
+ */
+static bool writeBDD(std::ostream &out, const DFTNode *root, Relaxation relax,
+                     const std::unordered_set<const DFTNode *> &dormant,
+                     size_t maxNodes = 1 << 22)
+{
+	StaticCompiler compiler(relax, maxNodes);
+	std::vector<DFT::BDD::Node> nodes;
+	uint32_t bddRoot;
+	try {
+		nodes = compiler.extract(compiler.compile(root), bddRoot);
+	} catch (std::length_error &) {
+		return false;
+	}
+	if (compiler.cyclic)
+		return false;
+	out << "B" << compiler.events.size() << " " << nodes.size()
+	    << " " << bddRoot << " " << root->getName() << "\n";
+	for (const DFT::Nodes::BasicEvent *be : compiler.events) {
+		decnumber<> lambda = be->getLambda();
+		if (dormant.count(be) && lambda != -1)
+			lambda = be->getMu();
+		out << lambda.str() << " " << be->getProb().str()
+		    << " " << be->getPhases() << "\n";
+	}
+	for (size_t i = 2; i < nodes.size(); i++)
+		out << nodes[i].var << " " << nodes[i].low << " " << nodes[i].high << "\n";
+	return true;
+}
+
+/* Writes the module rooted at root as a BDD (B), if it is static.
+ * @return Whether the module was static.
+ */
+static bool writeStatic(std::ostream &out, DFTNode *root)
+{
+	std::unordered_set<DFTNode *> region;
+	if (!collectStatic(root, region))
+		return false;
+	return writeBDD(out, root, Relaxation::EXACT, {});
+}
+
+bool writeBounds(std::ostream &out, DFT::DFTree *dft, size_t maxNodes)
+{
+	std::unordered_set<const DFTNode *> dormant;
+	std::vector<const DFTNode *> stack;
+	for (const DFTNode *node : dft->getNodes()) {
+		if (node->isBasicEvent()) {
+			if (!isStaticBE(node))
+				return false;
+			continue;
+		}
+		if (!isStaticGate(node)
+		    && !node->matchesType(DFT::Nodes::GatePAndType)
+		    && !node->matchesType(DFT::Nodes::GateSAndType)
+		    && !node->matchesType(DFT::Nodes::GatePorType)
+		    && !node->matchesType(DFT::Nodes::GateSeqType)
+		    && !node->matchesType(DFT::Nodes::GateSpareType)
+		    && !node->matchesType(DFT::Nodes::GateFDEPType))
+		{
+			return false;
+		}
+		if (node->matchesType(DFT::Nodes::GateSpareType)) {
+			const DFT::Nodes::Gate *g = static_cast<const DFT::Nodes::Gate *>(node);
+			stack.insert(stack.end(), g->getChildren().begin(),
+			             g->getChildren().end());
+		}
+	}
+	/* Everything below a spare gate may be dormant */
+	while (!stack.empty()) {
+		const DFTNode *node = stack.back();
+		stack.pop_back();
+		if (!dormant.insert(node).second || !node->isGate())
+			continue;
+		const DFT::Nodes::Gate *g = static_cast<const DFT::Nodes::Gate *>(node);
+		stack.insert(stack.end(), g->getChildren().begin(),
+		             g->getChildren().end());
+	}
+	std::ostringstream tmp;
+	if (!writeBDD(tmp, dft->getTopNode(), Relaxation::LOWER, dormant, maxNodes)
+	    || !writeBDD(tmp, dft->getTopNode(), Relaxation::UPPER, {}, maxNodes))
+	{
+		return false;
+	}
+	out << tmp.str();
+	return true;
+}
+
 static void writeModules(std::ostream &out, DFT::DFTree *dft, DFT::Nodes::Node *root)
 {
 	if (root->matchesType(DFT::Nodes::NodeType::BasicEventType)) {
 		DFT::Nodes::BasicEvent *be;
 		be = static_cast<DFT::Nodes::BasicEvent *>(root);
+		if (be->getFailed()) {
+			out << "=1\n";
+			return;
+		}
 		if (be->getLambda() == -1) {
 			out << "=" << be->getProb().str() << "\n";
 			return;
@@ -22,14 +547,16 @@ static void writeModules(std::ostream &out, DFT::DFTree *dft, DFT::Nodes::Node *
 	      || root->matchesType(DFT::Nodes::NodeType::GateOrType)
 	      || root->matchesType(DFT::Nodes::NodeType::GateVotingType)))
 	{
-		out << "M" << root->getName() << "\n";
+		if (!writeStatic(out, root))
+			out << "I" << moduleHash(root) << " " << root->getName() << "\n";
 		return;
 	}
 	DFT::Nodes::Gate *g = static_cast<DFT::Nodes::Gate *>(root);
 	std::vector<DFT::Nodes::Node *> children = g->getChildren();
 	for (DFT::Nodes::Node *child : children) {
 		if (!child->isIndependentSubtree()) {
-			out << "M" << root->getName() << "\n";
+			if (!writeStatic(out, root))
+				out << "I" << moduleHash(root) << " " << root->getName() << "\n";
 			return;
 		}
 	}
@@ -46,14 +573,19 @@ static void writeModules(std::ostream &out, DFT::DFTree *dft, DFT::Nodes::Node *
 		writeModules(out, dft, child);
 }
 
+void writeModules(std::ostream &out, DFT::DFTree *dft)
+{
+	dft->detectModules();
+	writeModules(out, dft, dft->getTopNode());
+}
+
 void writeModules(std::string filename, DFT::DFTree *dft)
 {
-	DFT::Nodes::Node *root = dft->getTopNode();
 	if (filename.empty())
-		writeModules(std::cout, dft, root);
+		writeModules(std::cout, dft);
 	else {
 		ofstream out(filename, std::ofstream::out);
-		writeModules(out, dft, root);
+		writeModules(out, dft);
 		out.close();
 	}
 }
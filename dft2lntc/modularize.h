@@ -1,3 +1,45 @@
 #include "DFTree.h"
 
+#include <ostream>
+
+/**
+ * Writes the modules description of the specified DFT: its static top
+ * part as AND (*), OR (+) and voting (/) combinations of the modules
+ * below it, which are either constant probabilities (=), static modules
+ * given as a BDD (B), or dynamic modules to analyse (I). The latter are
+ * written as "I<hash> <root>", where isomorphic modules (equal up to
+ * renaming) have the same hash.
+ * A static module is written as "B<events> <nodes> <bddRoot> <root>",
+ * followed by a line "<lambda> <prob> <phases>" per basic event and a
+ * line "<event> <low> <high>" per BDD node after the terminals 0 and 1.
+ */
 void writeModules(std::string filename, DFT::DFTree *dft);
+void writeModules(std::ostream &out, DFT::DFTree *dft);
+
+/**
+ * Writes static bounds on the failure of the specified DFT, as two B
+ * modules (see writeModules()): a sufficient condition for the failure
+ * of the DFT, with dormant basic events at their dormant failure rate,
+ * followed by a necessary condition, with all basic events active.
+ * The former has PAND, SAND, SEQ and POR gates never failing and spare
+ * gates failing with all of their children. The latter has PAND, SAND
+ * and SEQ gates failing with all of their children, POR gates with
+ * their first child, spare gates once each child has failed or may be
+ * claimed, and FDEP dependers with their triggers.
+ * @param maxNodes The number of BDD nodes after which either
+ *        relaxation is given up.
+ * @return false, with nothing written, if the DFT has repairs,
+ *         inspections, non-exponential basic events or cyclic FDEPs,
+ *         or if a relaxation needs more than maxNodes nodes.
+ */
+bool writeBounds(std::ostream &out, DFT::DFTree *dft,
+                 size_t maxNodes = 1 << 22);
+
+/**
+ * Returns a canonical hash of the module rooted at the specified node,
+ * consisting of all nodes reachable from it by children and
+ * dependencies. Modules with equal hashes are isomorphic: they have the
+ * same gate types, arities, thresholds and basic event parameters, and
+ * differ at most in the names of their nodes.
+ */
+std::string moduleHash(const DFT::Nodes::Node *root);
@@ -0,0 +1,68 @@
+/*
+ * autconv.cpp
+ *
+ * Part of dft2lnt library - a library containing read/write operations for DFT
+ * files in Galileo format and translating DFT specifications into Lotos NT.
+ *
+ * Converts automata between the Aldebaran (.aut) format and the binary
+ * (.baut) format written by dft2lntc (see automata/binary.h). The format
+ * of the input is detected from its contents, that of the output from
+ * its extension.
+ *
+ * Usage: autconv <input> <output>
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+#include "imc.h"
+#include "automata/binary.h"
+
+int main(int argc, char **argv)
+{
+	if (argc != 3) {
+		fprintf(stderr, "Usage: autconv <input> <output>\n");
+		return EXIT_FAILURE;
+	}
+	std::ifstream in(argv[1], std::ios::binary);
+	if (!in) {
+		fprintf(stderr, "Could not open `%s'\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+	std::string contents((std::istreambuf_iterator<char>(in)),
+	                     std::istreambuf_iterator<char>());
+
+	DFT::IMC imc;
+	std::string error;
+	bool ok;
+	const char *magic = automata::binary::MAGIC;
+	if (contents.compare(0, sizeof(automata::binary::MAGIC), magic,
+	                     sizeof(automata::binary::MAGIC)) == 0)
+	{
+		ok = imc.readBinary(contents.data(), contents.size(), error);
+	} else {
+		std::istringstream text(contents);
+		ok = imc.readAUT(text, error);
+	}
+	if (!ok) {
+		fprintf(stderr, "Could not read `%s': %s\n", argv[1], error.c_str());
+		return EXIT_FAILURE;
+	}
+
+	std::string output(argv[2]);
+	std::ofstream out(output, std::ios::binary);
+	if (output.size() >= 5 && output.compare(output.size() - 5, 5, ".baut") == 0)
+		imc.writeBinary(out);
+	else
+		imc.writeAUT(out);
+	out.close();
+	if (!out) {
+		fprintf(stderr, "Could not write `%s'\n", argv[2]);
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -29,6 +29,9 @@ public:
 	 * returned as one query per time), but the set of returned
 	 * queries should be identical when given the same set of input
 	 * queries.
+	 * Since loading the model often dominates the analysis time,
+	 * implementations should answer the queries with as few
+	 * invocations of the model checker as possible.
 	 */
 	virtual std::vector<DFT::DFTCalculationResultItem> analyze(
 			std::vector<Query> queries) = 0;
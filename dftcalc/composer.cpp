@@ -0,0 +1,752 @@
+/*
+ * composer.cpp
+ *
+ * Part of dft2lnt library - a library containing read/write operations for DFT
+ * files in Galileo format and translating DFT specifications into Lotos NT.
+ */
+
+#include "composer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <stdexcept>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "decnumber.h"
+#include "automata/signals.h"
+
+namespace DFT {
+	extern const int VERBOSITY_FLOW; /* Defined in dftcalc.cpp */
+}
+
+namespace {
+
+/* What a label of an operand does in a product: either it interleaves as
+ * the label id of the product, or it leads vector id.
+ */
+struct Action {
+	bool sync;
+	uint32_t id;
+};
+
+struct Operand {
+	const DFT::IMC *automaton;
+	/* The actions of every label of the automaton */
+	std::vector<std::vector<Action>> actions;
+};
+
+struct Vector {
+	/* The participating operands, with the labels they take part with */
+	std::vector<std::pair<size_t, std::vector<uint32_t>>> participants;
+	uint32_t result;
+};
+
+/* A synchronization rule, resolved to the processes taking part */
+struct Rule {
+	std::vector<size_t> processes; /* Sorted */
+	std::string result;            /* "i" if hidden */
+};
+
+/* The product of some of the processes. Labels of rules that also need
+ * processes outside the component are named "#<rule>", all other labels
+ * move independently of the other components.
+ */
+struct Component {
+	std::vector<size_t> processes; /* Sorted */
+	DFT::IMC imc;
+};
+
+static std::string pendingLabel(size_t rule) {
+	return "#" + std::to_string(rule);
+}
+
+static bool intersects(const std::vector<size_t>& a, const std::vector<size_t>& b) {
+	size_t i = 0, j = 0;
+	while (i < a.size() && j < b.size()) {
+		if (a[i] == b[j])
+			return true;
+		else if (a[i] < b[j])
+			i++;
+		else
+			j++;
+	}
+	return false;
+}
+
+/* Sorts the transitions and removes duplicates */
+static void normalize(std::vector<DFT::IMC::Transition>& out) {
+	std::sort(out.begin(), out.end(),
+	          [](const DFT::IMC::Transition& a, const DFT::IMC::Transition& b) {
+		return a.label < b.label || (a.label == b.label && a.target < b.target);
+	});
+	out.erase(std::unique(out.begin(), out.end(),
+	                      [](const DFT::IMC::Transition& a, const DFT::IMC::Transition& b) {
+		return a.label == b.label && a.target == b.target;
+	}), out.end());
+}
+
+/* Hash set of fixed-width product states, numbering them in insertion
+ * order.
+ */
+class StateTable {
+private:
+	size_t width;
+	std::vector<uint32_t> data;
+	std::vector<uint32_t> buckets; /* State number + 1, 0 if empty */
+	size_t count;
+
+	size_t hash(const uint32_t *s) const {
+		uint64_t h = 0xcbf29ce484222325ULL;
+		for (size_t i = 0; i < width; i++)
+			h = (h ^ s[i]) * 0x100000001b3ULL;
+		return h ^ (h >> 32);
+	}
+
+	void grow() {
+		buckets.assign(buckets.size() * 2, 0);
+		size_t mask = buckets.size() - 1;
+		for (size_t s = 0; s < count; s++) {
+			size_t i = hash(get(s)) & mask;
+			while (buckets[i])
+				i = (i + 1) & mask;
+			buckets[i] = s + 1;
+		}
+	}
+
+public:
+	StateTable(size_t width)
+		:width(width), buckets(1024, 0), count(0)
+	{}
+
+	size_t size() const { return count; }
+
+	const uint32_t *get(size_t state) const {
+		return data.data() + state * width;
+	}
+
+	/* Returns the number of the specified state, adding it if needed.
+	 * The state must not point into this table.
+	 */
+	uint32_t insert(const uint32_t *s) {
+		if ((count + 1) * 2 > buckets.size())
+			grow();
+		size_t mask = buckets.size() - 1;
+		for (size_t i = hash(s) & mask;; i = (i + 1) & mask) {
+			uint32_t b = buckets[i];
+			if (!b) {
+				if (count >= std::numeric_limits<uint32_t>::max() - 1)
+					throw std::length_error("Too many states in composition");
+				data.insert(data.end(), s, s + width);
+				buckets[i] = ++count;
+				return count - 1;
+			}
+			if (std::equal(s, s + width, get(b - 1)))
+				return b - 1;
+		}
+	}
+};
+
+class Product {
+private:
+	const std::vector<Operand>& operands;
+	const std::vector<Vector>& vectors;
+	StateTable& table;
+
+	/* Fires vector v with all participants from p onwards, given the
+	 * targets of the earlier participants in next.
+	 */
+	void synchronize(const Vector& v, size_t p,
+	                 const std::vector<uint32_t>& state,
+	                 std::vector<uint32_t>& next,
+	                 std::vector<DFT::IMC::Transition>& out)
+	{
+		if (p == v.participants.size()) {
+			out.push_back({v.result, table.insert(next.data())});
+			return;
+		}
+		size_t c = v.participants[p].first;
+		const std::vector<uint32_t>& labels = v.participants[p].second;
+		const DFT::IMC *a = operands[c].automaton;
+		for (const DFT::IMC::Transition *t = a->begin(state[c]); t != a->end(state[c]); ++t) {
+			if (std::find(labels.begin(), labels.end(), t->label) == labels.end())
+				continue;
+			next[c] = t->target;
+			synchronize(v, p + 1, state, next, out);
+		}
+		next[c] = state[c];
+	}
+
+public:
+	Product(const std::vector<Operand>& operands,
+	        const std::vector<Vector>& vectors, StateTable& table)
+		:operands(operands), vectors(vectors), table(table)
+	{}
+
+	/* Adds the outgoing transitions of the specified product state to
+	 * out, sorted and without duplicates.
+	 */
+	void successors(const std::vector<uint32_t>& state,
+	                std::vector<DFT::IMC::Transition>& out)
+	{
+		std::vector<uint32_t> next(state);
+		out.clear();
+		for (size_t c = 0; c < operands.size(); c++) {
+			const DFT::IMC *a = operands[c].automaton;
+			for (const DFT::IMC::Transition *t = a->begin(state[c]); t != a->end(state[c]); ++t) {
+				for (const Action& action : operands[c].actions[t->label]) {
+					next[c] = t->target;
+					if (!action.sync)
+						out.push_back({action.id, table.insert(next.data())});
+					else
+						synchronize(vectors[action.id], 1, state, next, out);
+					next[c] = state[c];
+				}
+			}
+		}
+		normalize(out);
+	}
+};
+
+/* Builds the reachable part of the product of the specified components.
+ * Rules shared by several of them synchronize; a rule that is complete
+ * afterwards gets its result label.
+ */
+static void product(const std::vector<const Component*>& parts,
+                    const std::vector<Rule>& rules, Component& result)
+{
+	size_t n = parts.size();
+	std::vector<Operand> operands(n);
+	std::vector<Vector> vectors;
+	DFT::IMC& imc = result.imc;
+	imc = DFT::IMC();
+	result.processes.clear();
+	for (const Component *part : parts)
+		result.processes.insert(result.processes.end(), part->processes.begin(), part->processes.end());
+	std::sort(result.processes.begin(), result.processes.end());
+
+	for (size_t c = 0; c < n; c++) {
+		const DFT::IMC *a = &parts[c]->imc;
+		operands[c].automaton = a;
+		operands[c].actions.resize(a->getNumLabels());
+		for (uint32_t l = 0; l < a->getNumLabels(); l++) {
+			const std::string& name = a->getLabel(l);
+			if (name[0] != '#') {
+				operands[c].actions[l].push_back({false, imc.addLabel(name)});
+				continue;
+			}
+			const Rule& rule = rules[std::stoul(name.substr(1))];
+			std::vector<size_t> sharing;
+			for (size_t d = 0; d < n; d++)
+				if (intersects(parts[d]->processes, rule.processes))
+					sharing.push_back(d);
+			if (sharing.size() == 1) {
+				operands[c].actions[l].push_back({false, imc.addLabel(name)});
+				continue;
+			}
+			if (sharing[0] != c)
+				continue;
+			Vector v;
+			for (size_t d : sharing) {
+				std::vector<uint32_t> labels;
+				for (uint32_t m = 0; m < parts[d]->imc.getNumLabels(); m++)
+					if (parts[d]->imc.getLabel(m) == name)
+						labels.push_back(m);
+				if (labels.empty())
+					break;
+				v.participants.push_back(std::make_pair(d, labels));
+			}
+			if (v.participants.size() != sharing.size())
+				continue;
+			bool complete = std::includes(result.processes.begin(), result.processes.end(),
+			                              rule.processes.begin(), rule.processes.end());
+			v.result = imc.addLabel(complete ? rule.result : name);
+			operands[c].actions[l].push_back({true, (uint32_t)vectors.size()});
+			vectors.push_back(v);
+		}
+	}
+
+	/* Breadth-first exploration */
+	StateTable table(n);
+	Product prod(operands, vectors, table);
+	std::vector<uint32_t> state(n);
+	std::vector<DFT::IMC::Transition> out;
+	for (size_t c = 0; c < n; c++)
+		state[c] = operands[c].automaton->getInitial();
+	imc.setInitial(table.insert(state.data()));
+	for (size_t s = 0; s < table.size(); s++) {
+		const uint32_t *st = table.get(s);
+		state.assign(st, st + n);
+		imc.addState();
+		prod.successors(state, out);
+		for (const DFT::IMC::Transition& t : out)
+			imc.addTransition(t.label, t.target);
+	}
+}
+
+/* Returns whether the specified label of a component moves on its own */
+static bool isFree(const std::string& label) {
+	return label == "i"
+	       || label.compare(0, 5, "rate ") == 0
+	       || label.compare(0, 5, "time ") == 0;
+}
+
+/* Minimises the specified component modulo stochastic branching
+ * bisimulation. Labels that are neither free nor pending are results of
+ * complete rules, which nothing can block anymore, so they are urgent.
+ */
+static void minimise(Component& component) {
+	const DFT::IMC& imc = component.imc;
+	std::vector<bool> urgent(imc.getNumLabels());
+	for (uint32_t l = 0; l < imc.getNumLabels(); l++) {
+		const std::string& name = imc.getLabel(l);
+		urgent[l] = name[0] != '#' && !isFree(name);
+	}
+	component.imc = imc.minimise(urgent);
+}
+
+/* Composes the components bottom-up over the DFT: in post-order, every
+ * node is composed with the components of its children, smallest first,
+ * minimising after every step. Rules become complete, and hidden labels
+ * internal, as early as possible, so intermediate products stay small.
+ */
+static DFT::IMC aggregate(const DFT::EXPComposition& composition,
+                          std::vector<std::unique_ptr<Component>>& components,
+                          const std::vector<Rule>& rules,
+                          size_t& maxStates, size_t& maxTransitions)
+{
+	size_t n = composition.processes.size();
+	std::vector<size_t> owner(n);
+	for (size_t c = 0; c < n; c++) {
+		owner[c] = c;
+		minimise(*components[c]);
+	}
+
+	auto merge = [&](size_t a, size_t b) {
+		std::vector<const Component *> parts;
+		parts.push_back(components[a].get());
+		parts.push_back(components[b].get());
+		std::unique_ptr<Component> merged(new Component());
+		product(parts, rules, *merged);
+		maxStates = std::max(maxStates, merged->imc.getNumStates());
+		maxTransitions = std::max(maxTransitions, merged->imc.getNumTransitions());
+		minimise(*merged);
+		for (size_t p : merged->processes)
+			owner[p] = components.size();
+		components[a].reset();
+		components[b].reset();
+		components.push_back(std::move(merged));
+	};
+
+	/* Children before their parents, starting from the toplevel */
+	std::vector<size_t> order;
+	std::vector<bool> visited(n);
+	std::vector<std::pair<size_t, size_t>> stack;
+	for (size_t root = 0; root < n; root++) {
+		if (visited[root])
+			continue;
+		visited[root] = true;
+		stack.push_back(std::make_pair(root, 0));
+		while (!stack.empty()) {
+			size_t p = stack.back().first;
+			const std::vector<unsigned int>& children = composition.processes[p].children;
+			if (stack.back().second < children.size()) {
+				size_t child = children[stack.back().second++];
+				if (child < n && !visited[child]) {
+					visited[child] = true;
+					stack.push_back(std::make_pair(child, 0));
+				}
+				continue;
+			}
+			order.push_back(p);
+			stack.pop_back();
+		}
+	}
+
+	for (size_t p : order) {
+		std::vector<size_t> others;
+		for (unsigned int child : composition.processes[p].children) {
+			if (child >= n || owner[child] == owner[p])
+				continue;
+			if (std::find(others.begin(), others.end(), owner[child]) == others.end())
+				others.push_back(owner[child]);
+		}
+		std::sort(others.begin(), others.end(), [&](size_t a, size_t b) {
+			return components[a]->imc.getNumStates() < components[b]->imc.getNumStates();
+		});
+		for (size_t o : others)
+			merge(owner[p], o);
+	}
+	for (size_t c = 0; c < n; c++)
+		if (owner[c] != owner[0])
+			merge(owner[0], owner[c]);
+
+	return std::move(components[owner[0]]->imc);
+}
+
+} // Anonymous namespace
+
+/* Reads the automaton in binary format from the memory-mapped file. */
+static bool readBinaryFile(const std::string& file, DFT::IMC& imc) {
+	std::string error;
+#ifndef WIN32
+	int fd = open(file.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		close(fd);
+		return false;
+	}
+	size_t size = st.st_size;
+	void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return false;
+	bool ret = imc.readBinary((const char *)map, size, error);
+	munmap(map, size);
+	return ret;
+#else
+	std::ifstream in(file, std::ios::binary);
+	std::string contents((std::istreambuf_iterator<char>(in)),
+	                     std::istreambuf_iterator<char>());
+	return in && imc.readBinary(contents.data(), contents.size(), error);
+#endif
+}
+
+const DFT::IMC *DFT::Composer::loadAutomaton(const std::string& file,
+                                             const std::string& binaryFile)
+{
+	auto it = automata.find(file);
+	if (it != automata.end())
+		return it->second.get();
+	if (!binaryFile.empty()) {
+		std::unique_ptr<IMC> automaton(new IMC());
+		if (readBinaryFile(binaryFile, *automaton)) {
+			const IMC *ret = automaton.get();
+			automata.emplace(file, std::move(automaton));
+			return ret;
+		}
+	}
+	std::ifstream in(file);
+	if (!in) {
+		messageFormatter->reportError("Could not open automaton `" + file + "'");
+		return nullptr;
+	}
+	std::unique_ptr<IMC> automaton(new IMC());
+	std::string error;
+	if (!automaton->readAUT(in, error)) {
+		messageFormatter->reportError("Could not read automaton `" + file + "': " + error);
+		return nullptr;
+	}
+	const IMC *ret = automaton.get();
+	automata.emplace(file, std::move(automaton));
+	return ret;
+}
+
+int DFT::Composer::compose(const EXPComposition& composition, bool compositional) {
+	size_t n = composition.processes.size();
+	std::vector<const IMC *> loaded(n);
+	std::vector<std::vector<std::vector<std::string>>> renamed(n);
+	imc = IMC();
+	maxStates = maxTransitions = 0;
+
+	/* Load the automata and apply the renamings. A label matching
+	 * no renaming keeps its name.
+	 */
+	for (size_t c = 0; c < n; c++) {
+		const EXPProcess& proc = composition.processes[c];
+		loaded[c] = loadAutomaton(proc.file, proc.binaryFile);
+		if (!loaded[c])
+			return 1;
+		const IMC *a = loaded[c];
+		renamed[c].resize(a->getNumLabels());
+		for (uint32_t l = 0; l < a->getNumLabels(); l++) {
+			for (const std::pair<std::string, std::string>& r : proc.renames) {
+				if (r.first == a->getLabel(l))
+					renamed[c][l].push_back(r.second);
+			}
+			if (renamed[c][l].empty())
+				renamed[c][l].push_back(a->getLabel(l));
+		}
+	}
+
+	/* Resolve the synchronization rules to the processes taking part.
+	 * Rules some participant can never take part in are dropped.
+	 */
+	std::vector<Rule> rules;
+	std::vector<std::unordered_map<std::string, std::vector<size_t>>> rulesOf(n);
+	for (const EXPSyncRule& syncRule : composition.rules) {
+		Rule rule;
+		bool alive = true;
+		for (const auto& item : syncRule.label) {
+			size_t c = item.first;
+			if (c >= n) {
+				messageFormatter->reportError("Synchronization rule refers to unknown process");
+				return 1;
+			}
+			std::string label = item.second.toString();
+			bool found = false;
+			for (const std::vector<std::string>& names : renamed[c])
+				if (std::find(names.begin(), names.end(), label) != names.end())
+					found = true;
+			if (!found) {
+				alive = false;
+				break;
+			}
+			rule.processes.push_back(c);
+		}
+		if (!alive || rule.processes.empty())
+			continue;
+		rule.result = syncRule.hideToLabel ? "i" : syncRule.toLabel;
+		for (const auto& item : syncRule.label)
+			rulesOf[item.first][item.second.toString()].push_back(rules.size());
+		rules.push_back(rule);
+	}
+
+	/* Turn every process into a component. Labels of rules with a
+	 * single participant get their result right away, labels in no rule
+	 * at all are blocked.
+	 */
+	std::vector<std::unique_ptr<Component>> components;
+	for (size_t c = 0; c < n; c++) {
+		const IMC *a = loaded[c];
+		std::unique_ptr<Component> component(new Component());
+		component->processes.push_back(c);
+		IMC& leaf = component->imc;
+		std::vector<std::vector<uint32_t>> labels(a->getNumLabels());
+		for (uint32_t l = 0; l < a->getNumLabels(); l++) {
+			for (const std::string& name : renamed[c][l]) {
+				if (isFree(name)) {
+					labels[l].push_back(leaf.addLabel(name));
+					continue;
+				}
+				auto it = rulesOf[c].find(name);
+				if (it == rulesOf[c].end())
+					continue;
+				for (size_t k : it->second) {
+					if (rules[k].processes.size() == 1)
+						labels[l].push_back(leaf.addLabel(rules[k].result));
+					else
+						labels[l].push_back(leaf.addLabel(pendingLabel(k)));
+				}
+			}
+		}
+		std::vector<IMC::Transition> out;
+		for (uint32_t s = 0; s < a->getNumStates(); s++) {
+			leaf.addState();
+			for (const IMC::Transition *t = a->begin(s); t != a->end(s); ++t)
+				for (uint32_t l : labels[t->label])
+					out.push_back({l, t->target});
+			normalize(out);
+			for (const IMC::Transition& t : out)
+				leaf.addTransition(t.label, t.target);
+			out.clear();
+		}
+		leaf.setInitial(a->getInitial());
+		components.push_back(std::move(component));
+	}
+
+	try {
+		if (!compositional) {
+			std::vector<const Component *> parts;
+			for (const std::unique_ptr<Component>& c : components)
+				parts.push_back(c.get());
+			Component result;
+			product(parts, rules, result);
+			imc = std::move(result.imc);
+			maxStates = imc.getNumStates();
+			maxTransitions = imc.getNumTransitions();
+		} else {
+			imc = aggregate(composition, components, rules,
+			                maxStates, maxTransitions);
+		}
+	} catch (std::length_error& e) {
+		messageFormatter->reportError(e.what());
+		return 1;
+	}
+
+	messageFormatter->reportAction("Composed IMC has "
+		+ std::to_string(imc.getNumStates()) + " states and "
+		+ std::to_string(imc.getNumTransitions()) + " transitions"
+		+ " (largest intermediate: " + std::to_string(maxStates)
+		+ " states, " + std::to_string(maxTransitions) + " transitions)",
+		VERBOSITY_FLOW);
+	return 0;
+}
+
+namespace {
+
+enum Effect : unsigned char { NONE, FAILED, REPAIRED };
+
+enum LabelKind : unsigned char { INTERNAL, MARKOVIAN, FAIL, ONLINE };
+
+}
+
+int DFT::Composer::buildCTMC(CTMC& ctmc) const {
+	const uint32_t NO_STATE = std::numeric_limits<uint32_t>::max();
+	size_t n = imc.getNumStates();
+
+	/* Classify the labels that actually occur */
+	std::vector<bool> used(imc.getNumLabels());
+	for (uint32_t s = 0; s < n; s++)
+		for (const IMC::Transition *t = imc.begin(s); t != imc.end(s); ++t)
+			used[t->label] = true;
+	std::vector<LabelKind> kinds(imc.getNumLabels(), INTERNAL);
+	for (uint32_t l = 0; l < imc.getNumLabels(); l++) {
+		const std::string& label = imc.getLabel(l);
+		if (imc.isRate(l)) {
+			kinds[l] = MARKOVIAN;
+		} else if (label == automata::signals::GATE_FAIL) {
+			kinds[l] = FAIL;
+		} else if (label == automata::signals::GATE_ONLINE) {
+			kinds[l] = ONLINE;
+		} else if (!used[l] || l == IMC::TAU) {
+			continue;
+		} else if (label.find(automata::signals::GATE_IMPOSSIBLE) != std::string::npos) {
+			messageFormatter->reportError("Error composing model: 'IMPOSSIBLE' transitions reachable!");
+			return 1;
+		} else if (label.compare(0, 5, "time ") == 0) {
+			messageFormatter->reportError("Timed transitions are not supported by the native converter");
+			return 1;
+		} else {
+			messageFormatter->reportWarning("Unknown transition label `" + label + "', assuming no effect on labeling");
+		}
+	}
+
+	/* Maximal progress: a state with interactive transitions leaves
+	 * immediately, so it is replaced by the stable state its
+	 * interactive transitions lead to (together with whether the
+	 * toplevel failed or came back online on the way). This has to be
+	 * unique, otherwise the model is truly nondeterministic.
+	 * Interactive self-loops do not lead anywhere and are ignored,
+	 * although visible ones still disable the Markovian transitions.
+	 */
+	std::vector<uint32_t> stable(n, NO_STATE);
+	std::vector<Effect> effect(n, NONE);
+	std::vector<unsigned char> status(n, 0); /* 0: new, 1: on stack, 2: done */
+	std::vector<std::pair<uint32_t, const IMC::Transition *>> stack;
+	for (uint32_t root = 0; root < n; root++) {
+		if (status[root])
+			continue;
+		stack.push_back(std::make_pair(root, imc.begin(root)));
+		status[root] = 1;
+		while (!stack.empty()) {
+			uint32_t s = stack.back().first;
+			const IMC::Transition *&t = stack.back().second;
+			for (; t != imc.end(s); ++t) {
+				if (kinds[t->label] == MARKOVIAN || t->target == s
+				    || status[t->target] == 2)
+					continue;
+				if (status[t->target] == 1) {
+					messageFormatter->reportError("Cycle of interactive transitions through state " + std::to_string(s));
+					return 1;
+				}
+				break;
+			}
+			if (t != imc.end(s)) {
+				uint32_t target = t->target;
+				status[target] = 1;
+				stack.push_back(std::make_pair(target, imc.begin(target)));
+				continue;
+			}
+			stack.pop_back();
+			status[s] = 2;
+			stable[s] = s;
+			bool interactive = false;
+			for (const IMC::Transition *u = imc.begin(s); u != imc.end(s); ++u) {
+				if (kinds[u->label] == MARKOVIAN || u->target == s)
+					continue;
+				Effect e = effect[u->target];
+				if (e == NONE && kinds[u->label] == FAIL)
+					e = FAILED;
+				else if (e == NONE && kinds[u->label] == ONLINE)
+					e = REPAIRED;
+				if (!interactive) {
+					interactive = true;
+					stable[s] = stable[u->target];
+					effect[s] = e;
+				} else if (stable[s] != stable[u->target] || effect[s] != e) {
+					messageFormatter->reportError("Model has nondeterminism in state " + std::to_string(s) + ", which the native converter does not support");
+					return 1;
+				}
+			}
+		}
+	}
+
+	/* Build the CTMC over the reachable stable states. A state is
+	 * marked if it is reached by a failure, unmarked if it is reached by
+	 * a repair, and otherwise inherits the label of its predecessor.
+	 */
+	std::vector<uint32_t> number(n, NO_STATE);
+	std::vector<uint32_t> queue;
+	ctmc = CTMC();
+	auto visit = [&](uint32_t s, bool mark) -> uint32_t {
+		if (number[s] == NO_STATE) {
+			number[s] = queue.size();
+			queue.push_back(s);
+			ctmc.setMarked(number[s], mark);
+		} else if (ctmc.isMarked(number[s]) != mark) {
+			return NO_STATE;
+		}
+		return number[s];
+	};
+	uint32_t init = imc.getInitial();
+	visit(stable[init], effect[init] == FAILED);
+	try {
+		for (size_t i = 0; i < queue.size(); i++) {
+			uint32_t s = queue[i];
+			bool mark = ctmc.isMarked(i);
+			bool urgentLoop = false;
+			for (const IMC::Transition *t = imc.begin(s); t != imc.end(s); ++t)
+				if (kinds[t->label] != MARKOVIAN && t->label != IMC::TAU)
+					urgentLoop = true;
+			std::map<uint32_t, std::vector<uint32_t>> rates;
+			for (const IMC::Transition *t = imc.begin(s); t != imc.end(s); ++t) {
+				if (kinds[t->label] != MARKOVIAN || urgentLoop)
+					continue;
+				uint32_t target = stable[t->target];
+				bool targetMark = mark;
+				if (effect[t->target] == FAILED)
+					targetMark = true;
+				else if (effect[t->target] == REPAIRED)
+					targetMark = false;
+				if (visit(target, targetMark) == NO_STATE) {
+					messageFormatter->reportError("State reachable both from repair and fail transitions");
+					return 1;
+				}
+				if (target != s)
+					rates[number[target]].push_back(t->label);
+			}
+			ctmc.addState();
+			for (const auto& r : rates) {
+				std::string rate = imc.getLabel(r.second[0]).substr(5);
+				if (r.second.size() > 1) {
+					decnumber<> sum(rate);
+					for (size_t j = 1; j < r.second.size(); j++)
+						sum += decnumber<>(imc.getLabel(r.second[j]).substr(5));
+					rate = sum.str();
+				}
+				ctmc.addTransition(ctmc.addRate(rate), r.first);
+			}
+		}
+	} catch (std::exception& e) {
+		messageFormatter->reportError(std::string("Invalid rate: ") + e.what());
+		return 1;
+	}
+
+	messageFormatter->reportAction("CTMC has "
+		+ std::to_string(ctmc.getNumStates()) + " states and "
+		+ std::to_string(ctmc.getNumTransitions()) + " transitions",
+		VERBOSITY_FLOW);
+	return 0;
+}
@@ -0,0 +1,91 @@
+/*
+ * composer.h
+ *
+ * Part of dft2lnt library - a library containing read/write operations for DFT
+ * files in Galileo format and translating DFT specifications into Lotos NT.
+ */
+
+#ifndef COMPOSER_H
+#define COMPOSER_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "MessageFormatter.h"
+#include "DFTreeEXPBuilder.h"
+#include "imc.h"
+
+namespace DFT {
+
+/**
+ * Native replacement for the EXP.OPEN/SVL (or DFTRES) tool chain: composes
+ * the node automata of an EXPComposition in-process, and derives the CTMC
+ * analysed by the model checker from the resulting IMC.
+ */
+class Composer {
+private:
+	MessageFormatter *messageFormatter;
+	std::unordered_map<std::string, std::unique_ptr<IMC>> automata;
+	IMC imc;
+	size_t maxStates;
+	size_t maxTransitions;
+
+	/* Reads binaryFile (see EXPProcess::binaryFile) if it is given and
+	 * valid, and file otherwise; both are cached under file.
+	 */
+	const IMC *loadAutomaton(const std::string& file,
+	                         const std::string& binaryFile);
+
+public:
+	Composer(MessageFormatter *mf)
+		:messageFormatter(mf), maxStates(0), maxTransitions(0)
+	{}
+
+	/**
+	 * Builds the reachable part of the specified parallel composition,
+	 * following the semantics of the EXP.OPEN "label par" operator.
+	 * The processes are read from their binary automaton (.baut) files
+	 * when the composition names one that can be read, and from their
+	 * Aldebaran (.aut) files otherwise.
+	 * @param compositional If true, the processes are composed bottom-up
+	 *        over the DFT, minimising modulo stochastic branching
+	 *        bisimulation after every step; the result is then minimal
+	 *        as well. If false, the full product is built at once.
+	 * @return 0 if successful, non-zero otherwise
+	 */
+	int compose(const EXPComposition& composition, bool compositional = true);
+
+	/**
+	 * Returns the number of states of the largest (intermediate) product
+	 * built by compose(), before minimisation.
+	 */
+	size_t getMaxStates() const { return maxStates; }
+
+	/**
+	 * Returns the number of transitions of the largest (intermediate)
+	 * product built by compose(), before minimisation.
+	 */
+	size_t getMaxTransitions() const { return maxTransitions; }
+
+	/**
+	 * Returns the IMC built by compose().
+	 */
+	const IMC& getIMC() const { return imc; }
+
+	/**
+	 * Applies maximal progress to the IMC built by compose() and
+	 * eliminates its interactive transitions. A state of the resulting
+	 * CTMC is marked if the toplevel has failed (FAIL) and has not since
+	 * come back online (ONLINE).
+	 * Fails if the IMC has nondeterminism that does not resolve to a
+	 * unique stable state, or if modelling errors are reachable.
+	 * @return 0 if successful, non-zero otherwise
+	 */
+	int buildCTMC(CTMC& ctmc) const;
+};
+
+} // Namespace: DFT
+
+#endif
@@ -19,7 +19,14 @@
 #include <sys/types.h>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
 #include <limits.h>
 
 #ifdef HAVE_CADP
@@ -28,6 +35,10 @@
 
 #ifdef WIN32
 #include <io.h>
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
 #endif
 
 using namespace std;
@@ -37,6 +48,16 @@ using namespace std;
 #include "MessageFormatter.h"
 #include "dftcalc.h"
 #include "dft2lnt.h"
+#include "DFTreePrinter.h"
+#include "frontend.h"
+#include "modularize.h"
+#include "cutsets.h"
+#include "composer.h"
+#include "phasetype.h"
+#include "interval.h"
+#include "DFTreeAUTNodeBuilder.h"
+#include "sha256.h"
+#include "transient.h"
 #include "compiletime.h"
 #include "yaml-cpp/yaml.h"
 #include "mrmc.h"
@@ -62,7 +83,10 @@ void print_help(MessageFormatter* messageFormatter, string topic="") {
 		messageFormatter->message("  --no-color      Do not use colored messages.");
 		messageFormatter->message("  --version       Print version info and quit.");
 		messageFormatter->message("  -R              Reuse existing output files.");
+		messageFormatter->message("  --no-cache      Do not use or update the result cache shared by all runs.");
 		messageFormatter->message("  -M              Use modularization to check static parts of DFT.");
+		messageFormatter->message("  -j N            With -M, analyse up to N modules in parallel. With");
+		messageFormatter->message("                  --cutsets, expand up to N top-level branches in parallel.");
 		messageFormatter->message("  --storm         Use Storm. (standard setting)");
 		messageFormatter->message("  --modest        Use Modest instead of Storm.");
 #ifdef HAVE_CADP
@@ -71,7 +95,24 @@ void print_help(MessageFormatter* messageFormatter, string topic="") {
 #endif
 		messageFormatter->message("  --imrmc         Use IMRMC instead of Storm.");
 		messageFormatter->message("  --exact         Use DFTRES to give (more) exact results.");
+		messageFormatter->message("  --exact-arithmetic  With -M, combine the results of modules in exact");
+		messageFormatter->message("                  decimal arithmetic (implied by --exact).");
+		messageFormatter->message("  --native        Compose the model in-process instead of using CADP or");
+		messageFormatter->message("                  DFTRES (requires --imrmc or --transient).");
+		messageFormatter->message("  --transient     Use the built-in transient solver (implies --native).");
+		messageFormatter->message("                  Only supports time-bounded queries.");
 		messageFormatter->message("  --no-nd-warning Do not warn (but give notice) for non-determinism.");
+		messageFormatter->message("  --phase-type    Analyse independent subtrees separately, and replace each");
+		messageFormatter->message("                  by the phase-type distribution of its time to failure.");
+		messageFormatter->message("  --bounds        Only compute cheap bounds from static relaxations of the DFT.");
+		messageFormatter->message("                  Only supports -t, -i, -I, -u and -s. Without --bounds, -E");
+		messageFormatter->message("                  tries these bounds first, and if they are within the error");
+		messageFormatter->message("                  bound the result is taken from the bounds.");
+		messageFormatter->message("  --cutsets       Compute the minimal cut sets and bound the failure");
+		messageFormatter->message("                  probability by them instead of analysing the DFT.");
+		messageFormatter->message("                  Only supports -t, -i, -I, -u and -s.");
+		messageFormatter->message("  --cutset-order N   Truncate cut sets of more than N basic events.");
+		messageFormatter->message("  --cutset-cutoff p  Truncate cut sets of probability less than p.");
 		messageFormatter->message("");
 		messageFormatter->notify ("Debug Options:");
 		messageFormatter->message("  --verbose=x     Set verbosity to x, -1 <= x <= 5.");
@@ -93,7 +134,9 @@ void print_help(MessageFormatter* messageFormatter, string topic="") {
 		messageFormatter->message("  -u              Calculate P(DFT fails eventually)");
 		messageFormatter->message("  -I l u          Calculate P(DFT fails in [l,u] time units) where l can be >= 0");
 		messageFormatter->message("  -f <command>    Raw Calculation formula for the model-checker. Overrules -i, -s, -m, -t, and -u.");
-		messageFormatter->message("  -E errorbound   Error bound, to be passed to IMCA.");
+		messageFormatter->message("  -E errorbound   Error bound, to be passed to IMCA. Results are taken from the");
+		messageFormatter->message("                  static bounds (see --bounds) when those are within it,");
+		messageFormatter->message("                  unless --exact is given.");
 		messageFormatter->message("  -C DIR          Temporary output files will be in this directory");
 		messageFormatter->message("  --min           Compute minimum time-bounded reachability (default)");
 		messageFormatter->message("  --max           Compute maximum time-bounded reachability");
@@ -319,7 +362,6 @@ int DFT::DFTCalc::calcModular(const bool reuse,
 {
 	std::string dftFileName = dftOriginal.getFileBase();
 	messageFormatter->notify("Computing `"+dftFileName+"' with modularization");
-	CommandExecutor exec(messageFormatter, cwd, dftFileName);
 
 	File mod = dftOriginal.newWithPathTo(cwd).newWithExtension("mod");
 
@@ -329,102 +371,518 @@ int DFT::DFTCalc::calcModular(const bool reuse,
 		messageFormatter->reportAction("Preserving generated modules file.",
 		                               VERBOSITY_FLOW);
 	}
+	std::string modules;
 	if(!reuse || !FileSystem::exists(mod)) {
 		messageFormatter->reportAction("Modularizing DFT...",VERBOSITY_FLOW);
-		std::vector<std::string> arguments;
-		arguments.push_back("--verbose=" + std::to_string(messageFormatter->getVerbosity()));
-		arguments.push_back("-m");
-		arguments.push_back(mod.getFileRealPath());
-		arguments.push_back(dftOriginal.getFileRealPath());
-		if (exec.runCommand(dft2lntcExec.getFilePath(), arguments, "dft2lntc", mod) == "")
+		Frontend *frontend = getFrontend(dftOriginal);
+		if (!frontend)
+			return 1;
+		DFT::DFTree *tree = frontend->buildTree();
+		if (!tree)
 			return 1;
+		std::stringstream out;
+		try {
+			tree->applyEvidence(evidence);
+			writeModules(out, tree);
+		} catch(std::vector<std::string>& errors) {
+			for(std::string e: errors) {
+				messageFormatter->reportError(e);
+			}
+			delete tree;
+			return 1;
+		}
+		delete tree;
+		modules = out.str();
+		std::ofstream modFile(mod.getFileRealPath());
+		modFile << modules;
 	} else {
 		messageFormatter->reportAction("Reusing modules file",VERBOSITY_FLOW);
+		std::string* tmp = FileSystem::load(mod);
+		if (!tmp) {
+			messageFormatter->reportError("Error loading modules file");
+			return 1;
+		}
+		std::swap(modules, *tmp);
+		delete tmp;
 	}
-	std::string* tmp = FileSystem::load(mod);
-	if (!tmp) {
-		messageFormatter->reportError("Error loading modules file");
+
+	Module root;
+	if (parseModule(modules, root))
 		return 1;
+
+	/* Static modules only support failure probabilities; for other
+	 * queries they are analysed as dynamic modules.
+	 */
+	bool staticQueries = true;
+	std::vector<Query> expanded = queries;
+	expandRangeQueries(expanded);
+	for (const Query &q : expanded) {
+		if (q.type != TIMEBOUND && q.type != UNBOUNDED && q.type != STEADY)
+			staticQueries = false;
+	}
+	std::vector<Module *> todo(1, &root);
+	while (!staticQueries && !todo.empty()) {
+		Module *m = todo.back();
+		todo.pop_back();
+		if (m->type == 'B')
+			m->type = 'M';
+		for (Module &child : m->children)
+			todo.push_back(&child);
+	}
+
+	std::vector<const Module *> leaves;
+	std::vector<const Module *> stack(1, &root);
+	while (!stack.empty()) {
+		const Module *m = stack.back();
+		stack.pop_back();
+		if (m->type == 'M')
+			leaves.push_back(m);
+		for (auto it = m->children.rbegin(); it != m->children.rend(); ++it)
+			stack.push_back(&*it);
+	}
+
+	/* Isomorphic modules have the same results, so only the first of
+	 * each class is analysed.
+	 */
+	std::vector<size_t> analyse, representative(leaves.size());
+	std::unordered_map<std::string, size_t> classes;
+	for (size_t i = 0; i < leaves.size(); i++) {
+		representative[i] = i;
+		if (!leaves[i]->hash.empty()) {
+			auto ins = classes.emplace(leaves[i]->hash, i);
+			if (!ins.second) {
+				representative[i] = ins.first->second;
+				continue;
+			}
+		}
+		analyse.push_back(i);
 	}
-	std::string modules;
-	std::swap(modules, *tmp);
-	delete tmp;
-	return checkModule(reuse, cwd, dftOriginal, queries, useChecker,
-	                   useConverter, warnNonDeterminism, ret, expOnly, exactMode, modules);
+	if (analyse.size() < leaves.size()) {
+		messageFormatter->reportAction("Analysing " + std::to_string(analyse.size())
+		                               + " of " + std::to_string(leaves.size())
+		                               + " modules, the others are isomorphic to these",
+		                               VERBOSITY_FLOW);
+	}
+
+	/* The M modules are independent, so they are analysed by a pool of
+	 * workers, each taking the next module not yet started.
+	 */
+	std::vector<DFT::DFTCalculationResult> results(leaves.size());
+	std::atomic<size_t> next(0);
+	std::atomic<bool> failed(false);
+	auto work = [&]() {
+		size_t n;
+		while (!failed && (n = next++) < analyse.size()) {
+			size_t i = analyse[n];
+			int res;
+			try {
+				res = calculateDFT(reuse, cwd, dftOriginal, queries,
+				                   useChecker, useConverter,
+				                   warnNonDeterminism, leaves[i]->value,
+				                   results[i], expOnly, exactMode);
+			} catch (std::exception &e) {
+				messageFormatter->reportError(e.what());
+				res = 1;
+			}
+			if (res)
+				failed = true;
+		}
+	};
+	size_t nThreads = std::min<size_t>(jobs, analyse.size());
+	if (nThreads <= 1) {
+		work();
+	} else {
+		messageFormatter->reportAction("Analysing " + std::to_string(analyse.size())
+		                               + " modules using " + std::to_string(nThreads)
+		                               + " jobs", VERBOSITY_FLOW);
+		std::vector<std::thread> threads;
+		for (size_t i = 0; i < nThreads; i++)
+			threads.emplace_back(work);
+		for (std::thread &t : threads)
+			t.join();
+	}
+	if (failed)
+		return 1;
+	for (size_t i = 0; i < leaves.size(); i++) {
+		if (representative[i] != i)
+			results[i] = results[representative[i]];
+	}
+
+	size_t leaf = 0;
+	return checkModule(root, queries, results, leaf, ret,
+	                   exactMode || exactArithmetic);
 }
 
-static void addVoteResults(DFT::DFTCalculationResultItem &ret,
-                           std::vector<DFT::DFTCalculationResultItem> P,
-			   size_t votCount)
+DFT::Frontend *DFT::DFTCalc::getFrontend(const File& dftOriginal)
 {
-	if (votCount == 0) {
-		ret.lowerBound = ret.upperBound = (uintmax_t)1;
-		return;
-	} else if (votCount > P.size()) {
-		ret.lowerBound = ret.upperBound = (uintmax_t)0;
-		return;
+	std::string fileName = dftOriginal.getFileRealPath();
+	if (frontend && frontend->getFileName() == fileName)
+		return frontend.get();
+
+	frontend.reset();
+	phaseTypes.clear();
+	compilerContext.reset(new CompilerContext(std::cerr));
+	compilerContext->setVerbosity(messageFormatter->getVerbosity());
+	compilerContext->useColoredMessages(messageFormatter->usingColoredMessages());
+	frontend.reset(new Frontend(compilerContext.get(), dft2lntRoot, cacheDir));
+	if (!frontend->load(fileName)) {
+		frontend.reset();
+		return nullptr;
+	}
+	return frontend.get();
+}
+
+int DFT::DFTCalc::translateDFT(const File& dftOriginal,
+                               const std::string& root,
+                               const File& dft,
+                               const File& svl,
+                               const File& exp,
+                               const File& bcg,
+                               EXPComposition *composition)
+{
+	Frontend *frontend = getFrontend(dftOriginal);
+	if (!frontend)
+		return 1;
+	DFT::DFTree *tree = frontend->buildTree(root);
+	if (!tree)
+		return 1;
+	std::vector<std::string> treeEvidence = evidence;
+	if (usePhaseTypes) {
+		/* Evidence on removed basic events is part of their
+		 * substitutes already.
+		 */
+		std::unordered_set<std::string> removed;
+		abstractSubtrees(frontend, tree, removed);
+		treeEvidence.clear();
+		for (const std::string &e : evidence) {
+			if (!removed.count(e))
+				treeEvidence.push_back(e);
+		}
+	}
+	if (!frontend->prepare(tree, treeEvidence)) {
+		delete tree;
+		return 1;
+	}
+
+	/* Keep a copy of the canonical (re-rooted) DFT for reference */
+	{
+		std::ofstream dftFile(dft.getFileRealPath());
+		DFT::DFTreePrinter printer(tree, compilerContext.get());
+		printer.print(dftFile);
+	}
+
+	std::ofstream svlFile(svl.getFileRealPath());
+	std::ofstream expFile(exp.getFileRealPath());
+	bool ok = frontend->compile(tree, bcg.getFileRealPath(),
+	                            exp.getFileRealPath(), svlFile, expFile,
+	                            composition);
+	delete tree;
+	if (!ok) {
+		svlFile.close();
+		expFile.close();
+		FileSystem::remove(svl);
+		FileSystem::remove(exp);
+		return 1;
+	}
+	return 0;
+}
+
+void DFT::DFTCalc::abstractSubtrees(Frontend *frontend, DFT::DFTree *tree,
+                                    std::unordered_set<std::string> &removed)
+{
+	typedef DFT::Nodes::Node Node;
+	tree->detectModules();
+	std::vector<std::pair<Node *, std::string>> substitutes;
+	std::unordered_set<Node *> seen;
+	std::vector<Node *> stack(1, tree->getTopNode());
+	while (!stack.empty()) {
+		Node *node = stack.back();
+		stack.pop_back();
+		if (!node->isGate() || !seen.insert(node).second)
+			continue;
+		if (node != tree->getTopNode() && node->isIndependentSubtree()
+		    && !node->outputIsDumb())
+		{
+			std::string file = phaseTypeOf(frontend, node->getName());
+			if (!file.empty()) {
+				substitutes.push_back(std::make_pair(node, file));
+				continue;
+			}
+		}
+		if (node->matchesType(DFT::Nodes::GateSpareType)
+		    || node->matchesType(DFT::Nodes::GateSeqType)
+		    || node->usesDynamicActivation())
+		{
+			continue;
+		}
+		DFT::Nodes::Gate *g = static_cast<DFT::Nodes::Gate *>(node);
+		stack.insert(stack.end(), g->getChildren().begin(), g->getChildren().end());
+	}
+
+	for (auto &sub : substitutes) {
+		Node *node = sub.first;
+		std::vector<Node *> below(1, node);
+		while (!below.empty()) {
+			Node *n = below.back();
+			below.pop_back();
+			removed.insert(n->getName());
+			if (n->isGate()) {
+				DFT::Nodes::Gate *g = static_cast<DFT::Nodes::Gate *>(n);
+				below.insert(below.end(), g->getChildren().begin(), g->getChildren().end());
+			}
+		}
+		DFT::Nodes::BasicEvent *be;
+		be = new DFT::Nodes::BasicEvent(node->getLocation(), node->getName());
+		be->setMode(DFT::Nodes::BE::CalculationMode::APH);
+		be->setFileToEmbed(sub.second);
+		for (DFT::Nodes::Gate *parent : node->getParents()) {
+			std::vector<Node *> &c = parent->getChildren();
+			std::replace(c.begin(), c.end(), node, static_cast<Node *>(be));
+		}
+		be->setParents(node->getParents());
+		node->getParents().clear();
+		tree->addNode(be);
+	}
+	if (!substitutes.empty())
+		tree->removeUnreachable();
+}
+
+std::string DFT::DFTCalc::phaseTypeOf(Frontend *frontend, const std::string &root)
+{
+	auto it = phaseTypes.find(root);
+	if (it != phaseTypes.end())
+		return it->second;
+	/* Stays empty if the subtree cannot be abstracted */
+	std::string &ret = phaseTypes[root];
+
+	std::unique_ptr<DFT::DFTree> tree(frontend->buildTree(root));
+	if (!tree)
+		return ret;
+	for (DFT::Nodes::Node *node : tree->getNodes()) {
+		if (node->outputIsDumb() && !node->matchesType(DFT::Nodes::GateFDEPType))
+			return ret; /* Inspections, replacements and repair units */
+		if (!node->isBasicEvent())
+			continue;
+		const DFT::Nodes::BasicEvent *be;
+		be = static_cast<const DFT::Nodes::BasicEvent *>(node);
+		if (be->getRepair() > 0 || be->isRepairable()
+		    || be->getMaintain() > 0 || be->getInterval() > 0)
+		{
+			return ret;
+		}
+		if (be->getMode() == DFT::Nodes::BE::CalculationMode::APH
+		    && File(be->getFileToEmbed()).getFileExtension() != "aut")
+		{
+			return ret;
+		}
+	}
+
+	std::unordered_set<std::string> removed;
+	abstractSubtrees(frontend, tree.get(), removed);
+	std::vector<std::string> treeEvidence;
+	for (const std::string &e : evidence) {
+		if (!removed.count(e) && tree->getNode(e))
+			treeEvidence.push_back(e);
 	}
-	DFT::DFTCalculationResultItem cur = P[0];
-	P.erase(P.begin());
-	/* P{k/N}(X1, X2, ..., XN)
-	 * = P(X1)*P{(k-1)/(N-1)}(X2, ..., XN)
-	 *   + (1-P(X1))*P{k/(N-1)}(X2, ..., XN)
+	if (!frontend->prepare(tree.get(), treeEvidence))
+		return ret;
+	std::ostringstream svl, exp;
+	EXPComposition composition;
+	if (!frontend->compile(tree.get(), "", "", svl, exp, &composition))
+		return ret;
+
+	/* Failing here (e.g., on nondeterminism) only means the subtree
+	 * stays part of the composition, so it is not reported as an error.
 	 */
-	addVoteResults(ret, P, votCount - 1);
-	decnumber<> loSum = cur.lowerBound * ret.lowerBound;
-	decnumber<> upSum = cur.upperBound * ret.upperBound;
-	addVoteResults(ret, P, votCount);
-	/* In the next part we swap the lower and upper bounds of the
-	 * current entry due to the subtraction.
+	std::ostringstream log;
+	MessageFormatter quiet(log);
+	Composer composer(&quiet);
+	CTMC ctmc;
+	if (composer.compose(composition) || composer.buildCTMC(ctmc)) {
+		messageFormatter->reportAction("Not abstracting `" + root + "': it cannot be composed natively",VERBOSITY_FLOW);
+		return ret;
+	}
+	PhaseType ph;
+	IMC imc;
+	size_t phases = 0;
+	if (ph.fromCTMC(ctmc)) {
+		ph.minimise();
+		ph.toIMC(imc);
+		phases = ph.getNumPhases();
+	} else {
+		PhaseType::toIMC(ctmc, imc);
+		phases = ctmc.getNumStates();
+	}
+	std::ostringstream aut;
+	imc.writeAUT(aut);
+
+	/* Named by contents, so the EXP files (and the cached results)
+	 * change with the distribution.
 	 */
-	loSum += (decnumber<>(1) - cur.upperBound) * ret.lowerBound;
-	upSum += (decnumber<>(1) - cur.lowerBound) * ret.upperBound;
-	ret.lowerBound = loSum;
-	ret.upperBound = upSum;
+	File file(cacheDir + DFT2LNT::AUT_CACHE_DIR,
+	          "aph_" + SHA256::hash(aut.str()), "aut");
+	if (!FileSystem::exists(file)) {
+		/* Written aside and renamed, so concurrent runs sharing the
+		 * cache never see a partially written automaton. A failed
+		 * rename is fine if another run published it first.
+		 */
+		std::string path = file.getFileRealPath();
+		std::string tmp = path + ".tmp" + std::to_string(getpid());
+		std::ofstream out(tmp);
+		out << aut.str();
+		out.close();
+		bool ok = out && !std::rename(tmp.c_str(), path.c_str());
+		if (!ok)
+			std::remove(tmp.c_str());
+		if (!ok && !FileSystem::exists(file)) {
+			messageFormatter->reportWarning("Could not write `" + path + "'");
+			return ret;
+		}
+	}
+	messageFormatter->reportAction("Abstracted `" + root + "' to a phase-type distribution of "
+	                               + std::to_string(phases) + " phases",VERBOSITY_FLOW);
+	ret = file.getFileRealPath();
+	return ret;
 }
 
-static void addVoteResults(std::vector<DFT::DFTCalculationResultItem> &ret,
-                           const std::vector<DFT::DFTCalculationResult> P,
-			   MessageFormatter &mf,
-                           size_t votCount)
+/* Checks that the modules in P have results for the same queries, in
+ * the same order.
+ */
+static bool alignedResults(const std::vector<DFT::DFTCalculationResult> &P,
+                           MessageFormatter &mf)
 {
-	if (P.empty())
-		return;
 	size_t nResults = P[0].failProbs.size();
-	for (const DFT::DFTCalculationResult r : P) {
+	for (const DFT::DFTCalculationResult &r : P) {
 		if (r.failProbs.size() != nResults) {
 			mf.reportError("Unequal number of results for modules.");
+			return false;
 		}
 	}
 	for (size_t i = 0; i < nResults; i++) {
-		std::vector<DFT::DFTCalculationResultItem> probs;
-		DFT::DFTCalculationResultItem ref = P[0].failProbs[i];
-		for (const DFT::DFTCalculationResult r : P) {
-			DFT::DFTCalculationResultItem it = r.failProbs[i];
+		const DFT::DFTCalculationResultItem &ref = P[0].failProbs[i];
+		for (const DFT::DFTCalculationResult &r : P) {
+			const DFT::DFTCalculationResultItem &it = r.failProbs[i];
 			if (it.missionTime != ref.missionTime
 			    || it.mrmcCommand != ref.mrmcCommand)
 			{
 				mf.reportError("Unequal order/type of results for modules.");
-				return;
+				return false;
 			}
-			probs.push_back(it);
 		}
-		addVoteResults(ref, probs, votCount);
-		ret.push_back(ref);
 	}
+	return true;
 }
 
-int DFT::DFTCalc::checkModule(const bool reuse,
-                              const std::string& cwd,
-                              const File& dft,
-                              const std::vector<Query> &queries,
-                              enum DFT::checker useChecker,
-                              enum DFT::converter useConverter,
-                              bool warnNonDeterminism,
-                              DFT::DFTCalculationResult &ret,
-                              bool expOnly,
-                              bool exactMode,
-                              std::string &module)
+/* Whether every result of the modules in P is a single exact value */
+static bool pointResults(const std::vector<DFT::DFTCalculationResult> &P)
+{
+	for (const DFT::DFTCalculationResult &r : P) {
+		for (const DFT::DFTCalculationResultItem &it : r.failProbs) {
+			if (!it.exactBounds || it.lowerBound != it.upperBound)
+				return false;
+		}
+	}
+	return true;
+}
+
+template<class Num>
+static DFT::Interval<Num> resultBounds(const DFT::DFTCalculationResultItem &it);
+
+template<>
+DFT::Interval<decnumber<>> resultBounds(const DFT::DFTCalculationResultItem &it)
+{
+	return DFT::Interval<decnumber<>>(it.lowerBound, it.upperBound);
+}
+
+template<>
+DFT::Interval<double> resultBounds(const DFT::DFTCalculationResultItem &it)
+{
+	return DFT::toDoubleInterval(it.lowerBound, it.upperBound);
+}
+
+/* Computes the probability that at least votCount of the modules in P
+ * have failed, for each of their results. Uses
+ * P{k/N}(X1, X2, ..., XN)
+ * = P(X1)*P{(k-1)/(N-1)}(X2, ..., XN)
+ *   + (1-P(X1))*P{k/(N-1)}(X2, ..., XN),
+ * evaluated from XN back to X1 keeping P{c/(N-j)}(Xj+1, ..., XN) for
+ * every 0 <= c <= k, i.e., in O(N*k) per result. The bounds are
+ * combined as intervals: in 1-P(Xj), the lower and upper bounds swap.
+ */
+template<class Num>
+static void addVoteResults(std::vector<DFT::DFTCalculationResultItem> &ret,
+                           const std::vector<DFT::DFTCalculationResult> &P,
+                           size_t votCount)
+{
+	typedef DFT::Interval<Num> Bounds;
+	size_t nResults = P[0].failProbs.size();
+	const Bounds zero(Num(0)), one(Num(1));
+	size_t N = P.size();
+	/* at[i][c]: bounds on P{c/(N-j)}(Xj+1, ..., XN) for result i,
+	 * where j is the number of modules not yet processed.
+	 */
+	std::vector<std::vector<Bounds>> at;
+	if (votCount <= N) {
+		at.assign(nResults, std::vector<Bounds>(votCount + 1, zero));
+		for (size_t i = 0; i < nResults; i++)
+			at[i][0] = one;
+	}
+	for (size_t j = N; j-- > 0 && votCount <= N;) {
+		/* At least c of the N-j modules from Xj+1 can only have
+		 * failed if c <= N-j.
+		 */
+		size_t maxC = std::min(votCount, N - j);
+		for (size_t i = 0; i < nResults; i++) {
+			const Bounds cur = resultBounds<Num>(P[j].failProbs[i]);
+			const Bounds notCur = cur.complement();
+			std::vector<Bounds> &a = at[i];
+			/* Descending, so a[c - 1] is still the previous value */
+			for (size_t c = maxC; c > 0; c--) {
+				Bounds next = cur * a[c - 1];
+				if (c < N - j)
+					next += notCur * a[c];
+				a[c] = next;
+			}
+		}
+	}
+	for (size_t i = 0; i < nResults; i++) {
+		DFT::DFTCalculationResultItem item = P[0].failProbs[i];
+		if (votCount > N) {
+			item.lowerBound = item.upperBound = decnumber<>(0);
+		} else {
+			item.lowerBound = decnumber<>(at[i][votCount].lower());
+			item.upperBound = decnumber<>(at[i][votCount].upper());
+		}
+		ret.push_back(item);
+	}
+}
+
+/* Combines the results of the modules in P by an AND (op '*') or OR
+ * (op '+') gate, the latter as the complement of the AND of the
+ * complements.
+ */
+template<class Num>
+static void addGateResults(std::vector<DFT::DFTCalculationResultItem> &ret,
+                           const std::vector<DFT::DFTCalculationResult> &P,
+                           char op)
+{
+	typedef DFT::Interval<Num> Bounds;
+	for (size_t i = 0; i < P[0].failProbs.size(); i++) {
+		Bounds acc(Num(1));
+		for (const DFT::DFTCalculationResult &r : P) {
+			Bounds b = resultBounds<Num>(r.failProbs[i]);
+			acc *= op == '*' ? b : b.complement();
+		}
+		if (op == '+')
+			acc = acc.complement();
+		DFT::DFTCalculationResultItem item = P[0].failProbs[i];
+		item.lowerBound = decnumber<>(acc.lower());
+		item.upperBound = decnumber<>(acc.upper());
+		ret.push_back(item);
+	}
+}
+
+int DFT::DFTCalc::parseModule(std::string &module, Module &ret)
 {
 	if (module.length() == 0) {
 		messageFormatter->reportError("Modules file empty.");
@@ -433,29 +891,68 @@ int DFT::DFTCalc::checkModule(const bool reuse,
 	size_t eol = module.find('\n');
 	if (eol == std::string::npos)
 		eol = module.length();
-	if (module[0] == 'M') {
-		std::string root = module.substr(1, eol - 1);
+	ret.type = module[0];
+	ret.votCount = 0;
+	if (module[0] == 'M' || module[0] == '=') {
+		ret.value = module.substr(1, eol - 1);
 		module = module.substr(eol + 1);
-		return calculateDFT(reuse, cwd, dft, queries, useChecker,
-		                    useConverter, warnNonDeterminism, root, ret,
-		                    expOnly, exactMode);
-	} else if (module[0] == '=') {
-		decnumber<> val(module.substr(1, eol - 1));
+		return 0;
+	} else if (module[0] == 'I') {
+		size_t sp = module.find(' ');
+		if (sp == std::string::npos || sp > eol) {
+			messageFormatter->reportError("Improperly formatted modules file: module without hash.");
+			return 1;
+		}
+		ret.type = 'M';
+		ret.hash = module.substr(1, sp - 1);
+		ret.value = module.substr(sp + 1, eol - sp - 1);
 		module = module.substr(eol + 1);
-		std::vector<Query> tmp = queries;
-		expandRangeQueries(tmp);
-		for (Query q : tmp) {
-			DFT::DFTCalculationResultItem it(q);
-			it.exactBounds = true;
-			it.lowerBound = it.upperBound = val;
-			ret.failProbs.push_back(it);
+		return 0;
+	} else if (module[0] == 'B') {
+		std::istringstream header(module.substr(1, eol - 1));
+		size_t nEvents, nNodes;
+		header >> nEvents >> nNodes >> ret.bddRoot >> std::ws;
+		std::getline(header, ret.value);
+		if (!header || nNodes < 2 || ret.bddRoot >= nNodes) {
+			messageFormatter->reportError("Improperly formatted modules file: invalid static module header.");
+			return 1;
 		}
+		/* The block ends after nEvents + nNodes - 2 more lines */
+		size_t end = eol;
+		for (size_t i = 0; i < nEvents + nNodes - 2 && end < module.length(); i++) {
+			end = module.find('\n', end + 1);
+			if (end == std::string::npos)
+				end = module.length();
+		}
+		std::istringstream block(module.substr(eol + 1, end - eol));
+		ret.events.resize(nEvents, StaticEvent{0, 0, 1});
+		for (StaticEvent &e : ret.events) {
+			std::string lambda, prob;
+			block >> lambda >> prob >> e.phases;
+			if (!block)
+				break;
+			e.lambda = decnumber<>(lambda);
+			e.prob = decnumber<>(prob);
+		}
+		ret.bdd.resize(nNodes);
+		ret.bdd[BDD::ZERO] = ret.bdd[BDD::ONE] = BDD::Node{UINT32_MAX, 0, 0};
+		for (size_t i = 2; i < nNodes && block; i++) {
+			BDD::Node &n = ret.bdd[i];
+			block >> n.var >> n.low >> n.high;
+			if (n.var >= nEvents || n.low >= i || n.high >= i) {
+				messageFormatter->reportError("Improperly formatted modules file: invalid BDD node.");
+				return 1;
+			}
+		}
+		if (!block) {
+			messageFormatter->reportError("Modules contains too few entries for static module.");
+			return 1;
+		}
+		module = end < module.length() ? module.substr(end + 1) : "";
 		return 0;
 	}
-	char op = module[0];
 	std::string numStr;
-	unsigned long votCount = 0;
-	if (op != '/') {
+	if (ret.type != '/') {
 		numStr = module.substr(1, eol);
 	} else {
 		size_t sp = module.find(' ');
@@ -464,63 +961,443 @@ int DFT::DFTCalc::checkModule(const bool reuse,
 			return 1;
 		}
 		numStr = module.substr(sp + 1, eol);
-		votCount = std::stoul(module.substr(1, sp));
+		ret.votCount = std::stoul(module.substr(1, sp));
 	}
 	module = module.substr(eol + 1);
 	unsigned long num = std::stoul(numStr);
-	std::vector<DFT::DFTCalculationResultItem> gather;
-	std::vector<DFT::DFTCalculationResult> votResults;
+	ret.children.resize(num);
 	for (unsigned long i = 0; i < num; i++) {
-		DFT::DFTCalculationResult tmp;
 		if (module.empty()) {
 			messageFormatter->reportError("Modules contains too few entries for module.");
 			return 1;
 		}
-		if (checkModule(reuse, cwd, dft, queries, useChecker, useConverter,
-		                warnNonDeterminism, tmp, expOnly, exactMode, module))
+		if (parseModule(module, ret.children[i]))
 			return 1;
-		if (op == '/') {
-			votResults.push_back(tmp);
-		} else if (i == 0) {
-			gather = tmp.failProbs;
-		} else {
-			if (gather.size() != tmp.failProbs.size()) {
-				messageFormatter->reportError("Unequal number of results for modules.");
-				return 1;
-			}
-			for (size_t i = gather.size() - 1; i != SIZE_MAX; i--) {
-				DFT::DFTCalculationResultItem &old = gather[i];
-				DFT::DFTCalculationResultItem add = tmp.failProbs[i];
-				if (old.missionTime != add.missionTime
-				    || old.mrmcCommand != add.mrmcCommand)
-				{
-					messageFormatter->reportError("Unequal order/type of results for modules.");
-					return 1;
-				}
-				if (op == '*') {
-					old.lowerBound *= add.lowerBound;
-					old.upperBound *= add.upperBound;
-				} else if (op == '+') {
-					decnumber<> one(1);
-					old.lowerBound = (one - (one - old.lowerBound)
-					                      * (one - add.lowerBound));
-					old.upperBound = (one - (one - old.upperBound)
-					                      * (one - add.upperBound));
-				} else {
-					messageFormatter->reportError(std::string("Unknown module type: ") + op);
-					return 1;
-				}
-			}
+	}
+	return 0;
+}
+
+/* The probability that an Erlang distribution with the specified number
+ * of phases, each of rate lambda, is below and above t. The terms of the
+ * Poisson series are computed in log space, and the smaller of the two
+ * probabilities is summed directly, to avoid cancellation.
+ */
+static void erlangProbabilities(double lambda, int phases, double t,
+                                double &below, double &above)
+{
+	if (lambda <= 0) {
+		below = 0;
+		above = 1;
+		return;
+	}
+	if (std::isinf(t)) {
+		below = 1;
+		above = 0;
+		return;
+	}
+	double x = lambda * t;
+	if (phases <= 1) {
+		below = -std::expm1(-x);
+		above = std::exp(-x);
+		return;
+	}
+	auto term = [x](int i) {
+		return std::exp(-x + i * std::log(x) - std::lgamma(i + 1.0));
+	};
+	if (x < phases) {
+		below = 0;
+		for (int i = phases; ; i++) {
+			double add = term(i);
+			below += add;
+			if (add <= below * DBL_EPSILON)
+				break;
 		}
+		above = 1 - below;
+	} else {
+		above = 0;
+		for (int i = 0; i < phases; i++)
+			above += term(i);
+		below = 1 - above;
 	}
-	if (op != '/') {
-		ret.failProbs.insert(ret.failProbs.begin(), gather.begin(), gather.end());
+}
+
+/* The probabilities that a non-repairable basic event has and has not
+ * failed at time t. A lambda of -1 denotes a constant probability.
+ */
+static void eventProbabilities(double lambda, double prob, int phases,
+                               double t, double &pTrue, double &pFalse)
+{
+	if (lambda == -1) {
+		pTrue = prob;
+		pFalse = 1 - prob;
+		return;
+	}
+	double below, above;
+	erlangProbabilities(lambda, phases, t, below, above);
+	pTrue = prob * below;
+	pFalse = (1 - prob) + prob * above;
+}
+
+/* The time at which a non-repairable DFT must have failed to satisfy
+ * the specified time-bounded, unbounded or steady-state query.
+ * Failures are permanent, so failing within [l, u] is the same as being
+ * failed at u.
+ */
+static double failureTime(const Query &q)
+{
+	if (q.type == TIMEBOUND)
+		return (double)q.upperBound;
+	return INFINITY;
+}
+
+void DFT::DFTCalc::checkStatic(const Module &module,
+                               const std::vector<Query> &queries,
+                               DFT::DFTCalculationResult &ret)
+{
+	std::vector<Query> tmp = queries;
+	expandRangeQueries(tmp);
+	size_t n = module.events.size();
+	int maxPhases = 1;
+	for (const StaticEvent &e : module.events)
+		maxPhases = std::max(maxPhases, e.phases);
+	/* Every event probability and BDD node adds a few rounding errors */
+	double rel = (n + 1) * (maxPhases + 10) * DBL_EPSILON;
+
+	std::vector<double> pTrue(n), pFalse(n);
+	for (Query q : tmp) {
+		double t = failureTime(q);
+		for (size_t i = 0; i < n; i++) {
+			const StaticEvent &e = module.events[i];
+			eventProbabilities((double)e.lambda, (double)e.prob, e.phases,
+			                   t, pTrue[i], pFalse[i]);
+		}
+		double r = BDD::probability(module.bdd, module.bddRoot, pTrue, pFalse);
+		DFT::DFTCalculationResultItem it(q);
+		it.exactBounds = true;
+		it.lowerBound = DFT::probabilityBound(r * (1 - rel), false);
+		it.upperBound = DFT::probabilityBound(std::min(1.0, r * (1 + rel)), true);
+		ret.failProbs.push_back(it);
+	}
+	messageFormatter->reportAction("Analysed static module `" + module.value
+	                               + "' with a BDD of "
+	                               + std::to_string(module.bdd.size())
+	                               + " nodes", VERBOSITY_FLOW);
+}
+
+/* The size of the relaxation BDDs at which calculateDFT() gives up on
+ * static bounds and analyses the DFT.
+ */
+static const size_t STATIC_BOUNDS_MAX_NODES = 1 << 16;
+
+int DFT::DFTCalc::staticBounds(const File& dftOriginal,
+                               const std::string& root,
+                               const std::vector<Query> &queries,
+                               DFT::DFTCalculationResult &ret,
+                               size_t maxNodes)
+{
+	std::vector<Query> tmp = queries;
+	expandRangeQueries(tmp);
+	for (const Query &q : tmp) {
+		if (q.type != TIMEBOUND && q.type != UNBOUNDED && q.type != STEADY)
+			return 1;
+	}
+
+	/* Only the front end is shared; the tree is our own */
+	std::unique_ptr<DFT::DFTree> tree;
+	{
+		std::lock_guard<std::mutex> guard(frontendLock);
+		Frontend *frontend = getFrontend(dftOriginal);
+		if (!frontend)
+			return 1;
+		tree.reset(frontend->buildTree(root));
+	}
+	if (!tree)
+		return 1;
+	try {
+		tree->applyEvidence(evidence);
+	} catch(std::vector<std::string>&) {
+		return 1;
+	}
+	std::stringstream out;
+	if (!writeBounds(out, tree.get(), maxNodes))
+		return 1;
+	std::string bounds = out.str();
+
+	Module lower, upper;
+	if (parseModule(bounds, lower) || parseModule(bounds, upper))
+		return 1;
+	DFT::DFTCalculationResult lo, up;
+	checkStatic(lower, queries, lo);
+	checkStatic(upper, queries, up);
+	for (size_t i = 0; i < up.failProbs.size(); i++) {
+		DFT::DFTCalculationResultItem it = up.failProbs[i];
+		it.lowerBound = lo.failProbs[i].lowerBound;
+		ret.failProbs.push_back(it);
+	}
+	return 0;
+}
+
+int DFT::DFTCalc::calcCutSets(const File& dftOriginal,
+                              const std::vector<Query> &queries,
+                              size_t maxOrder, double cutoff,
+                              DFT::DFTCalculationResult &ret)
+{
+	std::string dftFileName = dftOriginal.getFileBase();
+	messageFormatter->notify("Computing minimal cut sets of `"+dftFileName+"'");
+
+	std::vector<Query> tmp = queries;
+	expandRangeQueries(tmp);
+	for (const Query &q : tmp) {
+		if (q.type != TIMEBOUND && q.type != UNBOUNDED && q.type != STEADY) {
+			messageFormatter->reportError("Cut sets only support failure probabilities.");
+			return 1;
+		}
+	}
+
+	Frontend *frontend = getFrontend(dftOriginal);
+	if (!frontend)
+		return 1;
+	std::unique_ptr<DFT::DFTree> tree(frontend->buildTree());
+	if (!tree)
+		return 1;
+	std::unique_ptr<CutSetGenerator> gen;
+	try {
+		tree->applyEvidence(evidence);
+		gen.reset(new CutSetGenerator(tree.get()));
+	} catch(std::vector<std::string>& errors) {
+		for(std::string e: errors) {
+			messageFormatter->reportError(e);
+		}
+		return 1;
+	}
+
+	const std::vector<const Nodes::BasicEvent *> &events = gen->getEvents();
+	std::vector<std::vector<double>> probs(tmp.size());
+	int maxPhases = 1;
+	for (size_t i = 0; i < tmp.size(); i++) {
+		double t = failureTime(tmp[i]);
+		for (const Nodes::BasicEvent *be : events) {
+			double pTrue, pFalse;
+			eventProbabilities((double)be->getLambda(), (double)be->getProb(),
+			                   be->getPhases(), t, pTrue, pFalse);
+			probs[i].push_back(pTrue);
+			maxPhases = std::max(maxPhases, be->getPhases());
+		}
+	}
+	gen->generate(probs, maxOrder, cutoff, jobs);
+
+	const std::vector<CutSetGenerator::CutSet> &cutSets = gen->getCutSets();
+	size_t maxSize = 0;
+	for (const CutSetGenerator::CutSet &cs : cutSets) {
+		std::vector<std::string> names;
+		for (uint32_t e : cs)
+			names.push_back(events[e]->getName());
+		ret.cutSets.push_back(names);
+		maxSize = std::max(maxSize, cs.size());
+	}
+	messageFormatter->reportAction("Found " + std::to_string(cutSets.size())
+	                               + " minimal cut sets", VERBOSITY_FLOW);
+	if (!gen->isExact()) {
+		messageFormatter->notify("The DFT is dynamic: the cut sets are those of a static relaxation, and only the upper bound is meaningful.");
+	}
+
+	/* The rare-event approximation, plus what was truncated, bounds
+	 * the probability from above, as the union bound. Every cut set
+	 * of the exact DFT bounds it from below.
+	 */
+	double rel = (cutSets.size() + maxSize + maxPhases + 10) * DBL_EPSILON;
+	for (size_t i = 0; i < tmp.size(); i++) {
+		double sum = gen->getTruncated()[i], max = 0;
+		for (const CutSetGenerator::CutSet &cs : cutSets) {
+			double p = gen->probability(cs, i);
+			sum += p;
+			max = std::max(max, p);
+		}
+		DFT::DFTCalculationResultItem it(tmp[i]);
+		it.exactBounds = true;
+		if (gen->isExact())
+			it.lowerBound = DFT::probabilityBound(max * (1 - rel), false);
+		else
+			it.lowerBound = decnumber<>(0);
+		it.upperBound = DFT::probabilityBound(sum * (1 + rel), true);
+		ret.failProbs.push_back(it);
+	}
+	return 0;
+}
+
+int DFT::DFTCalc::checkModule(const Module &module,
+                              const std::vector<Query> &queries,
+                              const std::vector<DFT::DFTCalculationResult> &leaves,
+                              size_t &leaf,
+                              DFT::DFTCalculationResult &ret,
+                              bool exact)
+{
+	if (module.type == 'M') {
+		const DFT::DFTCalculationResult &res = leaves[leaf++];
+		ret.failProbs.insert(ret.failProbs.end(), res.failProbs.begin(), res.failProbs.end());
+		ret.stats = res.stats;
+		return 0;
+	} else if (module.type == '=') {
+		decnumber<> val(module.value);
+		std::vector<Query> tmp = queries;
+		expandRangeQueries(tmp);
+		for (Query q : tmp) {
+			DFT::DFTCalculationResultItem it(q);
+			it.exactBounds = true;
+			it.lowerBound = it.upperBound = val;
+			ret.failProbs.push_back(it);
+		}
+		return 0;
+	} else if (module.type == 'B') {
+		checkStatic(module, queries, ret);
+		return 0;
+	}
+	char op = module.type;
+	if (op != '*' && op != '+' && op != '/') {
+		messageFormatter->reportError(std::string("Unknown module type: ") + op);
+		return 1;
+	}
+	std::vector<DFT::DFTCalculationResult> children(module.children.size());
+	for (size_t i = 0; i < module.children.size(); i++) {
+		if (checkModule(module.children[i], queries, leaves, leaf, children[i], exact))
+			return 1;
+	}
+	if (children.empty())
+		return 0;
+	if (!alignedResults(children, *messageFormatter))
+		return 1;
+	if (children.size() == 1 && op != '/') {
+		ret.failProbs = children[0].failProbs;
+		return 0;
+	}
+	/* Exact values stay exact, other bounds only need to stay valid */
+	if (exact || pointResults(children)) {
+		if (op == '/')
+			addVoteResults<decnumber<>>(ret.failProbs, children, module.votCount);
+		else
+			addGateResults<decnumber<>>(ret.failProbs, children, op);
 	} else {
-		addVoteResults(ret.failProbs, votResults, *messageFormatter, votCount);
+		if (op == '/')
+			addVoteResults<double>(ret.failProbs, children, module.votCount);
+		else
+			addGateResults<double>(ret.failProbs, children, op);
 	}
 	return 0;
 }
 
+/* Increase when the format or meaning of the cached results changes. */
+static const unsigned int RESULT_CACHE_VERSION = 1;
+
+std::string DFT::DFTCalc::resultKey(const File& exp,
+                                    const std::vector<Query> &queries,
+                                    enum DFT::checker useChecker,
+                                    enum DFT::converter useConverter,
+                                    bool exactMode)
+{
+	std::ifstream in(exp.getFileRealPath(), std::ios::binary);
+	if (!in.is_open())
+		return "";
+	SHA256 hash;
+	std::ostringstream settings;
+	settings << "dftcalc results " << RESULT_CACHE_VERSION
+	         << ' ' << COMPILETIME_GITREV
+	         << ' ' << DFTreeAUTNodeBuilder::VERSION
+	         << ' ' << useChecker << ' ' << useConverter
+	         << ' ' << exactMode << '\n';
+	std::vector<Query> expanded = queries;
+	expandRangeQueries(expanded);
+	for (Query &q : expanded) {
+		settings << q.type << ' ' << q.min
+		         << ' ' << q.lowerBound.str() << ' ' << q.upperBound.str()
+		         << ' ' << q.step.str()
+		         << ' ' << (q.errorBoundSet ? q.errorBound.str() : "-")
+		         << ' ' << q.customQuery.length() << ':' << q.customQuery
+		         << '\n';
+	}
+	hash.update(settings.str() + '\n');
+	char buf[65536];
+	while (in.read(buf, sizeof(buf)) || in.gcount())
+		hash.update(buf, in.gcount());
+	return hash.hexDigest();
+}
+
+bool DFT::DFTCalc::loadResult(const std::string& key,
+                              const std::vector<Query> &queries,
+                              DFT::DFTCalculationResult &ret)
+{
+	File file(cacheDir + DFT2LNT::RESULT_CACHE_DIR, key, "yml");
+	if (!FileSystem::exists(file))
+		return false;
+	std::vector<Query> expanded = queries;
+	expandRangeQueries(expanded);
+	DFT::DFTCalculationResult result;
+	try {
+		YAML::Node node = YAML::LoadFile(file.getFileRealPath());
+		if (node["version"].as<unsigned int>() != RESULT_CACHE_VERSION)
+			return false;
+		node >> result;
+		const YAML::Node items = node["failProbs"];
+		if (result.failProbs.size() != expanded.size())
+			return false;
+		for (size_t i = 0; i < expanded.size(); i++) {
+			DFT::DFTCalculationResultItem &it = result.failProbs[i];
+			it.query = expanded[i];
+			it.exactBounds = items[i]["exactBounds"].as<bool>();
+			if (const YAML::Node exact = items[i]["exact"])
+				it.exactString = exact.as<std::string>();
+		}
+	} catch (YAML::Exception &e) {
+		messageFormatter->reportWarning("Ignoring unreadable cached result `" + file.getFileRealPath() + "': " + e.what());
+		return false;
+	}
+	messageFormatter->reportAction("Reusing cached result " + key, VERBOSITY_FLOW);
+	ret = result;
+	return true;
+}
+
+void DFT::DFTCalc::storeResult(const std::string& key,
+                               const DFT::DFTCalculationResult &result)
+{
+	YAML::Emitter out;
+	out << YAML::BeginMap;
+	out << YAML::Key << "version" << YAML::Value << RESULT_CACHE_VERSION;
+	out << YAML::Key << "failProbs" << YAML::Value << YAML::BeginSeq;
+	for (const DFT::DFTCalculationResultItem &it : result.failProbs) {
+		out << YAML::BeginMap;
+		out << YAML::Key << "missionTime" << YAML::Value << it.missionTime;
+		out << YAML::Key << "mrmcCommand" << YAML::Value << it.mrmcCommand;
+		out << YAML::Key << "lowerBound" << YAML::Value << it.lowerBound.str();
+		out << YAML::Key << "upperBound" << YAML::Value << it.upperBound.str();
+		out << YAML::Key << "exactBounds" << YAML::Value << it.exactBounds;
+		if (!it.exactString.empty())
+			out << YAML::Key << "exact" << YAML::Value << it.exactString;
+		out << YAML::EndMap;
+	}
+	out << YAML::EndSeq;
+	out << YAML::Key << "stats" << YAML::Value << result.stats;
+	out << YAML::EndMap;
+
+	/* Write under a name unique to this process, then rename, so that
+	 * concurrent runs never see a partially written result.
+	 */
+	std::string dir = cacheDir + DFT2LNT::RESULT_CACHE_DIR + "/";
+	std::string tmp = dir + key + "." + std::to_string(getpid()) + ".tmp";
+	{
+		std::ofstream file(tmp);
+		file << out.c_str() << '\n';
+		if (!file.good()) {
+			messageFormatter->reportWarning("Could not write cached result `" + tmp + "'");
+			file.close();
+			std::remove(tmp.c_str());
+			return;
+		}
+	}
+	if (std::rename(tmp.c_str(), (dir + key + ".yml").c_str())) {
+		messageFormatter->reportWarning("Could not store cached result `" + dir + key + ".yml'");
+		std::remove(tmp.c_str());
+	}
+}
+
 int DFT::DFTCalc::calculateDFT(const bool reuse,
                                const std::string& cwd,
                                const File& dftOriginal,
@@ -581,56 +1458,23 @@ int DFT::DFTCalc::calculateDFT(const bool reuse,
 	}
 
 	CommandExecutor exec(messageFormatter, cwd, dftFileName);
-	this->exec = &exec;
-
-	if(!reuse || !FileSystem::exists(dft)) {
-		messageFormatter->reportAction("Canonicalizing DFT...",VERBOSITY_FLOW);
-		std::vector<std::string> arguments;
-		arguments.push_back("--verbose=" + std::to_string(messageFormatter->getVerbosity()));
-		arguments.push_back("-t");
-		arguments.push_back(dft.getFileRealPath());
-		if (!root.empty()) {
-			arguments.push_back("-r");
-			arguments.push_back(root);
-		}
-		arguments.push_back(dftOriginal.getFileRealPath());
-		if (exec.runCommand(dft2lntcExec.getFilePath(), arguments, "dft2lntc", dft) == "")
-			return 1;
-	} else {
-		messageFormatter->reportAction("Reusing copy of original dft file",VERBOSITY_FLOW);
-	}
 
 	if (root == "")
 		messageFormatter->notify("Calculating `"+dftFileName+"'");
 
-	if(!reuse || !FileSystem::exists(exp) || !FileSystem::exists(svl)) {
+	/* The native converter composes in-process, so it needs the
+	 * composition itself rather than the EXP file.
+	 */
+	EXPComposition composition;
+	bool compose = useConverter == DFT::converter::NATIVE && !expOnly
+	               && (!reuse || !FileSystem::exists(tra) || !FileSystem::exists(lab));
+
+	if(!reuse || !FileSystem::exists(dft) || !FileSystem::exists(exp) || !FileSystem::exists(svl) || compose) {
 		// dft -> exp, svl
 		messageFormatter->reportAction("Translating DFT to EXP...",VERBOSITY_FLOW);
-		std::vector<std::string> arguments;
-		arguments.push_back("--verbose=" + std::to_string(messageFormatter->getVerbosity()));
-		arguments.push_back("-s");
-		arguments.push_back(svl.getFileRealPath());
-		arguments.push_back("-x");
-		arguments.push_back(exp.getFileRealPath());
-		arguments.push_back("-b");
-		arguments.push_back(bcg.getFileRealPath());
-		arguments.push_back("-n");
-		arguments.push_back(dftOriginal.getFileRealPath());
-		if(!evidence.empty()) {
-			arguments.push_back("-e");
-			std::stringstream ss;
-			for(std::string e: evidence) {
-				ss << e << ",";
-			}
-			arguments.push_back(ss.str());
-		}
-		if (!messageFormatter->usingColoredMessages())
-			arguments.push_back(" --no-color");
-		arguments.push_back(dft.getFileRealPath());
-        std::vector<File> outputs;
-		outputs.push_back(exp);
-		outputs.push_back(svl);
-		if (exec.runCommand(dft2lntcExec.getFilePath(), arguments, "dft2lntc", outputs) == "")
+		std::lock_guard<std::mutex> guard(frontendLock);
+		if (translateDFT(dftOriginal, root, dft, svl, exp, bcg,
+		                 compose ? &composition : NULL))
 			return 1;
 	} else {
 		messageFormatter->reportAction("Reusing DFT to EXP translation result",VERBOSITY_FLOW);
@@ -639,14 +1483,48 @@ int DFT::DFTCalc::calculateDFT(const bool reuse,
 	if (expOnly)
 		return 0;
 
-	std::string* tmpContents = FileSystem::load(exp);
-	if (cachedResults.find(*tmpContents) != cachedResults.end()) {
-		ret = cachedResults[*tmpContents];
-		delete tmpContents;
-		return 0;
+	std::string key = resultKey(exp, queries, useChecker, useConverter, exactMode);
+	if (key.empty()) {
+		messageFormatter->reportError("Could not read EXP file `" + exp.getFileRealPath() + "'");
+		return 1;
+	}
+	{
+		std::lock_guard<std::mutex> guard(cacheLock);
+		auto cached = cachedResults.find(key);
+		if (cached != cachedResults.end()) {
+			ret = cached->second;
+			return 0;
+		}
+		if (useResultCache && loadResult(key, queries, ret)) {
+			cachedResults[key] = ret;
+			return 0;
+		}
+	}
+
+	/* Static bounds may already be within the error bound the user
+	 * asked for, making the analysis unnecessary. The relaxation BDDs
+	 * are kept small, as dynamic trees rarely give tight bounds. Not
+	 * in exact mode, which asks for values rather than bounds.
+	 */
+	bool errorBoundsSet = !queries.empty();
+	for (const Query &q : queries)
+		errorBoundsSet = errorBoundsSet && q.errorBoundSet;
+	if (errorBoundsSet && !exactMode) {
+		DFT::DFTCalculationResult bounds;
+		bool tight = !staticBounds(dftOriginal, root, queries, bounds,
+		                           STATIC_BOUNDS_MAX_NODES)
+		             && !bounds.failProbs.empty();
+		for (const DFT::DFTCalculationResultItem &it : bounds.failProbs) {
+			double width = (double)(it.upperBound - it.lowerBound);
+			if (width > (double)it.query.errorBound)
+				tight = false;
+		}
+		if (tight) {
+			messageFormatter->reportAction("Static bounds are within the error bound, skipping the analysis",VERBOSITY_FLOW);
+			ret.failProbs.insert(ret.failProbs.end(), bounds.failProbs.begin(), bounds.failProbs.end());
+			return 0;
+		}
 	}
-	std::string expContents = *tmpContents;
-	delete tmpContents;
 
 	if (useConverter == DFT::converter::SVL) {
 #ifndef HAVE_CADP
@@ -738,6 +1616,32 @@ int DFT::DFTCalc::calculateDFT(const bool reuse,
 			messageFormatter->notify("No impossible labels detected.");
 		}
 #endif /* HAVE_CADP */
+	} else if (useConverter == DFT::converter::NATIVE) {
+		if (compose) {
+			// exp -> aut -> tra, lab
+			messageFormatter->reportAction("Building IMC...",VERBOSITY_FLOW);
+			Composer composer(messageFormatter);
+			if (composer.compose(composition))
+				return 1;
+			{
+				std::ofstream autFile(aut.getFileRealPath());
+				composer.getIMC().writeAUT(autFile);
+			}
+
+			messageFormatter->reportAction("Applying maximal progress to IMC...",VERBOSITY_FLOW);
+			CTMC ctmc;
+			if (composer.buildCTMC(ctmc))
+				return 1;
+			std::ofstream traFile(tra.getFileRealPath());
+			std::ofstream labFile(lab.getFileRealPath());
+			ctmc.writeTraLab(traFile, labFile);
+			if (!traFile || !labFile) {
+				messageFormatter->reportError("Error writing `" + tra.getFileRealPath() + "'");
+				return 1;
+			}
+		} else {
+			messageFormatter->reportAction("Reusing IMC to .tra/.lab translation result",VERBOSITY_FLOW);
+		}
 	} else if (!reuse
 	           || (useChecker == IMRMC && !FileSystem::exists(exactTra))
 	           || (useChecker == STORM && !FileSystem::exists(jani))
@@ -795,7 +1699,7 @@ int DFT::DFTCalc::calculateDFT(const bool reuse,
 		break;
 #endif /* HAVE_CADP */
 	case IMRMC:
-		if(useConverter != DFTRES && (!reuse || !FileSystem::exists(tra))) {
+		if(useConverter == SVL && (!reuse || !FileSystem::exists(tra))) {
 #ifndef HAVE_CADP
 			messageFormatter->reportError("Internal error: tried to use bcg2jani in non-CADP program.");
 			return 1;
@@ -811,12 +1715,12 @@ int DFT::DFTCalc::calculateDFT(const bool reuse,
 			if (exec.runCommand(bcg2tralabExec.getFilePath(), arguments, "bcg2tralab", tra) == "")
 				return 1;
 #endif /* HAVE_CADP */
-		} else {
+		} else if (useConverter == SVL) {
 			messageFormatter->reportAction("Reusing IMC to .tra/.lab translation result",VERBOSITY_FLOW);
 		}
 		{
 			File tmpTra, tmpLab;
-			if (useConverter == SVL) {
+			if (useConverter != DFTRES) {
 				tmpTra = tra;
 				tmpLab = lab;
 			} else {
@@ -900,6 +1804,9 @@ int DFT::DFTCalc::calculateDFT(const bool reuse,
 			checker = std::unique_ptr<Checker>(sr);
 		}
 		break;
+	case TRANSIENT:
+		checker = std::unique_ptr<Checker>(new TransientRunner(messageFormatter, &exec, tra, lab));
+		break;
 	default:
 		messageFormatter->reportError("Unexpected checker type");
 	}
@@ -936,7 +1843,10 @@ int DFT::DFTCalc::calculateDFT(const bool reuse,
 #endif /* HAVE_CADP */
 	}
 
-	cachedResults[expContents] = ret;
+	std::lock_guard<std::mutex> guard(cacheLock);
+	cachedResults[key] = ret;
+	if (useResultCache)
+		storeResult(key, ret);
 	return 0;
 }
 
@@ -967,7 +1877,15 @@ int main(int argc, char** argv) {
 
 	int verbosity            = 0;
 	bool warnNonDeterminism  = true;
+	bool useResultCache      = true;
+	bool usePhaseTypes       = false;
+	bool exactArithmetic     = false;
 	bool modularize          = false;
+	bool cutSets             = false;
+	bool boundsOnly          = false;
+	size_t cutSetOrder       = SIZE_MAX;
+	double cutSetCutoff      = 0;
+	unsigned long jobs       = 1;
 	int print                = 0;
 	int reuse                = 0;
 	int useColoredMessages   = 1;
@@ -1028,6 +1946,9 @@ int main(int argc, char** argv) {
 			mttf = 1;
 		} else if (!strcmp(argv[argi], "-M")) {
 			modularize = 1;
+		} else if (!strcmp(argv[argi], "-j")) {
+			// -j Number of modules to analyse in parallel
+			jobs = strtoul(argv[++argi], NULL, 10);
 		} else if (!strcmp(argv[argi], "-s")) {
 			steadyState = 1;
 		} else if (!strcmp(argv[argi], "-t")) {
@@ -1103,6 +2024,25 @@ int main(int argc, char** argv) {
 			useColoredMessages = false;
 		} else if(!strcmp("--no-nd-warning", argv[argi])) {
 			warnNonDeterminism = false;
+		} else if(!strcmp("--no-cache", argv[argi])) {
+			useResultCache = false;
+		} else if(!strcmp("--phase-type", argv[argi])) {
+			usePhaseTypes = true;
+		} else if(!strcmp("--exact-arithmetic", argv[argi])) {
+			exactArithmetic = true;
+		} else if(!strcmp("--bounds", argv[argi])) {
+			boundsOnly = true;
+		} else if(!strcmp("--cutsets", argv[argi])) {
+			cutSets = true;
+		} else if(!strcmp("--cutset-order", argv[argi])) {
+			// --cutset-order Maximum number of events per cut set
+			cutSetOrder = strtoul(argv[++argi], NULL, 10);
+		} else if(!strcmp("--cutset-cutoff", argv[argi])) {
+			// --cutset-cutoff Minimum probability per cut set
+			std::string cutoff(argv[++argi]);
+			if (!isReal(cutoff, &cutSetCutoff) || cutSetCutoff < 0 || cutSetCutoff > 1) {
+				messageFormatter->reportErrorAt(Location("commandline --cutset-cutoff flag"),"Given cutoff is not a probability: "+cutoff);
+			}
 		} else if(!strcmp("--min", argv[argi])) {
 			checkMin = true;
 			minMaxSet = true;
@@ -1130,6 +2070,14 @@ int main(int argc, char** argv) {
 			useConverter = DFT::converter::DFTRES;
 			if (!explicitChecker)
 				useChecker = DFT::checker::IMRMC;
+		} else if (!strcmp("--native", argv[argi])) {
+			useConverter = DFT::converter::NATIVE;
+			if (!explicitChecker)
+				useChecker = DFT::checker::IMRMC;
+		} else if (!strcmp("--transient", argv[argi])) {
+			useChecker = DFT::checker::TRANSIENT;
+			useConverter = DFT::converter::NATIVE;
+			explicitChecker = true;
 		}
 	}
 	if (expOnly)
@@ -1156,6 +2104,15 @@ int main(int argc, char** argv) {
 		useChecker = DFT::checker::IMRMC;
 	}
 
+	if (useConverter == DFT::converter::NATIVE
+		&& useChecker != DFT::checker::EXP_ONLY
+		&& useChecker != DFT::checker::IMRMC
+		&& useChecker != DFT::checker::TRANSIENT)
+	{
+		messageFormatter->reportWarningAt(Location("commandline"),"Native flag can only be used with IMRMC or the transient solver, defaulting to IMRMC");
+		useChecker = DFT::checker::IMRMC;
+	}
+
 	Query q;
 	if (errorBoundSet) {
 		double t;
@@ -1307,6 +2264,16 @@ int main(int argc, char** argv) {
 		queries.push_back(iq);
 	}
 	
+	if (useChecker == DFT::checker::TRANSIENT) {
+		for (const Query& tq : queries) {
+			if (tq.type != TIMEBOUND) {
+				messageFormatter->reportWarningAt(Location("commandline"),"The transient solver only supports time-bounded queries, defaulting to IMRMC");
+				useChecker = DFT::checker::IMRMC;
+				break;
+			}
+		}
+	}
+
 	/* Parse command line arguments without a -X.
 	 * These specify the input files.
 	 */
@@ -1325,9 +2292,13 @@ int main(int argc, char** argv) {
 	/* Create the DFTCalc class */
 	DFT::DFTCalc calc(messageFormatter);
 	if(dotToTypeSet) calc.setBuildDOT(dotToType);
+	calc.setJobs(jobs);
+	calc.setResultCache(useResultCache);
+	calc.setPhaseTypes(usePhaseTypes);
+	calc.setExactArithmetic(exactArithmetic);
 	
 	/* Check if all needed tools are available */
-	if(calc.checkNeededTools(useChecker, useConverter)) {
+	if(!cutSets && !boundsOnly && calc.checkNeededTools(useChecker, useConverter)) {
 		messageFormatter->reportError("There was an error with the environment");
 		return -1;
 	}
@@ -1356,7 +2327,14 @@ int main(int argc, char** argv) {
 			DFT::DFTCalculationResult ret;
 			bool res;
 			try {
-				if (!modularize) {
+				if (boundsOnly) {
+					res = calc.staticBounds(dft, "", queries, ret);
+					if (res) {
+						messageFormatter->reportError("Static bounds do not support this DFT or these queries.");
+					}
+				} else if (cutSets) {
+					res = calc.calcCutSets(dft, queries, cutSetOrder, cutSetCutoff, ret);
+				} else if (!modularize) {
 					res = calc.calculateDFT(reuse, outputFolderFile.getFileRealPath(),dft, queries, useChecker, useConverter, warnNonDeterminism, "", ret, expOnly, exactMode);
 				} else {
 					res = calc.calcModular(reuse, outputFolderFile.getFileRealPath(),dft, queries, useChecker, useConverter, warnNonDeterminism, ret, expOnly, exactMode);
@@ -1396,6 +2374,12 @@ int main(int argc, char** argv) {
 		std::stringstream out;
 		for(auto it: results) {
 			std::string fName = it.first;
+			for(auto& cs: it.second.cutSets) {
+				out << "MCS(`" << fName << "')={";
+				for(size_t i = 0; i < cs.size(); i++)
+					out << (i ? ", " : "") << cs[i];
+				out << "}" << std::endl;
+			}
 			for(auto it2: it.second.failProbs) {
 				if (it2.query.type == EXPECTEDTIME) {
 					out << "MTTF(`" << fName << "'" << ")=" << it2.valStr() << std::endl;
@@ -1414,7 +2398,7 @@ int main(int argc, char** argv) {
 		std::cout << out.str();
 	}
     
-	if (useConverter != DFT::converter::DFTRES) {
+	if (useConverter == DFT::converter::SVL) {
 		for(File dft: dfts) {
 			File svlLogFile = File(outputFolderFile.getFileRealPath(),dft.getFileBase(),"log");
 			Shell::SvlStatistics svlStats;
@@ -1535,30 +2519,27 @@ bool DFT::DFTCalc::checkNeededTools(DFT::checker checker, converter conv) {
 		svlExec = File(cadpRoot+"/com/svl");
 #endif
 
-	/* These tools should be easy to find in the roots. Note that an added
-	 * bonus would be to locate them using PATH as well.
+	/* The DFT is compiled in-process, but the dft2lnt root is still
+	 * needed to find the other tools and the BCG nodes.
 	 */
-	dft2lntcExec = File(dft2lntRoot+"/bin/dft2lntc");
-	if (!FileSystem::exists(dft2lntcExec)) {
-		if (FileSystem::exists(File(dft2lntRoot + "/bin/dft2lntc.exe")))
-			dft2lntcExec = File(dft2lntRoot + "/bin/dft2lntc.exe");
-	}
-
-	/* Find dft2lntc executable (based on DFT2LNTROOT environment variable) */
 	if(dft2lntRoot.empty()) {
-		messageFormatter->reportError("Environment variable `DFT2LNTROOT' not set. Please set it to where /bin/dft2lntc can be found.");
+		messageFormatter->reportError("Environment variable `DFT2LNTROOT' not set. Please set it to where dft2lnt is installed.");
 		ok = false;
 	} else if(!FileSystem::isDir(File(dft2lntRoot))) {
 		messageFormatter->reportError("Could not enter dft2lntroot directory (environment variable `DFT2LNTROOT'");
 		ok = false;
-	} else if(!FileSystem::exists(dft2lntcExec)) {
-		messageFormatter->reportError("dft2lntc not found (in " + dft2lntRoot + "/bin)");
-		ok = false;
-	} else if(!FileSystem::hasAccessTo(dft2lntcExec,X_OK)) {
-		messageFormatter->reportError("dft2lntc not executable (in " + dft2lntRoot+"/bin)");
-		ok = false;
-	} else {
-		messageFormatter->reportAction("Using dft2lntc [" + dft2lntcExec.getFilePath() + "]",VERBOSITY_SEARCHING);
+	}
+
+	/* Find the cache directory for the generated node automata */
+	{
+		CompilerContext cc(std::cerr);
+		cc.useColoredMessages(messageFormatter->usingColoredMessages());
+		cacheDir = DFT::getCacheDir(&cc);
+		cc.flush();
+		if(cacheDir.empty())
+			ok = false;
+		else
+			messageFormatter->reportAction("Using cache directory [" + cacheDir + "]",VERBOSITY_SEARCHING);
 	}
 
 	/* Find imc2ctmdpi executable (based on CORAL environment variable) */
@@ -10,24 +10,31 @@
 #ifndef DFTCALC_H
 #define DFTCALC_H
 
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include "DFTCalculationResult.h"
 #include "executor.h"
+#include "compiler.h"
+#include "frontend.h"
+#include "bdd.h"
 
 namespace DFT {
 	extern const int VERBOSITY_FLOW;
 
-	enum checker {STORM, MRMC, IMRMC, IMCA, MODEST, EXP_ONLY};
-	enum converter {SVL, DFTRES};
+	enum checker {STORM, MRMC, IMRMC, IMCA, MODEST, TRANSIENT, EXP_ONLY};
+	enum converter {SVL, DFTRES, NATIVE};
 
 	class DFTCalc {
 	public:
 		static const int VERBOSITY_SEARCHING;
 
 		DFTCalc(MessageFormatter *mf)
-			:messageFormatter(mf), exec(nullptr)
+			:messageFormatter(mf), useResultCache(true), jobs(1),
+			 usePhaseTypes(false), exactArithmetic(false)
 		{}
 
 		~DFTCalc()
@@ -43,7 +50,7 @@ namespace DFT {
 		std::string dft2lntRoot;
 		std::string coralRoot;
 		std::string imcaRoot;
-		File dft2lntcExec;
+		std::string cacheDir;
 #ifdef HAVE_CADP
 		std::string cadpRoot;
 		File imc2ctmdpExec;
@@ -71,20 +78,157 @@ namespace DFT {
 		File getDftresJar();
 
 		std::vector<std::string> evidence;
+		/// Results of this run, keyed by resultKey()
 		std::unordered_map<std::string, DFTCalculationResult> cachedResults;
-		CommandExecutor *exec;
+		std::mutex cacheLock;
+		/// Whether results are also cached on disk, across runs
+		bool useResultCache;
 
-		int checkModule(const bool reuse,
-		                const std::string& cwd,
-		                const File& dftOriginal,
+		/**
+		 * Returns the (hexadecimal SHA-256) key under which the results
+		 * of the specified EXP file are cached: a hash of its contents,
+		 * and of all settings that affect the results.
+		 * @return The key, or the empty string if exp cannot be read.
+		 */
+		std::string resultKey(const File& exp,
+		                      const std::vector<Query> &queries,
+		                      enum DFT::checker useChecker,
+		                      enum DFT::converter useConverter,
+		                      bool exactMode);
+
+		/**
+		 * Looks up the results with the specified key in the on-disk
+		 * cache, restoring the queries they answer from the specified
+		 * ones.
+		 * @return true if found, false otherwise
+		 */
+		bool loadResult(const std::string& key,
 		                const std::vector<Query> &queries,
-		                enum DFT::checker useChecker,
-		                enum DFT::converter useConverter,
-		                bool warnNonDeterminism,
+		                DFT::DFTCalculationResult &ret);
+
+		/**
+		 * Stores the specified results in the on-disk cache.
+		 */
+		void storeResult(const std::string& key,
+		                 const DFT::DFTCalculationResult &result);
+
+		/// The number of modules analysed in parallel
+		unsigned int jobs;
+
+		/// The in-process compiler of the DFT currently being analysed
+		std::unique_ptr<CompilerContext> compilerContext;
+		std::unique_ptr<Frontend> frontend;
+		/// Held while using the front end or the node cache
+		std::mutex frontendLock;
+
+		/**
+		 * Returns the front end holding the parsed and validated
+		 * specified DFT, parsing it if it is not the current one.
+		 * @return The front end, or nullptr if the DFT is invalid.
+		 */
+		Frontend *getFrontend(const File& dftOriginal);
+
+		/// Whether independent subtrees are analysed separately
+		bool usePhaseTypes;
+		/// The embedded files of the subtrees already analysed, by root
+		std::unordered_map<std::string, std::string> phaseTypes;
+
+		/// Whether the results of modules are combined exactly
+		bool exactArithmetic;
+
+		/**
+		 * Replaces the largest independent subtrees below the top of
+		 * the specified DFT, which must not be prepared yet, by APH
+		 * basic events (see phaseTypeOf()). Subtrees below spare and
+		 * SEQ gates are kept, since they are not activated at once.
+		 * @param removed The names of the removed nodes are added here.
+		 */
+		void abstractSubtrees(Frontend *frontend, DFT::DFTree *tree,
+		                      std::unordered_set<std::string> &removed);
+
+		/**
+		 * Computes the phase-type distribution of the time to failure
+		 * of the independent subtree rooted at the specified node,
+		 * abstracting its own independent subtrees in turn, and
+		 * writes it to the node cache as the embedded process of an
+		 * APH basic event.
+		 * @return The embedded file, or the empty string if the
+		 *         subtree is repairable or cannot be composed natively.
+		 */
+		std::string phaseTypeOf(Frontend *frontend, const std::string &root);
+
+		/**
+		 * Compiles the specified DFT, re-rooted at root if not empty,
+		 * writing the canonical DFT and the SVL and EXP files.
+		 * @param composition If not NULL, the composition described by
+		 *        the EXP file is stored here as well.
+		 * @return 0 if successful, non-zero otherwise
+		 */
+		int translateDFT(const File& dftOriginal,
+		                 const std::string& root,
+		                 const File& dft,
+		                 const File& svl,
+		                 const File& exp,
+		                 const File& bcg,
+		                 EXPComposition *composition = NULL);
+
+		/// A basic event of a static (B) module
+		struct StaticEvent {
+			decnumber<> lambda, prob;
+			int phases;
+		};
+
+		/**
+		 * A node of the modules description written by writeModules():
+		 * a module to analyse (M, or I if its isomorphism class is
+		 * given), a static module given as a BDD (B), a constant
+		 * probability (=), or the combination of its children by an
+		 * AND (*), OR (+) or voting (/) gate.
+		 */
+		struct Module {
+			/// The type, with I normalised to M
+			char type;
+			/// The root of an M or B module, or the probability of =
+			std::string value;
+			/// The canonical hash of an M module, if known
+			std::string hash;
+			unsigned long votCount;
+			std::vector<Module> children;
+			/// The events and BDD of a B module
+			std::vector<StaticEvent> events;
+			std::vector<BDD::Node> bdd;
+			uint32_t bddRoot;
+		};
+
+		/**
+		 * Computes the results of the queries for a static (B)
+		 * module, which must all be time-bounded, unbounded or
+		 * steady-state.
+		 */
+		void checkStatic(const Module &module,
+		                 const std::vector<Query> &queries,
+		                 DFT::DFTCalculationResult &ret);
+
+		/**
+		 * Parses the first module from the specified description,
+		 * removing it from the description.
+		 * @return 0 if successful, non-zero otherwise
+		 */
+		int parseModule(std::string &description, Module &ret);
+
+		/**
+		 * Combines the results of the M modules (in depth-first
+		 * order, starting from leaf) according to the module tree.
+		 * Unless exact, bounds that are not exact values are
+		 * combined in outward-rounded double arithmetic.
+		 * @return 0 if successful, non-zero otherwise
+		 */
+		int checkModule(const Module &module,
+		                const std::vector<Query> &queries,
+		                const std::vector<DFT::DFTCalculationResult> &leaves,
+		                size_t &leaf,
 		                DFT::DFTCalculationResult &ret,
-		                bool expOnly,
-		                bool exactMode,
-		                std::string &module);
+		                bool exact);
 
 		bool findInPath(std::string tool, File &ret);
 	public:
@@ -104,6 +248,40 @@ namespace DFT {
 		void setBuildDOT(const std::string& buildDot) {
 			this->buildDot = buildDot;
 		}
+
+		/**
+		 * Sets whether results are looked up in and added to the
+		 * on-disk cache shared by all runs (the default).
+		 */
+		void setResultCache(bool use) {
+			useResultCache = use;
+		}
+
+		/**
+		 * Sets whether independent subtrees below the top of the
+		 * analysed DFTs are analysed separately, and replaced by the
+		 * phase-type distributions of their times to failure.
+		 */
+		void setPhaseTypes(bool use) {
+			usePhaseTypes = use;
+		}
+
+		/**
+		 * Sets whether calcModular() combines the results of the
+		 * modules in exact decimal arithmetic (as it always does in
+		 * exact mode), rather than in rounded doubles.
+		 */
+		void setExactArithmetic(bool exact) {
+			exactArithmetic = exact;
+		}
+
+		/**
+		 * Sets the number of modules analysed in parallel by
+		 * calcModular().
+		 */
+		void setJobs(unsigned int jobs) {
+			this->jobs = jobs ? jobs : 1;
+		}
 		
 		/**
 		 * Calculates the specified DFT file with modularization.
@@ -129,6 +307,39 @@ namespace DFT {
 		                DFT::DFTCalculationResult &ret,
 		                bool expOnly,
 		                bool exactMode);
+		/**
+		 * Computes cheap bounds on the results of the queries from
+		 * the static relaxations of the DFT (see writeBounds()),
+		 * re-rooted at root if not empty.
+		 * @param ret Will have the bounds added.
+		 * @param maxNodes The size of the relaxation BDDs at which to
+		 *        give up.
+		 * @return 0 if successful, non-zero if the DFT or one of the
+		 *         queries is not supported, or the BDDs are too large
+		 */
+		int staticBounds(const File& dftOriginal,
+		                 const std::string& root,
+		                 const std::vector<Query> &queries,
+		                 DFT::DFTCalculationResult &ret,
+		                 size_t maxNodes = 1 << 22);
+
+		/**
+		 * Computes the minimal cut sets of the specified DFT, and
+		 * bounds on its failure probability from them for each of the
+		 * queries, which must all be time-bounded, unbounded or
+		 * steady-state.
+		 * @param maxOrder Cut sets with more basic events are
+		 *        truncated.
+		 * @param cutoff Cut sets with a lower probability are
+		 *        truncated.
+		 * @param ret Will have the cut sets and results added.
+		 * @return 0 if successful, non-zero otherwise
+		 */
+		int calcCutSets(const File& dftOriginal,
+		                const std::vector<Query> &queries,
+		                size_t maxOrder, double cutoff,
+		                DFT::DFTCalculationResult &ret);
+
 		/**
 		 * Calculates the specified DFT file.
 		 * @param reuse Whether to reuse intermediate files.
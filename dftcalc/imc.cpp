@@ -0,0 +1,630 @@
+/*
+ * imc.cpp
+ *
+ * Part of dft2lnt library - a library containing read/write operations for DFT
+ * files in Galileo format and translating DFT specifications into Lotos NT.
+ */
+
+#include "imc.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <string>
+
+#include "decnumber.h"
+#include "automata/binary.h"
+
+DFT::IMC::IMC():
+	offsets(1, 0),
+	initial(0)
+{
+	addLabel("i");
+}
+
+uint32_t DFT::IMC::addLabel(const std::string& label) {
+	auto it = labelIndex.find(label);
+	if (it != labelIndex.end())
+		return it->second;
+	uint32_t ret = labels.size();
+	labels.push_back(label);
+	rateLabels.push_back(label.compare(0, 5, "rate ") == 0);
+	labelIndex.emplace(label, ret);
+	return ret;
+}
+
+uint32_t DFT::IMC::addState() {
+	offsets.push_back(offsets.back());
+	return offsets.size() - 2;
+}
+
+static bool parseNumber(const std::string& s, size_t& pos, unsigned long& ret) {
+	while (pos < s.size() && isspace((unsigned char)s[pos]))
+		pos++;
+	if (pos >= s.size() || !isdigit((unsigned char)s[pos]))
+		return false;
+	const char *start = s.c_str() + pos;
+	char *end;
+	ret = strtoul(start, &end, 10);
+	pos += end - start;
+	return true;
+}
+
+static bool expect(const std::string& s, size_t& pos, char c) {
+	while (pos < s.size() && isspace((unsigned char)s[pos]))
+		pos++;
+	if (pos >= s.size() || s[pos] != c)
+		return false;
+	pos++;
+	return true;
+}
+
+bool DFT::IMC::readAUT(std::istream& in, std::string& error) {
+	std::string line;
+	size_t pos = 3;
+	unsigned long init, nTransitions, nStates;
+	if (!std::getline(in, line)
+	    || line.compare(0, 3, "des") != 0
+	    || !expect(line, pos, '(')
+	    || !parseNumber(line, pos, init) || !expect(line, pos, ',')
+	    || !parseNumber(line, pos, nTransitions) || !expect(line, pos, ',')
+	    || !parseNumber(line, pos, nStates) || !expect(line, pos, ')'))
+	{
+		error = "invalid header: " + line;
+		return false;
+	}
+	if (init >= nStates) {
+		error = "initial state out of range";
+		return false;
+	}
+
+	/* Transitions may come in any order, so group them by source. */
+	std::vector<uint32_t> sources;
+	std::vector<Transition> read;
+	sources.reserve(nTransitions);
+	read.reserve(nTransitions);
+	while (std::getline(in, line)) {
+		if (line.find_first_not_of(" \t\r") == std::string::npos)
+			continue;
+		unsigned long from, to;
+		pos = 0;
+		size_t close = line.rfind(')');
+		size_t lastComma = line.rfind(',', close);
+		if (!expect(line, pos, '(') || !parseNumber(line, pos, from)
+		    || !expect(line, pos, ',')
+		    || close == std::string::npos
+		    || lastComma == std::string::npos || lastComma < pos)
+		{
+			error = "invalid transition: " + line;
+			return false;
+		}
+		size_t labelPos = lastComma + 1;
+		if (!parseNumber(line, labelPos, to)) {
+			error = "invalid transition: " + line;
+			return false;
+		}
+		std::string label = line.substr(pos, lastComma - pos);
+		size_t first = label.find_first_not_of(" \t");
+		size_t last = label.find_last_not_of(" \t");
+		label = label.substr(first, last - first + 1);
+		if (label.size() >= 2 && label.front() == '"' && label.back() == '"')
+			label = label.substr(1, label.size() - 2);
+		if (from >= nStates || to >= nStates) {
+			error = "state out of range: " + line;
+			return false;
+		}
+		sources.push_back(from);
+		read.push_back({addLabel(label), (uint32_t)to});
+	}
+
+	offsets.assign(nStates + 1, 0);
+	for (uint32_t s : sources)
+		offsets[s + 1]++;
+	for (size_t s = 0; s < nStates; s++)
+		offsets[s + 1] += offsets[s];
+	transitions.resize(read.size());
+	std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+	for (size_t t = 0; t < read.size(); t++)
+		transitions[fill[sources[t]]++] = read[t];
+	initial = init;
+	return true;
+}
+
+void DFT::IMC::writeAUT(std::ostream& out) const {
+	out << "des (" << initial << ", " << getNumTransitions()
+	    << ", " << getNumStates() << ")\n";
+	for (uint32_t s = 0; s < getNumStates(); s++) {
+		for (const Transition *t = begin(s); t != end(s); ++t) {
+			out << "(" << s << ", ";
+			if (t->label == TAU)
+				out << "i";
+			else
+				out << "\"" << labels[t->label] << "\"";
+			out << ", " << t->target << ")\n";
+		}
+	}
+}
+
+bool DFT::IMC::readBinary(const char *data, size_t size, std::string& error) {
+	using namespace automata::binary;
+	const char *pos = data, *end = data + size;
+	uint64_t version, init, nStates, nTransitions, nLabels;
+	if (size < sizeof(MAGIC) || memcmp(data, MAGIC, sizeof(MAGIC)) != 0) {
+		error = "not a binary automaton";
+		return false;
+	}
+	pos += sizeof(MAGIC);
+	if (!get(pos, end, version) || version != VERSION) {
+		error = "unsupported format version";
+		return false;
+	}
+	if (!get(pos, end, init) || !get(pos, end, nStates)
+	    || !get(pos, end, nTransitions) || !get(pos, end, nLabels))
+	{
+		error = "truncated header";
+		return false;
+	}
+	/* Every state, transition and label takes at least one byte */
+	if (nStates > UINT32_MAX || nStates > size
+	    || nTransitions > size || nLabels > size)
+	{
+		error = "invalid header";
+		return false;
+	}
+	if (init >= nStates) {
+		error = "initial state out of range";
+		return false;
+	}
+
+	labels.clear();
+	rateLabels.clear();
+	labelIndex.clear();
+	addLabel("i");
+	std::vector<uint32_t> ids(nLabels);
+	for (uint64_t l = 0; l < nLabels; l++) {
+		uint64_t length;
+		if (!get(pos, end, length) || length > (uint64_t)(end - pos)) {
+			error = "truncated label";
+			return false;
+		}
+		ids[l] = addLabel(std::string(pos, length));
+		pos += length;
+	}
+
+	offsets.assign(1, 0);
+	offsets.reserve(nStates + 1);
+	transitions.clear();
+	transitions.reserve(nTransitions);
+	for (uint64_t s = 0; s < nStates; s++) {
+		uint64_t n, label, delta;
+		if (!get(pos, end, n)) {
+			error = "truncated transitions";
+			return false;
+		}
+		for (; n > 0; n--) {
+			if (!get(pos, end, label) || !get(pos, end, delta)) {
+				error = "truncated transitions";
+				return false;
+			}
+			uint64_t target = s + unzigzag(delta);
+			if (label >= nLabels || target >= nStates) {
+				error = "transition out of range";
+				return false;
+			}
+			transitions.push_back({ids[label], (uint32_t)target});
+		}
+		offsets.push_back(transitions.size());
+	}
+	if (transitions.size() != nTransitions) {
+		error = "wrong number of transitions";
+		return false;
+	}
+	initial = init;
+	return true;
+}
+
+void DFT::IMC::writeBinary(std::ostream& out) const {
+	using namespace automata::binary;
+	std::string buf(MAGIC, sizeof(MAGIC));
+	put(buf, VERSION);
+	put(buf, initial);
+	put(buf, getNumStates());
+	put(buf, getNumTransitions());
+	put(buf, labels.size());
+	for (const std::string& label : labels) {
+		put(buf, label.size());
+		buf += label;
+	}
+	for (uint32_t s = 0; s < getNumStates(); s++) {
+		put(buf, end(s) - begin(s));
+		for (const Transition *t = begin(s); t != end(s); ++t) {
+			put(buf, t->label);
+			put(buf, zigzag((int64_t)t->target - (int64_t)s));
+		}
+	}
+	out.write(buf.data(), buf.size());
+}
+
+DFT::CTMC::CTMC():
+	offsets(1, 0)
+{
+}
+
+uint32_t DFT::CTMC::addRate(const std::string& rate) {
+	auto it = rateIndex.find(rate);
+	if (it != rateIndex.end())
+		return it->second;
+	uint32_t ret = rates.size();
+	rates.push_back(rate);
+	rateValues.push_back(std::stod(rate));
+	rateIndex.emplace(rate, ret);
+	return ret;
+}
+
+uint32_t DFT::CTMC::addState() {
+	offsets.push_back(offsets.back());
+	return offsets.size() - 2;
+}
+
+void DFT::CTMC::writeTraLab(std::ostream& tra, std::ostream& lab) const {
+	tra << "STATES " << getNumStates() << "\n";
+	tra << "TRANSITIONS " << getNumTransitions() << "\n";
+	lab << "#DECLARATION\nmarked\n#END\n";
+	for (uint32_t s = 0; s < getNumStates(); s++) {
+		for (const Transition *t = begin(s); t != end(s); ++t) {
+			tra << (s + 1) << " " << (t->target + 1) << " "
+			    << rates[t->rate] << "\n";
+		}
+		if (isMarked(s))
+			lab << (s + 1) << " marked\n";
+	}
+}
+
+bool DFT::CTMC::readTraLab(std::istream& tra, std::istream& lab,
+                           std::string& error)
+{
+	*this = CTMC();
+	std::string word;
+	size_t nStates, nTransitions;
+	if (!(tra >> word) || word != "STATES" || !(tra >> nStates)
+	    || !(tra >> word) || word != "TRANSITIONS" || !(tra >> nTransitions))
+	{
+		error = "Malformed .tra header";
+		return false;
+	}
+
+	struct Entry {
+		uint32_t source;
+		Transition t;
+	};
+	std::vector<Entry> entries;
+	entries.reserve(nTransitions);
+	for (size_t i = 0; i < nTransitions; i++) {
+		size_t s, t;
+		std::string rate;
+		if (!(tra >> s >> t >> rate)) {
+			error = "Expected " + std::to_string(nTransitions)
+			        + " transitions, got " + std::to_string(i);
+			return false;
+		}
+		if (s < 1 || s > nStates || t < 1 || t > nStates) {
+			error = "State out of range in transition "
+			        + std::to_string(i + 1);
+			return false;
+		}
+		char *end;
+		strtod(rate.c_str(), &end);
+		if (*end || end == rate.c_str()) {
+			error = "Invalid rate in transition "
+			        + std::to_string(i + 1) + ": " + rate;
+			return false;
+		}
+		entries.push_back({(uint32_t)(s - 1),
+		                   {addRate(rate), (uint32_t)(t - 1)}});
+	}
+	std::stable_sort(entries.begin(), entries.end(),
+		[](const Entry& a, const Entry& b) { return a.source < b.source; });
+	size_t e = 0;
+	for (uint32_t s = 0; s < nStates; s++) {
+		addState();
+		for (; e < entries.size() && entries[e].source == s; e++)
+			addTransition(entries[e].t.rate, entries[e].t.target);
+	}
+
+	std::string line;
+	bool declarations = false;
+	while (std::getline(lab, line)) {
+		if (line.compare(0, 12, "#DECLARATION") == 0) {
+			declarations = true;
+			continue;
+		}
+		if (line.compare(0, 4, "#END") == 0) {
+			declarations = false;
+			continue;
+		}
+		if (declarations)
+			continue;
+		std::istringstream words(line);
+		size_t state;
+		if (!(words >> state))
+			continue;
+		if (state < 1 || state > nStates) {
+			error = "State out of range in .lab file: " + line;
+			return false;
+		}
+		while (words >> word) {
+			if (word == "marked")
+				setMarked(state - 1, true);
+		}
+	}
+	return true;
+}
+
+namespace {
+
+/* An element of the signature of a state: a (label, class) pair, or the
+ * total rate into a class if label is RATE.
+ */
+struct SigEntry {
+	static const uint32_t RATE = 0xffffffff;
+	uint32_t label;
+	uint32_t cls;
+	double rate;
+
+	bool operator<(const SigEntry& other) const {
+		if (label != other.label)
+			return label < other.label;
+		if (cls != other.cls)
+			return cls < other.cls;
+		return rate < other.rate;
+	}
+
+	bool operator==(const SigEntry& other) const {
+		return label == other.label && cls == other.cls
+		       && rate == other.rate;
+	}
+};
+
+struct KeyHash {
+	size_t operator()(const std::vector<uint64_t>& key) const {
+		uint64_t h = 0xcbf29ce484222325ULL;
+		for (uint64_t k : key)
+			h = (h ^ k) * 0x100000001b3ULL;
+		return h ^ (h >> 32);
+	}
+};
+
+}
+
+DFT::IMC DFT::IMC::minimise(const std::vector<bool>& urgent) const {
+	const uint32_t NONE = 0xffffffff;
+	size_t n = getNumStates();
+	auto isUrgent = [&](uint32_t label) {
+		return label == TAU || (label < urgent.size() && urgent[label]);
+	};
+
+	/* Find the strongly connected components of the internal
+	 * transitions (Tarjan). Components are numbered such that internal
+	 * transitions only lead to components with lower numbers.
+	 */
+	std::vector<uint32_t> scc(n, NONE), index(n, NONE), low(n);
+	std::vector<bool> onStack(n);
+	std::vector<uint32_t> sccStack;
+	std::vector<std::pair<uint32_t, const Transition *>> call;
+	uint32_t counter = 0, nScc = 0;
+	for (uint32_t root = 0; root < n; root++) {
+		if (index[root] != NONE)
+			continue;
+		index[root] = low[root] = counter++;
+		sccStack.push_back(root);
+		onStack[root] = true;
+		call.push_back(std::make_pair(root, begin(root)));
+		while (!call.empty()) {
+			uint32_t s = call.back().first;
+			const Transition *t = call.back().second;
+			while (t != end(s) && t->label != TAU)
+				++t;
+			if (t != end(s)) {
+				call.back().second = t + 1;
+				uint32_t v = t->target;
+				if (index[v] == NONE) {
+					index[v] = low[v] = counter++;
+					sccStack.push_back(v);
+					onStack[v] = true;
+					call.push_back(std::make_pair(v, begin(v)));
+				} else if (onStack[v] && index[v] < low[s]) {
+					low[s] = index[v];
+				}
+				continue;
+			}
+			call.pop_back();
+			if (!call.empty() && low[s] < low[call.back().first])
+				low[call.back().first] = low[s];
+			if (low[s] == index[s]) {
+				uint32_t w;
+				do {
+					w = sccStack.back();
+					sccStack.pop_back();
+					onStack[w] = false;
+					scc[w] = nScc;
+				} while (w != s);
+				nScc++;
+			}
+		}
+	}
+
+	/* Collapse the components. Maximal progress: Markovian
+	 * transitions of components that can still take an urgent
+	 * transition are removed.
+	 */
+	std::vector<std::vector<uint32_t>> members(nScc);
+	std::vector<bool> stable(nScc, true);
+	for (uint32_t s = 0; s < n; s++) {
+		members[scc[s]].push_back(s);
+		for (const Transition *t = begin(s); t != end(s); ++t) {
+			if (t->label == TAU && scc[t->target] == scc[s])
+				continue;
+			if (isUrgent(t->label))
+				stable[scc[s]] = false;
+		}
+	}
+	IMC c;
+	for (uint32_t l = 0; l < labels.size(); l++)
+		c.addLabel(labels[l]);
+	std::vector<Transition> out;
+	auto flush = [](IMC& m, std::vector<Transition>& out) {
+		std::sort(out.begin(), out.end(), [](const Transition& a, const Transition& b) {
+			return a.label < b.label || (a.label == b.label && a.target < b.target);
+		});
+		for (size_t i = 0; i < out.size(); i++) {
+			if (i > 0 && out[i].label == out[i - 1].label
+			    && out[i].target == out[i - 1].target)
+				continue;
+			m.addTransition(out[i].label, out[i].target);
+		}
+		out.clear();
+	};
+	for (uint32_t x = 0; x < nScc; x++) {
+		c.addState();
+		for (uint32_t s : members[x]) {
+			for (const Transition *t = begin(s); t != end(s); ++t) {
+				if (isRate(t->label) && !stable[x])
+					continue;
+				if (t->label == TAU && scc[t->target] == x)
+					continue;
+				out.push_back({t->label, scc[t->target]});
+			}
+		}
+		flush(c, out);
+	}
+	c.setInitial(scc[initial]);
+	members.clear();
+
+	std::vector<double> rateValues(labels.size());
+	for (uint32_t l = 0; l < labels.size(); l++)
+		if (isRate(l))
+			rateValues[l] = strtod(labels[l].c_str() + 5, NULL);
+
+	/* Signature refinement: states are split until all states in a
+	 * class have the same signature, i.e. the same (label, class) pairs
+	 * reachable by internal transitions within their class, and the
+	 * same total rates into other classes.
+	 */
+	size_t m = c.getNumStates();
+	std::vector<uint32_t> cls(m, 0), newCls(m);
+	std::vector<std::vector<SigEntry>> sigs(m);
+	std::vector<std::pair<uint32_t, double>> rates;
+	size_t nCls = 1;
+	while (true) {
+		std::unordered_map<std::vector<uint64_t>, uint32_t, KeyHash> ids;
+		std::vector<uint64_t> key;
+		for (uint32_t x = 0; x < m; x++) {
+			std::vector<SigEntry>& sig = sigs[x];
+			sig.clear();
+			rates.clear();
+			for (const Transition *t = c.begin(x); t != c.end(x); ++t) {
+				uint32_t tc = cls[t->target];
+				if (c.isRate(t->label)) {
+					if (tc != cls[x])
+						rates.push_back(std::make_pair(tc, rateValues[t->label]));
+				} else if (t->label == TAU && tc == cls[x]) {
+					/* Inert, so the target was done before */
+					sig.insert(sig.end(), sigs[t->target].begin(), sigs[t->target].end());
+				} else {
+					sig.push_back({t->label, tc, 0});
+				}
+			}
+			std::sort(rates.begin(), rates.end());
+			for (size_t i = 0; i < rates.size();) {
+				SigEntry e = {SigEntry::RATE, rates[i].first, 0};
+				for (; i < rates.size() && rates[i].first == e.cls; i++)
+					e.rate += rates[i].second;
+				sig.push_back(e);
+			}
+			std::sort(sig.begin(), sig.end());
+			sig.erase(std::unique(sig.begin(), sig.end()), sig.end());
+
+			key.clear();
+			key.push_back(cls[x]);
+			for (const SigEntry& e : sig) {
+				uint64_t bits;
+				memcpy(&bits, &e.rate, sizeof(bits));
+				key.push_back(((uint64_t)e.label << 32) | e.cls);
+				key.push_back(bits);
+			}
+			auto it = ids.emplace(key, ids.size()).first;
+			newCls[x] = it->second;
+		}
+		cls.swap(newCls);
+		if (ids.size() == nCls)
+			break;
+		nCls = ids.size();
+	}
+	sigs.clear();
+
+	/* Build the quotient. The rates of a class are those of any of its
+	 * stable members.
+	 */
+	std::vector<std::vector<uint32_t>> classMembers(nCls);
+	for (uint32_t x = 0; x < m; x++)
+		classMembers[cls[x]].push_back(x);
+	IMC q;
+	for (uint32_t l = 0; l < labels.size(); l++)
+		q.addLabel(labels[l]);
+	for (uint32_t k = 0; k < nCls; k++) {
+		q.addState();
+		bool haveRates = false;
+		for (uint32_t x : classMembers[k]) {
+			bool isStable = true;
+			for (const Transition *t = c.begin(x); t != c.end(x); ++t) {
+				if (isUrgent(t->label))
+					isStable = false;
+				if (c.isRate(t->label))
+					continue;
+				if (t->label == TAU && cls[t->target] == k)
+					continue;
+				out.push_back({t->label, cls[t->target]});
+			}
+			if (!isStable || haveRates)
+				continue;
+			haveRates = true;
+			std::map<uint32_t, std::vector<uint32_t>> byClass;
+			for (const Transition *t = c.begin(x); t != c.end(x); ++t)
+				if (c.isRate(t->label) && cls[t->target] != k)
+					byClass[cls[t->target]].push_back(t->label);
+			for (const auto& r : byClass) {
+				uint32_t label = r.second[0];
+				if (r.second.size() > 1) {
+					decnumber<> sum(labels[r.second[0]].substr(5));
+					for (size_t i = 1; i < r.second.size(); i++)
+						sum += decnumber<>(labels[r.second[i]].substr(5));
+					label = q.addLabel("rate " + sum.str());
+				}
+				out.push_back({label, r.first});
+			}
+		}
+		flush(q, out);
+	}
+
+	/* Maximal progress may have made classes unreachable */
+	std::vector<uint32_t> number(nCls, NONE), queue;
+	number[cls[c.getInitial()]] = 0;
+	queue.push_back(cls[c.getInitial()]);
+	IMC r;
+	for (uint32_t l = 0; l < q.getNumLabels(); l++)
+		r.addLabel(q.getLabel(l));
+	for (size_t i = 0; i < queue.size(); i++) {
+		r.addState();
+		for (const Transition *t = q.begin(queue[i]); t != q.end(queue[i]); ++t) {
+			if (number[t->target] == NONE) {
+				number[t->target] = queue.size();
+				queue.push_back(t->target);
+			}
+			r.addTransition(t->label, number[t->target]);
+		}
+	}
+	return r;
+}
@@ -0,0 +1,222 @@
+/*
+ * imc.h
+ *
+ * Part of dft2lnt library - a library containing read/write operations for DFT
+ * files in Galileo format and translating DFT specifications into Lotos NT.
+ */
+
+#ifndef IMC_H
+#define IMC_H
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace DFT {
+
+/**
+ * An explicit Interactive Markov Chain. Labels are interned: transitions
+ * refer to them by number. Labels of the form "rate <r>" are Markovian,
+ * all others are interactive, with "i" (label TAU) the internal action.
+ * The transitions are stored grouped by source state, so states have to
+ * be added in order, each followed by its outgoing transitions.
+ */
+class IMC {
+public:
+	struct Transition {
+		uint32_t label;
+		uint32_t target;
+	};
+
+	/// The number of the internal action "i"
+	static const uint32_t TAU = 0;
+
+private:
+	std::vector<std::string> labels;
+	std::vector<bool> rateLabels;
+	std::unordered_map<std::string, uint32_t> labelIndex;
+	std::vector<size_t> offsets;
+	std::vector<Transition> transitions;
+	uint32_t initial;
+
+public:
+	IMC();
+
+	/**
+	 * Returns the number of the specified label, adding it if needed.
+	 */
+	uint32_t addLabel(const std::string& label);
+
+	const std::string& getLabel(uint32_t label) const { return labels[label]; }
+	size_t getNumLabels() const { return labels.size(); }
+
+	/**
+	 * Returns whether the specified label is Markovian ("rate <r>").
+	 */
+	bool isRate(uint32_t label) const { return rateLabels[label]; }
+
+	/**
+	 * Adds a new state. Transitions added after this call, until the
+	 * next call, leave from this state.
+	 * @return The number of the new state.
+	 */
+	uint32_t addState();
+
+	/**
+	 * Adds a transition from the last added state.
+	 */
+	void addTransition(uint32_t label, uint32_t target) {
+		transitions.push_back({label, target});
+		offsets.back()++;
+	}
+
+	size_t getNumStates() const { return offsets.size() - 1; }
+	size_t getNumTransitions() const { return transitions.size(); }
+	uint32_t getInitial() const { return initial; }
+	void setInitial(uint32_t state) { initial = state; }
+
+	/**
+	 * Returns the first outgoing transition of the specified state.
+	 */
+	const Transition *begin(uint32_t state) const {
+		return transitions.data() + offsets[state];
+	}
+
+	/**
+	 * Returns the end of the outgoing transitions of the specified state.
+	 */
+	const Transition *end(uint32_t state) const {
+		return transitions.data() + offsets[state + 1];
+	}
+
+	/**
+	 * Replaces the contents of this IMC by the automaton in Aldebaran
+	 * (.aut) format read from the specified stream.
+	 * @param error Will contain the reason if reading fails.
+	 * @return true if successful, false otherwise.
+	 */
+	bool readAUT(std::istream& in, std::string& error);
+
+	/**
+	 * Writes this IMC in Aldebaran (.aut) format.
+	 */
+	void writeAUT(std::ostream& out) const;
+
+	/**
+	 * Replaces the contents of this IMC by the automaton in binary
+	 * (.baut) format (see automata/binary.h) in the specified buffer.
+	 * @param error Will contain the reason if reading fails.
+	 * @return true if successful, false otherwise.
+	 */
+	bool readBinary(const char *data, size_t size, std::string& error);
+
+	/**
+	 * Writes this IMC in binary (.baut) format.
+	 */
+	void writeBinary(std::ostream& out) const;
+
+	/**
+	 * Returns the quotient of this IMC modulo stochastic branching
+	 * bisimulation. The internal action, and labels for which urgent is
+	 * true, cannot be delayed: Markovian transitions of states having
+	 * such transitions are removed first (maximal progress). Cycles of
+	 * internal transitions are collapsed.
+	 * @param urgent Indexed by label, missing labels are not urgent.
+	 */
+	IMC minimise(const std::vector<bool>& urgent) const;
+};
+
+/**
+ * An explicit Continuous-Time Markov Chain, with a single state label
+ * ("marked"). Rates are interned decimal strings, so they can be written
+ * back exactly.
+ */
+class CTMC {
+public:
+	struct Transition {
+		uint32_t rate;
+		uint32_t target;
+	};
+
+private:
+	std::vector<std::string> rates;
+	std::vector<double> rateValues;
+	std::unordered_map<std::string, uint32_t> rateIndex;
+	std::vector<size_t> offsets;
+	std::vector<Transition> transitions;
+	std::vector<bool> marked;
+
+public:
+	CTMC();
+
+	/**
+	 * Returns the number of the specified (decimal) rate, adding it if
+	 * needed.
+	 */
+	uint32_t addRate(const std::string& rate);
+
+	const std::string& getRate(uint32_t rate) const { return rates[rate]; }
+	double getRateValue(uint32_t rate) const { return rateValues[rate]; }
+
+	/**
+	 * Adds a new state. Transitions added after this call, until the
+	 * next call, leave from this state.
+	 * @return The number of the new state.
+	 */
+	uint32_t addState();
+
+	/**
+	 * Adds a transition from the last added state.
+	 */
+	void addTransition(uint32_t rate, uint32_t target) {
+		transitions.push_back({rate, target});
+		offsets.back()++;
+	}
+
+	/**
+	 * Sets the label of the specified state, which may already have
+	 * been numbered without having been added yet.
+	 */
+	void setMarked(uint32_t state, bool mark) {
+		if (state >= marked.size())
+			marked.resize(state + 1);
+		marked[state] = mark;
+	}
+
+	bool isMarked(uint32_t state) const {
+		return state < marked.size() && marked[state];
+	}
+
+	size_t getNumStates() const { return offsets.size() - 1; }
+	size_t getNumTransitions() const { return transitions.size(); }
+
+	const Transition *begin(uint32_t state) const {
+		return transitions.data() + offsets[state];
+	}
+
+	const Transition *end(uint32_t state) const {
+		return transitions.data() + offsets[state + 1];
+	}
+
+	/**
+	 * Writes this CTMC in the MRMC .tra/.lab format, with state 0 as
+	 * the initial state (state 1 in the output).
+	 */
+	void writeTraLab(std::ostream& tra, std::ostream& lab) const;
+
+	/**
+	 * Replaces the contents of this CTMC by the one read from the
+	 * specified streams in the MRMC .tra/.lab format. Transitions need
+	 * not be ordered by source state. Only the label "marked" is kept.
+	 * @param error Will contain the reason if reading fails.
+	 * @return true if successful, false otherwise.
+	 */
+	bool readTraLab(std::istream& tra, std::istream& lab, std::string& error);
+};
+
+} // Namespace: DFT
+
+#endif
@@ -21,7 +21,13 @@
 
 using std::vector;
 
-static void getOptions(Query q, std::vector<std::string> &options) {
+/* Options that have to be the same for all queries in one invocation */
+static std::string getBatchKey(const Query &q) {
+	return std::string(q.min ? "-min" : "-max") + " "
+	       + (q.errorBoundSet ? q.errorBound.str() : "");
+}
+
+static void getCommonOptions(const Query &q, std::vector<std::string> &options) {
 	if (q.min)
 		options.push_back("-min");
 	else
@@ -30,6 +36,9 @@ static void getOptions(Query q, std::vector<std::string> &options) {
 		options.push_back("-e");
 		options.push_back(q.errorBound.str());
 	}
+}
+
+static void getOptions(const Query &q, std::vector<std::string> &options) {
 	switch (q.type) {
 	case EXPECTEDTIME:
 		options.push_back("-et");
@@ -55,194 +64,161 @@ static void getOptions(Query q, std::vector<std::string> &options) {
 	}
 }
 
-bool parseOutputFile(File file, Query q,
-                     vector<DFT::DFTCalculationResultItem> &ret)
+static DFT::DFTCalculationResultItem makeItem(const Query &q,
+                                               const std::string &res)
 {
-	/* This function assumes that the answer to only the given query is
-	 * in the result file. It is entirely possible in IMCA to have
-	 * multiple queries in one file, and if we ever need to include that
-	 * optimization, we need to change this parser.
-	 */
-	FILE* fp;
-	long len;
-	char* buffer;
-
-	fp = fopen(file.getFileRealPath().c_str(),"rb");
-	if (!fp)
-		return 0;
-	fseek(fp,0,SEEK_END);
-	len = ftell(fp)+1;
-	fseek(fp,0,SEEK_SET);
-	buffer = (char *)malloc(len);
-	memset(buffer, 0, len);
-	fread(buffer,len,1,fp); //read into buffer
-	fclose(fp);
-
 	decnumber<> margin = q.errorBound;
 	if (q.errorBoundSet)
 		margin *= 0.5;
 	else
 		margin = decnumber<>("1e-6") * 0.5;
+	DFT::DFTCalculationResultItem it(q);
+	decnumber<> dres(res);
+	it.exactBounds = 0;
+	it.lowerBound = dres - margin;
+	it.upperBound = dres + margin;
+	return it;
+}
 
-	//fprintf(stdout, "imca buffer info (%ld,%ld):\n", len, n);
-	//fprintf(stdout, "imca buffer\n%*s\n", (int)n, buffer);
-
-	// for each line:
-	char *p = buffer;
-	char *k;
-	char tb_needle[] = "tb=";
-	char prob_needle[] = "probability: ";
-	char et_max_needle[] = "Maximal expected time: ";
-	char et_min_needle[] = "Minimal expected time: ";
-	char *et_needles[] = { et_max_needle, et_min_needle, 0 };
-	char ub_max_needle[] = "Maximal unbounded reachability: ";
-	char ub_min_needle[] = "Minimal unbounded reachability: ";
-	char *ub_needles[] = { ub_max_needle, ub_min_needle, 0 };
-	for(int i=0; et_needles[i] != 0; i++) {
-		if((k=strstr(p, et_needles[i])) != 0) {
-			char *et = k + strlen(et_needles[i]);
-			char *et_e = strchr(et, '\n');
-			if (et_e != 0) {
-				*et_e = '\0';
-				p = et_e + 1;
-			} else {
-				p = et;
-			}
-			std::string res(et, et_e - et);
-			double et_res;
-                	int r_et  = sscanf(et,"%lf",&et_res);
-			if (r_et ==  1) {
-				DFT::DFTCalculationResultItem it(q);
-				decnumber<> dres(res);
-				it.exactBounds = 0;
-				it.lowerBound = dres - margin;
-				it.upperBound = dres + margin;
-				ret.push_back(it);
-				free(buffer);
-				return 1;
-			}
-		}
-	}
+/* Returns the number at the start of str, or an empty string */
+static std::string getNumber(const std::string &str, size_t start) {
+	size_t end = str.find(' ', start);
+	std::string ret = str.substr(start, end == std::string::npos ? end : end - start);
+	double tmp;
+	if (sscanf(ret.c_str(), "%lf", &tmp) != 1)
+		return "";
+	return ret;
+}
 
-	for(int i=0; ub_needles[i] != 0; i++) {
-		if((k=strstr(p, ub_needles[i])) != 0) {
-			char *ub = k + strlen(ub_needles[i]);
-			char *ub_e = strchr(ub, '\n');
-			if (ub_e != 0) {
-				*ub_e = '\0';
-				p = ub_e + 1;
-			} else {
-				p = ub;
-			}
-			std::string res(ub, ub_e - ub);
-			double ub_res;
-			int r_ub  = sscanf(ub,"%lf",&ub_res);
-			if (r_ub ==  1){
-				DFT::DFTCalculationResultItem it(q);
-				decnumber<> dres(res);
-				it.exactBounds = 0;
-				it.lowerBound = dres - margin;
-				it.upperBound = dres + margin;
-				ret.push_back(it);
-				free(buffer);
-				return 1;
-			}
-		}
-	}
+/* Parses the output of an IMCA invocation answering the given queries,
+ * of which there is at most one of each type. The results of each query
+ * are added to the corresponding element of results.
+ */
+static bool parseOutputFile(File file, const vector<Query> &queries,
+                            vector<vector<DFT::DFTCalculationResultItem>> &results)
+{
+	std::ifstream input(file.getFileRealPath());
+	if (!input.is_open())
+		return 0;
 
-	bool found = 0;
-	p = buffer;
-	while((k= strstr(p, prob_needle)) != 0) {
-		// find start of line, by looking for end of previous line (either '\n' or '\0')
-		char *ep = k;
-		while(ep > p && *ep != '\0' && *ep != '\n')
-			ep--;
-		char *line_start;
-		if (*ep == '\0' || *ep == '\n')
-			line_start = ep + 1;
-		else
-			line_start = p;
-		//fprintf(stderr, "prob found, p=%p, k=%p, ep=%p, line_start=%p\n", p, k, ep, line_start);
-
-		// get probability value, turning end-of-line into \0
-		int r_prob = 0;
-		double tmp;
-		char *prob = k + strlen(prob_needle);
-		char *prob_e = strchr(prob, '\n');
-		if (prob_e != 0) {
-			*prob_e = '\0';
-			p = prob_e + 1;
-		} else {
-			p = prob;
+	static const char tb_needle[] = "tb=";
+	static const char prob_needle[] = "probability: ";
+	static const char *et_needles[] = {
+		"Maximal expected time: ",
+		"Minimal expected time: ",
+		0
+	};
+	static const char *ub_needles[] = {
+		"Maximal unbounded reachability: ",
+		"Minimal unbounded reachability: ",
+		0
+	};
+
+	auto find = [&](enum query_type type) {
+		for (size_t i = 0; i < queries.size(); i++) {
+			if (queries[i].type == type)
+				return i;
+		}
+		return queries.size();
+	};
+	size_t et = find(EXPECTEDTIME), ub = find(UNBOUNDED);
+	size_t tb = find(TIMEBOUND);
+
+	std::string line;
+	while (std::getline(input, line)) {
+		size_t k;
+		for (int i = 0; et < queries.size() && et_needles[i]; i++) {
+			if ((k = line.find(et_needles[i])) != std::string::npos) {
+				std::string res = getNumber(line, k + strlen(et_needles[i]));
+				if (res != "" && results[et].empty())
+					results[et].push_back(makeItem(queries[et], res));
+			}
 		}
-		char *prob_v = strchr(prob, ' ');
-		if (prob_v)
-			prob_e = prob_v;
-		std::string prob_res(prob, prob_e - prob);
-		r_prob  = sscanf(prob,"%lf",&tmp);
-
-		// look for tb= value, from start of line
-		// we will not cross into next line, because end-of-line is turned into \0
-		int r_tb = 0;
-		std::string tb_res;
-		if ((k = strstr(line_start, tb_needle)) != 0) {
-			//fprintf(stderr, "tb found, p=%p, k=%p, ep=%p, line_start=%p\n", p, k, ep, line_start);
-			char *tb = k + strlen(tb_needle);
-			char *tb_e = strchr(tb, ' ');
-			if (tb_e != 0) {
-				*tb_e = '\0';
-				//p = tb_e + 1;
-			} else {
-				//p = tb;
+		for (int i = 0; ub < queries.size() && ub_needles[i]; i++) {
+			if ((k = line.find(ub_needles[i])) != std::string::npos) {
+				std::string res = getNumber(line, k + strlen(ub_needles[i]));
+				if (res != "" && results[ub].empty())
+					results[ub].push_back(makeItem(queries[ub], res));
 			}
-			tb_res = std::string(tb, tb_e - tb);
-			r_tb  = sscanf(tb,"%lf",&tmp);
 		}
-		//fprintf(stderr, "r_prob=%d r_tb=%d\n", r_prob, r_tb);
-
-		decnumber<> dres(prob_res);
-		if (r_tb ==  1 && r_prob == 1){
-			Query qt = q;
-			qt.lowerBound = qt.upperBound = decnumber<>(tb_res);
-			DFT::DFTCalculationResultItem it(qt);
-			it.exactBounds = 0;
-			it.lowerBound = dres - margin;
-			it.upperBound = dres + margin;
-			ret.push_back(it);
-		} else if (r_prob == 1){
-			DFT::DFTCalculationResultItem it(q);
-			it.exactBounds = 0;
-			it.lowerBound = dres - margin;
-			it.upperBound = dres + margin;
-			ret.push_back(it);
+		if (tb == queries.size())
+			continue;
+		if ((k = line.find(prob_needle)) == std::string::npos)
+			continue;
+		std::string prob = getNumber(line, k + strlen(prob_needle));
+		if (prob == "")
+			continue;
+		std::string time;
+		if ((k = line.find(tb_needle)) != std::string::npos)
+			time = getNumber(line, k + strlen(tb_needle));
+		if (time != "") {
+			Query qt = queries[tb];
+			qt.lowerBound = qt.upperBound = decnumber<>(time);
+			results[tb].push_back(makeItem(qt, prob));
+		} else {
+			results[tb].push_back(makeItem(queries[tb], prob));
 		}
-		found = 1;
 	}
 
-	free(buffer);
-	return found;
+	for (size_t i = 0; i < queries.size(); i++) {
+		if (results[i].empty())
+			return 0;
+	}
+	return 1;
 }
 
 std::vector<DFT::DFTCalculationResultItem> IMCARunner::analyze(vector<Query> queries)
 {
 	std::vector<DFT::DFTCalculationResultItem> ret;
 	messageFormatter->reportAction("Calculating probability with IMCA...",DFT::VERBOSITY_FLOW);
-	for(Query query: queries) {
+
+	/* IMCA can answer one query of each type per invocation, as long as
+	 * they agree on the common options.
+	 */
+	std::vector<std::vector<size_t>> batches;
+	for (size_t i = 0; i < queries.size(); i++) {
+		size_t b;
+		for (b = 0; b < batches.size(); b++) {
+			const Query &first = queries[batches[b][0]];
+			if (getBatchKey(first) != getBatchKey(queries[i]))
+				continue;
+			bool taken = false;
+			for (size_t j : batches[b])
+				taken |= queries[j].type == queries[i].type;
+			if (!taken)
+				break;
+		}
+		if (b == batches.size())
+			batches.push_back(std::vector<size_t>());
+		batches[b].push_back(i);
+	}
+
+	vector<vector<DFT::DFTCalculationResultItem>> results(queries.size());
+	for (const auto &batch : batches) {
 		// imca -> calculation
 		std::vector<std::string> arguments;
 		arguments.push_back(modelFile.getFileRealPath());
-		getOptions(query, arguments);
+		getCommonOptions(queries[batch[0]], arguments);
+		vector<Query> batchQueries;
+		for (size_t i : batch) {
+			getOptions(queries[i], arguments);
+			batchQueries.push_back(queries[i]);
+		}
 
 		std::string out = exec->runCommand(imcaExec.getFilePath(),
 				arguments, "imca");
 		if (out == "")
 			return ret;
 
-		File outFile(out);
-		if (!parseOutputFile(outFile, query, ret)) {
+		vector<vector<DFT::DFTCalculationResultItem>> batchResults(batch.size());
+		if (!parseOutputFile(File(out), batchQueries, batchResults)) {
 			messageFormatter->reportError("Could not calculate");
 			return ret;
 		}
+		for (size_t i = 0; i < batch.size(); i++)
+			results[batch[i]] = batchResults[i];
 	}
+	for (const auto &r : results)
+		ret.insert(ret.end(), r.begin(), r.end());
 	return ret;
 }
@@ -16,7 +16,9 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <algorithm>
 #include <iostream>
+#include <map>
 #include <stdexcept>
 
 std::vector<std::string> ModestRunner::getCommandOptions(Query q)
@@ -63,16 +65,28 @@ static std::string getQuery(Query q)
 	return ret;
 }
 
-static int readOutputFile(File file, DFT::DFTCalculationResultItem &it) {
+typedef std::pair<decnumber<>, decnumber<>> Bounds;
+
+/* Reads the results of all properties. With a ranged experiment, every
+ * property is listed once per value, in order.
+ */
+static bool readOutputFile(File file,
+                           std::map<std::string, std::vector<Bounds>> &results)
+{
 	if(!FileSystem::exists(file))
-		return -1;
+		return false;
 
-	std::string needle = "+ Property " + getQuery(it.query);
+	static const std::string needle = "+ Property ";
 	std::ifstream input(file.getFileRealPath());
 	std::string line;
 	std::getline(input, line);
 	while (input.good()) {
-		if (line.find(needle) == 0) {
+		size_t indent = line.find_first_not_of(" \t");
+		if (indent != std::string::npos
+		    && line.compare(indent, needle.length(), needle) == 0)
+		{
+			std::string name = line.substr(indent + needle.length());
+			name.erase(name.find_last_not_of(" \t\r") + 1);
 			std::getline(input, line);
 			std::getline(input, line);
 			if (!input.good())
@@ -86,44 +100,149 @@ static int readOutputFile(File file, DFT::DFTCalculationResultItem &it) {
 			std::string up = line.substr(end + 2);
 			end = up.find(']');
 			up = up.substr(0, end);
-			it.lowerBound = decnumber<>(low);
-			it.upperBound = decnumber<>(up);
-			it.exactBounds = 0;
-			return 0;
+			results[name].push_back(Bounds(low, up));
 		}
 		std::getline(input, line);
 	}
-	return -1;
+	return true;
 }
 
 std::vector<DFT::DFTCalculationResultItem> ModestRunner::analyze(std::vector<Query> queries)
 {
 	std::vector<DFT::DFTCalculationResultItem> ret;
-	expandRangeQueries(queries);
 	messageFormatter->reportAction("Calculating probability with Modest", DFT::VERBOSITY_FLOW);
-	for (Query q : queries) {
-		std::vector<std::string> arguments = getCommandOptions(q);
+
+	/* mcsta computes all properties of the model in each run, so all
+	 * queries needing the same constants are answered together, and
+	 * every time-stepped query becomes a single ranged experiment.
+	 */
+	struct Invocation {
+		std::vector<std::string> options;
+		std::vector<size_t> queries;
+		bool ranged;
+	};
+	std::vector<Invocation> invocations;
+	std::vector<Query> expanded;
+	std::vector<DFT::DFTCalculationResultItem> items;
+	std::vector<bool> done;
+	std::map<std::vector<std::string>, size_t> byOptions;
+
+	auto add = [&](const Query &q) {
+		expanded.push_back(q);
+		items.push_back(DFT::DFTCalculationResultItem(q));
+		done.push_back(false);
+		if (q.type == TIMEBOUND && q.upperBound == 0) {
+			/* Incorrect for models with prob= BEs, but needed since
+			 * Modest doesn't handle the query otherwise.
+			 */
+			items.back().exactBounds = 1;
+			items.back().lowerBound = items.back().upperBound = (uintmax_t)0;
+			done.back() = true;
+		}
+		return expanded.size() - 1;
+	};
+	auto addSingle = [&](size_t i) {
+		std::vector<std::string> options = getCommandOptions(expanded[i]);
+		auto it = byOptions.find(options);
+		if (it == byOptions.end()) {
+			it = byOptions.emplace(options, invocations.size()).first;
+			invocations.push_back({options, {}, false});
+		}
+		invocations[it->second].queries.push_back(i);
+	};
+
+	std::vector<size_t> others;
+	for (const Query &q : queries) {
+		if (q.type != TIMEBOUND || q.step == -1) {
+			size_t i = add(q);
+			if (q.type != TIMEBOUND)
+				others.push_back(i);
+			else if (!done[i])
+				addSingle(i);
+			continue;
+		}
+		std::vector<Query> points(1, q);
+		expandRangeQueries(points);
+		Invocation inv;
+		for (const Query &p : points) {
+			size_t i = add(p);
+			if (!done[i])
+				inv.queries.push_back(i);
+		}
+		if (inv.queries.empty())
+			continue;
+		const Query &first = expanded[inv.queries.front()];
+		const Query &last = expanded[inv.queries.back()];
+		inv.options = getCommandOptions(first);
+		inv.ranged = inv.queries.size() > 1;
+		if (inv.ranged) {
+			inv.options[1] = "T=" + first.upperBound.str() + ":"
+			                 + last.upperBound.str() + ":"
+			                 + q.step.str() + ",L=0";
+		}
+		invocations.push_back(inv);
+	}
+	/* The other queries do not depend on the constants */
+	for (size_t i : others) {
+		std::vector<std::string> options = getCommandOptions(expanded[i]);
+		size_t inv;
+		for (inv = 0; inv < invocations.size(); inv++) {
+			std::vector<std::string> &o = invocations[inv].options;
+			if (std::equal(o.begin() + 2, o.end(), options.begin() + 2, options.end()))
+				break;
+		}
+		if (inv < invocations.size())
+			invocations[inv].queries.push_back(i);
+		else
+			addSingle(i);
+	}
+
+	for (size_t inv = 0; inv < invocations.size(); inv++) {
+		std::vector<std::string> arguments = invocations[inv].options;
+		std::vector<size_t> batch = invocations[inv].queries;
+		bool ranged = invocations[inv].ranged;
 		arguments.push_back(janiFile.getFileRealPath());
-		DFT::DFTCalculationResultItem it(q);
-		int result;
-		if (q.type != TIMEBOUND || q.upperBound != 0) {
-			std::string of = exec->runCommand(modestCmd, arguments, "modest");
-			if (of == "")
-				return ret; /* Exec should have reported already */
-			result = readOutputFile(of, it);
-			if (result == -1) {
+		std::string of = exec->runCommand(modestCmd, arguments, "modest");
+		if (of == "")
+			return ret; /* Exec should have reported already */
+		std::map<std::string, std::vector<Bounds>> results;
+		if (!readOutputFile(of, results)) {
+			messageFormatter->reportError("Could not calculate.");
+			return ret;
+		}
+		std::map<std::string, size_t> expected, used;
+		for (size_t i : batch) {
+			if (ranged && expanded[i].type == TIMEBOUND)
+				expected[getQuery(expanded[i])]++;
+		}
+		for (size_t i : batch) {
+			std::string name = getQuery(expanded[i]);
+			const std::vector<Bounds> &r = results[name];
+			size_t n = 0;
+			if (expected.count(name)) {
+				/* Fall back to one run per time if the range
+				 * was not expanded as expected.
+				 */
+				if (r.size() != expected[name]) {
+					invocations.push_back({getCommandOptions(expanded[i]), {i}, false});
+					continue;
+				}
+				n = used[name]++;
+			}
+			if (r.empty()) {
 				messageFormatter->reportError("Could not calculate.");
 				return ret;
 			}
-		} else {
-			/* Incorrect for models with prob= BEs, but needed since
-			 * Modest doesn't handle the query otherwise.
-			 */
-			it.exactBounds = 1;
-			it.lowerBound = it.upperBound = (uintmax_t)0;
-			result = 0;
+			items[i].lowerBound = r[n].first;
+			items[i].upperBound = r[n].second;
+			items[i].exactBounds = 0;
 		}
-		if (result == 0 && !it.exactBounds) {
+	}
+
+	for (size_t i = 0; i < items.size(); i++) {
+		const Query &q = expanded[i];
+		DFT::DFTCalculationResultItem &it = items[i];
+		if (!it.exactBounds) {
 			decnumber<> margin = q.errorBound;
 			if (q.errorBoundSet)
 				margin *= 0.5;
@@ -53,8 +53,34 @@ static std::string getQuery(Query q, std::string goalLabel) {
 	return ret;
 }
 
-static std::pair<decnumber<>, decnumber<>> readOutputFile(const File& file) {
-	std::pair<decnumber<>, decnumber<>> ret(-1, -1);
+/* Parses a single result value, either a number or an interval. */
+static std::pair<decnumber<>, decnumber<>> parseResult(std::string res) {
+	if (res.find('[') == std::string::npos) {
+		decnumber<> val(res);
+		return std::pair<decnumber<>, decnumber<>>(val, val);
+	}
+	size_t pos = res.find('[');
+	std::string pre = res.substr(0, pos);
+	res = res.substr(pos + 1);
+	pos = res.find(']');
+	std::string post = res.substr(pos + 1);
+	res = res.substr(0, pos);
+	pos = post.find(',');
+	if (pos != std::string::npos)
+		post = post.substr(0, pos);
+	pos = res.find(';');
+	if (pos == std::string::npos)
+		pos = res.find(',');
+	std::string low = pre + res.substr(0, pos) + post;
+	std::string up = pre + res.substr(pos + 2) + post;
+	return std::pair<decnumber<>, decnumber<>>(low, up);
+}
+
+/* Reads all printed results from the output, in the order in which the
+ * formulas were given.
+ */
+static std::vector<std::pair<decnumber<>, decnumber<>>> readOutputFile(const File& file) {
+	std::vector<std::pair<decnumber<>, decnumber<>>> ret;
 
 	FILE* fp;
 	long len;
@@ -75,56 +101,28 @@ static std::pair<decnumber<>, decnumber<>> readOutputFile(const File& file) {
 	buffer[len] = 0;
 	fclose(fp);
 
-	const char *resultString, *c;
-	resultString = strstr(buffer, "$MIN_RESULT");
-	if (resultString)
-		c = resultString + 15;
-	if (!resultString) {
-		resultString = strstr(buffer, "$MAX_RESULT");
-		if (resultString)
-			c = resultString + 15;
-	}
-	if (!resultString) {
-		resultString = strstr(buffer, "$RESULT[1]");
-		if (resultString)
-			c = resultString + 13;
-	}
-	if (!resultString) {
-		resultString = strstr(buffer, "$RESULT:");
-		if (resultString)
-			c = resultString + 11;
-	}
-
-	if(!resultString)
-		return ret;
-
-	const char *end = c;
-	while (*end && *end != '\n' && *end != '\r')
-		end++;
-	std::string res(c, end - c);
-	if (res.find('[') == std::string::npos) {
-		end = c;
-		while (*end && *end != '\n' && *end != '\r')
-			end++;
-		res = std::string(c, end - c);
-		decnumber<> val(res);
-		ret = std::pair<decnumber<>, decnumber<>>(val, val);
-	} else {
-		size_t pos = res.find('[');
-		std::string pre = res.substr(0, pos);
-		res = res.substr(pos + 1);
-		pos = res.find(']');
-		std::string post = res.substr(pos + 1);
-		res = res.substr(0, pos);
-		pos = post.find(',');
-		if (pos != std::string::npos)
-			post = post.substr(0, pos);
-		pos = res.find(';');
-		if (pos == std::string::npos)
-			pos = res.find(',');
-		std::string low = pre + res.substr(0, pos) + post;
-		std::string up = pre + res.substr(pos + 2) + post;
-		ret = std::pair<decnumber<>, decnumber<>>(low, up);
+	/* The first kind of result found is the one used */
+	static const struct {
+		const char *needle;
+		size_t skip;
+	} needles[] = {
+		{"$MIN_RESULT", 15},
+		{"$MAX_RESULT", 15},
+		{"$RESULT[1]", 13},
+		{"$RESULT:", 11},
+	};
+	for (const auto &n : needles) {
+		const char *resultString = strstr(buffer, n.needle);
+		while (resultString && strlen(resultString) >= n.skip) {
+			const char *c = resultString + n.skip;
+			const char *end = c;
+			while (*end && *end != '\n' && *end != '\r')
+				end++;
+			ret.push_back(parseResult(std::string(c, end - c)));
+			resultString = strstr(end, n.needle);
+		}
+		if (!ret.empty())
+			break;
 	}
 
 	free(buffer);
@@ -159,38 +157,47 @@ std::vector<DFT::DFTCalculationResultItem> MRMCRunner::analyze(
 	std::vector<DFT::DFTCalculationResultItem> ret;
 	expandRangeQueries(queries);
 	messageFormatter->reportAction("Calculating probability with " + mrmcExec.getFileName(), DFT::VERBOSITY_FLOW);
+	if (queries.empty())
+		return ret;
+
+	/* All formulas are checked in one run, so the model is only loaded
+	 * once.
+	 */
+	File inputFile = exec->genInputFile("query");
+	std::ofstream out(inputFile.getFileRealPath());
+	if(!out.is_open()) {
+		messageFormatter->reportError("Could not open "
+		                + inputFile.getFileRealPath());
+		return ret;
+	}
+	out << "set print off\n";
 	for (Query q : queries) {
-		File inputFile = exec->genInputFile("query");
-		std::string qText = getQuery(q, goalLabel);
-		std::ofstream out(inputFile.getFileRealPath());
-		if(!out.is_open()) {
-			messageFormatter->reportError("Could not open "
-			                + inputFile.getFileRealPath());
-			return ret;
-		}
-		out << "set print off\n";
-		out << qText;
+		out << getQuery(q, goalLabel);
 		out << "$RESULT[1]\n";
-		out << "quit\n";
-		out.close();
-		std::vector<std::string> arguments;
-		arguments.push_back(isCtmdp ? "ctmdpi" : "ctmc");
-		arguments.push_back(modelFile.getFileRealPath());
-		arguments.push_back(labFile.getFileRealPath());
+	}
+	out << "quit\n";
+	out.close();
+	std::vector<std::string> arguments;
+	arguments.push_back(isCtmdp ? "ctmdpi" : "ctmc");
+	arguments.push_back(modelFile.getFileRealPath());
+	arguments.push_back(labFile.getFileRealPath());
 
-		std::string res = exec->runCommand(
-				mrmcExec.getFilePath(),
-				arguments,
-				mrmcExec.getFileName(),
-				std::vector<File>(),
-				&inputFile);
-		if (res == "")
-			return ret; /* Exec should have reported already */
-		auto result = readOutputFile(res);
-		if (result.first == -1) {
-			messageFormatter->reportError("Could not calculate.");
-			return ret;
-		}
+	std::string res = exec->runCommand(
+			mrmcExec.getFilePath(),
+			arguments,
+			mrmcExec.getFileName(),
+			std::vector<File>(),
+			&inputFile);
+	if (res == "")
+		return ret; /* Exec should have reported already */
+	auto results = readOutputFile(res);
+	if (results.size() != queries.size()) {
+		messageFormatter->reportError("Could not calculate.");
+		return ret;
+	}
+	for (size_t i = 0; i < queries.size(); i++) {
+		const Query &q = queries[i];
+		const auto &result = results[i];
 		DFT::DFTCalculationResultItem it(q);
 		if (mrmcExec.getFileName() == "mrmc") {
 			decnumber<> errorBound = q.errorBound;
@@ -0,0 +1,315 @@
+/*
+ * phasetype.cpp
+ *
+ * Part of dft2lnt library - a library containing read/write operations for DFT
+ * files in Galileo format and translating DFT specifications into Lotos NT.
+ */
+
+#include "phasetype.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <string>
+
+/* The relative change of any initial probability allowed when removing
+ * a phase. Bounding every coefficient (rather than their sum) keeps the
+ * small probabilities of rare failures accurate.
+ */
+static const double TOLERANCE = 1e-9;
+
+static std::string rateLabel(double rate)
+{
+	std::ostringstream ss;
+	ss << "rate " << std::setprecision(17) << rate;
+	return ss.str();
+}
+
+/*
+ * Writing L(i) for the distribution starting in phase i, and E(r) for
+ * the exponential distribution with rate r: for rates a <= b,
+ *   E(a) = (a/b) E(b) + (1 - a/b) E(a)*E(b)
+ * (compare the Laplace transforms). This moves a missing phase of rate
+ * b into a sequence, keeping all coefficients non-negative, which is
+ * why the rates are kept ordered. The states are added in reverse
+ * topological order, each inserting its rate into the ordered phases.
+ */
+bool DFT::PhaseType::fromCTMC(const CTMC& ctmc)
+{
+	const uint32_t NONE = std::numeric_limits<uint32_t>::max();
+	rates.clear();
+	initial.clear();
+	immediate = false;
+	size_t n = ctmc.getNumStates();
+	if (n == 0)
+		return true;
+	if (ctmc.isMarked(0)) {
+		immediate = true;
+		return true;
+	}
+
+	/* The unmarked states from which a marked state is reachable */
+	std::vector<std::vector<uint32_t>> preds(n);
+	for (uint32_t s = 0; s < n; s++) {
+		for (const CTMC::Transition *t = ctmc.begin(s); t != ctmc.end(s); ++t)
+			preds[t->target].push_back(s);
+	}
+	std::vector<bool> live(n, false);
+	std::vector<uint32_t> queue;
+	for (uint32_t s = 0; s < n; s++) {
+		if (ctmc.isMarked(s))
+			queue.push_back(s);
+	}
+	for (size_t i = 0; i < queue.size(); i++) {
+		for (uint32_t p : preds[queue[i]]) {
+			if (!ctmc.isMarked(p) && !live[p]) {
+				live[p] = true;
+				queue.push_back(p);
+			}
+		}
+	}
+	if (!live[0])
+		return true;
+
+	/* The transient states, those reachable from the initial one */
+	std::vector<uint32_t> index(n, NONE), states(1, 0);
+	index[0] = 0;
+	for (size_t i = 0; i < states.size(); i++) {
+		uint32_t s = states[i];
+		for (const CTMC::Transition *t = ctmc.begin(s); t != ctmc.end(s); ++t) {
+			if (live[t->target] && index[t->target] == NONE) {
+				index[t->target] = states.size();
+				states.push_back(t->target);
+			}
+		}
+		if (states.size() > MAX_STATES)
+			return false;
+	}
+
+	/* Topological order, failing on cycles */
+	std::vector<uint32_t> inDegree(states.size(), 0);
+	for (uint32_t s : states) {
+		for (const CTMC::Transition *t = ctmc.begin(s); t != ctmc.end(s); ++t) {
+			if (index[t->target] != NONE)
+				inDegree[index[t->target]]++;
+		}
+	}
+	std::vector<uint32_t> need(inDegree);
+	std::vector<uint32_t> order;
+	for (uint32_t i = 0; i < states.size(); i++) {
+		if (inDegree[i] == 0)
+			order.push_back(i);
+	}
+	for (size_t i = 0; i < order.size(); i++) {
+		uint32_t s = states[order[i]];
+		for (const CTMC::Transition *t = ctmc.begin(s); t != ctmc.end(s); ++t) {
+			uint32_t j = index[t->target];
+			if (j != NONE && --inDegree[j] == 0)
+				order.push_back(j);
+		}
+	}
+	if (order.size() != states.size())
+		return false;
+
+	/* coefs[i]: the distribution from the i'th state, as coefficients
+	 * of L(0), ..., L(m-1) and of immediate absorption for the current
+	 * m phases. Only kept while the state has predecessors left.
+	 */
+	std::vector<double> phases;
+	std::vector<std::vector<double>> coefs(states.size());
+	std::vector<uint32_t> kept;
+	for (size_t k = order.size(); k-- > 0;) {
+		uint32_t i = order[k];
+		uint32_t s = states[i];
+		size_t m = phases.size();
+		double r = 0;
+		for (const CTMC::Transition *t = ctmc.begin(s); t != ctmc.end(s); ++t)
+			r += ctmc.getRateValue(t->rate);
+		std::vector<double> w(m + 1, 0.0);
+		for (const CTMC::Transition *t = ctmc.begin(s); t != ctmc.end(s); ++t) {
+			double p = ctmc.getRateValue(t->rate) / r;
+			uint32_t j = index[t->target];
+			if (ctmc.isMarked(t->target)) {
+				w[m] += p;
+			} else if (j != NONE) {
+				for (size_t c = 0; c <= m; c++)
+					w[c] += p * coefs[j][c];
+				if (--need[j] == 0)
+					std::vector<double>().swap(coefs[j]);
+			}
+		}
+
+		/* Insert the new phase, prefixing it to w: E(r)*L(c) is
+		 * the new L(c) for the slower phases c, while the gap
+		 * between E(r) and the faster ones is filled from the back.
+		 */
+		size_t pos = std::lower_bound(phases.begin(), phases.end(), r) - phases.begin();
+		std::vector<double> u(m + 2, 0.0);
+		for (size_t c = 0; c < pos; c++)
+			u[c] = w[c];
+		double carry = 0;
+		for (size_t c = m + 1; c > pos + 1; c--) {
+			carry += w[c - 1];
+			double f = r / phases[c - 2];
+			u[c - 1] += carry * f;
+			carry *= 1 - f;
+		}
+		u[pos] += carry + w[pos];
+
+		/* Express the kept distributions in the new phases: the
+		 * slower ones gain the new phase, E(a) splitting into
+		 * E(r) and E(a)*E(r).
+		 */
+		size_t nKept = 0;
+		for (uint32_t j : kept) {
+			if (coefs[j].empty())
+				continue;
+			kept[nKept++] = j;
+			std::vector<double> &v = coefs[j];
+			std::vector<double> x(m + 2, 0.0);
+			for (size_t c = 0; c < pos; c++) {
+				double f = phases[c] / r;
+				x[c] += (1 - f) * v[c];
+				x[c + 1] += f * v[c];
+			}
+			for (size_t c = pos; c <= m; c++)
+				x[c + 1] += v[c];
+			v.swap(x);
+		}
+		kept.resize(nKept);
+		phases.insert(phases.begin() + pos, r);
+		coefs[i].swap(u);
+		kept.push_back(i);
+	}
+
+	rates.swap(phases);
+	initial.assign(coefs[0].begin(), coefs[0].end() - 1);
+	return true;
+}
+
+bool DFT::PhaseType::removePhase(size_t p)
+{
+	size_t n = rates.size();
+	double r = rates[p];
+	std::vector<double> mu(rates);
+	mu.erase(mu.begin() + p);
+
+	/* Invert the insertion of phase p (see fromCTMC()), which is
+	 * determined by the coefficients before p, then check the rest.
+	 */
+	std::vector<double> v(n - 1);
+	for (size_t i = 0; i < p; i++) {
+		double x = initial[i];
+		if (i > 0)
+			x -= mu[i - 1] / r * v[i - 1];
+		v[i] = std::max(0.0, x / (1 - mu[i] / r));
+	}
+	for (size_t i = p + 1; i < n; i++)
+		v[i - 1] = initial[i];
+
+	std::vector<double> u(n, 0.0);
+	for (size_t i = 0; i < p; i++) {
+		double f = mu[i] / r;
+		u[i] += (1 - f) * v[i];
+		u[i + 1] += f * v[i];
+	}
+	for (size_t i = p; i + 1 < n; i++)
+		u[i + 1] += v[i];
+	for (size_t i = 0; i < n; i++) {
+		if (std::fabs(u[i] - initial[i]) > TOLERANCE * initial[i])
+			return false;
+	}
+	rates.swap(mu);
+	initial.swap(v);
+	return true;
+}
+
+void DFT::PhaseType::minimise()
+{
+	bool changed = true;
+	while (changed) {
+		/* Phases before the first initial one are never visited */
+		size_t first = 0;
+		while (first < initial.size() && initial[first] <= 0)
+			first++;
+		rates.erase(rates.begin(), rates.begin() + first);
+		initial.erase(initial.begin(), initial.begin() + first);
+
+		changed = false;
+		for (size_t p = rates.size(); p-- > 0;) {
+			if (p > 0 && rates[p - 1] == rates[p])
+				continue;
+			if (removePhase(p))
+				changed = true;
+		}
+	}
+}
+
+/*
+ * Running the phases backwards, the process is in phase i after the
+ * slower phases with the probability S(i) of starting in one of phases
+ * 0, ..., i. Phase i then ends the process with the probability of
+ * having started there, or continues.
+ */
+void DFT::PhaseType::toIMC(IMC& imc) const
+{
+	imc = IMC();
+	uint32_t activate = imc.addLabel("ACTIVATE");
+	uint32_t fail = imc.addLabel("FAIL");
+	uint32_t n = rates.size();
+	uint32_t failing = n + 1, failed = n + 2, never = n + 3;
+	std::vector<double> sum(n);
+	double total = 0;
+	for (uint32_t i = 0; i < n; i++)
+		sum[i] = total += initial[i];
+	double defect = std::max(0.0, 1 - total);
+
+	imc.addState();
+	if (immediate)
+		imc.addTransition(activate, failing);
+	else
+		imc.addTransition(activate, n ? 1 : never);
+	for (uint32_t i = n; i-- > 0;) {
+		uint32_t state = imc.addState();
+		double reach = sum[i];
+		if (i == n - 1)
+			reach += defect;
+		double r = rates[i] / reach;
+		if (initial[i] > 0)
+			imc.addTransition(imc.addLabel(rateLabel(r * initial[i])), failing);
+		if (i > 0 && sum[i - 1] > 0)
+			imc.addTransition(imc.addLabel(rateLabel(r * sum[i - 1])), state + 1);
+		if (i == n - 1 && defect > 0)
+			imc.addTransition(imc.addLabel(rateLabel(r * defect)), never);
+	}
+	imc.addState();
+	imc.addTransition(fail, failed);
+	imc.addState();
+	imc.addState();
+}
+
+void DFT::PhaseType::toIMC(const CTMC& ctmc, IMC& imc)
+{
+	imc = IMC();
+	uint32_t activate = imc.addLabel("ACTIVATE");
+	uint32_t fail = imc.addLabel("FAIL");
+	uint32_t n = ctmc.getNumStates();
+	uint32_t failed = n + 1;
+	imc.addState();
+	imc.addTransition(activate, 1);
+	for (uint32_t s = 0; s < n; s++) {
+		imc.addState();
+		if (ctmc.isMarked(s)) {
+			imc.addTransition(fail, failed);
+			continue;
+		}
+		for (const CTMC::Transition *t = ctmc.begin(s); t != ctmc.end(s); ++t) {
+			uint32_t label = imc.addLabel("rate " + ctmc.getRate(t->rate));
+			imc.addTransition(label, t->target + 1);
+		}
+	}
+	imc.addState();
+}
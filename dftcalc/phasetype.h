@@ -0,0 +1,90 @@
+/*
+ * phasetype.h
+ *
+ * Part of dft2lnt library - a library containing read/write operations for DFT
+ * files in Galileo format and translating DFT specifications into Lotos NT.
+ */
+
+#ifndef PHASETYPE_H
+#define PHASETYPE_H
+
+#include <cstddef>
+#include <vector>
+
+#include "imc.h"
+
+namespace DFT {
+
+/**
+ * An acyclic phase-type distribution in ordered bidiagonal form
+ * (Cumani's CF1): phase i has rate getRate(i), the rates are
+ * non-decreasing, phase i leads to phase i+1 and the last phase to
+ * absorption. The process starts in phase i with probability
+ * getInitial(i), and is never absorbed with the remaining probability.
+ * Every acyclic phase-type distribution has such a representation with
+ * no more phases than its acyclic representations.
+ */
+class PhaseType {
+private:
+	std::vector<double> rates;
+	std::vector<double> initial;
+	bool immediate;
+
+	/**
+	 * Tries to represent the distribution without phase p, which must
+	 * be the first of the phases with its rate.
+	 * @return true if the distribution is unchanged (up to rounding),
+	 *         false if phase p is needed.
+	 */
+	bool removePhase(size_t p);
+
+public:
+	/// The largest number of transient states fromCTMC() converts
+	static const size_t MAX_STATES = 1000;
+
+	PhaseType(): immediate(false) {}
+
+	/**
+	 * Sets this to the distribution of the time until the CTMC, from
+	 * state 0, first reaches a marked state.
+	 * @return false if the CTMC has more than MAX_STATES unmarked
+	 *         states from which a marked state is reachable, or if it
+	 *         has a cycle through such states.
+	 */
+	bool fromCTMC(const CTMC& ctmc);
+
+	/**
+	 * Removes phases that do not change the distribution: those never
+	 * started in, and those cancelled out by the others, until each of
+	 * the remaining phases is needed.
+	 */
+	void minimise();
+
+	size_t getNumPhases() const { return rates.size(); }
+	double getRate(size_t phase) const { return rates[phase]; }
+	double getInitial(size_t phase) const { return initial[phase]; }
+
+	/**
+	 * Returns whether absorption is immediate (at time 0).
+	 */
+	bool isImmediate() const { return immediate; }
+
+	/**
+	 * Builds an IMC of this distribution as the embedded process of an
+	 * APH basic event: after ACTIVATE, the phases run in the reverse
+	 * order (as a Coxian distribution, fastest phase first), and
+	 * absorption is signalled by FAIL.
+	 */
+	void toIMC(IMC& imc) const;
+
+	/**
+	 * Builds an IMC of the time until the CTMC, from state 0, first
+	 * reaches a marked state, in the same way as toIMC(). Unlike
+	 * fromCTMC(), this keeps all unmarked states and the exact rates.
+	 */
+	static void toIMC(const CTMC& ctmc, IMC& imc);
+};
+
+} // Namespace: DFT
+
+#endif
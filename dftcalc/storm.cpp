@@ -17,6 +17,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <iostream>
+#include <map>
 #include <stdexcept>
 
 static const char needle[] = "Result (for initial states): ";
@@ -77,15 +78,24 @@ static std::string getQuery(Query q)
 	return ret;
 }
 
-static int readOutputFile(File file, DFT::DFTCalculationResultItem &it) {
+/* Reads the results of all properties, in the order in which they were
+ * given to Storm. Results that Storm gives as fractions are stored in
+ * exactString.
+ * Returns the number of results read, or -1 if the file does not exist.
+ */
+static int readOutputFile(File file,
+                          std::vector<DFT::DFTCalculationResultItem *> &items)
+{
 	if(!FileSystem::exists(file))
 		return -1;
 
 	std::ifstream input(file.getFileRealPath());
 	std::string line;
+	size_t n = 0;
 	std::getline(input, line);
-	while (input.good()) {
+	while (input.good() && n < items.size()) {
 		if (line.find(needle) != std::string::npos) {
+			DFT::DFTCalculationResultItem &it = *items[n++];
 			line.erase(0, strlen(needle));
 			size_t appr = line.find(" (approx.");
 			if (appr != std::string::npos) {
@@ -94,16 +104,14 @@ static int readOutputFile(File file, DFT::DFTCalculationResultItem &it) {
 			} else {
 				it.exactBounds = 0;
 			}
-			if (line.find('/') != std::string::npos) {
+			if (line.find('/') != std::string::npos)
 				it.exactString = line;
-				return 1;
-			}
-			it.lowerBound = decnumber<>(line);
-			return 0;
+			else
+				it.lowerBound = decnumber<>(line);
 		}
 		std::getline(input, line);
 	}
-	return -1;
+	return n;
 }
 
 std::vector<DFT::DFTCalculationResultItem> StormRunner::analyze(std::vector<Query> queries)
@@ -111,32 +119,48 @@ std::vector<DFT::DFTCalculationResultItem> StormRunner::analyze(std::vector<Quer
 	std::vector<DFT::DFTCalculationResultItem> ret;
 	expandRangeQueries(queries);
 	messageFormatter->reportAction("Calculating probability with " + stormExec.getFileName(), DFT::VERBOSITY_FLOW);
-	for (Query q : queries) {
-		std::vector<std::string> arguments;
-		getCommandOptions(q, arguments);
+
+	/* Storm loads the model only once for all properties given to it,
+	 * so all queries needing the same options are checked together.
+	 */
+	std::map<std::vector<std::string>, std::vector<size_t>> batches;
+	std::vector<DFT::DFTCalculationResultItem> items;
+	for (size_t i = 0; i < queries.size(); i++) {
+		items.push_back(DFT::DFTCalculationResultItem(queries[i]));
+		items.back().exactBounds = 0;
+		/* Special case since Storm fails to compute otherwise. */
+		if (queries[i].type == TIMEBOUND && queries[i].upperBound == 0)
+			continue;
+		std::vector<std::string> options;
+		getCommandOptions(queries[i], options);
+		batches[options].push_back(i);
+	}
+
+	for (auto &batch : batches) {
+		std::vector<std::string> arguments = batch.first;
+		std::string props;
+		std::vector<DFT::DFTCalculationResultItem *> batchItems;
+		for (size_t i : batch.second) {
+			if (!props.empty())
+				props += "; ";
+			props += getQuery(queries[i]);
+			batchItems.push_back(&items[i]);
+		}
 		arguments.push_back("--prop");
-		arguments.push_back(getQuery(q));
+		arguments.push_back(props);
 		arguments.push_back("--jani");
 		arguments.push_back(janiFile.getFileRealPath());
-		DFT::DFTCalculationResultItem it(q);
-		int result;
-		std::string of;
-		if (q.type == TIMEBOUND && q.upperBound == 0) {
-			/* Special case since Storm fails to compute otherwise. */
-			result = 0;
-		} else {
-			of = exec->runCommand(stormExec.getFilePath(), arguments, stormExec.getFileName());
-			if (of == "") {
-				messageFormatter->reportError("Could not calculate.");
-				return ret;
-			}
-			result = readOutputFile(of, it);
-		}
-		if (result == -1) {
+		std::string of = exec->runCommand(stormExec.getFilePath(), arguments, stormExec.getFileName());
+		if (of == "" || readOutputFile(of, batchItems) != (int)batchItems.size()) {
 			messageFormatter->reportError("Could not calculate.");
 			return ret;
 		}
-		if (result == 0 && !it.exactBounds) {
+	}
+
+	for (size_t i = 0; i < items.size(); i++) {
+		const Query &q = queries[i];
+		DFT::DFTCalculationResultItem &it = items[i];
+		if (it.exactString.empty() && !it.exactBounds) {
 			decnumber<> margin = q.errorBound;
 			if (q.errorBoundSet)
 				margin *= 0.5;
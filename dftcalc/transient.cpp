@@ -0,0 +1,341 @@
+/*
+ * transient.cpp
+ *
+ * Part of dft2lnt library - a library containing read/write operations for DFT
+ * files in Galileo format and translating DFT specifications into Lotos NT.
+ */
+
+#include "transient.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include "query.h"
+
+namespace {
+
+/* Unnormalised Poisson weights, from the left truncation point onwards.
+ * The probability mass outside the weights, relative to their total, is
+ * at most omitted.
+ */
+struct PoissonWeights {
+	size_t left;
+	std::vector<double> weights;
+	double total;
+	double omitted;
+
+	size_t right() const { return left + weights.size() - 1; }
+};
+
+/* Computes the weights of the Poisson distribution with parameter lambda,
+ * truncated such that at most epsilon of the mass is omitted. As in the
+ * algorithm of Fox and Glynn, the weights are computed outwards from the
+ * mode, starting from a large value to avoid underflow. The tails are
+ * bounded by geometric series, since beyond the mode the ratio between
+ * consecutive weights is below lambda/(k+2) or (k-1)/lambda.
+ */
+PoissonWeights poissonWeights(double lambda, double epsilon) {
+	PoissonWeights ret;
+	if (lambda <= 0) {
+		ret.left = 0;
+		ret.weights.push_back(1);
+		ret.total = 1;
+		ret.omitted = 0;
+		return ret;
+	}
+	size_t mode = (size_t)lambda;
+	std::vector<double> below, above;
+	above.push_back(std::ldexp(1.0, 700));
+	double total = above.back();
+	double leftTail = 0, rightTail;
+
+	for (size_t k = mode; k > 0; k--) {
+		double w = below.empty() ? above.front() : below.back();
+		double next = w * k / lambda;
+		leftTail = next / (1 - (k - 1) / lambda) / total;
+		if (leftTail <= epsilon / 2)
+			break;
+		below.push_back(next);
+		total += next;
+		leftTail = 0;
+	}
+	for (size_t k = mode; ; k++) {
+		double next = above.back() * lambda / (k + 1);
+		rightTail = next / (1 - lambda / (k + 2)) / total;
+		if (rightTail <= epsilon / 2)
+			break;
+		above.push_back(next);
+		total += next;
+	}
+
+	ret.left = mode - below.size();
+	ret.weights.assign(below.rbegin(), below.rend());
+	ret.weights.insert(ret.weights.end(), above.begin(), above.end());
+	ret.total = total;
+	ret.omitted = leftTail + rightTail;
+	return ret;
+}
+
+/* Bounds on the rounding error of the result after the specified number
+ * of iterations, for values at most 1: every multiplication adds at most
+ * (row + 1) rounding errors, the weights at most two per step from the
+ * mode, and the summation one per weight.
+ */
+double roundingError(size_t iterations, size_t maxRow,
+                     const PoissonWeights& w)
+{
+	return ((iterations + 1) * (maxRow + 3) + 4 * (w.weights.size() + 2))
+	       * DBL_EPSILON;
+}
+
+void bounds(double sum, const PoissonWeights& w, double slack, double xMax,
+            double& lower, double& upper)
+{
+	double s = sum / w.total;
+	lower = std::max(0.0, s / (1 + w.omitted) - slack);
+	upper = std::min(xMax, s + w.omitted * xMax + slack);
+}
+
+} // Anonymous namespace
+
+DFT::TransientSolver::TransientSolver(const CTMC& ctmc, bool absorbMarked):
+	nStates(ctmc.getNumStates()),
+	initial(0),
+	rate(0),
+	maxRow(0),
+	rowStart(1, 0),
+	diagonal(ctmc.getNumStates())
+{
+	std::vector<double> exitRates(nStates, 0);
+	for (uint32_t s = 0; s < nStates; s++) {
+		if (absorbMarked && ctmc.isMarked(s))
+			continue;
+		for (const CTMC::Transition *t = ctmc.begin(s); t != ctmc.end(s); ++t) {
+			if (t->target != s)
+				exitRates[s] += ctmc.getRateValue(t->rate);
+		}
+		rate = std::max(rate, exitRates[s]);
+	}
+	if (rate == 0)
+		rate = 1;
+
+	for (uint32_t s = 0; s < nStates; s++) {
+		if (!absorbMarked || !ctmc.isMarked(s)) {
+			for (const CTMC::Transition *t = ctmc.begin(s); t != ctmc.end(s); ++t) {
+				if (t->target == s)
+					continue;
+				columns.push_back(t->target);
+				probabilities.push_back(ctmc.getRateValue(t->rate) / rate);
+			}
+		}
+		rowStart.push_back(columns.size());
+		maxRow = std::max(maxRow, rowStart[s + 1] - rowStart[s]);
+		diagonal[s] = std::max(0.0, (rate - exitRates[s]) / rate);
+	}
+}
+
+/* y = Px. The row loop uses independent accumulators, so the compiler can
+ * vectorise the gathers.
+ */
+void DFT::TransientSolver::multiply(const double *x, double *y) const {
+	const size_t *__restrict start = rowStart.data();
+	const uint32_t *__restrict cols = columns.data();
+	const double *__restrict probs = probabilities.data();
+	const double *__restrict diag = diagonal.data();
+	for (size_t s = 0; s < nStates; s++) {
+		double sum0 = diag[s] * x[s], sum1 = 0, sum2 = 0, sum3 = 0;
+		size_t i = start[s], end = start[s + 1];
+		for (; i + 4 <= end; i += 4) {
+			sum0 += probs[i] * x[cols[i]];
+			sum1 += probs[i + 1] * x[cols[i + 1]];
+			sum2 += probs[i + 2] * x[cols[i + 2]];
+			sum3 += probs[i + 3] * x[cols[i + 3]];
+		}
+		for (; i < end; i++)
+			sum0 += probs[i] * x[cols[i]];
+		y[s] = (sum0 + sum1) + (sum2 + sum3);
+	}
+}
+
+size_t DFT::TransientSolver::solve(const std::vector<double>& x,
+                                   const std::vector<double>& times,
+                                   double epsilon,
+                                   std::vector<double>& lower,
+                                   std::vector<double>& upper) const
+{
+	std::vector<PoissonWeights> weights;
+	std::vector<size_t> order(times.size());
+	size_t iterations = 0;
+	for (size_t j = 0; j < times.size(); j++) {
+		weights.push_back(poissonWeights(rate * times[j], epsilon));
+		iterations = std::max(iterations, weights.back().right());
+		order[j] = j;
+	}
+	std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+		return weights[a].left < weights[b].left;
+	});
+
+	/* Iterate once up to the last right truncation point, adding each
+	 * iterate to the time points whose window covers it.
+	 */
+	std::vector<double> sums(times.size(), 0);
+	std::vector<size_t> active;
+	std::vector<double> cur(x), next(nStates);
+	size_t pending = 0;
+	for (size_t k = 0; k <= iterations; k++) {
+		while (pending < order.size() && weights[order[pending]].left == k)
+			active.push_back(order[pending++]);
+		double v = cur[initial];
+		for (size_t a = 0; a < active.size(); ) {
+			const PoissonWeights& w = weights[active[a]];
+			sums[active[a]] += w.weights[k - w.left] * v;
+			if (w.right() == k) {
+				active[a] = active.back();
+				active.pop_back();
+			} else {
+				a++;
+			}
+		}
+		if (k < iterations) {
+			multiply(cur.data(), next.data());
+			cur.swap(next);
+		}
+	}
+
+	double xMax = 0;
+	for (double v : x)
+		xMax = std::max(xMax, v);
+	lower.resize(times.size());
+	upper.resize(times.size());
+	for (size_t j = 0; j < times.size(); j++) {
+		const PoissonWeights& w = weights[j];
+		double slack = roundingError(w.right(), maxRow, w);
+		bounds(sums[j], w, slack, xMax, lower[j], upper[j]);
+	}
+	return iterations;
+}
+
+size_t DFT::TransientSolver::solveAll(const std::vector<double>& x,
+                                      double time, double epsilon,
+                                      std::vector<double>& lower,
+                                      std::vector<double>& upper) const
+{
+	PoissonWeights w = poissonWeights(rate * time, epsilon);
+	std::vector<double> sums(nStates, 0);
+	std::vector<double> cur(x), next(nStates);
+	for (size_t k = 0; k <= w.right(); k++) {
+		if (k >= w.left) {
+			double weight = w.weights[k - w.left];
+			for (size_t s = 0; s < nStates; s++)
+				sums[s] += weight * cur[s];
+		}
+		if (k < w.right()) {
+			multiply(cur.data(), next.data());
+			cur.swap(next);
+		}
+	}
+
+	double xMax = 0;
+	for (double v : x)
+		xMax = std::max(xMax, v);
+	double slack = roundingError(w.right(), maxRow, w);
+	lower.resize(nStates);
+	upper.resize(nStates);
+	for (size_t s = 0; s < nStates; s++)
+		bounds(sums[s], w, slack, xMax, lower[s], upper[s]);
+	return w.right();
+}
+
+std::vector<DFT::DFTCalculationResultItem> TransientRunner::analyze(
+		std::vector<Query> queries)
+{
+	std::vector<DFT::DFTCalculationResultItem> ret;
+	expandRangeQueries(queries);
+	messageFormatter->reportAction("Calculating probability with the native transient solver", DFT::VERBOSITY_FLOW);
+
+	DFT::CTMC ctmc;
+	{
+		std::ifstream tra(traFile.getFileRealPath());
+		std::ifstream lab(labFile.getFileRealPath());
+		if (!tra.is_open() || !lab.is_open()) {
+			messageFormatter->reportError("Could not open `"
+			                + traFile.getFileRealPath() + "' or `"
+			                + labFile.getFileRealPath() + "'");
+			return ret;
+		}
+		std::string error;
+		if (!ctmc.readTraLab(tra, lab, error)) {
+			messageFormatter->reportError("Error reading `"
+			                + traFile.getFileRealPath() + "': " + error);
+			return ret;
+		}
+	}
+
+	/* Queries from time 0 are solved together, interval queries each in
+	 * two phases: first the probability to reach the goal within the
+	 * length of the interval from every state, then the expected value
+	 * of that at the start of the interval.
+	 */
+	std::vector<double> goal(ctmc.getNumStates());
+	for (uint32_t s = 0; s < ctmc.getNumStates(); s++)
+		goal[s] = ctmc.isMarked(s) ? 1 : 0;
+	DFT::TransientSolver reach(ctmc, true);
+	std::unique_ptr<DFT::TransientSolver> plain;
+	std::vector<size_t> batch;
+	std::vector<double> times;
+	double epsilon = 1;
+	std::vector<double> lower(queries.size()), upper(queries.size());
+	for (size_t i = 0; i < queries.size(); i++) {
+		const Query& q = queries[i];
+		if (q.type != TIMEBOUND) {
+			messageFormatter->reportError("The native transient solver only supports time-bounded queries, not "
+			                              + queries[i].toString());
+			return ret;
+		}
+		double from = (double)q.lowerBound, to = (double)q.upperBound;
+		double eps = (double)q.errorBound;
+		if (from > to) {
+			messageFormatter->reportError("Empty time interval in "
+			                              + queries[i].toString());
+			return ret;
+		}
+		if (from == 0) {
+			batch.push_back(i);
+			times.push_back(to);
+			epsilon = std::min(epsilon, eps / 2);
+			continue;
+		}
+		if (!plain)
+			plain.reset(new DFT::TransientSolver(ctmc, false));
+		std::vector<double> lo, hi, tmp, res;
+		reach.solveAll(goal, to - from, eps / 4, lo, hi);
+		plain->solve(lo, {from}, eps / 4, res, tmp);
+		lower[i] = res[0];
+		plain->solve(hi, {from}, eps / 4, tmp, res);
+		upper[i] = res[0];
+	}
+	if (!batch.empty()) {
+		std::vector<double> lo, hi;
+		size_t iterations = reach.solve(goal, times, epsilon, lo, hi);
+		messageFormatter->reportAction("Uniformization rate "
+		                + std::to_string(reach.getRate()) + ", "
+		                + std::to_string(iterations) + " iterations for "
+		                + std::to_string(times.size()) + " time points",
+		                DFT::VERBOSITY_FLOW);
+		for (size_t j = 0; j < batch.size(); j++) {
+			lower[batch[j]] = lo[j];
+			upper[batch[j]] = hi[j];
+		}
+	}
+
+	for (size_t i = 0; i < queries.size(); i++) {
+		DFT::DFTCalculationResultItem it(queries[i]);
+		it.exactBounds = 1;
+		it.lowerBound = DFT::probabilityBound(lower[i], false);
+		it.upperBound = DFT::probabilityBound(upper[i], true);
+		ret.push_back(it);
+	}
+	return ret;
+}
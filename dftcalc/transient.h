@@ -0,0 +1,97 @@
+/*
+ * transient.h
+ *
+ * Part of dft2lnt library - a library containing read/write operations for DFT
+ * files in Galileo format and translating DFT specifications into Lotos NT.
+ */
+
+#ifndef TRANSIENT_H
+#define TRANSIENT_H
+
+#include "FileSystem.h"
+#include "checker.h"
+#include "imc.h"
+#include <vector>
+
+namespace DFT {
+
+/**
+ * Transient analysis of a CTMC by uniformization. The uniformized matrix
+ * is stored in compressed sparse row format, and iterated backwards from
+ * a value vector, so that a single run yields the results for any number
+ * of time points. The Poisson weights are computed as by Fox and Glynn,
+ * with the truncation error and floating-point rounding accounted for in
+ * the returned bounds.
+ */
+class TransientSolver {
+private:
+	size_t nStates;
+	uint32_t initial;
+	double rate;
+	size_t maxRow;
+	std::vector<size_t> rowStart;
+	std::vector<uint32_t> columns;
+	std::vector<double> probabilities;
+	std::vector<double> diagonal;
+
+	void multiply(const double *x, double *y) const;
+
+public:
+	/**
+	 * Uniformizes the specified CTMC, starting in its state 0.
+	 * @param absorbMarked If true, the marked states are made absorbing,
+	 *        so that the values computed are time-bounded reachability
+	 *        probabilities.
+	 */
+	TransientSolver(const CTMC& ctmc, bool absorbMarked);
+
+	/**
+	 * Returns the uniformization rate.
+	 */
+	double getRate() const { return rate; }
+
+	/**
+	 * Computes bounds on the expected value of x at each of the
+	 * specified times, starting from the initial state. All times are
+	 * handled in a single iteration, up to the largest one.
+	 * @param x The value of every state, between 0 and 1.
+	 * @param epsilon The allowed truncation error per time point.
+	 * @param lower Will contain a lower bound for each time.
+	 * @param upper Will contain an upper bound for each time.
+	 * @return The number of iterations performed.
+	 */
+	size_t solve(const std::vector<double>& x,
+	             const std::vector<double>& times, double epsilon,
+	             std::vector<double>& lower,
+	             std::vector<double>& upper) const;
+
+	/**
+	 * As solve(), but for a single time, and giving the bounds for every
+	 * starting state rather than only the initial state.
+	 * @return The number of iterations performed.
+	 */
+	size_t solveAll(const std::vector<double>& x, double time,
+	                double epsilon, std::vector<double>& lower,
+	                std::vector<double>& upper) const;
+};
+
+} // Namespace: DFT
+
+/**
+ * Checker using the native transient solver on a CTMC in .tra/.lab format,
+ * as produced by the native converter. Only time-bounded queries are
+ * supported.
+ */
+class TransientRunner : public Checker {
+private:
+	const File traFile, labFile;
+public:
+	TransientRunner(MessageFormatter *mf, DFT::CommandExecutor *exec,
+	                File tra, File lab)
+		:Checker(mf, exec), traFile(tra), labFile(lab)
+	{}
+
+	virtual std::vector<DFT::DFTCalculationResultItem> analyze(std::vector<Query> queries);
+};
+
+#endif
@@ -162,6 +162,10 @@ if [ "$1" = "--all" ]; then
 		DFTCALC_OPTS="--exact $CHECKER $*";
 		do_tests < tests.txt
 	done
+	for CHECKER in --imrmc --transient; do
+		DFTCALC_OPTS="--native $CHECKER $*";
+		do_tests < tests.txt
+	done
 else
 	if [ "$#" -gt 0 ]; then
 		DFTCALC_OPTS="$*";